@@ -11,6 +11,8 @@ Feature: osrm-contract command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--threads"
         And stdout should contain "--core"
+        And stdout should contain "--core-landmarks"
+        And stdout should contain "--unpack-shortcuts"
         And stdout should contain "--level-cache"
         And stdout should contain "--segment-speed-file"
         And it should exit with code 1
@@ -25,6 +27,8 @@ Feature: osrm-contract command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--threads"
         And stdout should contain "--core"
+        And stdout should contain "--core-landmarks"
+        And stdout should contain "--unpack-shortcuts"
         And stdout should contain "--level-cache"
         And stdout should contain "--segment-speed-file"
         And it should exit with code 0
@@ -39,6 +43,8 @@ Feature: osrm-contract command line options: help
         And stdout should contain "Configuration:"
         And stdout should contain "--threads"
         And stdout should contain "--core"
+        And stdout should contain "--core-landmarks"
+        And stdout should contain "--unpack-shortcuts"
         And stdout should contain "--level-cache"
         And stdout should contain "--segment-speed-file"
         And it should exit with code 0
@@ -50,6 +50,11 @@ class Contractor
                        std::vector<bool> &is_core_node,
                        std::vector<float> &inout_node_levels) const;
     void WriteCoreNodeMarker(std::vector<bool> &&is_core_node) const;
+    void WriteCoreLandmarks(const std::vector<bool> &is_core_node,
+                            const util::DeallocatingVector<QueryEdge> &contracted_edge_list) const;
+    void
+    WriteShortcutUnpacking(unsigned max_node_id,
+                           const util::DeallocatingVector<QueryEdge> &contracted_edge_list) const;
     void WriteNodeLevels(std::vector<float> &&node_levels) const;
     void ReadNodeLevels(std::vector<float> &contraction_order) const;
     std::size_t
@@ -19,6 +19,8 @@ struct ContractorConfig
     {
         level_output_path = osrm_input_path.string() + ".level";
         core_output_path = osrm_input_path.string() + ".core";
+        landmarks_output_path = osrm_input_path.string() + ".landmarks";
+        shortcuts_output_path = osrm_input_path.string() + ".shortcuts";
         graph_output_path = osrm_input_path.string() + ".hsgr";
         edge_based_graph_path = osrm_input_path.string() + ".ebg";
         edge_segment_lookup_path = osrm_input_path.string() + ".edge_segment_lookup";
@@ -31,6 +33,8 @@ struct ContractorConfig
 
     std::string level_output_path;
     std::string core_output_path;
+    std::string landmarks_output_path;
+    std::string shortcuts_output_path;
     std::string graph_output_path;
     std::string edge_based_graph_path;
 
@@ -47,6 +51,12 @@ struct ContractorConfig
     //(e.g. 0.8 contracts 80 percent of the hierarchy, leaving a core of 20%)
     double core_factor;
 
+    // Number of landmarks that guide the searches through the core (ALT), 0 disables them
+    unsigned number_of_core_landmarks;
+
+    // Shortcuts of at least this many original edges are stored unpacked, 0 disables it
+    unsigned min_unpacked_shortcut_size;
+
     std::string segment_speed_lookup_path;
 
 #ifdef DEBUG_GEOMETRY
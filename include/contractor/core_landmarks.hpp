@@ -0,0 +1,218 @@
+#ifndef CORE_LANDMARKS_HPP
+#define CORE_LANDMARKS_HPP
+
+#include "util/binary_heap.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <tbb/parallel_invoke.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+/*
+ * Landmarks for goal directed (ALT) searches in the uncontracted core of a hierarchy.
+ * Core nodes are numbered by increasing node id. For every core node the distances from and to
+ * every landmark are stored next to each other:
+ *
+ *   [core node 0: from 0, to 0, from 1, to 1, ...][core node 1: from 0, to 0, ...]...
+ *
+ * Pairs that are not connected in the core get INVALID_EDGE_WEIGHT.
+ */
+class CoreLandmarks
+{
+  public:
+    // edges can be any container of QueryEdge, only edges between core nodes are used
+    template <typename EdgeContainerT>
+    CoreLandmarks(const std::vector<bool> &is_core_node, const EdgeContainerT &edges)
+    {
+        core_index.resize(is_core_node.size(), SPECIAL_NODEID);
+        NodeID number_of_core_nodes = 0;
+        for (const auto node : util::irange<std::size_t>(0, is_core_node.size()))
+        {
+            if (is_core_node[node])
+            {
+                core_index[node] = number_of_core_nodes++;
+            }
+        }
+
+        // the core keeps the edges of both ends, so every arc is found at its source
+        std::vector<Arc> arcs;
+        for (const auto &edge : edges)
+        {
+            if (edge.source == edge.target || edge.source >= core_index.size() ||
+                edge.target >= core_index.size() || SPECIAL_NODEID == core_index[edge.source] ||
+                SPECIAL_NODEID == core_index[edge.target])
+            {
+                continue;
+            }
+            const NodeID source = core_index[edge.source];
+            const NodeID target = core_index[edge.target];
+            if (edge.data.forward)
+            {
+                arcs.push_back(Arc{source, target, edge.data.distance});
+            }
+            if (edge.data.backward)
+            {
+                arcs.push_back(Arc{target, source, edge.data.distance});
+            }
+        }
+        forward_graph = Graph(number_of_core_nodes, arcs, false);
+        backward_graph = Graph(number_of_core_nodes, arcs, true);
+    }
+
+    NodeID GetNumberOfCoreNodes() const { return forward_graph.NumberOfNodes(); }
+
+    // Picks landmarks far away from each other: every further landmark is the core node with
+    // the largest round trip to its closest landmark. Nodes that no landmark reaches come first.
+    std::vector<EdgeWeight> ComputeDistances(const unsigned number_of_landmarks) const
+    {
+        const auto number_of_core_nodes = GetNumberOfCoreNodes();
+        const unsigned used_landmarks =
+            std::min<unsigned>(number_of_landmarks, number_of_core_nodes);
+        std::vector<EdgeWeight> distances(2 * used_landmarks * number_of_core_nodes,
+                                          INVALID_EDGE_WEIGHT);
+        if (0 == used_landmarks)
+        {
+            return distances;
+        }
+
+        // start far away from an arbitrary node
+        std::vector<EdgeWeight> from_landmark(number_of_core_nodes);
+        std::vector<EdgeWeight> to_landmark(number_of_core_nodes);
+        forward_graph.Dijkstra(0, from_landmark);
+        NodeID landmark = static_cast<NodeID>(
+            std::max_element(from_landmark.begin(), from_landmark.end(),
+                             [](const EdgeWeight lhs, const EdgeWeight rhs)
+                             {
+                                 // unreachable nodes are no candidates
+                                 return (lhs == INVALID_EDGE_WEIGHT ? -1 : lhs) <
+                                        (rhs == INVALID_EDGE_WEIGHT ? -1 : rhs);
+                             }) -
+            from_landmark.begin());
+
+        std::vector<std::int64_t> round_trip_to_closest(number_of_core_nodes,
+                                                        std::numeric_limits<std::int64_t>::max());
+        for (const auto l : util::irange(0u, used_landmarks))
+        {
+            tbb::parallel_invoke(
+                [&]
+                {
+                    forward_graph.Dijkstra(landmark, from_landmark);
+                },
+                [&]
+                {
+                    backward_graph.Dijkstra(landmark, to_landmark);
+                });
+
+            for (const auto node : util::irange<NodeID>(0, number_of_core_nodes))
+            {
+                distances[2 * (node * used_landmarks + l)] = from_landmark[node];
+                distances[2 * (node * used_landmarks + l) + 1] = to_landmark[node];
+
+                if (INVALID_EDGE_WEIGHT != from_landmark[node] &&
+                    INVALID_EDGE_WEIGHT != to_landmark[node])
+                {
+                    const std::int64_t round_trip =
+                        static_cast<std::int64_t>(from_landmark[node]) + to_landmark[node];
+                    round_trip_to_closest[node] = std::min(round_trip_to_closest[node], round_trip);
+                }
+            }
+            round_trip_to_closest[landmark] = 0;
+
+            landmark = static_cast<NodeID>(
+                std::max_element(round_trip_to_closest.begin(), round_trip_to_closest.end()) -
+                round_trip_to_closest.begin());
+        }
+        return distances;
+    }
+
+  private:
+    struct Arc
+    {
+        NodeID source;
+        NodeID target;
+        EdgeWeight weight;
+    };
+
+    // adjacency array of the core in one direction
+    class Graph
+    {
+      public:
+        Graph() = default;
+
+        Graph(const NodeID number_of_nodes, const std::vector<Arc> &arcs, const bool reversed)
+            : first_arc(number_of_nodes + 1, 0), targets(arcs.size()), weights(arcs.size())
+        {
+            for (const auto &arc : arcs)
+            {
+                ++first_arc[(reversed ? arc.target : arc.source) + 1];
+            }
+            std::partial_sum(first_arc.begin(), first_arc.end(), first_arc.begin());
+            std::vector<std::size_t> position(first_arc.begin(), first_arc.end() - 1);
+            for (const auto &arc : arcs)
+            {
+                const auto index = position[reversed ? arc.target : arc.source]++;
+                targets[index] = reversed ? arc.source : arc.target;
+                weights[index] = arc.weight;
+            }
+        }
+
+        NodeID NumberOfNodes() const
+        {
+            return static_cast<NodeID>(first_arc.empty() ? 0 : first_arc.size() - 1);
+        }
+
+        void Dijkstra(const NodeID source, std::vector<EdgeWeight> &distances) const
+        {
+            std::fill(distances.begin(), distances.end(), INVALID_EDGE_WEIGHT);
+            Heap heap(NumberOfNodes());
+            heap.Insert(source, 0, HeapData());
+            while (!heap.Empty())
+            {
+                const NodeID node = heap.DeleteMin();
+                const EdgeWeight distance = heap.GetKey(node);
+                distances[node] = distance;
+                for (auto arc = first_arc[node]; arc != first_arc[node + 1]; ++arc)
+                {
+                    const NodeID to = targets[arc];
+                    const EdgeWeight to_distance = distance + weights[arc];
+                    if (!heap.WasInserted(to))
+                    {
+                        heap.Insert(to, to_distance, HeapData());
+                    }
+                    else if (to_distance < heap.GetKey(to))
+                    {
+                        heap.DecreaseKey(to, to_distance);
+                    }
+                }
+            }
+        }
+
+      private:
+        struct HeapData
+        {
+        };
+        using Heap = util::BinaryHeap<NodeID, NodeID, EdgeWeight, HeapData>;
+
+        std::vector<std::size_t> first_arc;
+        std::vector<NodeID> targets;
+        std::vector<EdgeWeight> weights;
+    };
+
+    std::vector<NodeID> core_index;
+    Graph forward_graph;
+    Graph backward_graph;
+};
+}
+}
+
+#endif // CORE_LANDMARKS_HPP
@@ -31,6 +31,12 @@ namespace osrm
 namespace contractor
 {
 
+// Heap of the witness searches. Any heap with the interface of util::BinaryHeap can be plugged
+// in here, e.g. util::DAryHeap. heap-bench compares them on recorded searches.
+template <typename Data>
+using ContractorHeapPolicy =
+    util::BinaryHeap<NodeID, NodeID, int, Data, util::XORFastHashStorage<NodeID, NodeID>>;
+
 class GraphContractor
 {
   private:
@@ -71,14 +77,7 @@ class GraphContractor
     };
 
     using ContractorGraph = util::DynamicGraph<ContractorEdgeData>;
-    //    using ContractorHeap = util::BinaryHeap<NodeID, NodeID, int, ContractorHeapData,
-    //    ArrayStorage<NodeID, NodeID>
-    //    >;
-    using ContractorHeap = util::BinaryHeap<NodeID,
-                                            NodeID,
-                                            int,
-                                            ContractorHeapData,
-                                            util::XORFastHashStorage<NodeID, NodeID>>;
+    using ContractorHeap = ContractorHeapPolicy<ContractorHeapData>;
     using ContractorEdge = ContractorGraph::InputEdge;
 
     struct ContractorThreadData
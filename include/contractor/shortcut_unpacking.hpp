@@ -0,0 +1,184 @@
+#ifndef SHORTCUT_UNPACKING_HPP
+#define SHORTCUT_UNPACKING_HPP
+
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <limits>
+#include <stack>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace contractor
+{
+
+// An original edge of an unpacked shortcut: the node it is traversed from and its id in the
+// search graph, which holds the id and the weight of the edge-based edge.
+struct UnpackedShortcutEdge
+{
+    NodeID source;
+    EdgeID edge;
+};
+
+// Shortcuts are stored at one of their nodes and may be traversed in both directions,
+// the unpacking of a direction is looked up by the id of the edge and the direction.
+inline unsigned GetShortcutUnpackingKey(const EdgeID edge, const bool reversed)
+{
+    BOOST_ASSERT(edge < std::numeric_limits<unsigned>::max() / 2);
+    return 2 * edge + (reversed ? 1 : 0);
+}
+
+// Finds the edge that is unpacked for from -> to: the smallest forward edge stored at from, if
+// there is none the smallest backward edge stored at to. reversed tells which one was found.
+// This is the choice BasicRoutingInterface::UnpackPath makes when unpacking on the fly.
+template <typename GraphT>
+EdgeID FindUnpackingEdge(const GraphT &graph, const NodeID from, const NodeID to, bool &reversed)
+{
+    EdgeID smaller_edge_id = SPECIAL_EDGEID;
+    EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
+    for (const auto edge_id : graph.GetAdjacentEdgeRange(from))
+    {
+        const EdgeWeight weight = graph.GetEdgeData(edge_id).distance;
+        if ((graph.GetTarget(edge_id) == to) && (weight < edge_weight) &&
+            graph.GetEdgeData(edge_id).forward)
+        {
+            smaller_edge_id = edge_id;
+            edge_weight = weight;
+        }
+    }
+    reversed = false;
+    if (SPECIAL_EDGEID == smaller_edge_id)
+    {
+        reversed = true;
+        for (const auto edge_id : graph.GetAdjacentEdgeRange(to))
+        {
+            const EdgeWeight weight = graph.GetEdgeData(edge_id).distance;
+            if ((graph.GetTarget(edge_id) == from) && (weight < edge_weight) &&
+                graph.GetEdgeData(edge_id).backward)
+            {
+                smaller_edge_id = edge_id;
+                edge_weight = weight;
+            }
+        }
+    }
+    return smaller_edge_id;
+}
+
+// Flat store of the original edges of the shortcuts that unpack into many of them, so queries
+// copy them instead of searching the adjacency lists at every level of the hierarchy.
+// The shortcuts are sorted by key, the edges of the i-th one are [offsets[i], offsets[i + 1]).
+struct ShortcutUnpackingTable
+{
+    std::vector<unsigned> keys;
+    std::vector<unsigned> offsets;
+    std::vector<UnpackedShortcutEdge> edges;
+
+    // Unpacks every direction of the shortcuts of the graph that consists of at least
+    // min_number_of_edges original edges.
+    template <typename GraphT>
+    ShortcutUnpackingTable(const GraphT &graph, const unsigned min_number_of_edges)
+    {
+        offsets.push_back(0);
+        if (0 == min_number_of_edges)
+        {
+            return;
+        }
+
+        // number of original edges per key, computed on demand, 0 if not yet known
+        std::vector<unsigned> number_of_edges(2 * graph.GetNumberOfEdges(), 0);
+        for (const auto node : util::irange(0u, graph.GetNumberOfNodes()))
+        {
+            for (const auto edge : graph.GetAdjacentEdgeRange(node))
+            {
+                const auto &data = graph.GetEdgeData(edge);
+                if (!data.shortcut)
+                {
+                    continue;
+                }
+                const NodeID target = graph.GetTarget(edge);
+                for (const bool reversed : {false, true})
+                {
+                    if (!(reversed ? data.backward : data.forward))
+                    {
+                        continue;
+                    }
+                    const NodeID from = reversed ? target : node;
+                    const NodeID to = reversed ? node : target;
+                    // the edge might not be the one unpacking picks, e.g. if it is a duplicate
+                    bool found_reversed;
+                    if (FindUnpackingEdge(graph, from, to, found_reversed) != edge ||
+                        found_reversed != reversed)
+                    {
+                        continue;
+                    }
+                    if (CountEdges(graph, from, to, number_of_edges) >= min_number_of_edges)
+                    {
+                        keys.push_back(GetShortcutUnpackingKey(edge, reversed));
+                        Unpack(graph, from, to);
+                        offsets.push_back(static_cast<unsigned>(edges.size()));
+                    }
+                }
+            }
+        }
+    }
+
+    ShortcutUnpackingTable() { offsets.push_back(0); }
+
+  private:
+    template <typename GraphT>
+    static unsigned CountEdges(const GraphT &graph,
+                               const NodeID from,
+                               const NodeID to,
+                               std::vector<unsigned> &counts)
+    {
+        bool reversed;
+        const EdgeID edge = FindUnpackingEdge(graph, from, to, reversed);
+        BOOST_ASSERT(SPECIAL_EDGEID != edge);
+        const auto &data = graph.GetEdgeData(edge);
+        if (!data.shortcut)
+        {
+            return 1;
+        }
+        auto &count = counts[GetShortcutUnpackingKey(edge, reversed)];
+        if (0 == count)
+        {
+            // the middle node is contracted before both ends, so this terminates
+            count = CountEdges(graph, from, data.id, counts) +
+                    CountEdges(graph, data.id, to, counts);
+        }
+        return count;
+    }
+
+    template <typename GraphT> void Unpack(const GraphT &graph, const NodeID from, const NodeID to)
+    {
+        std::stack<std::pair<NodeID, NodeID>> recursion_stack;
+        recursion_stack.emplace(from, to);
+        while (!recursion_stack.empty())
+        {
+            const auto edge = recursion_stack.top();
+            recursion_stack.pop();
+
+            bool reversed;
+            const EdgeID edge_id = FindUnpackingEdge(graph, edge.first, edge.second, reversed);
+            BOOST_ASSERT(SPECIAL_EDGEID != edge_id);
+            const auto &data = graph.GetEdgeData(edge_id);
+            if (data.shortcut)
+            {
+                recursion_stack.emplace(data.id, edge.second);
+                recursion_stack.emplace(edge.first, data.id);
+            }
+            else
+            {
+                edges.push_back(UnpackedShortcutEdge{edge.first, edge_id});
+            }
+        }
+    }
+};
+}
+}
+
+#endif // SHORTCUT_UNPACKING_HPP
@@ -7,7 +7,9 @@
 #include "engine/internal_route_result.hpp"
 #include "engine/object_encoder.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/polyline_compressor.hpp"
 #include "engine/polyline_formatter.hpp"
+#include "engine/protobuf_response.hpp"
 #include "engine/route_name_extraction.hpp"
 #include "engine/segment_information.hpp"
 #include "extractor/turn_instructions.hpp"
@@ -15,6 +17,7 @@
 #include "osrm/json_container.hpp"
 #include "osrm/route_parameters.hpp"
 #include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
@@ -24,6 +27,7 @@
 #include <cmath>
 
 #include <limits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -57,6 +61,12 @@ template <typename DataFacadeT> class ApiResponseGenerator
                        const InternalRouteResult &raw_route,
                        util::json::Object &json_result);
 
+    // Same as DescribeRoute, but writes the compact binary response instead of building JSON.
+    // Turn instructions are not part of the binary response.
+    void EncodeRoute(const RouteParameters &config,
+                     const InternalRouteResult &raw_route,
+                     std::string &buffer) const;
+
     // The following functions allow access to the different parts of the Describe Route
     // functionality.
     // For own responses, they can be used to generate only subsets of the information.
@@ -78,6 +88,13 @@ template <typename DataFacadeT> class ApiResponseGenerator
     // adds checksum and locations
     util::json::Object BuildHintData(const InternalRouteResult &raw_route) const;
 
+    void EncodeRouteSummary(protozero::pbf_writer &route_writer,
+                            const InternalRouteResult &raw_route,
+                            const Segments &segment_list) const;
+    void EncodeGeometry(protozero::pbf_writer &route_writer,
+                        const bool return_encoded,
+                        const Segments &segment_list) const;
+
   private:
     // data access to translate ids back into names
     DataFacade *facade;
@@ -181,6 +198,95 @@ void ApiResponseGenerator<DataFacadeT>::DescribeRoute(const RouteParameters &con
     json_result.values["hint_data"] = BuildHintData(raw_route);
 }
 
+template <typename DataFacadeT>
+void ApiResponseGenerator<DataFacadeT>::EncodeRoute(const RouteParameters &config,
+                                                    const InternalRouteResult &raw_route,
+                                                    std::string &buffer) const
+{
+    if (!raw_route.is_valid())
+    {
+        return;
+    }
+    const constexpr bool ALLOW_SIMPLIFICATION = true;
+    const constexpr bool EXTRACT_ROUTE = false;
+    const constexpr bool EXTRACT_ALTERNATIVE = true;
+    Segments segment_list(raw_route, EXTRACT_ROUTE, config.zoom_level, ALLOW_SIMPLIFICATION,
+                          facade);
+
+    // names are chosen to tell the main route and the alternative apart
+    auto path_segments = BuildRouteSegments(segment_list);
+    std::unique_ptr<Segments> alternate_segment_list;
+    RouteNames route_names;
+    if (raw_route.has_alternative())
+    {
+        alternate_segment_list = util::make_unique<Segments>(
+            raw_route, EXTRACT_ALTERNATIVE, config.zoom_level, ALLOW_SIMPLIFICATION, facade);
+        auto alternate_segments = BuildRouteSegments(*alternate_segment_list);
+        route_names = extractRouteNames(path_segments, alternate_segments, facade);
+    }
+    else
+    {
+        std::vector<detail::Segment> alternate_segments;
+        route_names = extractRouteNames(path_segments, alternate_segments, facade);
+    }
+
+    protozero::pbf_writer response_writer(buffer);
+    {
+        protozero::pbf_writer route_writer(response_writer, pbf::response::route);
+        EncodeRouteSummary(route_writer, raw_route, segment_list);
+        {
+            // the source of the first leg followed by the targets of all legs
+            protozero::packed_field_sint32 via_points(route_writer, pbf::route::via_points);
+            util::FixedPointCoordinate previous(0, 0);
+            const auto add_via_point = [&via_points, &previous](
+                const util::FixedPointCoordinate &location)
+            {
+                via_points.add_element(location.lat - previous.lat);
+                via_points.add_element(location.lon - previous.lon);
+                previous = location;
+            };
+            add_via_point(raw_route.segment_end_coordinates.front().source_phantom.location);
+            for (const PhantomNodes &nodes : raw_route.segment_end_coordinates)
+            {
+                add_via_point(nodes.target_phantom.location);
+            }
+        }
+        route_writer.add_packed_uint32(pbf::route::via_indices,
+                                       segment_list.GetViaIndices().begin(),
+                                       segment_list.GetViaIndices().end());
+        if (config.geometry)
+        {
+            EncodeGeometry(route_writer, config.compression, segment_list);
+        }
+        route_writer.add_string(pbf::route::names, route_names.shortest_path_name_1);
+        route_writer.add_string(pbf::route::names, route_names.shortest_path_name_2);
+    }
+
+    if (alternate_segment_list)
+    {
+        protozero::pbf_writer alternative_writer(response_writer, pbf::response::alternative);
+        EncodeRouteSummary(alternative_writer, raw_route, *alternate_segment_list);
+        alternative_writer.add_packed_uint32(pbf::route::via_indices,
+                                             alternate_segment_list->GetViaIndices().begin(),
+                                             alternate_segment_list->GetViaIndices().end());
+        if (config.geometry)
+        {
+            EncodeGeometry(alternative_writer, config.compression, *alternate_segment_list);
+        }
+        alternative_writer.add_string(pbf::route::names, route_names.alternative_path_name_1);
+        alternative_writer.add_string(pbf::route::names, route_names.alternative_path_name_2);
+    }
+
+    protozero::pbf_writer hints_writer(response_writer, pbf::response::hints);
+    hints_writer.add_uint32(pbf::hints::checksum, facade->GetCheckSum());
+    for (const PhantomNodes &nodes : raw_route.segment_end_coordinates)
+    {
+        hints_writer.add_string(pbf::hints::locations, encodeBase64(nodes.source_phantom));
+    }
+    hints_writer.add_string(pbf::hints::locations,
+                            encodeBase64(raw_route.segment_end_coordinates.back().target_phantom));
+}
+
 template <typename DataFacadeT>
 util::json::Object
 ApiResponseGenerator<DataFacadeT>::SummarizeRoute(const InternalRouteResult &raw_route,
@@ -287,6 +393,48 @@ ApiResponseGenerator<DataFacadeT>::BuildHintData(const InternalRouteResult &raw_
     return json_hint_object;
 }
 
+template <typename DataFacadeT>
+void ApiResponseGenerator<DataFacadeT>::EncodeRouteSummary(protozero::pbf_writer &route_writer,
+                                                           const InternalRouteResult &raw_route,
+                                                           const Segments &segment_list) const
+{
+    route_writer.add_uint32(pbf::route::total_time, segment_list.GetDuration());
+    route_writer.add_uint32(pbf::route::total_distance, segment_list.GetDistance());
+    if (!raw_route.segment_end_coordinates.empty())
+    {
+        const auto start_name_id = raw_route.segment_end_coordinates.front().source_phantom.name_id;
+        route_writer.add_string(pbf::route::start_point, facade->get_name_for_id(start_name_id));
+        const auto destination_name_id =
+            raw_route.segment_end_coordinates.back().target_phantom.name_id;
+        route_writer.add_string(pbf::route::end_point,
+                                facade->get_name_for_id(destination_name_id));
+    }
+}
+
+template <typename DataFacadeT>
+void ApiResponseGenerator<DataFacadeT>::EncodeGeometry(protozero::pbf_writer &route_writer,
+                                                       const bool return_encoded,
+                                                       const Segments &segment_list) const
+{
+    if (return_encoded)
+    {
+        route_writer.add_string(pbf::route::encoded_geometry, polylineEncode(segment_list.Get()));
+        return;
+    }
+
+    protozero::packed_field_sint32 geometry(route_writer, pbf::route::geometry);
+    util::FixedPointCoordinate previous(0, 0);
+    for (const auto &segment : segment_list.Get())
+    {
+        if (segment.necessary)
+        {
+            geometry.add_element(segment.location.lat - previous.lat);
+            geometry.add_element(segment.location.lon - previous.lon);
+            previous = segment.location;
+        }
+    }
+}
+
 template <typename DataFacadeT>
 ApiResponseGenerator<DataFacadeT> MakeApiResponseGenerator(DataFacadeT *facade)
 {
@@ -3,6 +3,7 @@
 
 // Exposes all data access interfaces to the algorithms via base class ptr
 
+#include "contractor/shortcut_unpacking.hpp"
 #include "extractor/edge_based_node.hpp"
 #include "extractor/external_memory_node.hpp"
 #include "engine/phantom_node.hpp"
@@ -28,6 +29,8 @@ namespace datafacade
 {
 
 using EdgeRange = util::range<EdgeID>;
+using UnpackedShortcutRange =
+    std::pair<const contractor::UnpackedShortcutEdge *, const contractor::UnpackedShortcutEdge *>;
 
 template <class EdgeDataT> class BaseDataFacade
 {
@@ -59,6 +62,11 @@ template <class EdgeDataT> class BaseDataFacade
 
     virtual EdgeID FindEdgeInEitherDirection(const NodeID from, const NodeID to) const = 0;
 
+    // original edges of the shortcut in the given direction if osrm-contract stored them,
+    // an empty range otherwise. See contractor::FindUnpackingEdge for the direction.
+    virtual UnpackedShortcutRange GetUnpackedShortcut(const EdgeID id,
+                                                      const bool reversed) const = 0;
+
     virtual EdgeID
     FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const = 0;
 
@@ -106,6 +114,22 @@ template <class EdgeDataT> class BaseDataFacade
 
     virtual std::size_t GetCoreSize() const = 0;
 
+    // false if the contraction levels are missing or do not fit the hierarchy
+    virtual bool HasSweepRanks() const = 0;
+
+    // position of a node in a top-down sweep over the hierarchy, see util::ComputeSweepRanks
+    virtual NodeID GetSweepRank(const NodeID id) const = 0;
+
+    // node at the given position of the sweep, the inverse of GetSweepRank
+    virtual NodeID GetNodeAtSweepRank(const NodeID rank) const = 0;
+
+    // 0 if the core has no landmarks or they do not fit it
+    virtual unsigned GetNumberOfCoreLandmarks() const = 0;
+
+    // distances from and to every landmark, interleaved as in contractor::CoreLandmarks,
+    // nullptr for nodes outside of the core
+    virtual const EdgeWeight *GetCoreLandmarkDistances(const NodeID id) const = 0;
+
     virtual std::string GetTimestamp() const = 0;
 };
 }
@@ -12,6 +12,8 @@
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/sweep_ranks.hpp"
+#include "util/integer_range.hpp"
 #include "util/range_table.hpp"
 #include "util/graph_loader.hpp"
 #include "util/simple_logger.hpp"
@@ -74,6 +76,14 @@ template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacad
     util::ShM<unsigned, false>::vector m_geometry_indices;
     util::ShM<unsigned, false>::vector m_geometry_list;
     util::ShM<bool, false>::vector m_is_core_node;
+    util::ShM<NodeID, false>::vector m_sweep_ranks;
+    util::ShM<NodeID, false>::vector m_sweep_order;
+    util::ShM<NodeID, false>::vector m_core_landmark_index;
+    util::ShM<EdgeWeight, false>::vector m_core_landmark_distances;
+    unsigned m_number_of_core_landmarks = 0;
+    util::ShM<unsigned, false>::vector m_shortcut_keys;
+    util::ShM<unsigned, false>::vector m_shortcut_offsets;
+    util::ShM<contractor::UnpackedShortcutEdge, false>::vector m_shortcut_edges;
 
     boost::thread_specific_ptr<InternalRTree> m_static_rtree;
     boost::thread_specific_ptr<InternalGeospatialQuery> m_geospatial_query;
@@ -197,6 +207,91 @@ template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacad
         }
     }
 
+    void LoadSweepRanks(const boost::filesystem::path &level_data_file)
+    {
+        boost::filesystem::ifstream level_stream(level_data_file, std::ios::binary);
+        unsigned number_of_levels = 0;
+        level_stream.read((char *)&number_of_levels, sizeof(unsigned));
+
+        std::vector<float> node_levels(number_of_levels);
+        level_stream.read((char *)node_levels.data(), sizeof(float) * number_of_levels);
+
+        m_sweep_ranks = util::ComputeSweepRanks(node_levels, *m_query_graph);
+        if (m_sweep_ranks.empty())
+        {
+            util::SimpleLogger().Write(logWARNING)
+                << level_data_file << " does not match the hierarchy, PHAST queries are disabled";
+        }
+        m_sweep_order = util::ComputeSweepOrder(m_sweep_ranks);
+    }
+
+    void LoadCoreLandmarks(const boost::filesystem::path &landmarks_data_file)
+    {
+        boost::filesystem::ifstream landmarks_stream(landmarks_data_file, std::ios::binary);
+        unsigned number_of_landmarks = 0;
+        unsigned number_of_core_nodes = 0;
+        landmarks_stream.read((char *)&number_of_landmarks, sizeof(unsigned));
+        landmarks_stream.read((char *)&number_of_core_nodes, sizeof(unsigned));
+        if (number_of_landmarks == 0)
+        {
+            return;
+        }
+
+        // core nodes are numbered by increasing node id
+        m_core_landmark_index.resize(m_is_core_node.size(), SPECIAL_NODEID);
+        NodeID core_index = 0;
+        for (const auto node : util::irange<std::size_t>(0, m_is_core_node.size()))
+        {
+            if (m_is_core_node[node])
+            {
+                m_core_landmark_index[node] = core_index++;
+            }
+        }
+        if (core_index != number_of_core_nodes)
+        {
+            util::SimpleLogger().Write(logWARNING) << landmarks_data_file
+                                                   << " does not match the core";
+            m_core_landmark_index.clear();
+            return;
+        }
+
+        m_core_landmark_distances.resize(2 * number_of_landmarks * number_of_core_nodes);
+        landmarks_stream.read((char *)m_core_landmark_distances.data(),
+                              sizeof(EdgeWeight) * m_core_landmark_distances.size());
+        m_number_of_core_landmarks = number_of_landmarks;
+    }
+
+    void LoadShortcutUnpacking(const boost::filesystem::path &shortcuts_data_file)
+    {
+        boost::filesystem::ifstream shortcuts_stream(shortcuts_data_file, std::ios::binary);
+        unsigned checksum = 0;
+        unsigned number_of_shortcuts = 0;
+        unsigned number_of_unpacked_edges = 0;
+        shortcuts_stream.read((char *)&checksum, sizeof(unsigned));
+        shortcuts_stream.read((char *)&number_of_shortcuts, sizeof(unsigned));
+        shortcuts_stream.read((char *)&number_of_unpacked_edges, sizeof(unsigned));
+        if (number_of_shortcuts == 0)
+        {
+            return;
+        }
+        if (checksum != m_check_sum)
+        {
+            util::SimpleLogger().Write(logWARNING) << shortcuts_data_file
+                                                   << " does not match the search graph";
+            return;
+        }
+
+        m_shortcut_keys.resize(number_of_shortcuts);
+        shortcuts_stream.read((char *)m_shortcut_keys.data(),
+                              sizeof(unsigned) * number_of_shortcuts);
+        m_shortcut_offsets.resize(number_of_shortcuts + 1);
+        shortcuts_stream.read((char *)m_shortcut_offsets.data(),
+                              sizeof(unsigned) * m_shortcut_offsets.size());
+        m_shortcut_edges.resize(number_of_unpacked_edges);
+        shortcuts_stream.read((char *)m_shortcut_edges.data(),
+                              sizeof(contractor::UnpackedShortcutEdge) * number_of_unpacked_edges);
+    }
+
     void LoadGeometries(const boost::filesystem::path &geometry_file)
     {
         std::ifstream geometry_stream(geometry_file.string().c_str(), std::ios::binary);
@@ -284,6 +379,33 @@ template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacad
         util::SimpleLogger().Write() << "loading core information";
         LoadCoreInformation(file_for("coredata"));
 
+        // optional, without node levels tables are always computed with bucket searches
+        const auto level_data_path = server_paths.find("leveldata");
+        if (level_data_path != end_it &&
+            boost::filesystem::is_regular_file(level_data_path->second))
+        {
+            util::SimpleLogger().Write() << "loading node levels";
+            LoadSweepRanks(level_data_path->second);
+        }
+
+        // optional, without landmarks the core is searched without goal direction
+        const auto landmarks_data_path = server_paths.find("landmarksdata");
+        if (landmarks_data_path != end_it &&
+            boost::filesystem::is_regular_file(landmarks_data_path->second))
+        {
+            util::SimpleLogger().Write() << "loading core landmarks";
+            LoadCoreLandmarks(landmarks_data_path->second);
+        }
+
+        // optional, without it all shortcuts are unpacked by searching the graph
+        const auto shortcuts_data_path = server_paths.find("shortcutsdata");
+        if (shortcuts_data_path != end_it &&
+            boost::filesystem::is_regular_file(shortcuts_data_path->second))
+        {
+            util::SimpleLogger().Write() << "loading unpacked shortcuts";
+            LoadShortcutUnpacking(shortcuts_data_path->second);
+        }
+
         util::SimpleLogger().Write() << "loading geometries";
         LoadGeometries(file_for("geometries"));
 
@@ -331,6 +453,27 @@ template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacad
         return m_query_graph->FindEdgeInEitherDirection(from, to);
     }
 
+    UnpackedShortcutRange GetUnpackedShortcut(const EdgeID id,
+                                              const bool reversed) const override final
+    {
+        if (m_shortcut_keys.empty())
+        {
+            return UnpackedShortcutRange(nullptr, nullptr);
+        }
+        const unsigned key = contractor::GetShortcutUnpackingKey(id, reversed);
+        const unsigned *keys_begin = &m_shortcut_keys[0];
+        const unsigned *keys_end = keys_begin + m_shortcut_keys.size();
+        const auto iter = std::lower_bound(keys_begin, keys_end, key);
+        if (iter == keys_end || *iter != key)
+        {
+            return UnpackedShortcutRange(nullptr, nullptr);
+        }
+        const auto index = iter - keys_begin;
+        const contractor::UnpackedShortcutEdge *edges = &m_shortcut_edges[0];
+        return UnpackedShortcutRange(edges + m_shortcut_offsets[index],
+                                     edges + m_shortcut_offsets[index + 1]);
+    }
+
     EdgeID
     FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const override final
     {
@@ -452,6 +595,30 @@ template <class EdgeDataT> class InternalDataFacade final : public BaseDataFacad
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    bool HasSweepRanks() const override final { return !m_sweep_ranks.empty(); }
+
+    NodeID GetSweepRank(const NodeID id) const override final { return m_sweep_ranks[id]; }
+
+    NodeID GetNodeAtSweepRank(const NodeID rank) const override final
+    {
+        return m_sweep_order[rank];
+    }
+
+    unsigned GetNumberOfCoreLandmarks() const override final
+    {
+        return m_number_of_core_landmarks;
+    }
+
+    const EdgeWeight *GetCoreLandmarkDistances(const NodeID id) const override final
+    {
+        if (0 == m_number_of_core_landmarks || SPECIAL_NODEID == m_core_landmark_index[id])
+        {
+            return nullptr;
+        }
+        return &m_core_landmark_distances[2 * m_number_of_core_landmarks *
+                                          m_core_landmark_index[id]];
+    }
+
     virtual bool IsCoreNode(const NodeID id) const override final
     {
         if (m_is_core_node.size() > 0)
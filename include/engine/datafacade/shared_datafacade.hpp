@@ -13,6 +13,7 @@
 #include "util/static_rtree.hpp"
 #include "util/make_unique.hpp"
 #include "util/simple_logger.hpp"
+#include "util/sweep_ranks.hpp"
 #include "util/rectangle.hpp"
 
 #include <cstddef>
@@ -79,6 +80,15 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
     util::ShM<unsigned, true>::vector m_geometry_indices;
     util::ShM<unsigned, true>::vector m_geometry_list;
     util::ShM<bool, true>::vector m_is_core_node;
+    util::ShM<NodeID, true>::vector m_sweep_ranks;
+    // not in shared memory, every process inverts the ranks when it loads them
+    std::vector<NodeID> m_sweep_order;
+    util::ShM<NodeID, true>::vector m_core_landmark_index;
+    util::ShM<EdgeWeight, true>::vector m_core_landmark_distances;
+    unsigned m_number_of_core_landmarks = 0;
+    util::ShM<unsigned, true>::vector m_shortcut_keys;
+    util::ShM<unsigned, true>::vector m_shortcut_offsets;
+    util::ShM<contractor::UnpackedShortcutEdge, true>::vector m_shortcut_edges;
 
     boost::thread_specific_ptr<std::pair<unsigned, std::shared_ptr<SharedRTree>>> m_static_rtree;
     boost::thread_specific_ptr<SharedGeospatialQuery> m_geospatial_query;
@@ -205,6 +215,72 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
         m_is_core_node = std::move(is_core_node);
     }
 
+    void LoadSweepRanks()
+    {
+        auto sweep_ranks_ptr =
+            data_layout->GetBlockPtr<NodeID>(shared_memory, storage::SharedDataLayout::SWEEP_RANKS);
+        const auto number_of_ranks =
+            data_layout->num_entries[storage::SharedDataLayout::SWEEP_RANKS];
+        // osrm-datastore invalidates ranks that do not fit the hierarchy
+        if (number_of_ranks <= 0 || SPECIAL_NODEID == sweep_ranks_ptr[0])
+        {
+            m_sweep_ranks = typename util::ShM<NodeID, true>::vector();
+            m_sweep_order.clear();
+            return;
+        }
+
+        typename util::ShM<NodeID, true>::vector sweep_ranks(sweep_ranks_ptr, number_of_ranks);
+        m_sweep_ranks = std::move(sweep_ranks);
+        m_sweep_order = util::ComputeSweepOrder(m_sweep_ranks);
+    }
+
+    void LoadCoreLandmarks()
+    {
+        // osrm-datastore leaves the blocks empty if the landmarks do not fit the core
+        m_number_of_core_landmarks = *data_layout->GetBlockPtr<unsigned>(
+            shared_memory, storage::SharedDataLayout::CORE_LANDMARK_COUNT);
+        if (m_number_of_core_landmarks == 0)
+        {
+            m_core_landmark_index = typename util::ShM<NodeID, true>::vector();
+            m_core_landmark_distances = typename util::ShM<EdgeWeight, true>::vector();
+            return;
+        }
+
+        typename util::ShM<NodeID, true>::vector core_landmark_index(
+            data_layout->GetBlockPtr<NodeID>(shared_memory,
+                                             storage::SharedDataLayout::CORE_LANDMARK_INDEX),
+            data_layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_INDEX]);
+        m_core_landmark_index = std::move(core_landmark_index);
+
+        typename util::ShM<EdgeWeight, true>::vector core_landmark_distances(
+            data_layout->GetBlockPtr<EdgeWeight>(
+                shared_memory, storage::SharedDataLayout::CORE_LANDMARK_DISTANCES),
+            data_layout->num_entries[storage::SharedDataLayout::CORE_LANDMARK_DISTANCES]);
+        m_core_landmark_distances = std::move(core_landmark_distances);
+    }
+
+    void LoadShortcutUnpacking()
+    {
+        // osrm-datastore leaves the blocks empty if the shortcuts do not fit the search graph
+        typename util::ShM<unsigned, true>::vector shortcut_keys(
+            data_layout->GetBlockPtr<unsigned>(shared_memory,
+                                               storage::SharedDataLayout::SHORTCUT_KEYS),
+            data_layout->num_entries[storage::SharedDataLayout::SHORTCUT_KEYS]);
+        m_shortcut_keys = std::move(shortcut_keys);
+
+        typename util::ShM<unsigned, true>::vector shortcut_offsets(
+            data_layout->GetBlockPtr<unsigned>(shared_memory,
+                                               storage::SharedDataLayout::SHORTCUT_OFFSETS),
+            data_layout->num_entries[storage::SharedDataLayout::SHORTCUT_OFFSETS]);
+        m_shortcut_offsets = std::move(shortcut_offsets);
+
+        typename util::ShM<contractor::UnpackedShortcutEdge, true>::vector shortcut_edges(
+            data_layout->GetBlockPtr<contractor::UnpackedShortcutEdge>(
+                shared_memory, storage::SharedDataLayout::SHORTCUT_EDGES),
+            data_layout->num_entries[storage::SharedDataLayout::SHORTCUT_EDGES]);
+        m_shortcut_edges = std::move(shortcut_edges);
+    }
+
     void LoadGeometries()
     {
         auto geometries_compressed_ptr = data_layout->GetBlockPtr<unsigned>(
@@ -252,8 +328,10 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
         CheckAndReloadFacade();
     }
 
-    void CheckAndReloadFacade()
+    // returns true if a different dataset was loaded
+    bool CheckAndReloadFacade()
     {
+        bool reloaded = false;
         if (CURRENT_LAYOUT != data_timestamp_ptr->layout ||
             CURRENT_DATA != data_timestamp_ptr->data ||
             CURRENT_TIMESTAMP != data_timestamp_ptr->timestamp)
@@ -313,6 +391,10 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
                 LoadViaNodeList();
                 LoadNames();
                 LoadCoreInformation();
+                LoadSweepRanks();
+                LoadCoreLandmarks();
+                LoadShortcutUnpacking();
+                reloaded = true;
 
                 util::SimpleLogger().Write()
                     << "number of geometries: " << m_coordinate_list->size();
@@ -326,6 +408,7 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
             }
             util::SimpleLogger().Write(logDEBUG) << "Releasing exclusive lock";
         }
+        return reloaded;
     }
 
     // search graph access
@@ -365,6 +448,27 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
         return m_query_graph->FindEdgeInEitherDirection(from, to);
     }
 
+    UnpackedShortcutRange GetUnpackedShortcut(const EdgeID id,
+                                              const bool reversed) const override final
+    {
+        if (m_shortcut_keys.empty())
+        {
+            return UnpackedShortcutRange(nullptr, nullptr);
+        }
+        const unsigned key = contractor::GetShortcutUnpackingKey(id, reversed);
+        const unsigned *keys_begin = &m_shortcut_keys[0];
+        const unsigned *keys_end = keys_begin + m_shortcut_keys.size();
+        const auto iter = std::lower_bound(keys_begin, keys_end, key);
+        if (iter == keys_end || *iter != key)
+        {
+            return UnpackedShortcutRange(nullptr, nullptr);
+        }
+        const auto index = iter - keys_begin;
+        const contractor::UnpackedShortcutEdge *edges = &m_shortcut_edges[0];
+        return UnpackedShortcutRange(edges + m_shortcut_offsets[index],
+                                     edges + m_shortcut_offsets[index + 1]);
+    }
+
     EdgeID
     FindEdgeIndicateIfReverse(const NodeID from, const NodeID to, bool &result) const override final
     {
@@ -507,6 +611,30 @@ template <class EdgeDataT> class SharedDataFacade final : public BaseDataFacade<
 
     virtual std::size_t GetCoreSize() const override final { return m_is_core_node.size(); }
 
+    bool HasSweepRanks() const override final { return m_sweep_ranks.size() > 0; }
+
+    NodeID GetSweepRank(const NodeID id) const override final { return m_sweep_ranks[id]; }
+
+    NodeID GetNodeAtSweepRank(const NodeID rank) const override final
+    {
+        return m_sweep_order[rank];
+    }
+
+    unsigned GetNumberOfCoreLandmarks() const override final
+    {
+        return m_number_of_core_landmarks;
+    }
+
+    const EdgeWeight *GetCoreLandmarkDistances(const NodeID id) const override final
+    {
+        if (0 == m_number_of_core_landmarks || SPECIAL_NODEID == m_core_landmark_index[id])
+        {
+            return nullptr;
+        }
+        return &m_core_landmark_distances[2 * m_number_of_core_landmarks *
+                                          m_core_landmark_index[id]];
+    }
+
     std::string GetTimestamp() const override final { return m_timestamp; }
 };
 }
@@ -6,6 +6,8 @@
 #include "osrm/json_container.hpp"
 #include "osrm/osrm.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <string>
@@ -30,6 +32,10 @@ namespace engine
 {
 struct EngineConfig;
 struct RouteParameters;
+struct CachedResponse;
+struct ResponseCacheTicket;
+struct EngineStatistics;
+class ResponseCache;
 namespace plugins
 {
 class BasePlugin;
@@ -51,14 +57,34 @@ class Engine final
     Engine &operator=(const Engine &) = delete;
 
     int RunQuery(const RouteParameters &route_parameters, util::json::Object &json_result);
+    int RunQuery(const RouteParameters &route_parameters,
+                 util::json::Object &json_result,
+                 ResponseCacheTicket &ticket,
+                 std::shared_ptr<const CachedResponse> &cached_response);
+
+    void StoreResponse(const ResponseCacheTicket &ticket, CachedResponse response);
+
+    EngineStatistics GetStatistics() const;
 
   private:
+    // looks up the response cache first if a ticket is given
+    int RunQuery(const RouteParameters &route_parameters,
+                 util::json::Object &json_result,
+                 ResponseCacheTicket *ticket,
+                 std::shared_ptr<const CachedResponse> *cached_response);
+    // needs to be called while the query is counted
+    std::shared_ptr<const CachedResponse> LookupResponse(const RouteParameters &route_parameters,
+                                                         ResponseCacheTicket &ticket);
     void RegisterPlugin(plugins::BasePlugin *plugin);
     PluginMap plugin_map;
     // will only be initialized if shared memory is used
     std::unique_ptr<storage::SharedBarriers> barrier;
     // base class pointer to the objects
     datafacade::BaseDataFacade<contractor::QueryEdge::EdgeData> *query_data_facade;
+    // will only be initialized if a cache size is configured
+    std::unique_ptr<ResponseCache> response_cache;
+    // unlike the shared memory barrier this only counts queries of this process
+    std::atomic<std::uint64_t> running_queries;
 
     // decrease number of concurrent queries
     void decrease_concurrent_query_count();
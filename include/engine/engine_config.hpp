@@ -46,6 +46,19 @@ struct EngineConfig
     int max_locations_viaroute = -1;
     int max_locations_distance_table = -1;
     int max_locations_map_matching = -1;
+    // size of the response cache in bytes, 0 disables caching
+    std::size_t response_cache_size = 0;
+    // query heaps of datasets with at most this many nodes use dense storage instead of hash maps
+    std::size_t max_dense_heap_nodes = 0;
+    // tables with at least this many destinations sweep the hierarchy if the dataset has node
+    // levels, 0 always searches buckets
+    std::size_t min_phast_table_targets = 0;
+    // trips that are too large for brute force are improved by local search for this long
+    int trip_search_time = 0;
+    // seconds a map matching session is kept after its last request, 0 disables sessions
+    int matching_session_ttl = 0;
+    // traces with at least this many coordinates are matched in parts in parallel, 0 never
+    std::size_t min_parallel_matching_locations = 0;
     bool use_shared_memory = true;
 };
 
@@ -0,0 +1,22 @@
+#ifndef ENGINE_STATISTICS_HPP
+#define ENGINE_STATISTICS_HPP
+
+#include <cstdint>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Snapshot of the engine's load and the work its searches did since startup
+struct EngineStatistics
+{
+    // queries currently running in this process
+    std::uint64_t running_queries;
+    std::uint64_t heap_pops;
+    std::uint64_t edge_relaxations;
+};
+}
+}
+
+#endif // ENGINE_STATISTICS_HPP
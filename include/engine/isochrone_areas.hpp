@@ -0,0 +1,53 @@
+#ifndef ISOCHRONE_AREAS_HPP
+#define ISOCHRONE_AREAS_HPP
+
+#include "util/typedefs.hpp"
+#include "osrm/coordinate.hpp"
+
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Collects what is reached from a source within several travel time cutoffs. Every segment
+// around the source is added with its travel time, the area of a cutoff is the convex hull of
+// the segments, or parts of segments, reached in time.
+class IsochroneAreas
+{
+  public:
+    // cutoffs in deciseconds, sorted ascending. The source is part of every area.
+    IsochroneAreas(std::vector<EdgeWeight> weight_cutoffs,
+                   const util::FixedPointCoordinate source);
+
+    // Segment from one coordinate to the other on an edge-based node. The node is reached after
+    // distance, INVALID_EDGE_WEIGHT if not at all, and the segment starts offset after that. The
+    // source node is reached after minus the offset of the source, so parts of its segments
+    // behind the source are not reached.
+    void AddSegment(const EdgeWeight distance,
+                    const EdgeWeight offset,
+                    const EdgeWeight weight,
+                    const util::FixedPointCoordinate from,
+                    const util::FixedPointCoordinate to);
+
+    // segments that are at least partly reached within the largest cutoff
+    unsigned GetNumberOfReachedSegments() const { return number_of_reached_segments; }
+
+    // One convex hull per cutoff. The areas are nested, the hull of a smaller cutoff is part of
+    // every larger one.
+    std::vector<std::vector<util::FixedPointCoordinate>> GetAreas() const;
+
+  private:
+    // Adds the coordinate to the smallest cutoff it is reached in
+    void AddReachedCoordinate(const EdgeWeight weight, const util::FixedPointCoordinate coordinate);
+
+    const std::vector<EdgeWeight> weight_cutoffs;
+    // coordinates reached within weight_cutoffs[i] but not within any smaller cutoff
+    std::vector<std::vector<util::FixedPointCoordinate>> reached_coordinates;
+    unsigned number_of_reached_segments;
+};
+}
+}
+
+#endif // ISOCHRONE_AREAS_HPP
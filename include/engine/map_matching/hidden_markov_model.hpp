@@ -8,7 +8,10 @@
 
 #include <cmath>
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -48,79 +51,91 @@ struct TransitionLogProbability
     double operator()(const double d_t) const { return -log_beta - d_t / beta; }
 };
 
-template <class CandidateLists> struct HiddenMarkovModel
+// The states of all candidates of a trace. Every timestamp is a row with an entry per candidate,
+// the rows are stored back to back in flat arrays. A model keeps its memory when it is reset for
+// the next trace, so a model that is reused by a thread rarely allocates.
+struct HiddenMarkovModel
 {
-    std::vector<std::vector<double>> viterbi;
-    std::vector<std::vector<std::pair<unsigned, unsigned>>> parents;
-    std::vector<std::vector<float>> path_lengths;
-    std::vector<std::vector<bool>> pruned;
-    std::vector<std::vector<bool>> suspicious;
-    std::vector<bool> breakage;
-
-    const CandidateLists &candidates_list;
-    const EmissionLogProbability &emission_log_probability;
-
-    HiddenMarkovModel(const CandidateLists &candidates_list,
-                      const EmissionLogProbability &emission_log_probability)
-        : breakage(candidates_list.size()), candidates_list(candidates_list),
-          emission_log_probability(emission_log_probability)
+    // first entry of every row, the last one is the number of entries
+    std::vector<std::size_t> row_offsets;
+    // emission log probability of every candidate, they are used for many transitions
+    std::vector<double> emissions;
+    std::vector<double> viterbi;
+    std::vector<std::pair<unsigned, unsigned>> parents;
+    std::vector<float> path_lengths;
+    std::vector<std::uint8_t> pruned;
+    std::vector<std::uint8_t> suspicious;
+    // one per timestamp
+    std::vector<std::uint8_t> breakage;
+
+    template <class CandidateLists>
+    void reset(const CandidateLists &candidates_list,
+               const EmissionLogProbability &emission_log_probability)
     {
-        viterbi.resize(candidates_list.size());
-        parents.resize(candidates_list.size());
-        path_lengths.resize(candidates_list.size());
-        suspicious.resize(candidates_list.size());
-        pruned.resize(candidates_list.size());
+        row_offsets.resize(candidates_list.size() + 1);
+        row_offsets[0] = 0;
+        for (const auto t : util::irange<std::size_t>(0u, candidates_list.size()))
+        {
+            row_offsets[t + 1] = row_offsets[t] + candidates_list[t].size();
+        }
+
+        const auto number_of_entries = row_offsets.back();
+        emissions.resize(number_of_entries);
+        viterbi.resize(number_of_entries);
+        parents.resize(number_of_entries);
+        path_lengths.resize(number_of_entries);
+        pruned.resize(number_of_entries);
+        suspicious.resize(number_of_entries);
         breakage.resize(candidates_list.size());
-        for (const auto i : util::irange<std::size_t>(0u, candidates_list.size()))
+
+        for (const auto t : util::irange<std::size_t>(0u, candidates_list.size()))
         {
-            const auto &num_candidates = candidates_list[i].size();
-            // add empty vectors
-            if (num_candidates > 0)
+            for (const auto s : util::irange<std::size_t>(0u, candidates_list[t].size()))
             {
-                viterbi[i].resize(num_candidates);
-                parents[i].resize(num_candidates);
-                path_lengths[i].resize(num_candidates);
-                suspicious[i].resize(num_candidates);
-                pruned[i].resize(num_candidates);
+                emissions[row_offsets[t] + s] =
+                    emission_log_probability(candidates_list[t][s].distance);
             }
         }
 
         clear(0);
     }
 
+    std::size_t size() const { return breakage.size(); }
+
+    // first entry of the row of a timestamp
+    std::size_t row(const std::size_t t) const { return row_offsets[t]; }
+
+    std::size_t row_size(const std::size_t t) const { return row_offsets[t + 1] - row_offsets[t]; }
+
     void clear(std::size_t initial_timestamp)
     {
-        BOOST_ASSERT(viterbi.size() == parents.size() && parents.size() == path_lengths.size() &&
-                     path_lengths.size() == pruned.size() && pruned.size() == breakage.size());
-
-        for (const auto t : util::irange(initial_timestamp, viterbi.size()))
-        {
-            std::fill(viterbi[t].begin(), viterbi[t].end(), IMPOSSIBLE_LOG_PROB);
-            std::fill(parents[t].begin(), parents[t].end(), std::make_pair(0u, 0u));
-            std::fill(path_lengths[t].begin(), path_lengths[t].end(), 0);
-            std::fill(suspicious[t].begin(), suspicious[t].end(), true);
-            std::fill(pruned[t].begin(), pruned[t].end(), true);
-        }
+        BOOST_ASSERT(initial_timestamp <= size());
+
+        const auto first = row_offsets[initial_timestamp];
+        std::fill(viterbi.begin() + first, viterbi.end(), IMPOSSIBLE_LOG_PROB);
+        std::fill(parents.begin() + first, parents.end(), std::make_pair(0u, 0u));
+        std::fill(path_lengths.begin() + first, path_lengths.end(), 0);
+        std::fill(suspicious.begin() + first, suspicious.end(), true);
+        std::fill(pruned.begin() + first, pruned.end(), true);
         std::fill(breakage.begin() + initial_timestamp, breakage.end(), true);
     }
 
     std::size_t initialize(std::size_t initial_timestamp)
     {
-        auto num_points = candidates_list.size();
+        auto num_points = size();
         do
         {
             BOOST_ASSERT(initial_timestamp < num_points);
 
-            for (const auto s : util::irange<std::size_t>(0u, viterbi[initial_timestamp].size()))
+            const auto first = row(initial_timestamp);
+            for (const auto s : util::irange<std::size_t>(0u, row_size(initial_timestamp)))
             {
-                viterbi[initial_timestamp][s] =
-                    emission_log_probability(candidates_list[initial_timestamp][s].distance);
-                parents[initial_timestamp][s] = std::make_pair(initial_timestamp, s);
-                pruned[initial_timestamp][s] = viterbi[initial_timestamp][s] < MINIMAL_LOG_PROB;
-                suspicious[initial_timestamp][s] = false;
-
-                breakage[initial_timestamp] =
-                    breakage[initial_timestamp] && pruned[initial_timestamp][s];
+                viterbi[first + s] = emissions[first + s];
+                parents[first + s] = std::make_pair(initial_timestamp, s);
+                pruned[first + s] = viterbi[first + s] < MINIMAL_LOG_PROB;
+                suspicious[first + s] = false;
+
+                breakage[initial_timestamp] = breakage[initial_timestamp] && pruned[first + s];
             }
 
             ++initial_timestamp;
@@ -134,10 +149,40 @@ template <class CandidateLists> struct HiddenMarkovModel
         BOOST_ASSERT(initial_timestamp > 0);
         --initial_timestamp;
 
-        BOOST_ASSERT(breakage[initial_timestamp] == false);
+        BOOST_ASSERT(!breakage[initial_timestamp]);
 
         return initial_timestamp;
     }
+
+    // Continues a trace whose candidates at the initial timestamp already have log probabilities,
+    // e.g. the last point matched by a previous request
+    std::size_t initialize(std::size_t initial_timestamp,
+                           const std::vector<double> &log_probabilities)
+    {
+        BOOST_ASSERT(initial_timestamp < size());
+        BOOST_ASSERT(log_probabilities.size() == row_size(initial_timestamp));
+
+        const auto first = row(initial_timestamp);
+        for (const auto s : util::irange<std::size_t>(0u, row_size(initial_timestamp)))
+        {
+            viterbi[first + s] = log_probabilities[s];
+            parents[first + s] = std::make_pair(initial_timestamp, s);
+            pruned[first + s] = viterbi[first + s] < MINIMAL_LOG_PROB;
+            suspicious[first + s] = false;
+
+            breakage[initial_timestamp] = breakage[initial_timestamp] && pruned[first + s];
+        }
+
+        if (!breakage[initial_timestamp])
+        {
+            return initial_timestamp;
+        }
+        if (initial_timestamp + 1 >= size())
+        {
+            return INVALID_STATE;
+        }
+        return initialize(initial_timestamp + 1);
+    }
 };
 }
 }
@@ -0,0 +1,100 @@
+#ifndef MATCHING_SESSIONS_HPP
+#define MATCHING_SESSIONS_HPP
+
+#include "engine/phantom_node.hpp"
+#include "osrm/coordinate.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+// State of the hidden markov model at the last point of a trace that was matched. A trace that
+// continues from it only needs to run the Viterbi algorithm on its new points.
+struct MatchingFrontier
+{
+    std::vector<PhantomNodeWithDistance> candidates;
+    // log probabilities of the candidates, shifted so that the most likely one is 0
+    std::vector<double> viterbi;
+    FixedPointCoordinate coordinate;
+    bool has_timestamp = false;
+    unsigned timestamp = 0;
+    // checksum of the dataset the candidates belong to
+    unsigned data_checksum = 0;
+};
+
+// Frontiers of the traces of many vehicles, identified by a session id given by the client.
+// Sessions that were not continued for longer than the time to live are dropped, the least
+// recently continued ones as well if there are too many.
+class MatchingSessions
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    MatchingSessions(const std::chrono::seconds time_to_live, const std::size_t max_sessions);
+    MatchingSessions(const MatchingSessions &) = delete;
+    MatchingSessions &operator=(const MatchingSessions &) = delete;
+
+    // Removes the frontier of the session and hands it out. Concurrent requests of the same
+    // session do not both continue it, the one that comes second starts a new trace.
+    bool Take(const std::string &session, MatchingFrontier &frontier, Clock::time_point now);
+
+    void Put(const std::string &session, MatchingFrontier frontier, Clock::time_point now);
+
+    std::size_t Size() const;
+
+  private:
+    struct Session
+    {
+        std::string id;
+        MatchingFrontier frontier;
+        Clock::time_point last_used;
+    };
+
+    void Evict(Clock::time_point now);
+
+    const Clock::duration time_to_live;
+    const std::size_t max_sessions;
+
+    mutable std::mutex mutex;
+    // most recently used session first
+    std::list<Session> sessions;
+    std::unordered_map<std::string, std::list<Session>::iterator> index;
+};
+
+// Holds a copy of the frontier a request took from its session. The matching clears the frontier
+// it continues, so a request that fails half way, e.g. once its deadline expired, would lose it.
+// Unless dismissed, the copy goes back to the session when leaving the scope.
+class ScopedFrontierReturn
+{
+  public:
+    ScopedFrontierReturn(MatchingSessions &sessions,
+                         std::string session,
+                         MatchingFrontier frontier);
+    ~ScopedFrontierReturn();
+
+    ScopedFrontierReturn(const ScopedFrontierReturn &) = delete;
+    ScopedFrontierReturn &operator=(const ScopedFrontierReturn &) = delete;
+
+    // the request succeeded, the session keeps the frontier the request left in it
+    void Dismiss() { dismissed = true; }
+
+  private:
+    MatchingSessions &sessions;
+    const std::string session;
+    MatchingFrontier frontier;
+    bool dismissed;
+};
+}
+}
+
+#endif // MATCHING_SESSIONS_HPP
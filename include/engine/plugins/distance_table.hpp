@@ -4,6 +4,7 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/object_encoder.hpp"
+#include "engine/protobuf_response.hpp"
 #include "engine/search_engine.hpp"
 #include "util/make_unique.hpp"
 #include "util/string_util.hpp"
@@ -28,11 +29,14 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
   private:
     std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
     int max_locations_distance_table;
+    std::size_t min_phast_targets;
 
   public:
-    explicit DistanceTablePlugin(DataFacadeT *facade, const int max_locations_distance_table)
-        : max_locations_distance_table(max_locations_distance_table), descriptor_string("table"),
-          facade(facade)
+    explicit DistanceTablePlugin(DataFacadeT *facade,
+                                 const int max_locations_distance_table,
+                                 const std::size_t min_phast_targets = 0)
+        : max_locations_distance_table(max_locations_distance_table),
+          min_phast_targets(min_phast_targets), descriptor_string("table"), facade(facade)
     {
         search_engine_ptr = util::make_unique<SearchEngine<DataFacadeT>>(facade);
     }
@@ -41,6 +45,11 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
 
     const std::string GetDescriptor() const override final { return descriptor_string; }
 
+    bool SupportsOutputFormat(const std::string &output_format) const override final
+    {
+        return BasePlugin::SupportsOutputFormat(output_format) || output_format == "pbf";
+    }
+
     Status HandleRequest(const RouteParameters &route_parameters,
                          util::json::Object &json_result) override final
     {
@@ -173,8 +182,15 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
         auto snapped_source_phantoms = snapPhantomNodes(phantom_node_source_vector);
         auto snapped_target_phantoms = snapPhantomNodes(phantom_node_target_vector);
 
+        // the buckets of many destinations are larger than the part of the hierarchy above them
+        const bool use_phast = min_phast_targets > 0 &&
+                               snapped_target_phantoms.size() >= min_phast_targets &&
+                               search_engine_ptr->phast.IsAvailable();
         auto result_table =
-            search_engine_ptr->distance_table(snapped_source_phantoms, snapped_target_phantoms);
+            use_phast
+                ? search_engine_ptr->phast(snapped_source_phantoms, snapped_target_phantoms)
+                : search_engine_ptr->distance_table(snapped_source_phantoms,
+                                                    snapped_target_phantoms);
 
         if (!result_table)
         {
@@ -182,6 +198,34 @@ template <class DataFacadeT> class DistanceTablePlugin final : public BasePlugin
             return Status::EmptyResult;
         }
 
+        if (route_parameters.output_format == "pbf")
+        {
+            std::string buffer;
+            // durations dominate, most of them need two to three bytes
+            buffer.reserve(64 + 3 * result_table->size() +
+                           8 * (number_of_sources + number_of_destination));
+            {
+                protozero::pbf_writer response_writer(buffer);
+                protozero::pbf_writer table_writer(response_writer, pbf::response::table);
+                table_writer.add_uint32(pbf::table::sources, number_of_sources);
+                table_writer.add_uint32(pbf::table::destinations, number_of_destination);
+                table_writer.add_packed_uint32(pbf::table::durations, result_table->begin(),
+                                               result_table->end());
+                const auto get_location = [](const PhantomNode &phantom)
+                {
+                    return phantom.location;
+                };
+                pbf::AddCoordinates(table_writer, pbf::table::source_coordinates,
+                                    snapped_source_phantoms.begin(),
+                                    snapped_source_phantoms.end(), get_location);
+                pbf::AddCoordinates(table_writer, pbf::table::destination_coordinates,
+                                    snapped_target_phantoms.begin(),
+                                    snapped_target_phantoms.end(), get_location);
+            }
+            json_result.values["pbf"] = util::json::Buffer(std::move(buffer));
+            return Status::Ok;
+        }
+
         util::json::Array matrix_json_array;
         for (const auto row : util::irange<std::size_t>(0, number_of_sources))
         {
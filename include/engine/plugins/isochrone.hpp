@@ -0,0 +1,199 @@
+#ifndef ISOCHRONE_HPP
+#define ISOCHRONE_HPP
+
+#include "engine/plugins/plugin_base.hpp"
+
+#include "engine/isochrone_areas.hpp"
+#include "engine/phantom_node.hpp"
+#include "engine/search_engine.hpp"
+#include "util/coordinate_calculation.hpp"
+#include "util/integer_range.hpp"
+#include "util/make_unique.hpp"
+#include "util/typedefs.hpp"
+#include "osrm/json_container.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace plugins
+{
+
+/*
+ * This Plugin computes the area reachable from a coordinate within several travel times.
+ * One sweep over the contraction hierarchy yields the travel time to every edge-based node,
+ * the segments of the RTree around the coordinate are then timed individually and every
+ * travel time cutoff is answered by the convex hull of the segments reached in time.
+ */
+template <class DataFacadeT> class IsochronePlugin final : public BasePlugin
+{
+  private:
+    // cutoffs used if none are given: 15, 30 and 45 minutes
+    static constexpr unsigned DEFAULT_CUTOFFS[] = {900, 1800, 2700};
+    static constexpr unsigned MAX_CUTOFF = 2 * 3600;
+    // meters per second no segment is faster than, bounds the RTree lookup
+    static constexpr double MAX_SPEED = 60.;
+
+    std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
+
+  public:
+    explicit IsochronePlugin(DataFacadeT *facade) : descriptor_string("isochrone"), facade(facade)
+    {
+        search_engine_ptr = util::make_unique<SearchEngine<DataFacadeT>>(facade);
+    }
+
+    virtual ~IsochronePlugin() {}
+
+    const std::string GetDescriptor() const override final { return descriptor_string; }
+
+    Status HandleRequest(const RouteParameters &route_parameters,
+                         util::json::Object &json_result) override final
+    {
+        if (route_parameters.coordinates.size() != 1 ||
+            !route_parameters.coordinates.front().IsValid())
+        {
+            json_result.values["status_message"] = "Isochrones need exactly one valid coordinate";
+            return Status::Error;
+        }
+
+        const auto &input_bearings = route_parameters.bearings;
+        if (input_bearings.size() > 1)
+        {
+            json_result.values["status_message"] =
+                "Number of bearings does not match number of coordinates";
+            return Status::Error;
+        }
+
+        std::vector<unsigned> cutoffs = route_parameters.cutoffs;
+        if (cutoffs.empty())
+        {
+            cutoffs.assign(std::begin(DEFAULT_CUTOFFS), std::end(DEFAULT_CUTOFFS));
+        }
+        std::sort(cutoffs.begin(), cutoffs.end());
+        cutoffs.erase(std::unique(cutoffs.begin(), cutoffs.end()), cutoffs.end());
+        if (cutoffs.back() > MAX_CUTOFF)
+        {
+            json_result.values["status_message"] = "Cutoff " + std::to_string(cutoffs.back()) +
+                                                   " is higher than current maximum (" +
+                                                   std::to_string(MAX_CUTOFF) + ")";
+            return Status::Error;
+        }
+
+        if (!search_engine_ptr->phast.IsAvailable())
+        {
+            json_result.values["status_message"] =
+                "Isochrones need the node levels of the contraction (.level file)";
+            return Status::Error;
+        }
+
+        const int bearing = input_bearings.size() > 0 ? input_bearings.front().first : 0;
+        const int range =
+            input_bearings.size() > 0
+                ? (input_bearings.front().second ? *input_bearings.front().second : 10)
+                : 180;
+        const auto phantom_node_pair = facade->NearestPhantomNodeWithAlternativeFromBigComponent(
+            route_parameters.coordinates.front(), bearing, range);
+        if (!phantom_node_pair.first.IsValid(facade->GetNumberOfNodes()))
+        {
+            json_result.values["status_message"] =
+                std::string("Could not find a matching segment for coordinate 0");
+            return Status::NoSegment;
+        }
+        const auto source = snapPhantomNodes({phantom_node_pair}).front();
+
+        std::vector<EdgeWeight> node_distances;
+        search_engine_ptr->phast.OneToAll(source, node_distances);
+
+        // weights are in deciseconds
+        std::vector<EdgeWeight> weight_cutoffs(cutoffs.size());
+        std::transform(cutoffs.begin(), cutoffs.end(), weight_cutoffs.begin(),
+                       [](const unsigned cutoff)
+                       {
+                           return static_cast<EdgeWeight>(10 * cutoff);
+                       });
+        IsochroneAreas areas(std::move(weight_cutoffs), source.location);
+
+        util::FixedPointCoordinate south_west, north_east;
+        GetReachableBox(source.location, cutoffs.back(), south_west, north_east);
+        for (const auto &leaf : facade->GetEdgesInBox(south_west, north_east))
+        {
+            const auto u = facade->GetCoordinateOfNode(leaf.u);
+            const auto v = facade->GetCoordinateOfNode(leaf.v);
+            if (leaf.forward_edge_based_node_id != SPECIAL_NODEID)
+            {
+                areas.AddSegment(node_distances[leaf.forward_edge_based_node_id],
+                                 leaf.forward_offset, leaf.forward_weight, u, v);
+            }
+            if (leaf.reverse_edge_based_node_id != SPECIAL_NODEID)
+            {
+                areas.AddSegment(node_distances[leaf.reverse_edge_based_node_id],
+                                 leaf.reverse_offset, leaf.reverse_weight, v, u);
+            }
+        }
+
+        util::json::Array json_isochrones;
+        const auto hulls = areas.GetAreas();
+        for (const auto i : util::irange<std::size_t>(0, cutoffs.size()))
+        {
+            util::json::Array json_polygon;
+            for (const auto &coordinate : hulls[i])
+            {
+                util::json::Array json_coordinate;
+                json_coordinate.values.push_back(coordinate.lat / COORDINATE_PRECISION);
+                json_coordinate.values.push_back(coordinate.lon / COORDINATE_PRECISION);
+                json_polygon.values.push_back(std::move(json_coordinate));
+            }
+            util::json::Object json_isochrone;
+            json_isochrone.values["cutoff"] = cutoffs[i];
+            json_isochrone.values["polygon"] = std::move(json_polygon);
+            json_isochrones.values.push_back(std::move(json_isochrone));
+        }
+
+        util::json::Array json_coordinate;
+        json_coordinate.values.push_back(source.location.lat / COORDINATE_PRECISION);
+        json_coordinate.values.push_back(source.location.lon / COORDINATE_PRECISION);
+        json_result.values["source_coordinate"] = std::move(json_coordinate);
+        json_result.values["reached_segments"] = areas.GetNumberOfReachedSegments();
+        json_result.values["isochrones"] = std::move(json_isochrones);
+        return Status::Ok;
+    }
+
+  private:
+    // Box around the location that contains everything reachable within the cutoff
+    static void GetReachableBox(const util::FixedPointCoordinate location,
+                                const unsigned cutoff,
+                                util::FixedPointCoordinate &south_west,
+                                util::FixedPointCoordinate &north_east)
+    {
+        const double radius = cutoff * MAX_SPEED;
+        const double lat_delta = radius / (util::EARTH_RADIUS * util::RAD);
+        const double lat = location.lat / COORDINATE_PRECISION;
+        // longitudes get closer towards the poles, use the one furthest from the equator
+        const double max_abs_lat = std::min(89., std::abs(lat) + lat_delta);
+        const double lon_delta = lat_delta / std::cos(max_abs_lat * util::RAD);
+        const double lon = location.lon / COORDINATE_PRECISION;
+
+        south_west.lat = static_cast<int>(std::max(-90., lat - lat_delta) * COORDINATE_PRECISION);
+        south_west.lon = static_cast<int>(std::max(-180., lon - lon_delta) * COORDINATE_PRECISION);
+        north_east.lat = static_cast<int>(std::min(90., lat + lat_delta) * COORDINATE_PRECISION);
+        north_east.lon = static_cast<int>(std::min(180., lon + lon_delta) * COORDINATE_PRECISION);
+    }
+
+    std::string descriptor_string;
+    DataFacadeT *facade;
+};
+
+template <class DataFacadeT> constexpr unsigned IsochronePlugin<DataFacadeT>::DEFAULT_CUTOFFS[];
+template <class DataFacadeT> constexpr unsigned IsochronePlugin<DataFacadeT>::MAX_CUTOFF;
+template <class DataFacadeT> constexpr double IsochronePlugin<DataFacadeT>::MAX_SPEED;
+}
+}
+}
+
+#endif // ISOCHRONE_HPP
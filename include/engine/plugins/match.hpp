@@ -9,16 +9,22 @@
 #include "engine/guidance/textual_route_annotation.hpp"
 #include "engine/guidance/segment_list.hpp"
 #include "engine/api_response_generator.hpp"
+#include "engine/matching_sessions.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
 #include "util/coordinate_calculation.hpp"
 #include "util/integer_range.hpp"
 #include "util/json_logger.hpp"
 #include "util/json_util.hpp"
+#include "util/make_unique.hpp"
 #include "util/string_util.hpp"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include <cstdlib>
 
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
@@ -43,9 +49,14 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
     using TraceClassification = ClassifierT::ClassificationT;
 
   public:
-    MapMatchingPlugin(DataFacadeT *facade, const int max_locations_map_matching)
+    MapMatchingPlugin(DataFacadeT *facade,
+                      const int max_locations_map_matching,
+                      const std::chrono::seconds session_time_to_live,
+                      const std::size_t max_sessions,
+                      const std::size_t min_parallel_matching_locations)
         : descriptor_string("match"), facade(facade),
           max_locations_map_matching(max_locations_map_matching),
+          min_parallel_matching_locations(min_parallel_matching_locations),
           // the values were derived from fitting a laplace distribution
           // to the values of manually classified traces
           classifier(map_matching::LaplaceDistribution(0.005986, 0.016646),
@@ -53,6 +64,10 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
                      0.696774) // valid apriori probability
     {
         search_engine_ptr = std::make_shared<SearchEngine<DataFacadeT>>(facade);
+        if (session_time_to_live.count() > 0)
+        {
+            sessions = util::make_unique<MatchingSessions>(session_time_to_live, max_sessions);
+        }
     }
 
     virtual ~MapMatchingPlugin() {}
@@ -81,110 +96,68 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
         const std::vector<util::FixedPointCoordinate> &input_coords,
         const std::vector<std::pair<const int, const boost::optional<int>>> &input_bearings,
         const double gps_precision,
+        const bool parallel_lookup,
         std::vector<double> &sub_trace_lengths)
     {
-        CandidateLists candidates_lists;
-
         // assuming gps_precision is the standard deviation of a normal distribution that
         // models GPS noise (in this model), this should give us the correct search radius
         // with > 99% confidence
-        double query_radius = 3 * gps_precision;
-        double last_distance =
-            util::coordinate_calculation::haversineDistance(input_coords[0], input_coords[1]);
+        const double query_radius = 3 * gps_precision;
 
         sub_trace_lengths.resize(input_coords.size());
         sub_trace_lengths[0] = 0;
-        for (const auto current_coordinate : util::irange<std::size_t>(0, input_coords.size()))
+        for (const auto current_coordinate : util::irange<std::size_t>(1, input_coords.size()))
         {
-            bool allow_uturn = false;
-            if (0 < current_coordinate)
-            {
-                last_distance = util::coordinate_calculation::haversineDistance(
-                    input_coords[current_coordinate - 1], input_coords[current_coordinate]);
-
-                sub_trace_lengths[current_coordinate] +=
-                    sub_trace_lengths[current_coordinate - 1] + last_distance;
-            }
-
-            if (input_coords.size() - 1 > current_coordinate && 0 < current_coordinate)
-            {
-                double turn_angle = util::coordinate_calculation::computeAngle(
-                    input_coords[current_coordinate - 1], input_coords[current_coordinate],
-                    input_coords[current_coordinate + 1]);
-
-                // sharp turns indicate a possible uturn
-                if (turn_angle <= 90.0 || turn_angle >= 270.0)
-                {
-                    allow_uturn = true;
-                }
-            }
+            const auto last_distance = util::coordinate_calculation::haversineDistance(
+                input_coords[current_coordinate - 1], input_coords[current_coordinate]);
+            sub_trace_lengths[current_coordinate] =
+                sub_trace_lengths[current_coordinate - 1] + last_distance;
+        }
 
-            // Use bearing values if supplied, otherwise fallback to 0,180 defaults
-            auto bearing = input_bearings.size() > 0 ? input_bearings[current_coordinate].first : 0;
-            auto range = input_bearings.size() > 0
-                             ? (input_bearings[current_coordinate].second
-                                    ? *input_bearings[current_coordinate].second
-                                    : 10)
-                             : 180;
-            auto candidates = facade->NearestPhantomNodesInRange(input_coords[current_coordinate],
-                                                                 query_radius, bearing, range);
-
-            if (candidates.size() == 0)
+        CandidateLists candidates_lists(input_coords.size());
+        if (parallel_lookup)
+        {
+            // The spatial index is thread-local, every TBB worker loads its own with its first
+            // lookup. A trace without candidates for its first point is not matched at all, so
+            // the other points are only looked up if it has some.
+            candidates_lists[0] = getCoordinateCandidates(input_coords, input_bearings, 0,
+                                                          query_radius);
+            if (!candidates_lists[0].empty())
             {
-                break;
+                tbb::parallel_for(tbb::blocked_range<std::size_t>(1, input_coords.size()),
+                                  [&](const tbb::blocked_range<std::size_t> &range)
+                                  {
+                                      for (auto i = range.begin(); i != range.end(); ++i)
+                                      {
+                                          candidates_lists[i] = getCoordinateCandidates(
+                                              input_coords, input_bearings, i, query_radius);
+                                      }
+                                  });
             }
-
-            // sort by forward id, then by reverse id and then by distance
-            std::sort(
-                candidates.begin(), candidates.end(),
-                [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
-                {
-                    return lhs.phantom_node.forward_node_id < rhs.phantom_node.forward_node_id ||
-                           (lhs.phantom_node.forward_node_id == rhs.phantom_node.forward_node_id &&
-                            (lhs.phantom_node.reverse_node_id < rhs.phantom_node.reverse_node_id ||
-                             (lhs.phantom_node.reverse_node_id ==
-                                  rhs.phantom_node.reverse_node_id &&
-                              lhs.distance < rhs.distance)));
-                });
-
-            auto new_end = std::unique(
-                candidates.begin(), candidates.end(),
-                [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
-                {
-                    return lhs.phantom_node.forward_node_id == rhs.phantom_node.forward_node_id &&
-                           lhs.phantom_node.reverse_node_id == rhs.phantom_node.reverse_node_id;
-                });
-            candidates.resize(new_end - candidates.begin());
-
-            if (!allow_uturn)
+        }
+        else
+        {
+            for (const auto current_coordinate :
+                 util::irange<std::size_t>(0, input_coords.size()))
             {
-                const auto compact_size = candidates.size();
-                for (const auto i : util::irange<std::size_t>(0, compact_size))
+                candidates_lists[current_coordinate] = getCoordinateCandidates(
+                    input_coords, input_bearings, current_coordinate, query_radius);
+                if (candidates_lists[current_coordinate].empty())
                 {
-                    // Split edge if it is bidirectional and append reverse direction to end of list
-                    if (candidates[i].phantom_node.forward_node_id != SPECIAL_NODEID &&
-                        candidates[i].phantom_node.reverse_node_id != SPECIAL_NODEID)
-                    {
-                        PhantomNode reverse_node(candidates[i].phantom_node);
-                        reverse_node.forward_node_id = SPECIAL_NODEID;
-                        candidates.push_back(
-                            PhantomNodeWithDistance{reverse_node, candidates[i].distance});
-
-                        candidates[i].phantom_node.reverse_node_id = SPECIAL_NODEID;
-                    }
+                    break;
                 }
             }
-
-            // sort by distance to make pruning effective
-            std::sort(candidates.begin(), candidates.end(),
-                      [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
-                      {
-                          return lhs.distance < rhs.distance;
-                      });
-
-            candidates_lists.push_back(std::move(candidates));
         }
 
+        // the trace ends before the first coordinate without candidates
+        const auto first_missing =
+            std::find_if(candidates_lists.begin(), candidates_lists.end(),
+                         [](const routing_algorithms::CandidateList &candidates)
+                         {
+                             return candidates.empty();
+                         });
+        candidates_lists.erase(first_missing, candidates_lists.end());
+
         return candidates_lists;
     }
 
@@ -289,33 +262,108 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
             return Status::Error;
         }
 
+        // a session continues the trace of its last request, so a single new point suffices
+        const bool use_session = sessions && !route_parameters.session.empty();
+        if (use_session && input_coords.empty())
+        {
+            json_result.values["status_message"] = "At least one coordinate needed";
+            return Status::Error;
+        }
         // at least two coordinates are needed for map matching
-        if (static_cast<int>(input_coords.size()) < 2)
+        if (!use_session && static_cast<int>(input_coords.size()) < 2)
         {
             json_result.values["status_message"] = "At least two coordinates needed";
             return Status::Error;
         }
 
-        const auto candidates_lists = getCandidates(
-            input_coords, input_bearings, route_parameters.gps_precision, sub_trace_lengths);
+        MatchingFrontier frontier;
+        // gives the frontier back to the session if this request fails
+        std::unique_ptr<ScopedFrontierReturn> frontier_return;
+        if (use_session &&
+            sessions->Take(route_parameters.session, frontier, MatchingSessions::Clock::now()))
+        {
+            // candidates of replaced data are meaningless, timestamps are given always or never
+            if (frontier.data_checksum != facade->GetCheckSum() ||
+                frontier.has_timestamp != !input_timestamps.empty())
+            {
+                frontier.candidates.clear();
+            }
+            else
+            {
+                frontier_return = util::make_unique<ScopedFrontierReturn>(
+                    *sessions, route_parameters.session, frontier);
+            }
+        }
+        const bool continues_frontier = !frontier.candidates.empty();
+
+        // long traces are split at gaps and the parts matched in parallel
+        const bool match_in_parts = min_parallel_matching_locations > 0 &&
+                                    input_coords.size() >= min_parallel_matching_locations;
+        auto candidates_lists =
+            getCandidates(input_coords, input_bearings, route_parameters.gps_precision,
+                          match_in_parts, sub_trace_lengths);
         if (candidates_lists.size() != input_coords.size())
         {
             BOOST_ASSERT(candidates_lists.size() < input_coords.size());
+            // the frontier goes back to the session, the next request may have better luck
             json_result.values["status_message"] =
                 std::string("Could not find a matching segment for coordinate ") +
                 std::to_string(candidates_lists.size());
             return Status::NoSegment;
         }
 
+        // the last point matched by the session is prepended to the trace
+        auto trace_coordinates = input_coords;
+        auto trace_timestamps = input_timestamps;
+        if (continues_frontier)
+        {
+            routing_algorithms::PrependFrontier(frontier, candidates_lists, trace_coordinates,
+                                                trace_timestamps);
+            const auto frontier_distance = util::coordinate_calculation::haversineDistance(
+                frontier.coordinate, input_coords.front());
+            for (auto &length : sub_trace_lengths)
+            {
+                length += frontier_distance;
+            }
+            sub_trace_lengths.insert(sub_trace_lengths.begin(), 0);
+        }
+
+        // the first point of a session, it is matched once the next one arrives
+        if (candidates_lists.size() < 2)
+        {
+            BOOST_ASSERT(use_session);
+            StartSession(route_parameters, candidates_lists.front(), trace_coordinates.front(),
+                         trace_timestamps);
+            json_result.values["matchings"] = util::json::Array();
+            json_result.values["status_message"] = "Cannot find matchings";
+            return Status::EmptyResult;
+        }
+
         // setup logging if enabled
         if (util::json::Logger::get())
             util::json::Logger::get()->initialize("matching");
 
         // call the actual map matching
         SubMatchingList sub_matchings;
-        search_engine_ptr->map_matching(candidates_lists, input_coords, input_timestamps,
-                                        route_parameters.matching_beta,
-                                        route_parameters.gps_precision, sub_matchings);
+        if (match_in_parts && !use_session)
+        {
+            search_engine_ptr->map_matching.MatchInParts(
+                candidates_lists, trace_coordinates, trace_timestamps,
+                route_parameters.matching_beta, route_parameters.gps_precision, sub_matchings);
+        }
+        else
+        {
+            search_engine_ptr->map_matching(candidates_lists, trace_coordinates, trace_timestamps,
+                                            route_parameters.matching_beta,
+                                            route_parameters.gps_precision, sub_matchings,
+                                            use_session ? &frontier : nullptr);
+        }
+        if (use_session && !frontier.candidates.empty())
+        {
+            frontier.data_checksum = facade->GetCheckSum();
+            sessions->Put(route_parameters.session, std::move(frontier),
+                          MatchingSessions::Clock::now());
+        }
 
         util::json::Array matchings;
         for (auto &sub : sub_matchings)
@@ -358,12 +406,22 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
 
             BOOST_ASSERT(raw_route.shortest_path_length != INVALID_EDGE_WEIGHT);
 
+            // the last request reported the prepended point, only the route from it is new
+            if (continues_frontier)
+            {
+                routing_algorithms::RemoveFrontier(sub);
+            }
+
             matchings.values.emplace_back(submatchingToJSON(sub, route_parameters, raw_route));
         }
 
         if (util::json::Logger::get())
             util::json::Logger::get()->render("matching", json_result);
         json_result.values["matchings"] = matchings;
+        if (frontier_return)
+        {
+            frontier_return->Dismiss();
+        }
 
         if (sub_matchings.empty())
         {
@@ -376,10 +434,131 @@ template <class DataFacadeT> class MapMatchingPlugin : public BasePlugin
     }
 
   private:
+    // candidates of one coordinate sorted by distance, empty if there are none in range
+    routing_algorithms::CandidateList getCoordinateCandidates(
+        const std::vector<util::FixedPointCoordinate> &input_coords,
+        const std::vector<std::pair<const int, const boost::optional<int>>> &input_bearings,
+        const std::size_t current_coordinate,
+        const double query_radius)
+    {
+        bool allow_uturn = false;
+        if (input_coords.size() - 1 > current_coordinate && 0 < current_coordinate)
+        {
+            double turn_angle = util::coordinate_calculation::computeAngle(
+                input_coords[current_coordinate - 1], input_coords[current_coordinate],
+                input_coords[current_coordinate + 1]);
+
+            // sharp turns indicate a possible uturn
+            if (turn_angle <= 90.0 || turn_angle >= 270.0)
+            {
+                allow_uturn = true;
+            }
+        }
+
+        // Use bearing values if supplied, otherwise fallback to 0,180 defaults
+        auto bearing = input_bearings.size() > 0 ? input_bearings[current_coordinate].first : 0;
+        auto range = input_bearings.size() > 0
+                         ? (input_bearings[current_coordinate].second
+                                ? *input_bearings[current_coordinate].second
+                                : 10)
+                         : 180;
+        auto candidates = facade->NearestPhantomNodesInRange(input_coords[current_coordinate],
+                                                             query_radius, bearing, range);
+
+        if (candidates.size() == 0)
+        {
+            return candidates;
+        }
+
+        // sort by forward id, then by reverse id and then by distance
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
+                  {
+                      return lhs.phantom_node.forward_node_id < rhs.phantom_node.forward_node_id ||
+                             (lhs.phantom_node.forward_node_id ==
+                                  rhs.phantom_node.forward_node_id &&
+                              (lhs.phantom_node.reverse_node_id <
+                                   rhs.phantom_node.reverse_node_id ||
+                               (lhs.phantom_node.reverse_node_id ==
+                                    rhs.phantom_node.reverse_node_id &&
+                                lhs.distance < rhs.distance)));
+                  });
+
+        auto new_end = std::unique(
+            candidates.begin(), candidates.end(),
+            [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
+            {
+                return lhs.phantom_node.forward_node_id == rhs.phantom_node.forward_node_id &&
+                       lhs.phantom_node.reverse_node_id == rhs.phantom_node.reverse_node_id;
+            });
+        candidates.resize(new_end - candidates.begin());
+
+        if (!allow_uturn)
+        {
+            const auto compact_size = candidates.size();
+            for (const auto i : util::irange<std::size_t>(0, compact_size))
+            {
+                // Split edge if it is bidirectional and append reverse direction to end of list
+                if (candidates[i].phantom_node.forward_node_id != SPECIAL_NODEID &&
+                    candidates[i].phantom_node.reverse_node_id != SPECIAL_NODEID)
+                {
+                    PhantomNode reverse_node(candidates[i].phantom_node);
+                    reverse_node.forward_node_id = SPECIAL_NODEID;
+                    candidates.push_back(
+                        PhantomNodeWithDistance{reverse_node, candidates[i].distance});
+
+                    candidates[i].phantom_node.reverse_node_id = SPECIAL_NODEID;
+                }
+            }
+        }
+
+        // sort by distance to make pruning effective
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const PhantomNodeWithDistance &lhs, const PhantomNodeWithDistance &rhs)
+                  {
+                      return lhs.distance < rhs.distance;
+                  });
+
+        return candidates;
+    }
+
+    // stores the candidates of a single point as the frontier of a new session
+    void StartSession(const RouteParameters &route_parameters,
+                      const routing_algorithms::CandidateList &candidates,
+                      const util::FixedPointCoordinate &coordinate,
+                      const std::vector<unsigned> &timestamps)
+    {
+        const map_matching::EmissionLogProbability emission_log_probability(
+            route_parameters.gps_precision);
+        MatchingFrontier frontier;
+        frontier.candidates = candidates;
+        frontier.viterbi.resize(candidates.size());
+        std::transform(candidates.begin(), candidates.end(), frontier.viterbi.begin(),
+                       [&](const PhantomNodeWithDistance &candidate)
+                       {
+                           return emission_log_probability(candidate.distance);
+                       });
+        const auto max_viterbi =
+            *std::max_element(frontier.viterbi.begin(), frontier.viterbi.end());
+        for (auto &value : frontier.viterbi)
+        {
+            value -= max_viterbi;
+        }
+        frontier.coordinate = coordinate;
+        frontier.has_timestamp = !timestamps.empty();
+        frontier.timestamp = timestamps.empty() ? 0 : timestamps.front();
+        frontier.data_checksum = facade->GetCheckSum();
+        sessions->Put(route_parameters.session, std::move(frontier),
+                      MatchingSessions::Clock::now());
+    }
+
     std::string descriptor_string;
     DataFacadeT *facade;
     int max_locations_map_matching;
+    std::size_t min_parallel_matching_locations;
     ClassifierT classifier;
+    // frontiers of the traces matched in sessions, null if sessions are disabled
+    std::unique_ptr<MatchingSessions> sessions;
 };
 }
 }
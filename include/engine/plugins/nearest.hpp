@@ -3,9 +3,13 @@
 
 #include "engine/plugins/plugin_base.hpp"
 #include "engine/phantom_node.hpp"
+#include "engine/protobuf_response.hpp"
 #include "util/integer_range.hpp"
 #include "osrm/json_container.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <string>
 
 namespace osrm
@@ -26,6 +30,11 @@ template <class DataFacadeT> class NearestPlugin final : public BasePlugin
 
     const std::string GetDescriptor() const override final { return descriptor_string; }
 
+    bool SupportsOutputFormat(const std::string &output_format) const override final
+    {
+        return BasePlugin::SupportsOutputFormat(output_format) || output_format == "pbf";
+    }
+
     Status HandleRequest(const RouteParameters &route_parameters,
                          util::json::Object &json_result) override final
     {
@@ -62,7 +71,25 @@ template <class DataFacadeT> class NearestPlugin final : public BasePlugin
         else
         {
             json_result.values["status_message"] = "Found nearest edge";
-            if (number_of_results > 1)
+            if (route_parameters.output_format == "pbf")
+            {
+                std::string buffer;
+                protozero::pbf_writer response_writer(buffer);
+                for (const auto i : util::irange<std::size_t>(
+                         0, std::min(number_of_results, phantom_node_vector.size())))
+                {
+                    const auto &node = phantom_node_vector[i].phantom_node;
+                    protozero::pbf_writer waypoint_writer(response_writer,
+                                                          pbf::response::waypoint);
+                    const std::int32_t location[] = {node.location.lat, node.location.lon};
+                    waypoint_writer.add_packed_sint32(pbf::waypoint::location, std::begin(location),
+                                                      std::end(location));
+                    waypoint_writer.add_string(pbf::waypoint::name,
+                                               facade->get_name_for_id(node.name_id));
+                }
+                json_result.values["pbf"] = util::json::Buffer(std::move(buffer));
+            }
+            else if (number_of_results > 1)
             {
                 util::json::Array results;
 
@@ -34,6 +34,11 @@ class BasePlugin
     virtual ~BasePlugin() {}
     virtual const std::string GetDescriptor() const = 0;
     virtual Status HandleRequest(const RouteParameters &, util::json::Object &) = 0;
+    // Plugins encoding their results in something else than JSON put them into the "pbf" buffer
+    virtual bool SupportsOutputFormat(const std::string &output_format) const
+    {
+        return output_format.empty() || output_format == "json";
+    }
     virtual bool check_all_coordinates(const std::vector<util::FixedPointCoordinate> &coordinates,
                                        const unsigned min = 2) const final
     {
@@ -4,10 +4,13 @@
 #include "engine/plugins/plugin_base.hpp"
 
 #include "engine/object_encoder.hpp"
+#include "engine/query_deadline.hpp"
 #include "extractor/tarjan_scc.hpp"
 #include "engine/trip/trip_nearest_neighbour.hpp"
 #include "engine/trip/trip_farthest_insertion.hpp"
-#include "engine/trip/trip_brute_force.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "engine/trip/trip_tabu_search.hpp"
+#include "engine/trip/trip_branch_and_bound.hpp"
 #include "engine/search_engine.hpp"
 #include "util/matrix_graph_wrapper.hpp" // wrapper to use tarjan scc on dist table
 #include "engine/api_response_generator.hpp"
@@ -17,8 +20,11 @@
 
 #include <boost/assert.hpp>
 
+#include <tbb/parallel_for.h>
+
 #include <cstdlib>
 #include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <utility>
@@ -39,10 +45,12 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
     DataFacadeT *facade;
     std::unique_ptr<SearchEngine<DataFacadeT>> search_engine_ptr;
     int max_locations_trip;
+    std::chrono::milliseconds search_time;
 
   public:
-    explicit RoundTripPlugin(DataFacadeT *facade, int max_locations_trip)
-        : descriptor_string("trip"), facade(facade), max_locations_trip(max_locations_trip)
+    explicit RoundTripPlugin(DataFacadeT *facade, int max_locations_trip, int search_time_ms)
+        : descriptor_string("trip"), facade(facade), max_locations_trip(max_locations_trip),
+          search_time(search_time_ms)
     {
         search_engine_ptr = util::make_unique<SearchEngine<DataFacadeT>>(facade);
     }
@@ -271,7 +279,6 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
             return Status::Error;
         }
 
-        const constexpr std::size_t BF_MAX_FEASABLE = 10;
         BOOST_ASSERT_MSG(result_table.size() == number_of_locations * number_of_locations,
                          "Distance Table has wrong size");
 
@@ -280,6 +287,17 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
 
         using NodeIDIterator = typename std::vector<NodeID>::const_iterator;
 
+        // the search time is shared by all components that are too large to try all orders
+        const auto stop_time = std::chrono::steady_clock::now() + search_time;
+        std::size_t remaining_searches = 0;
+        for (std::size_t k = 0; k < scc.GetNumberOfComponents(); ++k)
+        {
+            if (scc.range[k + 1] - scc.range[k] > trip::HELD_KARP_MAX_LOCATIONS)
+            {
+                ++remaining_searches;
+            }
+        }
+
         std::vector<std::vector<NodeID>> route_result;
         route_result.reserve(scc.GetNumberOfComponents());
         // run Trip computation for every SCC
@@ -296,14 +314,33 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
             if (component_size > 1)
             {
 
-                if (component_size < BF_MAX_FEASABLE)
+                if (component_size <= trip::HELD_KARP_MAX_LOCATIONS)
                 {
-                    scc_route = trip::BruteForceTrip(start, end, number_of_locations, result_table);
+                    scc_route = trip::HeldKarpTrip(start, end, number_of_locations, result_table);
                 }
                 else
                 {
                     scc_route =
                         trip::FarthestInsertionTrip(start, end, number_of_locations, result_table);
+                    // this component gets an equal share of what the previous ones left
+                    const auto component_time = GetRemainingTime(stop_time) / remaining_searches;
+                    --remaining_searches;
+                    const auto component_stop_time =
+                        std::chrono::steady_clock::now() + component_time;
+                    if (component_size <= trip::BRANCH_AND_BOUND_MAX_LOCATIONS)
+                    {
+                        // the tabu search gives a good bound, the branch and bound then proves
+                        // the trip optimal or finds a better one
+                        scc_route = trip::TabuSearchTrip(std::move(scc_route), result_table,
+                                                         component_time / 2);
+                        scc_route = trip::BranchAndBoundTrip(
+                            scc_route, result_table, GetRemainingTime(component_stop_time));
+                    }
+                    else
+                    {
+                        scc_route = trip::TabuSearchTrip(std::move(scc_route), result_table,
+                                                         component_time);
+                    }
                 }
 
                 // use this output if debugging of route is needed:
@@ -325,27 +362,34 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
             route_result.push_back(std::move(scc_route));
         }
 
-        // compute all round trip routes
-        std::vector<InternalRouteResult> comp_route;
-        comp_route.reserve(route_result.size());
-        for (auto &elem : route_result)
-        {
-            comp_route.push_back(ComputeRoute(phantom_node_list, route_parameters, elem));
-        }
+        // compute and describe all round trip routes, the trips of the components are independent
+        std::vector<util::json::Object> scc_trips(route_result.size());
+        const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+        const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, route_result.size()),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                ScopedQueryDeadline scoped_deadline(deadline);
+                for (auto i = range.begin(); i != range.end(); ++i)
+                {
+                    const auto comp_route =
+                        ComputeRoute(phantom_node_list, route_parameters, route_result[i]);
+
+                    // annotate comp_route as a json trip
+                    auto generator = MakeApiResponseGenerator(facade);
+                    generator.DescribeRoute(route_parameters, comp_route, scc_trips[i]);
+
+                    // set permutation output
+                    SetLocPermutationOutput(route_result[i], scc_trips[i]);
+                }
+            });
 
         // prepare JSON output
         // create a json object for every trip
         util::json::Array trip;
-        for (std::size_t i = 0; i < route_result.size(); ++i)
+        for (auto &scc_trip : scc_trips)
         {
-            util::json::Object scc_trip;
-
-            // annotate comp_route[i] as a json trip
-            auto generator = MakeApiResponseGenerator(facade);
-            generator.DescribeRoute(route_parameters, comp_route[i], scc_trip);
-
-            // set permutation output
-            SetLocPermutationOutput(route_result[i], scc_trip);
             // set viaroute output
             trip.values.push_back(std::move(scc_trip));
         }
@@ -360,6 +404,19 @@ template <class DataFacadeT> class RoundTripPlugin final : public BasePlugin
         json_result.values["status_message"] = "Found trips";
         return Status::Ok;
     }
+
+  private:
+    // time left until the stop time, zero once it passed
+    static std::chrono::milliseconds
+    GetRemainingTime(const std::chrono::steady_clock::time_point stop_time)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= stop_time)
+        {
+            return std::chrono::milliseconds(0);
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(stop_time - now);
+    }
 };
 }
 }
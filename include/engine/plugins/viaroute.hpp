@@ -47,6 +47,11 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
 
     const std::string GetDescriptor() const override final { return descriptor_string; }
 
+    bool SupportsOutputFormat(const std::string &output_format) const override final
+    {
+        return BasePlugin::SupportsOutputFormat(output_format) || output_format == "pbf";
+    }
+
     Status HandleRequest(const RouteParameters &route_parameters,
                          util::json::Object &json_result) override final
     {
@@ -141,7 +146,16 @@ template <class DataFacadeT> class ViaRoutePlugin final : public BasePlugin
         if (raw_route.is_valid())
         {
             auto generator = MakeApiResponseGenerator(facade);
-            generator.DescribeRoute(route_parameters, raw_route, json_result);
+            if (route_parameters.output_format == "pbf")
+            {
+                std::string buffer;
+                generator.EncodeRoute(route_parameters, raw_route, buffer);
+                json_result.values["pbf"] = util::json::Buffer(std::move(buffer));
+            }
+            else
+            {
+                generator.DescribeRoute(route_parameters, raw_route, json_result);
+            }
             json_result.values["status_message"] = "Found route between points";
         }
         else
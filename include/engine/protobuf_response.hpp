@@ -0,0 +1,162 @@
+#ifndef ENGINE_PROTOBUF_RESPONSE_HPP
+#define ENGINE_PROTOBUF_RESPONSE_HPP
+
+#include "osrm/coordinate.hpp"
+
+#include <protozero/pbf_writer.hpp>
+
+#include <cstdint>
+#include <string>
+
+// Compact binary responses, returned instead of JSON for output=pbf.
+// The results are written straight into a protobuf buffer, no JSON objects are created.
+//
+//  message Response {
+//      optional uint32 status = 1;
+//      optional string status_message = 2;
+//      optional Route route = 3;
+//      optional Route alternative = 4;
+//      optional Table table = 5;
+//      repeated Waypoint waypoints = 6;
+//      optional Hints hints = 7;
+//  }
+//  message Route {
+//      optional uint32 total_time = 1;
+//      optional uint32 total_distance = 2;
+//      optional string start_point = 3;
+//      optional string end_point = 4;
+//      repeated sint32 via_points = 5 [packed = true];
+//      repeated uint32 via_indices = 6 [packed = true];
+//      optional string encoded_geometry = 7;
+//      repeated sint32 geometry = 8 [packed = true];
+//      repeated string names = 9;
+//  }
+//  message Table {
+//      optional uint32 sources = 1;
+//      optional uint32 destinations = 2;
+//      repeated uint32 durations = 3 [packed = true];
+//      repeated sint32 source_coordinates = 4 [packed = true];
+//      repeated sint32 destination_coordinates = 5 [packed = true];
+//  }
+//  message Waypoint {
+//      repeated sint32 location = 1 [packed = true];
+//      optional string name = 2;
+//  }
+//  message Hints {
+//      optional uint32 checksum = 1;
+//      repeated string locations = 2;
+//  }
+//
+// Coordinates are lat,lon pairs in units of 1/COORDINATE_PRECISION degree, each value
+// stored as the difference to the previous one of the same field. The table holds the
+// durations row by row, unreachable entries are INVALID_EDGE_WEIGHT like in the JSON output.
+// Turn instructions are only available as JSON.
+namespace osrm
+{
+namespace engine
+{
+namespace pbf
+{
+
+namespace response
+{
+enum : protozero::pbf_tag_type
+{
+    status = 1,
+    status_message = 2,
+    route = 3,
+    alternative = 4,
+    table = 5,
+    waypoint = 6,
+    hints = 7
+};
+}
+
+namespace route
+{
+enum : protozero::pbf_tag_type
+{
+    total_time = 1,
+    total_distance = 2,
+    start_point = 3,
+    end_point = 4,
+    via_points = 5,
+    via_indices = 6,
+    encoded_geometry = 7,
+    geometry = 8,
+    names = 9
+};
+}
+
+namespace table
+{
+enum : protozero::pbf_tag_type
+{
+    sources = 1,
+    destinations = 2,
+    durations = 3,
+    source_coordinates = 4,
+    destination_coordinates = 5
+};
+}
+
+namespace waypoint
+{
+enum : protozero::pbf_tag_type
+{
+    location = 1,
+    name = 2
+};
+}
+
+namespace hints
+{
+enum : protozero::pbf_tag_type
+{
+    checksum = 1,
+    locations = 2
+};
+}
+
+// Writes the coordinates of [first, last) as a delta coded packed field.
+// get_location maps an element to its util::FixedPointCoordinate.
+template <typename Iterator, typename LocationGetter>
+void AddCoordinates(protozero::pbf_writer &writer,
+                    const protozero::pbf_tag_type tag,
+                    Iterator first,
+                    const Iterator last,
+                    LocationGetter get_location)
+{
+    if (first == last)
+    {
+        return;
+    }
+    protozero::packed_field_sint32 field(writer, tag);
+    std::int32_t previous_lat = 0;
+    std::int32_t previous_lon = 0;
+    for (; first != last; ++first)
+    {
+        const util::FixedPointCoordinate location = get_location(*first);
+        field.add_element(location.lat - previous_lat);
+        field.add_element(location.lon - previous_lon);
+        previous_lat = location.lat;
+        previous_lon = location.lon;
+    }
+}
+
+// Adds the status fields to an encoded response. Fields may come in any order in a
+// protobuf message, so they can be appended after the plugin has written its results.
+inline void AddStatus(std::string &buffer, const int status, const std::string &status_message)
+{
+    protozero::pbf_writer writer(buffer);
+    writer.add_uint32(response::status, static_cast<std::uint32_t>(status));
+    if (!status_message.empty())
+    {
+        writer.add_string(response::status_message, status_message);
+    }
+}
+}
+}
+}
+
+#endif // ENGINE_PROTOBUF_RESPONSE_HPP
@@ -0,0 +1,107 @@
+#ifndef QUERY_DEADLINE_HPP
+#define QUERY_DEADLINE_HPP
+
+#include <boost/thread/tss.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+namespace osrm
+{
+namespace engine
+{
+
+// Point in time after which nobody is interested in the result of a query anymore.
+// Can also be cancelled explicitly, e.g. when the client went away.
+class QueryDeadline
+{
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit QueryDeadline(const Clock::time_point deadline) : deadline(deadline), cancelled(false)
+    {
+    }
+
+    void Cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool IsExpired() const
+    {
+        return cancelled.load(std::memory_order_relaxed) || Clock::now() >= deadline;
+    }
+
+  private:
+    const Clock::time_point deadline;
+    std::atomic<bool> cancelled;
+};
+
+// Thrown out of the search loops once the deadline of the running query expired
+class QueryDeadlineExceeded final : public std::exception
+{
+  public:
+    const char *what() const noexcept override { return "Query deadline exceeded"; }
+
+  private:
+    // anchors the vtable, see util::exception
+    virtual void anchor() const;
+};
+
+// Makes a deadline visible to all searches run by the current thread while in scope.
+// The routing algorithms are shared between threads, so the deadline is kept next to the
+// thread local search heaps instead of being passed through every call.
+class ScopedQueryDeadline
+{
+  public:
+    struct State
+    {
+        const QueryDeadline *deadline;
+        // counts search steps over all searches of the query, so many short searches
+        // (e.g. in map matching) are checked as well
+        unsigned steps;
+    };
+
+    explicit ScopedQueryDeadline(const QueryDeadline *deadline);
+    ~ScopedQueryDeadline();
+
+    ScopedQueryDeadline(const ScopedQueryDeadline &) = delete;
+    ScopedQueryDeadline &operator=(const ScopedQueryDeadline &) = delete;
+
+    static State *GetCurrent() { return current_state.get(); }
+
+  private:
+    State state;
+    State *previous_state;
+    static boost::thread_specific_ptr<State> current_state;
+};
+
+// Cheap check to be called once per heap pop (or comparable unit of work) in search loops.
+// Only every CHECK_INTERVAL steps the clock is actually read.
+class DeadlineCheck
+{
+  public:
+    static const constexpr unsigned CHECK_INTERVAL = 1024;
+
+    DeadlineCheck() : state(ScopedQueryDeadline::GetCurrent())
+    {
+        if (state != nullptr && state->deadline == nullptr)
+        {
+            state = nullptr;
+        }
+    }
+
+    void Step()
+    {
+        if (state != nullptr && (++state->steps % CHECK_INTERVAL) == 0 &&
+            state->deadline->IsExpired())
+        {
+            throw QueryDeadlineExceeded();
+        }
+    }
+
+  private:
+    ScopedQueryDeadline::State *state;
+};
+}
+}
+
+#endif // QUERY_DEADLINE_HPP
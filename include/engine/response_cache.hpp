@@ -0,0 +1,83 @@
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+
+struct RouteParameters;
+
+// Rendered reply of a query, ready to be sent again for an identical request
+struct CachedResponse
+{
+    int status;
+    std::vector<char> content;
+};
+
+// Identifies a cache slot; handed out by a lookup and needed to fill the slot after a miss
+struct ResponseCacheTicket
+{
+    std::string key;
+    // the cache generation at lookup time, results computed on older data are not stored
+    std::uint64_t generation;
+};
+
+// Builds a canonical byte string of everything in the parameters that influences the reply
+std::string MakeResponseCacheKey(const RouteParameters &route_parameters,
+                                 const unsigned data_checksum);
+
+// Size-bounded LRU cache of rendered responses.
+// Split into independently locked shards so concurrent queries rarely contend.
+class ResponseCache
+{
+  public:
+    ResponseCache(const std::size_t max_size_in_bytes, const std::size_t number_of_shards);
+    ResponseCache(const ResponseCache &) = delete;
+    ResponseCache &operator=(const ResponseCache &) = delete;
+
+    std::shared_ptr<const CachedResponse> Get(const std::string &key);
+
+    // Stores the response unless the cache was cleared since the ticket was handed out
+    void Put(const ResponseCacheTicket &ticket, std::shared_ptr<const CachedResponse> response);
+
+    // Drops all entries, e.g. because the underlying dataset was replaced
+    void Clear();
+
+    std::uint64_t GetGeneration() const;
+    std::size_t GetSizeInBytes() const;
+
+  private:
+    using Entry = std::pair<std::string, std::shared_ptr<const CachedResponse>>;
+
+    struct Shard
+    {
+        mutable std::mutex mutex;
+        // most recently used entry first
+        std::list<Entry> entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::size_t size_in_bytes = 0;
+    };
+
+    Shard &GetShard(const std::string &key);
+    static std::size_t GetEntrySize(const std::string &key, const CachedResponse &response);
+
+    const std::size_t max_shard_size_in_bytes;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    std::atomic<std::uint64_t> generation;
+};
+}
+}
+
+#endif // RESPONSE_CACHE_HPP
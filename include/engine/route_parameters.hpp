@@ -32,6 +32,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <boost/optional/optional.hpp>
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -40,6 +42,8 @@ namespace osrm
 namespace engine
 {
 
+class QueryDeadline;
+
 struct RouteParameters
 {
     RouteParameters();
@@ -92,6 +96,12 @@ struct RouteParameters
 
     void SetCoordinatesFromGeometry(const std::string &geometry_string);
 
+    void AddCutoff(const unsigned cutoff);
+
+    void SetSession(const std::string &session);
+
+    void SetDeadline(const std::chrono::steady_clock::time_point deadline);
+
     void SetX(const int &x);
     void SetZ(const int &z);
     void SetY(const int &y);
@@ -119,9 +129,15 @@ struct RouteParameters
     std::vector<FixedPointCoordinate> coordinates;
     std::vector<bool> is_destination;
     std::vector<bool> is_source;
+    // travel times in seconds the isochrones are computed for
+    std::vector<unsigned> cutoffs;
+    // map matching continues the trace of the previous request with this id, if any
+    std::string session;
     int z;
     int x;
     int y;
+    // searches give up once this expires, no deadline if empty
+    std::shared_ptr<QueryDeadline> deadline;
 };
 }
 }
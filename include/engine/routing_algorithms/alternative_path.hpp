@@ -126,8 +126,10 @@ class AlternativeRouting final
         }
 
         // search from s and t till new_min/(1+epsilon) > length_of_shortest_path
+        DeadlineCheck deadline_check;
         while (0 < (forward_heap1.Size() + reverse_heap1.Size()))
         {
+            deadline_check.Step();
             if (0 < forward_heap1.Size())
             {
                 AlternativeRoutingStep<true>(forward_heap1, reverse_heap1, &middle_node,
@@ -406,8 +408,10 @@ class AlternativeRouting final
         // compute path <s,..,v> by reusing forward search from s
         const bool constexpr STALLING_ENABLED = true;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
+        DeadlineCheck deadline_check;
         while (!new_reverse_heap.Empty())
         {
+            deadline_check.Step();
             super::RoutingStep(new_reverse_heap, existing_forward_heap, s_v_middle,
                                upper_bound_s_v_path_length, min_edge_offset, false,
                                STALLING_ENABLED, DO_NOT_FORCE_LOOPS, DO_NOT_FORCE_LOOPS);
@@ -418,6 +422,7 @@ class AlternativeRouting final
         new_forward_heap.Insert(via_node, 0, via_node);
         while (!new_forward_heap.Empty())
         {
+            deadline_check.Step();
             super::RoutingStep(new_forward_heap, existing_reverse_heap, v_t_middle,
                                upper_bound_of_v_t_path_length, min_edge_offset, true,
                                STALLING_ENABLED, DO_NOT_FORCE_LOOPS, DO_NOT_FORCE_LOOPS);
@@ -695,8 +700,10 @@ class AlternativeRouting final
         new_reverse_heap.Insert(candidate.node, 0, candidate.node);
         const bool constexpr STALLING_ENABLED = true;
         const bool constexpr DO_NOT_FORCE_LOOPS = false;
+        DeadlineCheck deadline_check;
         while (new_reverse_heap.Size() > 0)
         {
+            deadline_check.Step();
             super::RoutingStep(new_reverse_heap, existing_forward_heap, *s_v_middle,
                                upper_bound_s_v_path_length, min_edge_offset, false,
                                STALLING_ENABLED, DO_NOT_FORCE_LOOPS, DO_NOT_FORCE_LOOPS);
@@ -713,6 +720,7 @@ class AlternativeRouting final
         new_forward_heap.Insert(candidate.node, 0, candidate.node);
         while (new_forward_heap.Size() > 0)
         {
+            deadline_check.Step();
             super::RoutingStep(new_forward_heap, existing_reverse_heap, *v_t_middle,
                                upper_bound_of_v_t_path_length, min_edge_offset, true,
                                STALLING_ENABLED, DO_NOT_FORCE_LOOPS, DO_NOT_FORCE_LOOPS);
@@ -880,6 +888,7 @@ class AlternativeRouting final
         // exploration from s and t until deletemin/(1+epsilon) > _lengt_oO_sShortest_path
         while ((forward_heap3.Size() + reverse_heap3.Size()) > 0)
         {
+            deadline_check.Step();
             if (!forward_heap3.Empty())
             {
                 super::RoutingStep(forward_heap3, reverse_heap3, middle, upper_bound,
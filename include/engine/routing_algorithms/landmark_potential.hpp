@@ -0,0 +1,182 @@
+#ifndef LANDMARK_POTENTIAL_HPP
+#define LANDMARK_POTENTIAL_HPP
+
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// Lower bounds on the remaining distance of a search through the core, derived from the
+// landmark distances with the triangle inequality (ALT).
+// The sources and targets of a core search are sets of entry points with offsets, so the
+// bounds are taken to the nearest entry point: for a landmark l and the targets t with
+// reverse offsets r_t
+//
+//   d(v, t) + r_t >= min_t(d(l, t) + r_t) - d(l, v)
+//   d(v, t) + r_t >= d(v, l) - max_t(d(t, l) - r_t)
+//
+// Both are consistent potentials, so is their maximum over all landmarks.
+// The per landmark terms are computed once per query from the entry points.
+template <class DataFacadeT> class CoreLandmarkPotential
+{
+    using EntryPoints = std::vector<std::pair<NodeID, EdgeWeight>>;
+
+    // bounds are computed in 64 bit, the distances of unconnected pairs are not added up
+    static const constexpr std::int64_t INF = std::numeric_limits<std::int64_t>::max();
+
+    struct Bounds
+    {
+        // smallest offset of an entry point, a trivial bound
+        std::int64_t min_offset = INF;
+        // per landmark: min(d(l, x) + offset_x), INF if no entry point is reached from l
+        std::vector<std::int64_t> min_from_landmark;
+        // per landmark: max(d(x, l) - offset_x), INF if an entry point does not reach l
+        std::vector<std::int64_t> max_to_landmark;
+    };
+
+  public:
+    CoreLandmarkPotential(const DataFacadeT *facade,
+                          const EntryPoints &forward_entry_points,
+                          const EntryPoints &reverse_entry_points)
+        : facade(facade), number_of_landmarks(facade->GetNumberOfCoreLandmarks())
+    {
+        // bounds towards the targets look at the targets, towards the sources at the sources
+        target_bounds = ComputeBounds(reverse_entry_points, false);
+        source_bounds = ComputeBounds(forward_entry_points, true);
+    }
+
+    // lower bound on the distance from the node to the closest target,
+    // INVALID_EDGE_WEIGHT if the node does not reach any target
+    EdgeWeight ToTargets(const NodeID node) const
+    {
+        return GetBound(node, target_bounds, false);
+    }
+
+    // lower bound on the distance from the closest source to the node,
+    // INVALID_EDGE_WEIGHT if no source reaches the node
+    EdgeWeight FromSources(const NodeID node) const
+    {
+        return GetBound(node, source_bounds, true);
+    }
+
+  private:
+    // distances of a core node are stored as [from landmark 0, to landmark 0, from 1, to 1, ...]
+    static EdgeWeight FromLandmark(const EdgeWeight *distances, const unsigned landmark)
+    {
+        return distances[2 * landmark];
+    }
+
+    static EdgeWeight ToLandmark(const EdgeWeight *distances, const unsigned landmark)
+    {
+        return distances[2 * landmark + 1];
+    }
+
+    // For the sources with forward offsets f_s the roles of d(l, x) and d(x, l) are swapped:
+    //   d(s, v) + f_s >= min_s(d(s, l) + f_s) - d(v, l)
+    //   d(s, v) + f_s >= d(l, v) - max_s(d(l, s) - f_s)
+    Bounds ComputeBounds(const EntryPoints &entry_points, const bool reversed) const
+    {
+        Bounds bounds;
+        bounds.min_from_landmark.resize(number_of_landmarks, INF);
+        bounds.max_to_landmark.resize(number_of_landmarks,
+                                      std::numeric_limits<std::int64_t>::min());
+        for (const auto &entry_point : entry_points)
+        {
+            bounds.min_offset = std::min<std::int64_t>(bounds.min_offset, entry_point.second);
+            if (0 == number_of_landmarks)
+            {
+                continue;
+            }
+            const EdgeWeight *distances = facade->GetCoreLandmarkDistances(entry_point.first);
+            BOOST_ASSERT(distances != nullptr);
+            for (const auto landmark : util::irange(0u, number_of_landmarks))
+            {
+                const EdgeWeight from_landmark = reversed ? ToLandmark(distances, landmark)
+                                                          : FromLandmark(distances, landmark);
+                const EdgeWeight to_landmark = reversed ? FromLandmark(distances, landmark)
+                                                        : ToLandmark(distances, landmark);
+                if (INVALID_EDGE_WEIGHT != from_landmark)
+                {
+                    bounds.min_from_landmark[landmark] =
+                        std::min(bounds.min_from_landmark[landmark],
+                                 static_cast<std::int64_t>(from_landmark) + entry_point.second);
+                }
+                if (INVALID_EDGE_WEIGHT == to_landmark ||
+                    INF == bounds.max_to_landmark[landmark])
+                {
+                    bounds.max_to_landmark[landmark] = INF;
+                }
+                else
+                {
+                    bounds.max_to_landmark[landmark] =
+                        std::max(bounds.max_to_landmark[landmark],
+                                 static_cast<std::int64_t>(to_landmark) - entry_point.second);
+                }
+            }
+        }
+        return bounds;
+    }
+
+    EdgeWeight GetBound(const NodeID node, const Bounds &bounds, const bool reversed) const
+    {
+        if (INF == bounds.min_offset)
+        {
+            return INVALID_EDGE_WEIGHT;
+        }
+        // offsets of the sources can be negative, so can the bounds
+        std::int64_t bound = bounds.min_offset;
+        const EdgeWeight *distances = facade->GetCoreLandmarkDistances(node);
+        if (nullptr == distances)
+        {
+            return static_cast<EdgeWeight>(bound);
+        }
+        for (const auto landmark : util::irange(0u, number_of_landmarks))
+        {
+            const EdgeWeight from_landmark = reversed ? ToLandmark(distances, landmark)
+                                                      : FromLandmark(distances, landmark);
+            const EdgeWeight to_landmark = reversed ? FromLandmark(distances, landmark)
+                                                    : ToLandmark(distances, landmark);
+            if (INF != bounds.min_from_landmark[landmark] && INVALID_EDGE_WEIGHT != from_landmark)
+            {
+                bound = std::max(bound, bounds.min_from_landmark[landmark] - from_landmark);
+            }
+            if (INF != bounds.max_to_landmark[landmark])
+            {
+                // every entry point reaches the landmark, so the node cannot reach any of them
+                if (INVALID_EDGE_WEIGHT == to_landmark)
+                {
+                    return INVALID_EDGE_WEIGHT;
+                }
+                bound = std::max(bound, to_landmark - bounds.max_to_landmark[landmark]);
+            }
+        }
+        BOOST_ASSERT(bound < INVALID_EDGE_WEIGHT);
+        return static_cast<EdgeWeight>(bound);
+    }
+
+    const DataFacadeT *facade;
+    const unsigned number_of_landmarks;
+    Bounds target_bounds;
+    Bounds source_bounds;
+};
+
+template <class DataFacadeT>
+const constexpr std::int64_t CoreLandmarkPotential<DataFacadeT>::INF;
+}
+}
+}
+
+#endif // LANDMARK_POTENTIAL_HPP
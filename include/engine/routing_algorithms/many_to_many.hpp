@@ -1,15 +1,23 @@
 #ifndef MANY_TO_MANY_ROUTING_HPP
 #define MANY_TO_MANY_ROUTING_HPP
 
+#include "engine/query_deadline.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+
+#include <algorithm>
+#include <array>
 #include <limits>
 #include <memory>
-#include <unordered_map>
+#include <tuple>
 #include <vector>
 
 namespace osrm
@@ -27,16 +35,94 @@ class ManyToManyRouting final
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
 
+  public:
+    // A node settled by the backward search from a target. Following the parents of the buckets
+    // of a target leads back to it, which gives the paths and not just the distances.
     struct NodeBucket
     {
+        NodeID middle_node;
+        NodeID parent;
         unsigned target_id; // essentially a row in the distance matrix
         EdgeWeight distance;
-        NodeBucket(const unsigned target_id, const EdgeWeight distance)
-            : target_id(target_id), distance(distance)
+        NodeBucket(const NodeID middle_node,
+                   const NodeID parent,
+                   const unsigned target_id,
+                   const EdgeWeight distance)
+            : middle_node(middle_node), parent(parent), target_id(target_id), distance(distance)
+        {
+        }
+
+        bool operator<(const NodeBucket &other) const
+        {
+            return std::tie(middle_node, target_id) < std::tie(other.middle_node, other.target_id);
+        }
+    };
+    // The search spaces of all targets, sorted by node. The buckets of a node are a contiguous
+    // range, found with a binary search.
+    using SearchSpaceWithBuckets = std::vector<NodeBucket>;
+
+    // looks up the buckets of a node
+    struct NodeBucketCompare
+    {
+        bool operator()(const NodeBucket &bucket, const NodeID node) const
+        {
+            return bucket.middle_node < node;
+        }
+        bool operator()(const NodeID node, const NodeBucket &bucket) const
         {
+            return node < bucket.middle_node;
         }
     };
-    using SearchSpaceWithBuckets = std::unordered_map<NodeID, std::vector<NodeBucket>>;
+
+  private:
+    // Sources that are searched at once by a bundled forward search. Each node carries the
+    // distances from all sources of the bundle, so its buckets are read once for all of them.
+    static const constexpr unsigned SOURCES_PER_BUNDLE = 8;
+    // below this the buckets of a node are too short for bundling to pay off
+    static const constexpr std::size_t MIN_TARGETS_FOR_BUNDLES = 64;
+    // distance of sources that did not reach a node yet. Adding path weights never lets it
+    // overflow or drop below, so unreached sources need no special casing in the inner loops.
+    static const constexpr EdgeWeight UNREACHED = std::numeric_limits<EdgeWeight>::max() / 2;
+    using BundleDistances = std::array<EdgeWeight, SOURCES_PER_BUNDLE>;
+
+    // distances of all sources of a bundle to the nodes it reached
+    class BundleSearchSpace
+    {
+      public:
+        // the slots are the dense storage of the thread, cleared for every bundle
+        explicit BundleSearchSpace(SearchEngineData::NodeSlotStorage &slots) : slots(slots) {}
+
+        void Clear()
+        {
+            slots.Clear();
+            distances.clear();
+        }
+
+        const BundleDistances &Get(const NodeID node) const
+        {
+            BOOST_ASSERT(slots.peek_index(node) < distances.size());
+            return distances[slots.peek_index(node)];
+        }
+
+        BundleDistances &GetOrCreate(const NodeID node)
+        {
+            auto slot = slots.peek_index(node);
+            if (slot == NO_SLOT)
+            {
+                slot = static_cast<unsigned>(distances.size());
+                slots[node] = slot;
+                distances.emplace_back();
+                distances.back().fill(UNREACHED);
+            }
+            return distances[slot];
+        }
+
+      private:
+        static const constexpr unsigned NO_SLOT = std::numeric_limits<unsigned>::max();
+
+        SearchEngineData::NodeSlotStorage &slots;
+        std::vector<BundleDistances> distances;
+    };
 
   public:
     ManyToManyRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
@@ -56,66 +142,114 @@ class ManyToManyRouting final
             std::make_shared<std::vector<EdgeWeight>>(number_of_targets * number_of_sources,
                                                       std::numeric_limits<EdgeWeight>::max());
 
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
+        // the searches run on the worker threads, they have to check the deadline of this query
+        const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+        const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
 
-        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        // every thread collects the buckets of its backward searches
+        tbb::enumerable_thread_specific<SearchSpaceWithBuckets> thread_buckets;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_targets),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                ScopedQueryDeadline scoped_deadline(deadline);
+                DeadlineCheck deadline_check;
+                engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+                auto &buckets = thread_buckets.local();
 
-        SearchSpaceWithBuckets search_space_with_buckets;
+                for (auto target_id = range.begin(); target_id != range.end(); ++target_id)
+                {
+                    const auto &phantom = phantom_targets_array[target_id];
+                    query_heap.Clear();
+                    // insert target(s) at distance 0
 
-        unsigned target_id = 0;
-        for (const auto &phantom : phantom_targets_array)
-        {
-            query_heap.Clear();
-            // insert target(s) at distance 0
+                    if (SPECIAL_NODEID != phantom.forward_node_id)
+                    {
+                        query_heap.Insert(phantom.forward_node_id,
+                                          phantom.GetForwardWeightPlusOffset(),
+                                          phantom.forward_node_id);
+                    }
+                    if (SPECIAL_NODEID != phantom.reverse_node_id)
+                    {
+                        query_heap.Insert(phantom.reverse_node_id,
+                                          phantom.GetReverseWeightPlusOffset(),
+                                          phantom.reverse_node_id);
+                    }
 
-            if (SPECIAL_NODEID != phantom.forward_node_id)
-            {
-                query_heap.Insert(phantom.forward_node_id, phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_node_id);
-            }
-            if (SPECIAL_NODEID != phantom.reverse_node_id)
-            {
-                query_heap.Insert(phantom.reverse_node_id, phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_node_id);
-            }
+                    // explore search space
+                    while (!query_heap.Empty())
+                    {
+                        deadline_check.Step();
+                        BackwardRoutingStep(static_cast<unsigned>(target_id), query_heap,
+                                            buckets);
+                    }
+                }
+            });
 
-            // explore search space
-            while (!query_heap.Empty())
-            {
-                BackwardRoutingStep(target_id, query_heap, search_space_with_buckets);
-            }
-            ++target_id;
+        SearchSpaceWithBuckets search_space_with_buckets;
+        std::size_t number_of_buckets = 0;
+        for (const auto &buckets : thread_buckets)
+        {
+            number_of_buckets += buckets.size();
         }
+        search_space_with_buckets.reserve(number_of_buckets);
+        for (const auto &buckets : thread_buckets)
+        {
+            search_space_with_buckets.insert(search_space_with_buckets.end(), buckets.begin(),
+                                             buckets.end());
+        }
+        tbb::parallel_sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
 
-        // for each source do forward search
-        unsigned source_id = 0;
-        for (const auto &phantom : phantom_sources_array)
+        if (number_of_sources >= SOURCES_PER_BUNDLE && number_of_targets >= MIN_TARGETS_FOR_BUNDLES)
         {
-            query_heap.Clear();
-            // insert target(s) at distance 0
+            BundledForwardSearches(phantom_sources_array, number_of_targets,
+                                   search_space_with_buckets, deadline, *result_table);
+            return result_table;
+        }
 
-            if (SPECIAL_NODEID != phantom.forward_node_id)
+        // for each source do forward search, every source fills its own row of the table
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_sources),
+            [&](const tbb::blocked_range<std::size_t> &range)
             {
-                query_heap.Insert(phantom.forward_node_id, -phantom.GetForwardWeightPlusOffset(),
-                                  phantom.forward_node_id);
-            }
-            if (SPECIAL_NODEID != phantom.reverse_node_id)
-            {
-                query_heap.Insert(phantom.reverse_node_id, -phantom.GetReverseWeightPlusOffset(),
-                                  phantom.reverse_node_id);
-            }
+                ScopedQueryDeadline scoped_deadline(deadline);
+                DeadlineCheck deadline_check;
+                engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
 
-            // explore search space
-            while (!query_heap.Empty())
-            {
-                ForwardRoutingStep(source_id, number_of_targets, query_heap,
-                                   search_space_with_buckets, result_table);
-            }
+                for (auto source_id = range.begin(); source_id != range.end(); ++source_id)
+                {
+                    const auto &phantom = phantom_sources_array[source_id];
+                    query_heap.Clear();
+                    // insert target(s) at distance 0
+
+                    if (SPECIAL_NODEID != phantom.forward_node_id)
+                    {
+                        query_heap.Insert(phantom.forward_node_id,
+                                          -phantom.GetForwardWeightPlusOffset(),
+                                          phantom.forward_node_id);
+                    }
+                    if (SPECIAL_NODEID != phantom.reverse_node_id)
+                    {
+                        query_heap.Insert(phantom.reverse_node_id,
+                                          -phantom.GetReverseWeightPlusOffset(),
+                                          phantom.reverse_node_id);
+                    }
+
+                    // explore search space
+                    while (!query_heap.Empty())
+                    {
+                        deadline_check.Step();
+                        ForwardRoutingStep(static_cast<unsigned>(source_id),
+                                           static_cast<unsigned>(number_of_targets), query_heap,
+                                           search_space_with_buckets, *result_table);
+                    }
+                }
+            });
 
-            ++source_id;
-        }
-        // BOOST_ASSERT(source_id == target_id);
         return result_table;
     }
 
@@ -123,39 +257,36 @@ class ManyToManyRouting final
                             const unsigned number_of_targets,
                             QueryHeap &query_heap,
                             const SearchSpaceWithBuckets &search_space_with_buckets,
-                            std::shared_ptr<std::vector<EdgeWeight>> result_table) const
+                            std::vector<EdgeWeight> &result_table) const
     {
         const NodeID node = query_heap.DeleteMin();
         const int source_distance = query_heap.GetKey(node);
 
         // check if each encountered node has an entry
-        const auto bucket_iterator = search_space_with_buckets.find(node);
-        // iterate bucket if there exists one
-        if (bucket_iterator != search_space_with_buckets.end())
+        const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                  search_space_with_buckets.end(), node,
+                                                  NodeBucketCompare());
+        for (auto bucket = bucket_list.first; bucket != bucket_list.second; ++bucket)
         {
-            const std::vector<NodeBucket> &bucket_list = bucket_iterator->second;
-            for (const NodeBucket &current_bucket : bucket_list)
+            // get target id from bucket entry
+            const unsigned target_id = bucket->target_id;
+            const int target_distance = bucket->distance;
+            auto &current_distance = result_table[source_id * number_of_targets + target_id];
+            // check if new distance is better
+            const EdgeWeight new_distance = source_distance + target_distance;
+            if (new_distance < 0)
             {
-                // get target id from bucket entry
-                const unsigned target_id = current_bucket.target_id;
-                const int target_distance = current_bucket.distance;
-                auto &current_distance = (*result_table)[source_id * number_of_targets + target_id];
-                // check if new distance is better
-                const EdgeWeight new_distance = source_distance + target_distance;
-                if (new_distance < 0)
+                const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                const int new_distance_with_loop = new_distance + loop_weight;
+                if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
                 {
-                    const EdgeWeight loop_weight = super::GetLoopWeight(node);
-                    const int new_distance_with_loop = new_distance + loop_weight;
-                    if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
-                    {
-                        current_distance = std::min(current_distance, new_distance_with_loop);
-                    }
-                }
-                else if (new_distance < current_distance)
-                {
-                    (*result_table)[source_id * number_of_targets + target_id] = new_distance;
+                    current_distance = std::min(current_distance, new_distance_with_loop);
                 }
             }
+            else if (new_distance < current_distance)
+            {
+                current_distance = new_distance;
+            }
         }
         if (StallAtNode<true>(node, source_distance, query_heap))
         {
@@ -172,7 +303,8 @@ class ManyToManyRouting final
         const int target_distance = query_heap.GetKey(node);
 
         // store settled nodes in search space bucket
-        search_space_with_buckets[node].emplace_back(target_id, target_distance);
+        search_space_with_buckets.emplace_back(node, query_heap.GetData(node).parent, target_id,
+                                               target_distance);
 
         if (StallAtNode<false>(node, target_distance, query_heap))
         {
@@ -182,6 +314,240 @@ class ManyToManyRouting final
         RelaxOutgoingEdges<false>(node, target_distance, query_heap);
     }
 
+    // Label-correcting search from a bundle of sources. Nodes are ordered by the smallest
+    // distance of any source, a node whose distances improve after it was settled is settled
+    // again. Results are collected per target, so the minima over all sources of the bundle are
+    // taken on one contiguous block, which the compiler turns into vector instructions.
+    void BundledForwardSearches(const std::vector<PhantomNode> &phantom_sources_array,
+                                const std::size_t number_of_targets,
+                                const SearchSpaceWithBuckets &search_space_with_buckets,
+                                const QueryDeadline *deadline,
+                                std::vector<EdgeWeight> &result_table) const
+    {
+        const auto number_of_sources = phantom_sources_array.size();
+        const auto number_of_bundles =
+            (number_of_sources + SOURCES_PER_BUNDLE - 1) / SOURCES_PER_BUNDLE;
+
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_bundles),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                ScopedQueryDeadline scoped_deadline(deadline);
+                DeadlineCheck deadline_check;
+                engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+
+                BundleSearchSpace search_space(engine_working_data.InitializeOrClearThreadNodeSlots(
+                    super::facade->GetNumberOfNodes()));
+                std::vector<EdgeWeight> bundle_table(number_of_targets * SOURCES_PER_BUNDLE);
+
+                for (auto bundle = range.begin(); bundle != range.end(); ++bundle)
+                {
+                    const auto first_source = bundle * SOURCES_PER_BUNDLE;
+                    const auto last_source =
+                        std::min<std::size_t>(first_source + SOURCES_PER_BUNDLE, number_of_sources);
+
+                    query_heap.Clear();
+                    search_space.Clear();
+                    std::fill(bundle_table.begin(), bundle_table.end(), UNREACHED);
+
+                    for (auto source_id = first_source; source_id != last_source; ++source_id)
+                    {
+                        const auto &phantom = phantom_sources_array[source_id];
+                        const auto lane = source_id - first_source;
+                        if (SPECIAL_NODEID != phantom.forward_node_id)
+                        {
+                            InsertBundleSource(phantom.forward_node_id, lane,
+                                               -phantom.GetForwardWeightPlusOffset(), query_heap,
+                                               search_space);
+                        }
+                        if (SPECIAL_NODEID != phantom.reverse_node_id)
+                        {
+                            InsertBundleSource(phantom.reverse_node_id, lane,
+                                               -phantom.GetReverseWeightPlusOffset(), query_heap,
+                                               search_space);
+                        }
+                    }
+
+                    // explore search space
+                    while (!query_heap.Empty())
+                    {
+                        deadline_check.Step();
+                        BundledForwardRoutingStep(query_heap, search_space,
+                                                  search_space_with_buckets, bundle_table);
+                    }
+
+                    for (auto source_id = first_source; source_id != last_source; ++source_id)
+                    {
+                        const auto lane = source_id - first_source;
+                        for (std::size_t target_id = 0; target_id < number_of_targets; ++target_id)
+                        {
+                            const auto distance =
+                                bundle_table[target_id * SOURCES_PER_BUNDLE + lane];
+                            if (distance < UNREACHED)
+                            {
+                                result_table[source_id * number_of_targets + target_id] = distance;
+                            }
+                        }
+                    }
+                }
+            });
+    }
+
+    void BundledForwardRoutingStep(QueryHeap &query_heap,
+                                   BundleSearchSpace &search_space,
+                                   const SearchSpaceWithBuckets &search_space_with_buckets,
+                                   std::vector<EdgeWeight> &bundle_table) const
+    {
+        const NodeID node = query_heap.DeleteMin();
+        // copied, the distances of the search space move when it grows
+        const BundleDistances source_distances = search_space.Get(node);
+
+        // check if each encountered node has an entry
+        const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                  search_space_with_buckets.end(), node,
+                                                  NodeBucketCompare());
+        for (auto bucket = bucket_list.first; bucket != bucket_list.second; ++bucket)
+        {
+            const EdgeWeight target_distance = bucket->distance;
+            auto *current_distances = &bundle_table[bucket->target_id * SOURCES_PER_BUNDLE];
+            bool has_negative_distance = false;
+            for (unsigned lane = 0; lane < SOURCES_PER_BUNDLE; ++lane)
+            {
+                // bucket weights can be negative, so unreached sources are masked explicitly
+                const bool reached = source_distances[lane] < UNREACHED;
+                const EdgeWeight new_distance = source_distances[lane] + target_distance;
+                has_negative_distance |= reached && new_distance < 0;
+                current_distances[lane] =
+                    std::min(current_distances[lane],
+                             (!reached || new_distance < 0) ? UNREACHED : new_distance);
+            }
+            // rare, source and target lie on the same edge in the wrong order
+            if (has_negative_distance)
+            {
+                const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                for (unsigned lane = 0; lane < SOURCES_PER_BUNDLE; ++lane)
+                {
+                    const EdgeWeight new_distance_with_loop =
+                        source_distances[lane] + target_distance + loop_weight;
+                    if (source_distances[lane] < UNREACHED &&
+                        source_distances[lane] + target_distance < 0 &&
+                        loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0)
+                    {
+                        current_distances[lane] =
+                            std::min(current_distances[lane], new_distance_with_loop);
+                    }
+                }
+            }
+        }
+
+        if (BundleStallsAtNode(node, source_distances, query_heap, search_space))
+        {
+            return;
+        }
+
+        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        {
+            const auto &data = super::facade->GetEdgeData(edge);
+            if (data.forward)
+            {
+                const NodeID to = super::facade->GetTarget(edge);
+                const int edge_weight = data.distance;
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+
+                auto &to_distances = search_space.GetOrCreate(to);
+                bool improved = false;
+                EdgeWeight min_distance = UNREACHED;
+                for (unsigned lane = 0; lane < SOURCES_PER_BUNDLE; ++lane)
+                {
+                    const EdgeWeight new_distance = source_distances[lane] + edge_weight;
+                    improved |= new_distance < to_distances[lane];
+                    to_distances[lane] = std::min(to_distances[lane], new_distance);
+                    min_distance = std::min(min_distance, to_distances[lane]);
+                }
+                if (improved)
+                {
+                    UpdateBundleHeap(node, to, min_distance, query_heap);
+                }
+            }
+        }
+    }
+
+    // Stalls only if the node is reached on a shorter path from every source
+    bool BundleStallsAtNode(const NodeID node,
+                            const BundleDistances &distances,
+                            QueryHeap &query_heap,
+                            const BundleSearchSpace &search_space) const
+    {
+        BundleDistances stalled_distances;
+        stalled_distances.fill(UNREACHED);
+        bool any_stalling_edge = false;
+        for (auto edge : super::facade->GetAdjacentEdgeRange(node))
+        {
+            const auto &data = super::facade->GetEdgeData(edge);
+            if (data.backward)
+            {
+                const NodeID to = super::facade->GetTarget(edge);
+                const int edge_weight = data.distance;
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+                if (query_heap.WasInserted(to))
+                {
+                    const auto &to_distances = search_space.Get(to);
+                    for (unsigned lane = 0; lane < SOURCES_PER_BUNDLE; ++lane)
+                    {
+                        stalled_distances[lane] =
+                            std::min(stalled_distances[lane], to_distances[lane] + edge_weight);
+                    }
+                    any_stalling_edge = true;
+                }
+            }
+        }
+        if (!any_stalling_edge)
+        {
+            return false;
+        }
+        for (unsigned lane = 0; lane < SOURCES_PER_BUNDLE; ++lane)
+        {
+            if (distances[lane] < UNREACHED && stalled_distances[lane] >= distances[lane])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void InsertBundleSource(const NodeID node,
+                            const std::size_t lane,
+                            const EdgeWeight distance,
+                            QueryHeap &query_heap,
+                            BundleSearchSpace &search_space) const
+    {
+        auto &distances = search_space.GetOrCreate(node);
+        if (distance < distances[lane])
+        {
+            distances[lane] = distance;
+            UpdateBundleHeap(node, node, distance, query_heap);
+        }
+    }
+
+    // (re-)inserts the node with the smallest of its distances as key
+    void UpdateBundleHeap(const NodeID parent,
+                          const NodeID node,
+                          const EdgeWeight min_distance,
+                          QueryHeap &query_heap) const
+    {
+        if (!query_heap.WasInserted(node) || query_heap.WasRemoved(node))
+        {
+            query_heap.Insert(node, min_distance, parent);
+        }
+        else if (min_distance < query_heap.GetKey(node))
+        {
+            query_heap.GetData(node).parent = parent;
+            query_heap.DecreaseKey(node, min_distance);
+        }
+    }
+
     template <bool forward_direction>
     inline void
     RelaxOutgoingEdges(const NodeID node, const EdgeWeight distance, QueryHeap &query_heap) const
@@ -240,6 +606,13 @@ class ManyToManyRouting final
         return false;
     }
 };
+
+template <class DataFacadeT>
+const constexpr unsigned ManyToManyRouting<DataFacadeT>::SOURCES_PER_BUNDLE;
+template <class DataFacadeT>
+const constexpr std::size_t ManyToManyRouting<DataFacadeT>::MIN_TARGETS_FOR_BUNDLES;
+template <class DataFacadeT>
+const constexpr EdgeWeight ManyToManyRouting<DataFacadeT>::UNREACHED;
 }
 }
 }
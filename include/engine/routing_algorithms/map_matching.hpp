@@ -1,6 +1,8 @@
 #ifndef MAP_MATCHING_HPP
 #define MAP_MATCHING_HPP
 
+#include "engine/matching_sessions.hpp"
+#include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/routing_base.hpp"
 
 #include "util/coordinate_calculation.hpp"
@@ -9,11 +11,18 @@
 #include "util/matching_debug_info.hpp"
 
 #include <cstddef>
+#include <cstdint>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
 #include <deque>
 #include <iomanip>
+#include <iterator>
+#include <limits>
 #include <numeric>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -34,13 +43,42 @@ struct SubMatching
 
 using CandidateList = std::vector<PhantomNodeWithDistance>;
 using CandidateLists = std::vector<CandidateList>;
-using HMM = map_matching::HiddenMarkovModel<CandidateLists>;
 using SubMatchingList = std::vector<SubMatching>;
 
 constexpr static const unsigned MAX_BROKEN_STATES = 10;
 constexpr static const double MAX_SPEED = 180 / 3.6; // 180km -> m/s
 constexpr static const unsigned SUSPICIOUS_DISTANCE_DELTA = 100;
 
+// A trace continued in a session starts with the last point the session matched, the frontier.
+// Prepends it to the candidates, coordinates and timestamps of the new points.
+inline void PrependFrontier(const MatchingFrontier &frontier,
+                            CandidateLists &candidates_lists,
+                            std::vector<util::FixedPointCoordinate> &trace_coordinates,
+                            std::vector<unsigned> &trace_timestamps)
+{
+    candidates_lists.insert(candidates_lists.begin(), frontier.candidates);
+    trace_coordinates.insert(trace_coordinates.begin(), frontier.coordinate);
+    if (frontier.has_timestamp)
+    {
+        trace_timestamps.insert(trace_timestamps.begin(), frontier.timestamp);
+    }
+}
+
+// The request that matched the frontier already reported it. Removes it from a matching of the
+// continued trace, the indices then refer to the points of the new request.
+inline void RemoveFrontier(SubMatching &sub_matching)
+{
+    if (0 == sub_matching.indices.front())
+    {
+        sub_matching.indices.erase(sub_matching.indices.begin());
+        sub_matching.nodes.erase(sub_matching.nodes.begin());
+    }
+    for (auto &index : sub_matching.indices)
+    {
+        --index;
+    }
+}
+
 // implements a hidden markov model map matching algorithm
 template <class DataFacadeT>
 class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<DataFacadeT>>
@@ -48,6 +86,9 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
     using super = BasicRoutingInterface<DataFacadeT, MapMatching<DataFacadeT>>;
     using QueryHeap = SearchEngineData::QueryHeap;
     SearchEngineData &engine_working_data;
+    // searches the buckets of the candidates
+    ManyToManyRouting<DataFacadeT> many_to_many;
+    bool transition_pruning;
 
     unsigned GetMedianSampleTime(const std::vector<unsigned> &timestamps) const
     {
@@ -65,34 +106,335 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
     }
 
   public:
+    using NodeBucket = typename ManyToManyRouting<DataFacadeT>::NodeBucket;
+    using NodeBucketCompare = typename ManyToManyRouting<DataFacadeT>::NodeBucketCompare;
+    // The search spaces of all candidates of a timestamp, sorted by node
+    using SearchSpaceWithBuckets = typename ManyToManyRouting<DataFacadeT>::SearchSpaceWithBuckets;
+
+    // The packed shortest paths between all candidates of two timestamps. The path of a pair is
+    // the range [begin, end) of nodes, empty if the candidates are not connected.
+    struct CandidatePaths
+    {
+        std::vector<NodeID> nodes;
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    };
+
+    // Computes the shortest paths from the unpruned candidates of one timestamp to all of the
+    // next one with a single many-to-many search instead of a query per pair: the backward
+    // searches from the targets leave buckets at the nodes they settle, the forward search from
+    // each source scans the buckets of the nodes it settles.
+    void ComputeCandidatePaths(const CandidateList &sources,
+                               const std::uint8_t *pruned_sources,
+                               const CandidateList &targets,
+                               QueryHeap &query_heap,
+                               SearchSpaceWithBuckets &search_space_with_buckets,
+                               CandidatePaths &paths) const
+    {
+        const auto number_of_targets = targets.size();
+        DeadlineCheck deadline_check;
+
+        search_space_with_buckets.clear();
+        for (const auto target_id : util::irange<std::size_t>(0u, number_of_targets))
+        {
+            const auto &phantom = targets[target_id].phantom_node;
+            query_heap.Clear();
+            if (SPECIAL_NODEID != phantom.forward_node_id)
+            {
+                query_heap.Insert(phantom.forward_node_id, phantom.GetForwardWeightPlusOffset(),
+                                  phantom.forward_node_id);
+            }
+            if (SPECIAL_NODEID != phantom.reverse_node_id)
+            {
+                query_heap.Insert(phantom.reverse_node_id, phantom.GetReverseWeightPlusOffset(),
+                                  phantom.reverse_node_id);
+            }
+            while (!query_heap.Empty())
+            {
+                deadline_check.Step();
+                many_to_many.BackwardRoutingStep(static_cast<unsigned>(target_id), query_heap,
+                                                 search_space_with_buckets);
+            }
+        }
+        std::sort(search_space_with_buckets.begin(), search_space_with_buckets.end());
+
+        paths.nodes.clear();
+        paths.ranges.assign(sources.size() * number_of_targets, std::make_pair(0, 0));
+        std::vector<EdgeWeight> distances(number_of_targets);
+        std::vector<NodeID> middle_nodes(number_of_targets);
+        std::vector<bool> loops(number_of_targets);
+        for (const auto source_id : util::irange<std::size_t>(0u, sources.size()))
+        {
+            if (pruned_sources[source_id])
+            {
+                continue;
+            }
+            const auto &phantom = sources[source_id].phantom_node;
+            query_heap.Clear();
+            if (SPECIAL_NODEID != phantom.forward_node_id)
+            {
+                query_heap.Insert(phantom.forward_node_id, -phantom.GetForwardWeightPlusOffset(),
+                                  phantom.forward_node_id);
+            }
+            if (SPECIAL_NODEID != phantom.reverse_node_id)
+            {
+                query_heap.Insert(phantom.reverse_node_id, -phantom.GetReverseWeightPlusOffset(),
+                                  phantom.reverse_node_id);
+            }
+
+            std::fill(distances.begin(), distances.end(), INVALID_EDGE_WEIGHT);
+            std::fill(middle_nodes.begin(), middle_nodes.end(), SPECIAL_NODEID);
+            while (!query_heap.Empty())
+            {
+                deadline_check.Step();
+                const NodeID node = query_heap.DeleteMin();
+                const EdgeWeight source_distance = query_heap.GetKey(node);
+
+                const auto bucket_list = std::equal_range(search_space_with_buckets.begin(),
+                                                          search_space_with_buckets.end(), node,
+                                                          NodeBucketCompare());
+                for (auto bucket = bucket_list.first; bucket != bucket_list.second; ++bucket)
+                {
+                    const auto target_id = bucket->target_id;
+                    const EdgeWeight new_distance = source_distance + bucket->distance;
+                    if (new_distance < 0)
+                    {
+                        // source and target lie on the same edge in the wrong order
+                        const EdgeWeight loop_weight = super::GetLoopWeight(node);
+                        const EdgeWeight new_distance_with_loop = new_distance + loop_weight;
+                        if (loop_weight != INVALID_EDGE_WEIGHT && new_distance_with_loop >= 0 &&
+                            new_distance_with_loop < distances[target_id])
+                        {
+                            distances[target_id] = new_distance_with_loop;
+                            middle_nodes[target_id] = node;
+                            loops[target_id] = true;
+                        }
+                    }
+                    else if (new_distance < distances[target_id])
+                    {
+                        distances[target_id] = new_distance;
+                        middle_nodes[target_id] = node;
+                        loops[target_id] = false;
+                    }
+                }
+
+                if (!many_to_many.template StallAtNode<true>(node, source_distance, query_heap))
+                {
+                    many_to_many.template RelaxOutgoingEdges<true>(node, source_distance,
+                                                                   query_heap);
+                }
+            }
+
+            for (const auto target_id : util::irange<std::size_t>(0u, number_of_targets))
+            {
+                const NodeID middle_node = middle_nodes[target_id];
+                if (SPECIAL_NODEID == middle_node)
+                {
+                    continue;
+                }
+                const auto begin = paths.nodes.size();
+                if (loops[target_id])
+                {
+                    paths.nodes.push_back(middle_node);
+                    paths.nodes.push_back(middle_node);
+                }
+                else
+                {
+                    super::RetrievePackedPathFromSingleHeap(query_heap, middle_node, paths.nodes);
+                    std::reverse(paths.nodes.begin() + begin, paths.nodes.end());
+                    paths.nodes.push_back(middle_node);
+                    // follow the parents of the backward search to the target
+                    NodeID node = middle_node;
+                    while (true)
+                    {
+                        const auto bucket = std::lower_bound(
+                            search_space_with_buckets.begin(), search_space_with_buckets.end(),
+                            NodeBucket(node, SPECIAL_NODEID, static_cast<unsigned>(target_id), 0));
+                        BOOST_ASSERT(bucket != search_space_with_buckets.end() &&
+                                     bucket->middle_node == node &&
+                                     bucket->target_id == target_id);
+                        if (bucket->parent == node)
+                        {
+                            break;
+                        }
+                        node = bucket->parent;
+                        paths.nodes.push_back(node);
+                    }
+                }
+                paths.ranges[source_id * number_of_targets + target_id] =
+                    std::make_pair(begin, paths.nodes.size());
+            }
+        }
+    }
+
     MapMatching(DataFacadeT *facade, SearchEngineData &engine_working_data)
-        : super(facade), engine_working_data(engine_working_data)
+        : super(facade), engine_working_data(engine_working_data),
+          many_to_many(facade, engine_working_data), transition_pruning(true)
     {
     }
 
+    // Transitions that can not beat the best predecessor of a candidate are not computed. The
+    // matchings are the same without, only slower to compute.
+    void SetTransitionPruning(const bool enabled) { transition_pruning = enabled; }
+
     void operator()(const CandidateLists &candidates_list,
                     const std::vector<util::FixedPointCoordinate> &trace_coordinates,
                     const std::vector<unsigned> &trace_timestamps,
                     const double matching_beta,
                     const double gps_precision,
-                    SubMatchingList &sub_matchings) const
+                    SubMatchingList &sub_matchings,
+                    MatchingFrontier *frontier = nullptr) const
+    {
+        BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
+        BOOST_ASSERT(candidates_list.size() > 1);
+
+        Match(candidates_list, trace_coordinates, trace_timestamps,
+              GetSampleTime(trace_timestamps), matching_beta, gps_precision,
+              util::json::Logger::get(), sub_matchings, frontier);
+    }
+
+    // Splits the trace at gaps and matches the parts in parallel. A gap is longer than
+    // MAX_BROKEN_STATES median sample times, the model splits the trace there anyway, so the
+    // matchings are the same as those of the whole trace. Traces without timestamps are split
+    // where points are further apart than MAX_BROKEN_STATES median distances between
+    // consecutive points. The model has no distance limit for those, it may connect the points
+    // across such a gap, so their matchings can differ from those of the whole trace. The
+    // matchings of all parts are returned in order, their indices refer to the whole trace. No
+    // debug info is collected.
+    void MatchInParts(const CandidateLists &candidates_list,
+                      const std::vector<util::FixedPointCoordinate> &trace_coordinates,
+                      const std::vector<unsigned> &trace_timestamps,
+                      const double matching_beta,
+                      const double gps_precision,
+                      SubMatchingList &sub_matchings) const
     {
         BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
         BOOST_ASSERT(candidates_list.size() > 1);
 
         const bool use_timestamps = trace_timestamps.size() > 1;
+        const auto median_sample_time = GetSampleTime(trace_timestamps);
+        const auto part_begins =
+            GetPartBegins(trace_coordinates, trace_timestamps, median_sample_time);
+        const auto number_of_parts = part_begins.size() - 1;
+
+        std::vector<SubMatchingList> part_matchings(number_of_parts);
+        const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+        const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_parts, 1),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                ScopedQueryDeadline scoped_deadline(deadline);
+                for (auto part = range.begin(); part != range.end(); ++part)
+                {
+                    const auto begin = part_begins[part];
+                    const auto end = part_begins[part + 1];
+                    // a single point can not be matched
+                    if (end - begin < 2)
+                    {
+                        continue;
+                    }
+
+                    // The first point after a time gap is kept, the model splits the part there
+                    // the same way it splits the whole trace. Points that broke before the gap
+                    // are matched again then. It never ends up in a matching of the part.
+                    const auto last = use_timestamps ? std::min(end + 1, candidates_list.size())
+                                                     : end;
+                    const CandidateLists part_candidates(candidates_list.begin() + begin,
+                                                         candidates_list.begin() + last);
+                    const std::vector<util::FixedPointCoordinate> part_coordinates(
+                        trace_coordinates.begin() + begin, trace_coordinates.begin() + last);
+                    const auto part_timestamps =
+                        use_timestamps ? std::vector<unsigned>(trace_timestamps.begin() + begin,
+                                                               trace_timestamps.begin() + last)
+                                       : std::vector<unsigned>();
+                    Match(part_candidates, part_coordinates, part_timestamps, median_sample_time,
+                          matching_beta, gps_precision, nullptr, part_matchings[part], nullptr);
+
+                    for (auto &matching : part_matchings[part])
+                    {
+                        for (auto &index : matching.indices)
+                        {
+                            index += begin;
+                        }
+                    }
+                }
+            });
 
-        const auto median_sample_time = [&]()
+        for (auto &matchings : part_matchings)
         {
-            if (use_timestamps)
+            sub_matchings.insert(sub_matchings.end(), std::make_move_iterator(matchings.begin()),
+                                 std::make_move_iterator(matchings.end()));
+        }
+    }
+
+  private:
+    // median time between two points, 1 for traces without timestamps
+    unsigned GetSampleTime(const std::vector<unsigned> &trace_timestamps) const
+    {
+        if (trace_timestamps.size() > 1)
+        {
+            return std::max(1u, GetMedianSampleTime(trace_timestamps));
+        }
+        return 1u;
+    }
+
+    // First point of every part of the trace, followed by the number of points. Only the time
+    // gaps are ones the model breaks at as well, see MatchInParts.
+    std::vector<std::size_t>
+    GetPartBegins(const std::vector<util::FixedPointCoordinate> &trace_coordinates,
+                  const std::vector<unsigned> &trace_timestamps,
+                  const unsigned median_sample_time) const
+    {
+        std::vector<std::size_t> part_begins = {0};
+        if (trace_timestamps.size() > 1)
+        {
+            const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
+            for (const auto i : util::irange<std::size_t>(1u, trace_timestamps.size()))
             {
-                return std::max(1u, GetMedianSampleTime(trace_timestamps));
+                if (trace_timestamps[i] - trace_timestamps[i - 1] > max_broken_time)
+                {
+                    part_begins.push_back(i);
+                }
             }
-            else
+        }
+        else
+        {
+            std::vector<double> distances(trace_coordinates.size() - 1);
+            for (const auto i : util::irange<std::size_t>(1u, trace_coordinates.size()))
             {
-                return 1u;
+                distances[i - 1] = util::coordinate_calculation::haversineDistance(
+                    trace_coordinates[i - 1], trace_coordinates[i]);
             }
-        }();
+            auto sorted_distances = distances;
+            const auto median = sorted_distances.begin() + sorted_distances.size() / 2;
+            std::nth_element(sorted_distances.begin(), median, sorted_distances.end());
+            const auto max_broken_distance = std::max(1., *median) * MAX_BROKEN_STATES;
+            for (const auto i : util::irange<std::size_t>(0u, distances.size()))
+            {
+                if (distances[i] > max_broken_distance)
+                {
+                    part_begins.push_back(i + 1);
+                }
+            }
+        }
+        part_begins.push_back(trace_coordinates.size());
+        return part_begins;
+    }
+
+    void Match(const CandidateLists &candidates_list,
+               const std::vector<util::FixedPointCoordinate> &trace_coordinates,
+               const std::vector<unsigned> &trace_timestamps,
+               const unsigned median_sample_time,
+               const double matching_beta,
+               const double gps_precision,
+               const util::json::Logger *logger,
+               SubMatchingList &sub_matchings,
+               MatchingFrontier *frontier) const
+    {
+        BOOST_ASSERT(candidates_list.size() == trace_coordinates.size());
+        BOOST_ASSERT(candidates_list.size() > 1);
+
+        const bool use_timestamps = trace_timestamps.size() > 1;
         const auto max_broken_time = median_sample_time * MAX_BROKEN_STATES;
         const auto max_distance_delta = [&]()
         {
@@ -110,28 +452,48 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
         map_matching::EmissionLogProbability emission_log_probability(gps_precision);
         map_matching::TransitionLogProbability transition_log_probability(matching_beta);
 
-        HMM model(candidates_list, emission_log_probability);
-
-        std::size_t initial_timestamp = model.initialize(0);
+        auto &model = SearchEngineData::GetThreadHiddenMarkovModel();
+        model.reset(candidates_list, emission_log_probability);
+
+        // a trace that continues a previous one starts with the last point matched back then
+        const bool continues_frontier = frontier != nullptr && !frontier->candidates.empty();
+        BOOST_ASSERT(!continues_frontier ||
+                     frontier->candidates.size() == candidates_list.front().size());
+        std::size_t initial_timestamp = continues_frontier
+                                            ? model.initialize(0, frontier->viterbi)
+                                            : model.initialize(0);
+        if (frontier != nullptr)
+        {
+            frontier->candidates.clear();
+            frontier->viterbi.clear();
+        }
         if (initial_timestamp == map_matching::INVALID_STATE)
         {
             return;
         }
 
-        util::MatchingDebugInfo matching_debug(util::json::Logger::get());
+        util::MatchingDebugInfo matching_debug(logger);
         matching_debug.initialize(candidates_list);
 
         engine_working_data.InitializeOrClearFirstThreadLocalStorage(
             super::facade->GetNumberOfNodes());
 
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
+        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        SearchSpaceWithBuckets search_space_with_buckets;
+        CandidatePaths candidate_paths;
+        // transitions of all pairs of candidates of one step, row-major by previous candidate
+        std::vector<double> transitions;
+        std::vector<double> network_distances;
+        std::vector<double> best_values;
+        std::vector<unsigned> best_parents;
 
         std::size_t breakage_begin = map_matching::INVALID_STATE;
         std::vector<std::size_t> split_points;
         std::vector<std::size_t> prev_unbroken_timestamps;
         prev_unbroken_timestamps.reserve(candidates_list.size());
         prev_unbroken_timestamps.push_back(initial_timestamp);
+        bool trace_ended_in_breakage = false;
+        DeadlineCheck deadline_check;
         for (auto t = initial_timestamp + 1; t < candidates_list.size(); ++t)
         {
             // breakage recover has removed all previous good points
@@ -167,6 +529,7 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 // no new start was found -> stop viterbi calculation
                 if (new_start == map_matching::INVALID_STATE)
                 {
+                    trace_ended_in_breakage = true;
                     break;
                 }
 
@@ -181,50 +544,62 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             BOOST_ASSERT(!prev_unbroken_timestamps.empty());
             const std::size_t prev_unbroken_timestamp = prev_unbroken_timestamps.back();
 
-            const auto &prev_viterbi = model.viterbi[prev_unbroken_timestamp];
-            const auto &prev_pruned = model.pruned[prev_unbroken_timestamp];
+            const auto prev_row = model.row(prev_unbroken_timestamp);
+            const auto number_of_prev = model.row_size(prev_unbroken_timestamp);
+            const double *prev_viterbi = model.viterbi.data() + prev_row;
+            const std::uint8_t *prev_pruned = model.pruned.data() + prev_row;
             const auto &prev_unbroken_timestamps_list = candidates_list[prev_unbroken_timestamp];
             const auto &prev_coordinate = trace_coordinates[prev_unbroken_timestamp];
 
-            auto &current_viterbi = model.viterbi[t];
-            auto &current_pruned = model.pruned[t];
-            auto &current_suspicious = model.suspicious[t];
-            auto &current_parents = model.parents[t];
-            auto &current_lengths = model.path_lengths[t];
+            const auto current_row = model.row(t);
+            const auto number_of_current = model.row_size(t);
             const auto &current_timestamps_list = candidates_list[t];
             const auto &current_coordinate = trace_coordinates[t];
 
             const auto haversine_distance = util::coordinate_calculation::haversineDistance(
                 prev_coordinate, current_coordinate);
 
-            // compute d_t for this timestamp and the next one
-            for (const auto s : util::irange<std::size_t>(0u, prev_viterbi.size()))
+            ComputeCandidatePaths(prev_unbroken_timestamps_list, prev_pruned,
+                                  current_timestamps_list, query_heap, search_space_with_buckets,
+                                  candidate_paths);
+
+            // Unpacking the paths is the expensive part, so a pair is left out if even the most
+            // likely transition, one as long as the great circle distance, can not beat the
+            // best predecessor of the target found so far.
+            const double max_transition_pr = transition_log_probability(0.);
+            transitions.assign(number_of_prev * number_of_current,
+                               map_matching::IMPOSSIBLE_LOG_PROB);
+            network_distances.resize(number_of_prev * number_of_current);
+            best_values.assign(number_of_current, map_matching::IMPOSSIBLE_LOG_PROB);
+            for (const auto s : util::irange<std::size_t>(0u, number_of_prev))
             {
                 if (prev_pruned[s])
                 {
                     continue;
                 }
 
-                for (const auto s_prime : util::irange<std::size_t>(0u, current_viterbi.size()))
+                for (const auto s_prime : util::irange<std::size_t>(0u, number_of_current))
                 {
-                    // how likely is candidate s_prime at time t to be emitted?
-                    // FIXME this can be pre-computed
-                    const double emission_pr =
-                        emission_log_probability(candidates_list[t][s_prime].distance);
-                    double new_value = prev_viterbi[s] + emission_pr;
-                    if (current_viterbi[s_prime] > new_value)
+                    deadline_check.Step();
+                    if (transition_pruning &&
+                        prev_viterbi[s] + max_transition_pr <= best_values[s_prime])
                     {
                         continue;
                     }
 
-                    forward_heap.Clear();
-                    reverse_heap.Clear();
+                    const auto pair = s * number_of_current + s_prime;
+                    const auto &path = candidate_paths.ranges[pair];
+                    if (path.first == path.second)
+                    {
+                        continue;
+                    }
 
                     // get distance diff between loc1/2 and locs/s_prime
-                    const auto network_distance = super::get_network_distance(
-                        forward_heap, reverse_heap, prev_unbroken_timestamps_list[s].phantom_node,
+                    const auto network_distance = super::GetPathDistance(
+                        candidate_paths.nodes.begin() + path.first,
+                        candidate_paths.nodes.begin() + path.second,
+                        prev_unbroken_timestamps_list[s].phantom_node,
                         current_timestamps_list[s_prime].phantom_node);
-
                     const auto d_t = std::abs(network_distance - haversine_distance);
 
                     // very low probability transition -> prune
@@ -234,22 +609,60 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                     }
 
                     const double transition_pr = transition_log_probability(d_t);
-                    new_value += transition_pr;
+                    transitions[pair] = transition_pr;
+                    network_distances[pair] = network_distance;
+                    best_values[s_prime] =
+                        std::max(best_values[s_prime], prev_viterbi[s] + transition_pr);
+
+                    matching_debug.add_transition_info(
+                        prev_unbroken_timestamp, t, s, s_prime, prev_viterbi[s],
+                        model.emissions[current_row + s_prime], transition_pr, network_distance,
+                        haversine_distance);
+                }
+            }
+
+            // Max-plus product of the previous viterbi row and the transitions. The inner loop
+            // runs over contiguous memory without branches, so it is vectorized. The emission
+            // does not depend on the predecessor and is added to the maximum afterwards.
+            std::fill(best_values.begin(), best_values.end(), map_matching::IMPOSSIBLE_LOG_PROB);
+            best_parents.assign(number_of_current, 0);
+            for (const auto s : util::irange<std::size_t>(0u, number_of_prev))
+            {
+                if (prev_pruned[s])
+                {
+                    continue;
+                }
 
-                    matching_debug.add_transition_info(prev_unbroken_timestamp, t, s, s_prime,
-                                                       prev_viterbi[s], emission_pr, transition_pr,
-                                                       network_distance, haversine_distance);
+                const double value = prev_viterbi[s];
+                const double *transition_row = transitions.data() + s * number_of_current;
+                const unsigned parent = s;
+                for (std::size_t s_prime = 0; s_prime < number_of_current; ++s_prime)
+                {
+                    const double new_value = value + transition_row[s_prime];
+                    const bool better = new_value > best_values[s_prime];
+                    best_values[s_prime] = better ? new_value : best_values[s_prime];
+                    best_parents[s_prime] = better ? parent : best_parents[s_prime];
+                }
+            }
 
-                    if (new_value > current_viterbi[s_prime])
-                    {
-                        current_viterbi[s_prime] = new_value;
-                        current_parents[s_prime] = std::make_pair(prev_unbroken_timestamp, s);
-                        current_lengths[s_prime] = network_distance;
-                        current_pruned[s_prime] = false;
-                        current_suspicious[s_prime] = d_t > SUSPICIOUS_DISTANCE_DELTA;
-                        model.breakage[t] = false;
-                    }
+            for (const auto s_prime : util::irange<std::size_t>(0u, number_of_current))
+            {
+                if (best_values[s_prime] == map_matching::IMPOSSIBLE_LOG_PROB)
+                {
+                    continue;
                 }
+
+                const auto entry = current_row + s_prime;
+                const auto parent = best_parents[s_prime];
+                const auto network_distance =
+                    network_distances[parent * number_of_current + s_prime];
+                model.viterbi[entry] = best_values[s_prime] + model.emissions[entry];
+                model.parents[entry] = std::make_pair(prev_unbroken_timestamp, parent);
+                model.path_lengths[entry] = network_distance;
+                model.pruned[entry] = false;
+                model.suspicious[entry] =
+                    std::abs(network_distance - haversine_distance) > SUSPICIOUS_DISTANCE_DELTA;
+                model.breakage[t] = false;
             }
 
             if (model.breakage[t])
@@ -270,7 +683,25 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
         }
 
-        matching_debug.set_viterbi(model.viterbi, model.pruned, model.suspicious);
+        matching_debug.set_viterbi(model);
+
+        if (frontier != nullptr && !trace_ended_in_breakage && !prev_unbroken_timestamps.empty())
+        {
+            const auto last_timestamp = prev_unbroken_timestamps.back();
+            const auto last_viterbi = model.viterbi.begin() + model.row(last_timestamp);
+            const auto last_viterbi_end = last_viterbi + model.row_size(last_timestamp);
+            const auto max_viterbi = *std::max_element(last_viterbi, last_viterbi_end);
+            frontier->candidates = candidates_list[last_timestamp];
+            frontier->viterbi.resize(model.row_size(last_timestamp));
+            std::transform(last_viterbi, last_viterbi_end, frontier->viterbi.begin(),
+                           [max_viterbi](const double value)
+                           {
+                               return value - max_viterbi;
+                           });
+            frontier->coordinate = trace_coordinates[last_timestamp];
+            frontier->has_timestamp = use_timestamps;
+            frontier->timestamp = use_timestamps ? trace_timestamps[last_timestamp] : 0;
+        }
 
         if (!prev_unbroken_timestamps.empty())
         {
@@ -301,12 +732,11 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
             }
 
             // loop through the columns, and only compare the last entry
-            const auto max_element_iter =
-                std::max_element(model.viterbi[parent_timestamp_index].begin(),
-                                 model.viterbi[parent_timestamp_index].end());
+            const auto parent_viterbi = model.viterbi.begin() + model.row(parent_timestamp_index);
+            const auto max_element_iter = std::max_element(
+                parent_viterbi, parent_viterbi + model.row_size(parent_timestamp_index));
 
-            std::size_t parent_candidate_index =
-                std::distance(model.viterbi[parent_timestamp_index].begin(), max_element_iter);
+            std::size_t parent_candidate_index = std::distance(parent_viterbi, max_element_iter);
 
             std::deque<std::pair<std::size_t, std::size_t>> reconstructed_indices;
             while (parent_timestamp_index > sub_matching_begin)
@@ -317,7 +747,8 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
                 }
 
                 reconstructed_indices.emplace_front(parent_timestamp_index, parent_candidate_index);
-                const auto &next = model.parents[parent_timestamp_index][parent_candidate_index];
+                const auto &next =
+                    model.parents[model.row(parent_timestamp_index) + parent_candidate_index];
                 // make sure we can never get stuck in this loop
                 if (parent_timestamp_index == next.first)
                 {
@@ -343,7 +774,7 @@ class MapMatching final : public BasicRoutingInterface<DataFacadeT, MapMatching<
 
                 matching.indices[i] = timestamp_index;
                 matching.nodes[i] = candidates_list[timestamp_index][location_index].phantom_node;
-                matching.length += model.path_lengths[timestamp_index][location_index];
+                matching.length += model.path_lengths[model.row(timestamp_index) + location_index];
 
                 matching_debug.add_chosen(timestamp_index, location_index);
             }
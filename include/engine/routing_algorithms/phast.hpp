@@ -0,0 +1,369 @@
+#ifndef PHAST_ROUTING_HPP
+#define PHAST_ROUTING_HPP
+
+#include "engine/query_deadline.hpp"
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/routing_algorithms/routing_base.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace routing_algorithms
+{
+
+// PHAST: an upward search from the source followed by a linear sweep over the nodes in
+// descending contraction level, pulling distances down the hierarchy. The sweep reads the graph
+// in one pass instead of probing buckets, so it wins for tables with thousands of targets.
+// For tables the sweep is restricted to the nodes above the targets (RPHAST), which are copied
+// into a compact downward graph once per query and then swept for every source.
+// A sweep only keeps the shortest distance of every node. If source and target lie on the same
+// segment in the wrong order the shortest one is negative and the detour around the loop is
+// lost, these rare entries are computed with bucket searches instead.
+template <class DataFacadeT>
+class PHASTRouting final : public BasicRoutingInterface<DataFacadeT, PHASTRouting<DataFacadeT>>
+{
+    using super = BasicRoutingInterface<DataFacadeT, PHASTRouting<DataFacadeT>>;
+    using QueryHeap = SearchEngineData::QueryHeap;
+    SearchEngineData &engine_working_data;
+    ManyToManyRouting<DataFacadeT> bucket_search;
+
+    // distance of nodes not reached yet. Adding path weights never lets it overflow.
+    static const constexpr EdgeWeight UNREACHED = std::numeric_limits<EdgeWeight>::max() / 2;
+
+    // edge u -> v of the downward graph, stored at v
+    struct DownwardArc
+    {
+        unsigned from; // index into the sweep order, always smaller than the one of v
+        EdgeWeight weight;
+    };
+
+    // the part of the hierarchy the targets can be reached from, in sweep order
+    struct RestrictedHierarchy
+    {
+        std::vector<NodeID> nodes;
+        std::unordered_map<NodeID, unsigned> index_of_node;
+        // arcs of the i-th node are [first_arc[i], first_arc[i + 1])
+        std::vector<unsigned> first_arc;
+        std::vector<DownwardArc> arcs;
+    };
+
+  public:
+    PHASTRouting(DataFacadeT *facade, SearchEngineData &engine_working_data)
+        : super(facade), engine_working_data(engine_working_data),
+          bucket_search(facade, engine_working_data)
+    {
+    }
+
+    ~PHASTRouting() {}
+
+    // the dataset was contracted without a core and osrm-contract wrote its node levels
+    bool IsAvailable() const { return super::facade->HasSweepRanks(); }
+
+    // Same result as ManyToManyRouting
+    std::shared_ptr<std::vector<EdgeWeight>>
+    operator()(const std::vector<PhantomNode> &phantom_sources_array,
+               const std::vector<PhantomNode> &phantom_targets_array) const
+    {
+        BOOST_ASSERT(IsAvailable());
+        const auto number_of_sources = phantom_sources_array.size();
+        const auto number_of_targets = phantom_targets_array.size();
+        std::shared_ptr<std::vector<EdgeWeight>> result_table =
+            std::make_shared<std::vector<EdgeWeight>>(number_of_targets * number_of_sources,
+                                                      std::numeric_limits<EdgeWeight>::max());
+
+        const auto hierarchy = SelectRestrictedHierarchy(phantom_targets_array);
+
+        // the sweeps run on the worker threads, they have to check the deadline of this query
+        const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+        const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
+
+        // entries the sweeps cannot answer, by source and target
+        tbb::enumerable_thread_specific<std::vector<std::pair<std::size_t, std::size_t>>>
+            thread_loop_entries;
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_sources),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                ScopedQueryDeadline scoped_deadline(deadline);
+                DeadlineCheck deadline_check;
+                engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                    super::facade->GetNumberOfNodes());
+                QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+                std::vector<std::pair<NodeID, EdgeWeight>> upward_search_space;
+                std::vector<EdgeWeight> distances(hierarchy.nodes.size());
+                auto &loop_entries = thread_loop_entries.local();
+
+                for (auto source_id = range.begin(); source_id != range.end(); ++source_id)
+                {
+                    UpwardSearch(phantom_sources_array[source_id], query_heap, deadline_check,
+                                 upward_search_space);
+
+                    std::fill(distances.begin(), distances.end(), UNREACHED);
+                    for (const auto &settled : upward_search_space)
+                    {
+                        const auto index = hierarchy.index_of_node.find(settled.first);
+                        if (index != hierarchy.index_of_node.end())
+                        {
+                            distances[index->second] = settled.second;
+                        }
+                    }
+
+                    // downward sweep, every node only reads nodes swept before it
+                    for (std::size_t index = 0; index < hierarchy.nodes.size(); ++index)
+                    {
+                        deadline_check.Step();
+                        EdgeWeight distance = distances[index];
+                        for (auto arc = hierarchy.first_arc[index];
+                             arc != hierarchy.first_arc[index + 1]; ++arc)
+                        {
+                            distance = std::min(distance, distances[hierarchy.arcs[arc].from] +
+                                                              hierarchy.arcs[arc].weight);
+                        }
+                        distances[index] = distance;
+                    }
+
+                    for (std::size_t target_id = 0; target_id < number_of_targets; ++target_id)
+                    {
+                        const auto &phantom = phantom_targets_array[target_id];
+                        auto &current_distance =
+                            (*result_table)[source_id * number_of_targets + target_id];
+                        bool is_loop = false;
+                        if (SPECIAL_NODEID != phantom.forward_node_id)
+                        {
+                            is_loop |= !UpdateTargetDistance(
+                                phantom.forward_node_id, phantom.GetForwardWeightPlusOffset(),
+                                hierarchy, distances, current_distance);
+                        }
+                        if (SPECIAL_NODEID != phantom.reverse_node_id)
+                        {
+                            is_loop |= !UpdateTargetDistance(
+                                phantom.reverse_node_id, phantom.GetReverseWeightPlusOffset(),
+                                hierarchy, distances, current_distance);
+                        }
+                        if (is_loop)
+                        {
+                            loop_entries.emplace_back(source_id, target_id);
+                        }
+                    }
+                }
+            });
+
+        for (const auto &loop_entries : thread_loop_entries)
+        {
+            for (const auto &entry : loop_entries)
+            {
+                const auto loop_table = bucket_search({phantom_sources_array[entry.first]},
+                                                      {phantom_targets_array[entry.second]});
+                (*result_table)[entry.first * number_of_targets + entry.second] =
+                    loop_table->front();
+            }
+        }
+
+        return result_table;
+    }
+
+    // Distances from the source to the start of every node of the search graph,
+    // INVALID_EDGE_WEIGHT for nodes that cannot be reached. The nodes of the source segment are
+    // entered before the source, their distances are negative.
+    void OneToAll(const PhantomNode &source, std::vector<EdgeWeight> &node_distances) const
+    {
+        BOOST_ASSERT(IsAvailable());
+        const auto number_of_nodes = super::facade->GetNumberOfNodes();
+
+        DeadlineCheck deadline_check;
+        engine_working_data.InitializeOrClearFirstThreadLocalStorage(number_of_nodes);
+        QueryHeap &query_heap = *(engine_working_data.forward_heap_1);
+        std::vector<std::pair<NodeID, EdgeWeight>> upward_search_space;
+        UpwardSearch(source, query_heap, deadline_check, upward_search_space);
+
+        node_distances.assign(number_of_nodes, UNREACHED);
+        for (const auto &settled : upward_search_space)
+        {
+            node_distances[settled.first] = settled.second;
+        }
+
+        for (NodeID rank = 0; rank < number_of_nodes; ++rank)
+        {
+            deadline_check.Step();
+            const NodeID node = super::facade->GetNodeAtSweepRank(rank);
+            EdgeWeight distance = node_distances[node];
+            for (const auto edge : super::facade->GetAdjacentEdgeRange(node))
+            {
+                const auto &data = super::facade->GetEdgeData(edge);
+                if (data.backward)
+                {
+                    const NodeID from = super::facade->GetTarget(edge);
+                    distance = std::min(distance, node_distances[from] + data.distance);
+                }
+            }
+            node_distances[node] = distance;
+        }
+
+        std::replace_if(node_distances.begin(), node_distances.end(),
+                        [](const EdgeWeight distance)
+                        {
+                            return distance >= UNREACHED;
+                        },
+                        INVALID_EDGE_WEIGHT);
+    }
+
+  private:
+    // plain CH search along the upward edges, collects all settled nodes
+    void UpwardSearch(const PhantomNode &phantom,
+                      QueryHeap &query_heap,
+                      DeadlineCheck &deadline_check,
+                      std::vector<std::pair<NodeID, EdgeWeight>> &upward_search_space) const
+    {
+        query_heap.Clear();
+        upward_search_space.clear();
+        if (SPECIAL_NODEID != phantom.forward_node_id)
+        {
+            query_heap.Insert(phantom.forward_node_id, -phantom.GetForwardWeightPlusOffset(),
+                              phantom.forward_node_id);
+        }
+        if (SPECIAL_NODEID != phantom.reverse_node_id)
+        {
+            query_heap.Insert(phantom.reverse_node_id, -phantom.GetReverseWeightPlusOffset(),
+                              phantom.reverse_node_id);
+        }
+
+        while (!query_heap.Empty())
+        {
+            deadline_check.Step();
+            const NodeID node = query_heap.DeleteMin();
+            const EdgeWeight distance = query_heap.GetKey(node);
+            upward_search_space.emplace_back(node, distance);
+
+            for (const auto edge : super::facade->GetAdjacentEdgeRange(node))
+            {
+                const auto &data = super::facade->GetEdgeData(edge);
+                if (data.forward)
+                {
+                    const NodeID to = super::facade->GetTarget(edge);
+                    const EdgeWeight to_distance = distance + data.distance;
+                    if (!query_heap.WasInserted(to))
+                    {
+                        query_heap.Insert(to, to_distance, node);
+                    }
+                    else if (to_distance < query_heap.GetKey(to))
+                    {
+                        query_heap.GetData(to).parent = node;
+                        query_heap.DecreaseKey(to, to_distance);
+                    }
+                }
+            }
+        }
+    }
+
+    // All nodes that have a downward path to a target, i.e. the unpruned backward upward
+    // search spaces of the targets, together with the downward arcs between them.
+    RestrictedHierarchy
+    SelectRestrictedHierarchy(const std::vector<PhantomNode> &phantom_targets_array) const
+    {
+        RestrictedHierarchy hierarchy;
+        std::vector<NodeID> stack;
+        const auto select = [&](const NodeID node)
+        {
+            if (hierarchy.index_of_node.emplace(node, 0).second)
+            {
+                hierarchy.nodes.push_back(node);
+                stack.push_back(node);
+            }
+        };
+        for (const auto &phantom : phantom_targets_array)
+        {
+            if (SPECIAL_NODEID != phantom.forward_node_id)
+            {
+                select(phantom.forward_node_id);
+            }
+            if (SPECIAL_NODEID != phantom.reverse_node_id)
+            {
+                select(phantom.reverse_node_id);
+            }
+        }
+        while (!stack.empty())
+        {
+            const NodeID node = stack.back();
+            stack.pop_back();
+            for (const auto edge : super::facade->GetAdjacentEdgeRange(node))
+            {
+                if (super::facade->GetEdgeData(edge).backward)
+                {
+                    select(super::facade->GetTarget(edge));
+                }
+            }
+        }
+
+        std::sort(hierarchy.nodes.begin(), hierarchy.nodes.end(),
+                  [this](const NodeID lhs, const NodeID rhs)
+                  {
+                      return super::facade->GetSweepRank(lhs) < super::facade->GetSweepRank(rhs);
+                  });
+        for (unsigned index = 0; index < hierarchy.nodes.size(); ++index)
+        {
+            hierarchy.index_of_node[hierarchy.nodes[index]] = index;
+        }
+
+        hierarchy.first_arc.reserve(hierarchy.nodes.size() + 1);
+        for (const auto node : hierarchy.nodes)
+        {
+            hierarchy.first_arc.push_back(static_cast<unsigned>(hierarchy.arcs.size()));
+            for (const auto edge : super::facade->GetAdjacentEdgeRange(node))
+            {
+                const auto &data = super::facade->GetEdgeData(edge);
+                const NodeID from = super::facade->GetTarget(edge);
+                if (data.backward && from != node)
+                {
+                    BOOST_ASSERT(hierarchy.index_of_node.count(from) > 0);
+                    hierarchy.arcs.push_back({hierarchy.index_of_node[from], data.distance});
+                }
+            }
+        }
+        hierarchy.first_arc.push_back(static_cast<unsigned>(hierarchy.arcs.size()));
+        return hierarchy;
+    }
+
+    // false if source and target lie on the same segment in the wrong order
+    bool UpdateTargetDistance(const NodeID node,
+                              const EdgeWeight target_distance,
+                              const RestrictedHierarchy &hierarchy,
+                              const std::vector<EdgeWeight> &distances,
+                              EdgeWeight &current_distance) const
+    {
+        const EdgeWeight source_distance = distances[hierarchy.index_of_node.find(node)->second];
+        if (source_distance >= UNREACHED)
+        {
+            return true;
+        }
+        const EdgeWeight new_distance = source_distance + target_distance;
+        if (new_distance < 0)
+        {
+            return false;
+        }
+        current_distance = std::min(current_distance, new_distance);
+        return true;
+    }
+};
+
+template <class DataFacadeT> const constexpr EdgeWeight PHASTRouting<DataFacadeT>::UNREACHED;
+}
+}
+}
+
+#endif // PHAST_ROUTING_HPP
@@ -2,7 +2,10 @@
 #define ROUTING_BASE_HPP
 
 #include "util/coordinate_calculation.hpp"
+#include "contractor/shortcut_unpacking.hpp"
 #include "engine/internal_route_result.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/routing_algorithms/landmark_potential.hpp"
 #include "engine/search_engine_data.hpp"
 #include "extractor/turn_instructions.hpp"
 #include "util/typedefs.hpp"
@@ -23,13 +26,6 @@ namespace osrm
 namespace engine
 {
 
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_1;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_2;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_3;
-SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_3;
-
 namespace routing_algorithms
 {
 
@@ -194,6 +190,94 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         }
     }
 
+    /*
+    RoutingStep through the core guided by landmarks (ALT). The keys of the heaps are the
+    distances plus the lower bound on the remaining distance of the respective direction, nodes
+    that cannot be on a path between the entry points are not inserted at all.
+    Both directions use their own potential, so a direction is done as soon as its smallest key
+    is not below the upper bound. The distances are recovered by subtracting the potentials.
+    */
+    void CoreRoutingStep(SearchEngineData::QueryHeap &forward_heap,
+                         SearchEngineData::QueryHeap &reverse_heap,
+                         const CoreLandmarkPotential<DataFacadeT> &potential,
+                         NodeID &middle_node_id,
+                         std::int32_t &upper_bound,
+                         const bool forward_direction,
+                         const bool force_loop_forward,
+                         const bool force_loop_reverse) const
+    {
+        const auto get_potential = [&potential](const NodeID node, const bool forward)
+        {
+            return forward ? potential.ToTargets(node) : potential.FromSources(node);
+        };
+
+        const NodeID node = forward_heap.DeleteMin();
+        const std::int32_t distance =
+            forward_heap.GetKey(node) - get_potential(node, forward_direction);
+
+        if (reverse_heap.WasInserted(node))
+        {
+            const std::int32_t new_distance =
+                reverse_heap.GetKey(node) - get_potential(node, !forward_direction) + distance;
+            if (new_distance < upper_bound)
+            {
+                if (new_distance >= 0 &&
+                    (!force_loop_forward || forward_heap.GetData(node).parent != node) &&
+                    (!force_loop_reverse || reverse_heap.GetData(node).parent != node))
+                {
+                    middle_node_id = node;
+                    upper_bound = new_distance;
+                }
+                else
+                {
+                    // check whether there is a loop present at the node
+                    for (const auto edge : facade->GetAdjacentEdgeRange(node))
+                    {
+                        const EdgeData &data = facade->GetEdgeData(edge);
+                        if ((forward_direction ? data.forward : data.backward) &&
+                            facade->GetTarget(edge) == node)
+                        {
+                            const std::int32_t loop_distance = new_distance + data.distance;
+                            if (loop_distance >= 0 && loop_distance < upper_bound)
+                            {
+                                middle_node_id = node;
+                                upper_bound = loop_distance;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        for (const auto edge : facade->GetAdjacentEdgeRange(node))
+        {
+            const EdgeData &data = facade->GetEdgeData(edge);
+            if (forward_direction ? data.forward : data.backward)
+            {
+                const NodeID to = facade->GetTarget(edge);
+                const EdgeWeight edge_weight = data.distance;
+                BOOST_ASSERT_MSG(edge_weight > 0, "edge_weight invalid");
+
+                const EdgeWeight to_potential = get_potential(to, forward_direction);
+                if (INVALID_EDGE_WEIGHT == to_potential)
+                {
+                    continue;
+                }
+                const int to_key = distance + edge_weight + to_potential;
+
+                if (!forward_heap.WasInserted(to))
+                {
+                    forward_heap.Insert(to, to_key, node);
+                }
+                else if (to_key < forward_heap.GetKey(to))
+                {
+                    forward_heap.GetData(to).parent = node;
+                    forward_heap.DecreaseKey(to, to_key);
+                }
+            }
+        }
+    }
+
     inline EdgeWeight GetLoopWeight(NodeID node) const
     {
         EdgeWeight loop_weight = INVALID_EDGE_WEIGHT;
@@ -233,6 +317,50 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             recursion_stack.emplace(*std::prev(current), *current);
         }
 
+        const auto append_original_edge = [&](const EdgeData &ed)
+        {
+            BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
+            unsigned name_index = facade->GetNameIndexFromEdgeID(ed.id);
+            const extractor::TurnInstruction turn_instruction =
+                facade->GetTurnInstructionForEdgeID(ed.id);
+            const extractor::TravelMode travel_mode =
+                (unpacked_path.empty() && start_traversed_in_reverse)
+                    ? phantom_node_pair.source_phantom.backward_travel_mode
+                    : facade->GetTravelModeForEdgeID(ed.id);
+
+            if (!facade->EdgeIsCompressed(ed.id))
+            {
+                BOOST_ASSERT(!facade->EdgeIsCompressed(ed.id));
+                unpacked_path.emplace_back(facade->GetGeometryIndexForEdgeID(ed.id), name_index,
+                                           turn_instruction, ed.distance, travel_mode);
+            }
+            else
+            {
+                std::vector<unsigned> id_vector;
+                facade->GetUncompressedGeometry(facade->GetGeometryIndexForEdgeID(ed.id),
+                                                id_vector);
+
+                const std::size_t start_index =
+                    (unpacked_path.empty()
+                         ? ((start_traversed_in_reverse)
+                                ? id_vector.size() -
+                                      phantom_node_pair.source_phantom.fwd_segment_position - 1
+                                : phantom_node_pair.source_phantom.fwd_segment_position)
+                         : 0);
+                const std::size_t end_index = id_vector.size();
+
+                BOOST_ASSERT(start_index >= 0);
+                BOOST_ASSERT(start_index <= end_index);
+                for (std::size_t i = start_index; i < end_index; ++i)
+                {
+                    unpacked_path.emplace_back(id_vector[i], name_index,
+                                               extractor::TurnInstruction::NoTurn, 0, travel_mode);
+                }
+                unpacked_path.back().turn_instruction = turn_instruction;
+                unpacked_path.back().segment_duration = ed.distance;
+            }
+        };
+
         std::pair<NodeID, NodeID> edge;
         while (!recursion_stack.empty())
         {
@@ -243,41 +371,33 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             recursion_stack.pop();
 
             // facade->FindEdge does not suffice here in case of shortcuts.
-            // The above explanation unclear? Think!
-            EdgeID smaller_edge_id = SPECIAL_EDGEID;
-            EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
-            {
-                const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
-                {
-                    smaller_edge_id = edge_id;
-                    edge_weight = weight;
-                }
-            }
-
+            // The smallest forward edge at edge.first is used, if there is none the smallest
+            // backward edge at edge.second:
             // edge.first         edge.second
             //     *<------------------*
             //            edge_id
-            if (SPECIAL_EDGEID == smaller_edge_id)
+            bool reversed;
+            const EdgeID smaller_edge_id =
+                contractor::FindUnpackingEdge(*facade, edge.first, edge.second, reversed);
+            BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "edge id invalid");
+
+            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
+            if (ed.shortcut)
             {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
+                // long shortcuts may have been unpacked by osrm-contract already
+                const auto unpacked_shortcut =
+                    facade->GetUnpackedShortcut(smaller_edge_id, reversed);
+                if (unpacked_shortcut.first != unpacked_shortcut.second)
                 {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
+                    for (auto iter = unpacked_shortcut.first; iter != unpacked_shortcut.second;
+                         ++iter)
                     {
-                        smaller_edge_id = edge_id;
-                        edge_weight = weight;
+                        append_original_edge(facade->GetEdgeData(iter->edge));
                     }
+                    continue;
                 }
-            }
-            BOOST_ASSERT_MSG(edge_weight != INVALID_EDGE_WEIGHT, "edge id invalid");
 
-            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
-            if (ed.shortcut)
-            { // unpack
+                // unpack
                 const NodeID middle_node_id = ed.id;
                 // again, we need to this in reversed order
                 recursion_stack.emplace(middle_node_id, edge.second);
@@ -285,47 +405,7 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             }
             else
             {
-                BOOST_ASSERT_MSG(!ed.shortcut, "original edge flagged as shortcut");
-                unsigned name_index = facade->GetNameIndexFromEdgeID(ed.id);
-                const extractor::TurnInstruction turn_instruction =
-                    facade->GetTurnInstructionForEdgeID(ed.id);
-                const extractor::TravelMode travel_mode =
-                    (unpacked_path.empty() && start_traversed_in_reverse)
-                        ? phantom_node_pair.source_phantom.backward_travel_mode
-                        : facade->GetTravelModeForEdgeID(ed.id);
-
-                if (!facade->EdgeIsCompressed(ed.id))
-                {
-                    BOOST_ASSERT(!facade->EdgeIsCompressed(ed.id));
-                    unpacked_path.emplace_back(facade->GetGeometryIndexForEdgeID(ed.id), name_index,
-                                               turn_instruction, ed.distance, travel_mode);
-                }
-                else
-                {
-                    std::vector<unsigned> id_vector;
-                    facade->GetUncompressedGeometry(facade->GetGeometryIndexForEdgeID(ed.id),
-                                                    id_vector);
-
-                    const std::size_t start_index =
-                        (unpacked_path.empty()
-                             ? ((start_traversed_in_reverse)
-                                    ? id_vector.size() -
-                                          phantom_node_pair.source_phantom.fwd_segment_position - 1
-                                    : phantom_node_pair.source_phantom.fwd_segment_position)
-                             : 0);
-                    const std::size_t end_index = id_vector.size();
-
-                    BOOST_ASSERT(start_index >= 0);
-                    BOOST_ASSERT(start_index <= end_index);
-                    for (std::size_t i = start_index; i < end_index; ++i)
-                    {
-                        unpacked_path.emplace_back(id_vector[i], name_index,
-                                                   extractor::TurnInstruction::NoTurn, 0,
-                                                   travel_mode);
-                    }
-                    unpacked_path.back().turn_instruction = turn_instruction;
-                    unpacked_path.back().segment_duration = ed.distance;
-                }
+                append_original_edge(ed);
             }
         }
         if (SPECIAL_EDGEID != phantom_node_pair.target_phantom.packed_geometry_id)
@@ -406,38 +486,28 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             edge = recursion_stack.top();
             recursion_stack.pop();
 
-            EdgeID smaller_edge_id = SPECIAL_EDGEID;
-            EdgeWeight edge_weight = std::numeric_limits<EdgeWeight>::max();
-            for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.first))
-            {
-                const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                if ((facade->GetTarget(edge_id) == edge.second) && (weight < edge_weight) &&
-                    facade->GetEdgeData(edge_id).forward)
-                {
-                    smaller_edge_id = edge_id;
-                    edge_weight = weight;
-                }
-            }
+            bool reversed;
+            const EdgeID smaller_edge_id =
+                contractor::FindUnpackingEdge(*facade, edge.first, edge.second, reversed);
+            BOOST_ASSERT_MSG(smaller_edge_id != SPECIAL_EDGEID, "edge weight invalid");
 
-            if (SPECIAL_EDGEID == smaller_edge_id)
+            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
+            if (ed.shortcut)
             {
-                for (const auto edge_id : facade->GetAdjacentEdgeRange(edge.second))
+                // long shortcuts may have been unpacked by osrm-contract already
+                const auto unpacked_shortcut =
+                    facade->GetUnpackedShortcut(smaller_edge_id, reversed);
+                if (unpacked_shortcut.first != unpacked_shortcut.second)
                 {
-                    const EdgeWeight weight = facade->GetEdgeData(edge_id).distance;
-                    if ((facade->GetTarget(edge_id) == edge.first) && (weight < edge_weight) &&
-                        facade->GetEdgeData(edge_id).backward)
+                    for (auto iter = unpacked_shortcut.first; iter != unpacked_shortcut.second;
+                         ++iter)
                     {
-                        smaller_edge_id = edge_id;
-                        edge_weight = weight;
+                        unpacked_path.emplace_back(iter->source);
                     }
+                    continue;
                 }
-            }
-            BOOST_ASSERT_MSG(edge_weight != std::numeric_limits<EdgeWeight>::max(),
-                             "edge weight invalid");
 
-            const EdgeData &ed = facade->GetEdgeData(smaller_edge_id);
-            if (ed.shortcut)
-            { // unpack
+                // unpack
                 const NodeID middle_node_id = ed.id;
                 // again, we need to this in reversed order
                 recursion_stack.emplace(middle_node_id, edge.second);
@@ -504,8 +574,10 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
 
         // run two-Target Dijkstra routing step.
         const constexpr bool STALLING_ENABLED = true;
+        DeadlineCheck deadline_check;
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
+            deadline_check.Step();
             if (!forward_heap.Empty())
             {
                 RoutingStep(forward_heap, reverse_heap, middle, distance, min_edge_offset, true,
@@ -573,9 +645,11 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         BOOST_ASSERT(reverse_heap.MinKey() >= 0);
 
         const constexpr bool STALLING_ENABLED = true;
+        DeadlineCheck deadline_check;
         // run two-Target Dijkstra routing step.
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
+            deadline_check.Step();
             if (!forward_heap.Empty())
             {
                 if (facade->IsCoreNode(forward_heap.Min()))
@@ -615,6 +689,23 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         std::sort(forward_entry_points.begin(), forward_entry_points.end(), entry_point_comparator);
         std::sort(reverse_entry_points.begin(), reverse_entry_points.end(), entry_point_comparator);
 
+        // the keys of searches guided by landmarks include the potentials of their direction
+        const bool use_landmarks = facade->GetNumberOfCoreLandmarks() > 0;
+        const CoreLandmarkPotential<DataFacadeT> potential(facade, forward_entry_points,
+                                                           reverse_entry_points);
+        const auto get_core_key = [&](const NodeID node, const EdgeWeight distance_to_node,
+                                      const bool forward)
+        {
+            if (!use_landmarks)
+            {
+                return distance_to_node;
+            }
+            const EdgeWeight node_potential =
+                forward ? potential.ToTargets(node) : potential.FromSources(node);
+            return INVALID_EDGE_WEIGHT == node_potential ? INVALID_EDGE_WEIGHT
+                                                         : distance_to_node + node_potential;
+        };
+
         NodeID last_id = SPECIAL_NODEID;
         forward_core_heap.Clear();
         reverse_core_heap.Clear();
@@ -624,8 +715,12 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             {
                 continue;
             }
-            forward_core_heap.Insert(p.first, p.second, p.first);
             last_id = p.first;
+            const EdgeWeight key = get_core_key(p.first, p.second, true);
+            if (INVALID_EDGE_WEIGHT != key)
+            {
+                forward_core_heap.Insert(p.first, key, p.first);
+            }
         }
         last_id = SPECIAL_NODEID;
         for (const auto p : reverse_entry_points)
@@ -634,38 +729,62 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
             {
                 continue;
             }
-            reverse_core_heap.Insert(p.first, p.second, p.first);
             last_id = p.first;
+            const EdgeWeight key = get_core_key(p.first, p.second, false);
+            if (INVALID_EDGE_WEIGHT != key)
+            {
+                reverse_core_heap.Insert(p.first, key, p.first);
+            }
         }
 
-        // get offset to account for offsets on phantom nodes on compressed edges
-        int min_core_edge_offset = 0;
-        if (forward_core_heap.Size() > 0)
-        {
-            min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
-        }
-        if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
+        if (use_landmarks)
         {
-            min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+            // a direction with no key below the upper bound cannot improve it anymore
+            while (!forward_core_heap.Empty() && !reverse_core_heap.Empty() &&
+                   forward_core_heap.MinKey() < distance && reverse_core_heap.MinKey() < distance)
+            {
+                deadline_check.Step();
+                CoreRoutingStep(forward_core_heap, reverse_core_heap, potential, middle, distance,
+                                true, force_loop_forward, force_loop_reverse);
+                if (!reverse_core_heap.Empty())
+                {
+                    CoreRoutingStep(reverse_core_heap, forward_core_heap, potential, middle,
+                                    distance, false, force_loop_reverse, force_loop_forward);
+                }
+            }
         }
-        BOOST_ASSERT(min_core_edge_offset <= 0);
-
-        // run two-target Dijkstra routing step on core with termination criterion
-        const constexpr bool STALLING_DISABLED = false;
-        while (0 < (forward_core_heap.Size() + reverse_core_heap.Size()) &&
-               distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+        else
         {
-            if (!forward_core_heap.Empty())
+            // get offset to account for offsets on phantom nodes on compressed edges
+            int min_core_edge_offset = 0;
+            if (forward_core_heap.Size() > 0)
             {
-                RoutingStep(forward_core_heap, reverse_core_heap, middle, distance,
-                            min_core_edge_offset, true, STALLING_DISABLED, force_loop_forward,
-                            force_loop_reverse);
+                min_core_edge_offset = std::min(min_core_edge_offset, forward_core_heap.MinKey());
             }
-            if (!reverse_core_heap.Empty())
+            if (reverse_core_heap.Size() > 0 && reverse_core_heap.MinKey() < 0)
             {
-                RoutingStep(reverse_core_heap, forward_core_heap, middle, distance,
-                            min_core_edge_offset, false, STALLING_DISABLED, force_loop_reverse,
-                            force_loop_forward);
+                min_core_edge_offset = std::min(min_core_edge_offset, reverse_core_heap.MinKey());
+            }
+            BOOST_ASSERT(min_core_edge_offset <= 0);
+
+            // run two-target Dijkstra routing step on core with termination criterion
+            const constexpr bool STALLING_DISABLED = false;
+            while (0 < (forward_core_heap.Size() + reverse_core_heap.Size()) &&
+                   distance > (forward_core_heap.MinKey() + reverse_core_heap.MinKey()))
+            {
+                deadline_check.Step();
+                if (!forward_core_heap.Empty())
+                {
+                    RoutingStep(forward_core_heap, reverse_core_heap, middle, distance,
+                                min_core_edge_offset, true, STALLING_DISABLED, force_loop_forward,
+                                force_loop_reverse);
+                }
+                if (!reverse_core_heap.Empty())
+                {
+                    RoutingStep(reverse_core_heap, forward_core_heap, middle, distance,
+                                min_core_edge_offset, false, STALLING_DISABLED, force_loop_reverse,
+                                force_loop_forward);
+                }
             }
         }
 
@@ -682,7 +801,10 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // we need to unpack sub path from core heaps
         if (facade->IsCoreNode(middle))
         {
-            if (distance != forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle))
+            const EdgeWeight core_distance =
+                forward_core_heap.GetKey(middle) + reverse_core_heap.GetKey(middle) -
+                (use_landmarks ? potential.ToTargets(middle) + potential.FromSources(middle) : 0);
+            if (distance != core_distance)
             {
                 // self loop
                 BOOST_ASSERT(forward_core_heap.GetData(middle).parent == middle &&
@@ -763,8 +885,10 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
         // search from s and t till new_min/(1+epsilon) > length_of_shortest_path
         const constexpr bool STALLING_ENABLED = true;
         const constexpr bool DO_NOT_FORCE_LOOPS = false;
+        DeadlineCheck deadline_check;
         while (0 < (forward_heap.Size() + reverse_heap.Size()))
         {
+            deadline_check.Step();
             if (0 < forward_heap.Size())
             {
                 RoutingStep(forward_heap, reverse_heap, middle_node, upper_bound, edge_offset, true,
@@ -794,25 +918,37 @@ template <class DataFacadeT, class Derived> class BasicRoutingInterface
                 RetrievePackedPathFromHeap(forward_heap, reverse_heap, middle_node, packed_leg);
             }
 
-            std::vector<PathData> unpacked_path;
-            PhantomNodes nodes;
-            nodes.source_phantom = source_phantom;
-            nodes.target_phantom = target_phantom;
-            UnpackPath(packed_leg.begin(), packed_leg.end(), nodes, unpacked_path);
+            distance = GetPathDistance(packed_leg.begin(), packed_leg.end(), source_phantom,
+                                       target_phantom);
+        }
+        return distance;
+    }
 
-            util::FixedPointCoordinate previous_coordinate = source_phantom.location;
-            util::FixedPointCoordinate current_coordinate;
-            distance = 0;
-            for (const auto &p : unpacked_path)
-            {
-                current_coordinate = facade->GetCoordinateOfNode(p.node);
-                distance += util::coordinate_calculation::haversineDistance(previous_coordinate,
-                                                                            current_coordinate);
-                previous_coordinate = current_coordinate;
-            }
+    // Length in meters of a packed path between two phantom nodes
+    template <typename RandomIter>
+    double GetPathDistance(RandomIter packed_path_begin,
+                           RandomIter packed_path_end,
+                           const PhantomNode &source_phantom,
+                           const PhantomNode &target_phantom) const
+    {
+        std::vector<PathData> unpacked_path;
+        PhantomNodes nodes;
+        nodes.source_phantom = source_phantom;
+        nodes.target_phantom = target_phantom;
+        UnpackPath(packed_path_begin, packed_path_end, nodes, unpacked_path);
+
+        util::FixedPointCoordinate previous_coordinate = source_phantom.location;
+        util::FixedPointCoordinate current_coordinate;
+        double distance = 0;
+        for (const auto &p : unpacked_path)
+        {
+            current_coordinate = facade->GetCoordinateOfNode(p.node);
             distance += util::coordinate_calculation::haversineDistance(previous_coordinate,
-                                                                        target_phantom.location);
+                                                                        current_coordinate);
+            previous_coordinate = current_coordinate;
         }
+        distance += util::coordinate_calculation::haversineDistance(previous_coordinate,
+                                                                    target_phantom.location);
         return distance;
     }
 };
@@ -5,11 +5,14 @@
 
 #include "engine/routing_algorithms/routing_base.hpp"
 
+#include "engine/query_deadline.hpp"
 #include "engine/search_engine_data.hpp"
 #include "util/integer_range.hpp"
 
 #include <boost/assert.hpp>
 
+#include <tbb/parallel_for.h>
+
 namespace osrm
 {
 namespace engine
@@ -182,18 +185,29 @@ class ShortestPathRouting final
                     const int shortest_path_length,
                     InternalRouteResult &raw_route_data) const
     {
-        raw_route_data.unpacked_path_segments.resize(packed_leg_begin.size() - 1);
+        const auto number_of_legs = packed_leg_begin.size() - 1;
+        raw_route_data.unpacked_path_segments.resize(number_of_legs);
 
         raw_route_data.shortest_path_length = shortest_path_length;
 
-        for (const auto current_leg : util::irange<std::size_t>(0, packed_leg_begin.size() - 1))
+        // legs are unpacked independently of each other
+        tbb::parallel_for(
+            tbb::blocked_range<std::size_t>(0, number_of_legs),
+            [&](const tbb::blocked_range<std::size_t> &range)
+            {
+                for (auto current_leg = range.begin(); current_leg != range.end(); ++current_leg)
+                {
+                    auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
+                    auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
+                    super::UnpackPath(leg_begin, leg_end, phantom_nodes_vector[current_leg],
+                                      raw_route_data.unpacked_path_segments[current_leg]);
+                }
+            });
+
+        for (const auto current_leg : util::irange<std::size_t>(0, number_of_legs))
         {
             auto leg_begin = total_packed_path.begin() + packed_leg_begin[current_leg];
             auto leg_end = total_packed_path.begin() + packed_leg_begin[current_leg + 1];
-            const auto &unpack_phantom_node_pair = phantom_nodes_vector[current_leg];
-            super::UnpackPath(leg_begin, leg_end, unpack_phantom_node_pair,
-                              raw_route_data.unpacked_path_segments[current_leg]);
-
             raw_route_data.source_traversed_in_reverse.push_back(
                 (*leg_begin != phantom_nodes_vector[current_leg].source_phantom.forward_node_id));
             raw_route_data.target_traversed_in_reverse.push_back(
@@ -207,18 +221,107 @@ class ShortestPathRouting final
                     InternalRouteResult &raw_route_data) const
     {
         BOOST_ASSERT(uturn_indicators.size() == phantom_nodes_vector.size() + 1);
-        engine_working_data.InitializeOrClearFirstThreadLocalStorage(
-            super::facade->GetNumberOfNodes());
 
-        QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
-        QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
+        // A u-turn at a via lets the next leg start from both of its nodes at the same distance,
+        // so the legs after it do not depend on how the via was reached. Such independent runs
+        // of legs are searched in parallel, the legs within a run have to be chained.
+        std::vector<std::size_t> run_begin(1, 0);
+        for (const auto leg : util::irange<std::size_t>(1, phantom_nodes_vector.size()))
+        {
+            if (uturn_indicators[leg])
+            {
+                run_begin.push_back(leg);
+            }
+        }
+        run_begin.push_back(phantom_nodes_vector.size());
+        const auto number_of_runs = run_begin.size() - 1;
+
+        std::vector<PackedLegs> runs(number_of_runs);
+        if (number_of_runs == 1)
+        {
+            engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                super::facade->GetNumberOfNodes());
+            SearchLegs(phantom_nodes_vector, uturn_indicators, 0, phantom_nodes_vector.size(),
+                       *(engine_working_data.forward_heap_1),
+                       *(engine_working_data.reverse_heap_1), runs.front());
+        }
+        else
+        {
+            // the searches run on the worker threads, they have to check the deadline of this query
+            const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+            const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
 
+            tbb::parallel_for(
+                tbb::blocked_range<std::size_t>(0, number_of_runs),
+                [&](const tbb::blocked_range<std::size_t> &range)
+                {
+                    ScopedQueryDeadline scoped_deadline(deadline);
+                    engine_working_data.InitializeOrClearFirstThreadLocalStorage(
+                        super::facade->GetNumberOfNodes());
+                    QueryHeap &forward_heap = *(engine_working_data.forward_heap_1);
+                    QueryHeap &reverse_heap = *(engine_working_data.reverse_heap_1);
+                    for (auto run = range.begin(); run != range.end(); ++run)
+                    {
+                        SearchLegs(phantom_nodes_vector, uturn_indicators, run_begin[run],
+                                   run_begin[run + 1], forward_heap, reverse_heap, runs[run]);
+                    }
+                });
+        }
+
+        std::vector<NodeID> total_packed_path;
+        std::vector<std::size_t> packed_leg_begin;
+        packed_leg_begin.reserve(phantom_nodes_vector.size() + 1);
+        int shortest_path_length = 0;
+        for (const auto &run : runs)
+        {
+            // No path found for one of the legs?
+            if (INVALID_EDGE_WEIGHT == run.distance)
+            {
+                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
+                raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
+                return;
+            }
+            for (const auto leg_begin : run.packed_leg_begin)
+            {
+                packed_leg_begin.push_back(total_packed_path.size() + leg_begin);
+            }
+            total_packed_path.insert(total_packed_path.end(), run.packed_path.begin(),
+                                     run.packed_path.end());
+            shortest_path_length += run.distance;
+        }
+
+        // insert sentinel
+        packed_leg_begin.push_back(total_packed_path.size());
+        BOOST_ASSERT(packed_leg_begin.size() == phantom_nodes_vector.size() + 1);
+
+        UnpackLegs(phantom_nodes_vector, total_packed_path, packed_leg_begin,
+                   shortest_path_length, raw_route_data);
+    }
+
+    // packed path of consecutive legs, each leg starts at packed_leg_begin
+    struct PackedLegs
+    {
+        std::vector<NodeID> packed_path;
+        std::vector<std::size_t> packed_leg_begin;
+        int distance = INVALID_EDGE_WEIGHT;
+    };
+
+    // Shortest route through the legs [first_leg, last_leg) that starts at any node of the first
+    // source. The distance of the result stays invalid if one of the legs has no path.
+    void SearchLegs(const std::vector<PhantomNodes> &phantom_nodes_vector,
+                    const std::vector<bool> &uturn_indicators,
+                    const std::size_t first_leg,
+                    const std::size_t last_leg,
+                    QueryHeap &forward_heap,
+                    QueryHeap &reverse_heap,
+                    PackedLegs &result) const
+    {
         int total_distance_to_forward = 0;
         int total_distance_to_reverse = 0;
         bool search_from_forward_node =
-            phantom_nodes_vector.front().source_phantom.forward_node_id != SPECIAL_NODEID;
+            phantom_nodes_vector[first_leg].source_phantom.forward_node_id != SPECIAL_NODEID;
         bool search_from_reverse_node =
-            phantom_nodes_vector.front().source_phantom.reverse_node_id != SPECIAL_NODEID;
+            phantom_nodes_vector[first_leg].source_phantom.reverse_node_id != SPECIAL_NODEID;
 
         std::vector<NodeID> prev_packed_leg_to_forward;
         std::vector<NodeID> prev_packed_leg_to_reverse;
@@ -228,11 +331,11 @@ class ShortestPathRouting final
         std::vector<NodeID> total_packed_path_to_reverse;
         std::vector<std::size_t> packed_leg_to_reverse_begin;
 
-        std::size_t current_leg = 0;
         // this implements a dynamic program that finds the shortest route through
         // a list of vias
-        for (const auto &phantom_node_pair : phantom_nodes_vector)
+        for (auto current_leg = first_leg; current_leg < last_leg; ++current_leg)
         {
+            const auto &phantom_node_pair = phantom_nodes_vector[current_leg];
             int new_total_distance_to_forward = INVALID_EDGE_WEIGHT;
             int new_total_distance_to_reverse = INVALID_EDGE_WEIGHT;
 
@@ -294,13 +397,11 @@ class ShortestPathRouting final
             if ((INVALID_EDGE_WEIGHT == new_total_distance_to_forward) &&
                 (INVALID_EDGE_WEIGHT == new_total_distance_to_reverse))
             {
-                raw_route_data.shortest_path_length = INVALID_EDGE_WEIGHT;
-                raw_route_data.alternative_path_length = INVALID_EDGE_WEIGHT;
                 return;
             }
 
             // we need to figure out how the new legs connect to the previous ones
-            if (current_leg > 0)
+            if (current_leg > first_leg)
             {
                 bool forward_to_forward =
                     (new_total_distance_to_forward != INVALID_EDGE_WEIGHT) &&
@@ -385,8 +486,6 @@ class ShortestPathRouting final
 
             total_distance_to_forward = new_total_distance_to_forward;
             total_distance_to_reverse = new_total_distance_to_reverse;
-
-            ++current_leg;
         }
 
         BOOST_ASSERT(total_distance_to_forward != INVALID_EDGE_WEIGHT ||
@@ -395,22 +494,17 @@ class ShortestPathRouting final
         // We make sure the fastest route is always in packed_legs_to_forward
         if (total_distance_to_forward > total_distance_to_reverse)
         {
-            // insert sentinel
-            packed_leg_to_reverse_begin.push_back(total_packed_path_to_reverse.size());
-            BOOST_ASSERT(packed_leg_to_reverse_begin.size() == phantom_nodes_vector.size() + 1);
-
-            UnpackLegs(phantom_nodes_vector, total_packed_path_to_reverse,
-                       packed_leg_to_reverse_begin, total_distance_to_reverse, raw_route_data);
+            result.packed_path = std::move(total_packed_path_to_reverse);
+            result.packed_leg_begin = std::move(packed_leg_to_reverse_begin);
+            result.distance = total_distance_to_reverse;
         }
         else
         {
-            // insert sentinel
-            packed_leg_to_forward_begin.push_back(total_packed_path_to_forward.size());
-            BOOST_ASSERT(packed_leg_to_forward_begin.size() == phantom_nodes_vector.size() + 1);
-
-            UnpackLegs(phantom_nodes_vector, total_packed_path_to_forward,
-                       packed_leg_to_forward_begin, total_distance_to_forward, raw_route_data);
+            result.packed_path = std::move(total_packed_path_to_forward);
+            result.packed_leg_begin = std::move(packed_leg_to_forward_begin);
+            result.distance = total_distance_to_forward;
         }
+        BOOST_ASSERT(result.packed_leg_begin.size() == last_leg - first_leg);
     }
 };
 }
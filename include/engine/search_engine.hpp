@@ -5,6 +5,7 @@
 #include "engine/routing_algorithms/alternative_path.hpp"
 #include "engine/routing_algorithms/many_to_many.hpp"
 #include "engine/routing_algorithms/map_matching.hpp"
+#include "engine/routing_algorithms/phast.hpp"
 #include "engine/routing_algorithms/shortest_path.hpp"
 #include "engine/routing_algorithms/direct_shortest_path.hpp"
 
@@ -27,12 +28,14 @@ template <class DataFacadeT> class SearchEngine
     routing_algorithms::AlternativeRouting<DataFacadeT> alternative_path;
     routing_algorithms::ManyToManyRouting<DataFacadeT> distance_table;
     routing_algorithms::MapMatching<DataFacadeT> map_matching;
+    routing_algorithms::PHASTRouting<DataFacadeT> phast;
 
     explicit SearchEngine(DataFacadeT *facade)
         : facade(facade), shortest_path(facade, engine_working_data),
           direct_shortest_path(facade, engine_working_data),
           alternative_path(facade, engine_working_data),
-          distance_table(facade, engine_working_data), map_matching(facade, engine_working_data)
+          distance_table(facade, engine_working_data), map_matching(facade, engine_working_data),
+          phast(facade, engine_working_data)
     {
         static_assert(!std::is_pointer<DataFacadeT>::value, "don't instantiate with ptr type");
         static_assert(std::is_object<DataFacadeT>::value,
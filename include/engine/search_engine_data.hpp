@@ -6,10 +6,17 @@
 #include "util/typedefs.hpp"
 #include "util/binary_heap.hpp"
 
+#include <atomic>
+#include <cstdint>
+
 namespace osrm
 {
 namespace engine
 {
+namespace map_matching
+{
+struct HiddenMarkovModel;
+}
 
 struct HeapData
 {
@@ -17,11 +24,72 @@ struct HeapData
     /* explicit */ HeapData(NodeID p) : parent(p) {}
 };
 
+// Work done by all searches of one thread. Only the owning thread writes, the counters are
+// atomic so that they can be read from other threads at any time.
+struct SearchEffortCounters
+{
+    std::atomic<std::uint64_t> heap_pops{0};
+    std::atomic<std::uint64_t> edge_relaxations{0};
+};
+
+// Totals over all threads
+struct SearchEffort
+{
+    std::uint64_t heap_pops;
+    std::uint64_t edge_relaxations;
+};
+
+// Heap of all searches. Any heap with the interface of util::BinaryHeap can be plugged in here,
+// e.g. util::DAryHeap, or util::RadixHeap as long as all edge weights are non-negative.
+// heap-bench compares them on recorded searches.
+using QueryHeapPolicy =
+    util::BinaryHeap<NodeID, NodeID, int, HeapData, util::SelectableStorage<NodeID, int>>;
+
+// Heap that accounts its pops and successful edge relaxations (insertions and key decreases) to
+// the search effort of the thread that created it
+class CountingQueryHeap final : public QueryHeapPolicy
+{
+    using BaseHeap = QueryHeapPolicy;
+
+  public:
+    CountingQueryHeap(const std::size_t max_id, const bool use_dense_storage);
+
+    void Insert(NodeID node, int weight, const HeapData &data)
+    {
+        Increment(counters.edge_relaxations);
+        BaseHeap::Insert(node, weight, data);
+    }
+
+    NodeID DeleteMin()
+    {
+        Increment(counters.heap_pops);
+        return BaseHeap::DeleteMin();
+    }
+
+    void DecreaseKey(NodeID node, int weight)
+    {
+        Increment(counters.edge_relaxations);
+        BaseHeap::DecreaseKey(node, weight);
+    }
+
+    std::size_t GetMaxID() const { return max_id; }
+
+  private:
+    // no other thread writes, so there is no need for an atomic read-modify-write
+    static void Increment(std::atomic<std::uint64_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    SearchEffortCounters &counters;
+    const std::size_t max_id;
+};
+
 struct SearchEngineData
 {
-    using QueryHeap =
-        util::BinaryHeap<NodeID, NodeID, int, HeapData, util::UnorderedMapStorage<NodeID, int>>;
+    using QueryHeap = CountingQueryHeap;
     using SearchEngineHeapPtr = boost::thread_specific_ptr<QueryHeap>;
+    using NodeSlotStorage = util::GenerationStampedStorage<NodeID, unsigned>;
 
     static SearchEngineHeapPtr forward_heap_1;
     static SearchEngineHeapPtr reverse_heap_1;
@@ -35,6 +103,24 @@ struct SearchEngineData
     void InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes);
 
     void InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes);
+
+    // Heaps for datasets with at most this many nodes index them with a dense array instead of a
+    // hash map. Only affects heaps created afterwards.
+    static void SetMaxDenseHeapNodes(const std::size_t max_nodes);
+
+    // counters of the calling thread, they outlive the thread
+    static SearchEffortCounters &GetThreadSearchEffort();
+
+    // cumulative effort of all searches since startup
+    static SearchEffort GetTotalSearchEffort();
+
+    // Slots of the nodes reached by the bundled table searches of the calling thread, see
+    // ManyToManyRouting. Always dense, 8 bytes per node, only threads that ran such a search
+    // allocate it.
+    static NodeSlotStorage &InitializeOrClearThreadNodeSlots(const unsigned number_of_nodes);
+
+    // model of the map matching queries of the calling thread, it keeps its memory between them
+    static map_matching::HiddenMarkovModel &GetThreadHiddenMarkovModel();
 };
 }
 }
@@ -0,0 +1,364 @@
+#ifndef TRIP_BRANCH_AND_BOUND_HPP
+#define TRIP_BRANCH_AND_BOUND_HPP
+
+#include "engine/query_deadline.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// Sets of locations are bitmasks
+const constexpr std::size_t BRANCH_AND_BOUND_MAX_LOCATIONS = 24;
+
+// Depth first search over all round trips that start at the first location of a given trip.
+// A partial trip is cut off if
+//  - a lower bound on its completions is not shorter than the best trip known, which at first
+//    is the given one, or
+//  - a partial trip over the same locations that ends at the same one was not longer. Every
+//    thread remembers a limited number of them.
+// The subtrees of the first two locations after the start are searched in parallel.
+class BranchAndBound
+{
+    using Clock = std::chrono::steady_clock;
+    using Set = std::uint32_t;
+
+  public:
+    BranchAndBound(const std::vector<NodeID> &trip,
+                   const util::DistTableWrapper<EdgeWeight> &dist_table,
+                   const Clock::time_point stop_time)
+        : locations(trip), number_of_locations(trip.size()),
+          weights(number_of_locations * number_of_locations), outgoing(number_of_locations),
+          stop_time(stop_time), stopped(false)
+    {
+        BOOST_ASSERT(number_of_locations <= BRANCH_AND_BOUND_MAX_LOCATIONS);
+        for (const auto from : util::irange<std::size_t>(0, number_of_locations))
+        {
+            for (const auto to : util::irange<std::size_t>(0, number_of_locations))
+            {
+                const auto weight = dist_table(locations[from], locations[to]);
+                BOOST_ASSERT_MSG(weight != INVALID_EDGE_WEIGHT, "invalid distance found");
+                weights[from * number_of_locations + to] = weight;
+            }
+        }
+
+        // the closest locations are tried first, they likely lead to short trips
+        for (const auto location : util::irange<std::size_t>(0, number_of_locations))
+        {
+            auto &out = outgoing[location];
+            for (const auto other : util::irange<std::size_t>(0, number_of_locations))
+            {
+                if (other != location)
+                {
+                    out.push_back(other);
+                }
+            }
+            std::sort(out.begin(), out.end(), [&](const std::size_t lhs, const std::size_t rhs)
+                      {
+                          return Weight(location, lhs) < Weight(location, rhs);
+                      });
+        }
+    }
+
+    // Returns the shortest trip, or the shortest one found if the time ran out
+    std::vector<NodeID> Run()
+    {
+        std::vector<std::size_t> trip(number_of_locations);
+        std::iota(trip.begin(), trip.end(), 0);
+        best_length = Length(trip);
+        best_trip = trip;
+        if (number_of_locations < 4)
+        {
+            return locations;
+        }
+
+        // every pair of first locations is a task, the closest ones first
+        std::vector<std::pair<std::size_t, std::size_t>> tasks;
+        for (const auto first : outgoing[0])
+        {
+            for (const auto second : outgoing[first])
+            {
+                if (second != 0)
+                {
+                    tasks.emplace_back(first, second);
+                }
+            }
+        }
+
+        tbb::enumerable_thread_specific<ShortestPaths> thread_shortest_paths;
+        const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+        const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, tasks.size()),
+                          [&](const tbb::blocked_range<std::size_t> &range)
+                          {
+                              ScopedQueryDeadline scoped_deadline(deadline);
+                              DeadlineCheck deadline_check;
+                              unsigned steps = 0;
+                              auto &shortest_paths = thread_shortest_paths.local();
+                              std::vector<std::size_t> partial_trip;
+                              partial_trip.reserve(number_of_locations);
+                              for (auto i = range.begin(); i != range.end(); ++i)
+                              {
+                                  const auto &task = tasks[i];
+                                  partial_trip = {0, task.first, task.second};
+                                  const Set visited = 1u | (1u << task.first) |
+                                                      (1u << task.second);
+                                  const std::int64_t length =
+                                      Weight(0, task.first) + Weight(task.first, task.second);
+                                  Search(partial_trip, visited, length, deadline_check, steps,
+                                         shortest_paths);
+                              }
+                          });
+
+        std::vector<NodeID> route(number_of_locations);
+        std::transform(best_trip.begin(), best_trip.end(), route.begin(),
+                       [this](const std::size_t location)
+                       {
+                           return locations[location];
+                       });
+        return route;
+    }
+
+  private:
+    static const constexpr unsigned CLOCK_CHECK_INTERVAL = 64;
+    static const constexpr std::size_t MAX_SHORTEST_PATHS = 1 << 16;
+
+    // shortest length of the partial trips searched per set of locations and last location
+    using ShortestPaths = std::unordered_map<std::uint64_t, std::int64_t>;
+
+    std::int64_t Weight(const std::size_t from, const std::size_t to) const
+    {
+        return weights[from * number_of_locations + to];
+    }
+
+    std::int64_t Length(const std::vector<std::size_t> &trip) const
+    {
+        std::int64_t length = 0;
+        for (const auto i : util::irange<std::size_t>(0, trip.size()))
+        {
+            length += Weight(trip[i], trip[(i + 1) % trip.size()]);
+        }
+        return length;
+    }
+
+    // The remaining trip leaves current and every unvisited location once and enters every
+    // unvisited location and the start once, so it is an assignment of the ones to the others.
+    // The shortest assignment is found with the Hungarian method in O(n^3).
+    std::int64_t LowerBound(const std::size_t current, const Set visited) const
+    {
+        const Set all = (1u << number_of_locations) - 1;
+        const Set unvisited = all & ~visited;
+
+        // rows are left, columns are entered, both 1-based as the method needs a dummy 0
+        using Line = std::array<std::size_t, BRANCH_AND_BOUND_MAX_LOCATIONS + 1>;
+        using Potential = std::array<std::int64_t, BRANCH_AND_BOUND_MAX_LOCATIONS + 1>;
+        Line rows;
+        Line columns;
+        std::size_t size = 0;
+        ++size;
+        rows[size] = current;
+        columns[size] = 0;
+        for (const auto location : util::irange<std::size_t>(0, number_of_locations))
+        {
+            if (unvisited & (1u << location))
+            {
+                ++size;
+                rows[size] = location;
+                columns[size] = location;
+            }
+        }
+        BOOST_ASSERT(size > 1);
+
+        // current can not go back to the start before the others are visited
+        const std::int64_t forbidden = std::numeric_limits<std::int32_t>::max();
+        const auto cost = [&](const std::size_t row, const std::size_t column)
+        {
+            const auto from = rows[row];
+            const auto to = columns[column];
+            return (from == to || (from == current && to == 0)) ? forbidden : Weight(from, to);
+        };
+
+        Potential row_potential;
+        Potential column_potential;
+        Line match; // row matched to a column
+        Line way;
+        row_potential.fill(0);
+        column_potential.fill(0);
+        match.fill(0);
+        for (const auto row : util::irange<std::size_t>(1, size + 1))
+        {
+            match[0] = row;
+            std::size_t column = 0;
+            Potential slack;
+            slack.fill(std::numeric_limits<std::int64_t>::max());
+            std::array<bool, BRANCH_AND_BOUND_MAX_LOCATIONS + 1> used;
+            used.fill(false);
+            do
+            {
+                used[column] = true;
+                const auto matched_row = match[column];
+                std::int64_t delta = std::numeric_limits<std::int64_t>::max();
+                std::size_t next_column = 0;
+                for (const auto other : util::irange<std::size_t>(1, size + 1))
+                {
+                    if (used[other])
+                    {
+                        continue;
+                    }
+                    const auto reduced = cost(matched_row, other) - row_potential[matched_row] -
+                                         column_potential[other];
+                    if (reduced < slack[other])
+                    {
+                        slack[other] = reduced;
+                        way[other] = column;
+                    }
+                    if (slack[other] < delta)
+                    {
+                        delta = slack[other];
+                        next_column = other;
+                    }
+                }
+                for (const auto other : util::irange<std::size_t>(0, size + 1))
+                {
+                    if (used[other])
+                    {
+                        row_potential[match[other]] += delta;
+                        column_potential[other] -= delta;
+                    }
+                    else
+                    {
+                        slack[other] -= delta;
+                    }
+                }
+                column = next_column;
+            } while (match[column] != 0);
+            do
+            {
+                const auto previous = way[column];
+                match[column] = match[previous];
+                column = previous;
+            } while (column != 0);
+        }
+        return -column_potential[0];
+    }
+
+    void Search(std::vector<std::size_t> &partial_trip,
+                const Set visited,
+                const std::int64_t length,
+                DeadlineCheck &deadline_check,
+                unsigned &steps,
+                ShortestPaths &shortest_paths)
+    {
+        deadline_check.Step();
+        if (stopped.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (++steps % CLOCK_CHECK_INTERVAL == 0 && Clock::now() >= stop_time)
+        {
+            stopped.store(true, std::memory_order_relaxed);
+            return;
+        }
+
+        const std::size_t current = partial_trip.back();
+        if (partial_trip.size() == number_of_locations)
+        {
+            const auto trip_length = length + Weight(current, 0);
+            std::lock_guard<std::mutex> lock(best_trip_mutex);
+            if (trip_length < best_length.load(std::memory_order_relaxed))
+            {
+                best_length.store(trip_length, std::memory_order_relaxed);
+                best_trip = partial_trip;
+            }
+            return;
+        }
+
+        // a shorter path over the same locations to the same one was searched already,
+        // locations fit into 5 bits
+        const auto key = (static_cast<std::uint64_t>(visited) << 5) | current;
+        const auto shortest = shortest_paths.find(key);
+        if (shortest != shortest_paths.end())
+        {
+            if (shortest->second <= length)
+            {
+                return;
+            }
+            shortest->second = length;
+        }
+        else if (shortest_paths.size() < MAX_SHORTEST_PATHS)
+        {
+            shortest_paths.emplace(key, length);
+        }
+
+        if (length + LowerBound(current, visited) >= best_length.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        for (const auto next : outgoing[current])
+        {
+            if (visited & (1u << next))
+            {
+                continue;
+            }
+            partial_trip.push_back(next);
+            Search(partial_trip, visited | (1u << next), length + Weight(current, next),
+                   deadline_check, steps, shortest_paths);
+            partial_trip.pop_back();
+        }
+    }
+
+    const std::vector<NodeID> locations;
+    const std::size_t number_of_locations;
+    std::vector<std::int64_t> weights;
+    std::vector<std::vector<std::size_t>> outgoing;
+
+    const Clock::time_point stop_time;
+    std::atomic<bool> stopped;
+
+    std::atomic<std::int64_t> best_length;
+    std::mutex best_trip_mutex;
+    std::vector<std::size_t> best_trip;
+};
+
+// Finds the shortest round trip that starts where the given one does. The given trip is the
+// first upper bound, so a good one makes the search fast. If the search does not finish within
+// the time budget the shortest trip found so far is returned.
+inline std::vector<NodeID> BranchAndBoundTrip(const std::vector<NodeID> &trip,
+                                              const util::DistTableWrapper<EdgeWeight> &dist_table,
+                                              const std::chrono::milliseconds time_budget)
+{
+    if (trip.size() < 4 || time_budget.count() <= 0)
+    {
+        return trip;
+    }
+    BranchAndBound search(trip, dist_table, std::chrono::steady_clock::now() + time_budget);
+    return search.Run();
+}
+}
+}
+}
+
+#endif // TRIP_BRANCH_AND_BOUND_HPP
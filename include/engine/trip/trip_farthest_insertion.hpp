@@ -1,6 +1,7 @@
 #ifndef TRIP_FARTHEST_INSERTION_HPP
 #define TRIP_FARTHEST_INSERTION_HPP
 
+#include "engine/query_deadline.hpp"
 #include "engine/search_engine.hpp"
 #include "util/dist_table_wrapper.hpp"
 
@@ -97,6 +98,7 @@ std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
     route.push_back(start2);
 
     // add all other nodes missing (two nodes are already in the initial start trip)
+    DeadlineCheck deadline_check;
     for (std::size_t j = 2; j < component_size; ++j)
     {
 
@@ -110,6 +112,7 @@ std::vector<NodeID> FindRoute(const std::size_t &number_of_locations,
             // find the shortest distance from i to all visited nodes
             if (!visited[*i])
             {
+                deadline_check.Step();
                 const auto insert_candidate =
                     GetShortestRoundTrip(*i, dist_table, number_of_locations, route);
 
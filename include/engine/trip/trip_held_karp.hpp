@@ -0,0 +1,135 @@
+#ifndef TRIP_HELD_KARP_HPP
+#define TRIP_HELD_KARP_HPP
+
+#include "engine/query_deadline.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/assert.hpp>
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace osrm
+{
+namespace engine
+{
+namespace trip
+{
+
+// The table of the dynamic program has (n - 1) * 2^(n - 1) entries of 8 bytes, 4MB for 16
+// locations but 80MB per request for 20
+const constexpr std::size_t HELD_KARP_MAX_LOCATIONS = 16;
+
+// Computes the shortest round trip with the dynamic program of Held and Karp. The trip starts at
+// the first location, a path over the set of locations S that ends at v is extended from the
+// shortest paths over S \ {v}:
+//
+//   length(S, v) = min_{u in S \ {v}} length(S \ {v}, u) + d(u, v)
+//
+// Sets are bitmasks over the other locations. Ties go to the location that comes first.
+template <typename NodeIDIterator>
+std::vector<NodeID> HeldKarpTrip(const NodeIDIterator start,
+                                 const NodeIDIterator end,
+                                 const std::size_t number_of_locations,
+                                 const util::DistTableWrapper<EdgeWeight> &dist_table)
+{
+    (void)number_of_locations; // unused
+
+    const std::vector<NodeID> locations(start, end);
+    BOOST_ASSERT_MSG(locations.size() > 0, "no locations given");
+    BOOST_ASSERT_MSG(locations.size() <= HELD_KARP_MAX_LOCATIONS, "too many locations");
+    if (locations.size() < 3)
+    {
+        return locations;
+    }
+
+    // the first location is left out of the sets, locations[i + 1] is in a set if bit i is set
+    const std::size_t number_of_others = locations.size() - 1;
+    const auto distance = [&](const std::size_t from, const std::size_t to)
+    {
+        const auto weight = dist_table(locations[from], locations[to]);
+        BOOST_ASSERT_MSG(weight != INVALID_EDGE_WEIGHT, "invalid distance found");
+        return static_cast<std::int64_t>(weight);
+    };
+
+    // length[set * number_of_others + i]: shortest path from the first location over the set
+    // that ends at locations[i + 1], only valid if i is in the set
+    const std::uint32_t number_of_sets = 1u << number_of_others;
+    std::vector<std::int64_t> length(number_of_sets * number_of_others, INVALID_EDGE_WEIGHT);
+    for (const auto i : util::irange<std::size_t>(0, number_of_others))
+    {
+        length[(1u << i) * number_of_others + i] = distance(0, i + 1);
+    }
+
+    DeadlineCheck deadline_check;
+    // subsets are smaller numbers than their supersets, so they are done first
+    for (const auto set : util::irange<std::uint32_t>(1, number_of_sets))
+    {
+        deadline_check.Step();
+        for (const auto last : util::irange<std::size_t>(0, number_of_others))
+        {
+            const std::uint32_t previous_set = set & ~(1u << last);
+            if (previous_set == set || previous_set == 0)
+            {
+                continue;
+            }
+            auto &best = length[set * number_of_others + last];
+            for (const auto previous : util::irange<std::size_t>(0, number_of_others))
+            {
+                if (previous_set & (1u << previous))
+                {
+                    const auto candidate = length[previous_set * number_of_others + previous] +
+                                           distance(previous + 1, last + 1);
+                    if (candidate < best)
+                    {
+                        best = candidate;
+                    }
+                }
+            }
+        }
+    }
+
+    // close the trip and walk back through the sets
+    const std::uint32_t all = number_of_sets - 1;
+    std::size_t last = 0;
+    for (const auto i : util::irange<std::size_t>(1, number_of_others))
+    {
+        if (length[all * number_of_others + i] + distance(i + 1, 0) <
+            length[all * number_of_others + last] + distance(last + 1, 0))
+        {
+            last = i;
+        }
+    }
+
+    std::vector<NodeID> route(locations.size());
+    route.front() = locations.front();
+    std::uint32_t set = all;
+    for (auto position = route.size() - 1; position > 1; --position)
+    {
+        route[position] = locations[last + 1];
+        const std::uint32_t previous_set = set & ~(1u << last);
+        const auto current_length = length[set * number_of_others + last];
+        for (const auto previous : util::irange<std::size_t>(0, number_of_others))
+        {
+            if ((previous_set & (1u << previous)) &&
+                length[previous_set * number_of_others + previous] +
+                        distance(previous + 1, last + 1) ==
+                    current_length)
+            {
+                last = previous;
+                break;
+            }
+        }
+        set = previous_set;
+    }
+    route[1] = locations[last + 1];
+    return route;
+}
+}
+}
+}
+
+#endif // TRIP_HELD_KARP_HPP
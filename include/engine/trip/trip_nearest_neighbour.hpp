@@ -1,6 +1,7 @@
 #ifndef TRIP_NEAREST_NEIGHBOUR_HPP
 #define TRIP_NEAREST_NEIGHBOUR_HPP
 
+#include "engine/query_deadline.hpp"
 #include "engine/search_engine.hpp"
 #include "util/simple_logger.hpp"
 #include "util/dist_table_wrapper.hpp"
@@ -42,6 +43,7 @@ std::vector<NodeID> NearestNeighbourTrip(const NodeIDIterator &start,
     const auto component_size = std::distance(start, end);
     auto shortest_trip_distance = INVALID_EDGE_WEIGHT;
 
+    DeadlineCheck deadline_check;
     // ALWAYS START AT ANOTHER STARTING POINT
     for (auto start_node = start; start_node != end; ++start_node)
     {
@@ -63,6 +65,7 @@ std::vector<NodeID> NearestNeighbourTrip(const NodeIDIterator &start,
             NodeID min_id = SPECIAL_NODEID;
 
             // 2. FIND NEAREST NEIGHBOUR
+            deadline_check.Step();
             for (auto next = start; next != end; ++next)
             {
                 const auto curr_dist = dist_table(curr_node, *next);
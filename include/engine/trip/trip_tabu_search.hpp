@@ -1,16 +1,24 @@
-#ifndef TRIP_BRUTE_FORCE_HPP
-#define TRIP_BRUTE_FORCE_HPP
+#ifndef TRIP_TABU_SEARCH_HPP
+#define TRIP_TABU_SEARCH_HPP
 
-#include "engine/search_engine.hpp"
-#include "util/simple_logger.hpp"
+#include "engine/query_deadline.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/integer_range.hpp"
+#include "util/typedefs.hpp"
 
-#include "osrm/json_container.hpp"
+#include <boost/assert.hpp>
+
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 
-#include <cstdlib>
 #include <algorithm>
-#include <string>
-#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
 #include <limits>
+#include <random>
+#include <utility>
+#include <vector>
 
 namespace osrm
 {
@@ -19,23 +27,323 @@ namespace engine
 namespace trip
 {
 
-// todo: yet to be implemented
-void TabuSearchTrip(std::vector<unsigned> &location,
-                    const PhantomNodeArray &phantom_node_vector,
-                    const std::vector<EdgeWeight> &dist_table,
-                    InternalRouteResult &min_route,
-                    std::vector<int> &min_loc_permutation)
+// Improves a round trip with 2-opt and Or-opt moves guided by a tabu list. The table is not
+// symmetric, so reversing a part of the trip changes its length. The lengths of all parts in
+// both directions are prefix sums along the trip, which makes every move O(1) to evaluate.
+class TabuSearch
 {
+    using Clock = std::chrono::steady_clock;
+
+  public:
+    TabuSearch(const util::DistTableWrapper<EdgeWeight> &dist_table,
+               const Clock::time_point stop_time)
+        : dist_table(dist_table), stop_time(stop_time)
+    {
+    }
+
+    // Runs until the time is up or the best trip did not improve for a while
+    std::vector<NodeID> Run(std::vector<NodeID> route) const
+    {
+        const auto number_of_nodes = route.size();
+        if (number_of_nodes < 4)
+        {
+            return route;
+        }
+
+        // arcs removed by a move may not be added back for a while, unless that finds a new best
+        const std::size_t tabu_tenure = std::max<std::size_t>(5, number_of_nodes / 4);
+        const std::size_t max_stalled_iterations = 10 * number_of_nodes;
+        std::vector<std::size_t> tabu_until(dist_table.GetNumberOfNodes() *
+                                                dist_table.GetNumberOfNodes(),
+                                            0);
+        const auto is_tabu = [&](const NodeID from, const NodeID to, const std::size_t iteration)
+        {
+            return tabu_until[from * dist_table.GetNumberOfNodes() + to] > iteration;
+        };
+
+        auto length = GetLength(route);
+        auto best_route = route;
+        auto best_length = length;
+
+        Prefixes prefixes;
+        DeadlineCheck deadline_check;
+        std::size_t last_improvement = 0;
+        for (std::size_t iteration = 1;
+             iteration - last_improvement <= max_stalled_iterations && Clock::now() < stop_time;
+             ++iteration)
+        {
+            ComputePrefixes(route, prefixes);
+
+            Move best_move{std::numeric_limits<std::int64_t>::max(), 0, 0, 0, false, false};
+            const auto consider = [&](const Move &move, const NodeID added_a_from,
+                                      const NodeID added_a_to, const NodeID added_b_from,
+                                      const NodeID added_b_to, const NodeID added_c_from,
+                                      const NodeID added_c_to)
+            {
+                if (move.delta >= best_move.delta)
+                {
+                    return;
+                }
+                const bool tabu = is_tabu(added_a_from, added_a_to, iteration) ||
+                                  is_tabu(added_b_from, added_b_to, iteration) ||
+                                  (SPECIAL_NODEID != added_c_from &&
+                                   is_tabu(added_c_from, added_c_to, iteration));
+                if (!tabu || length + move.delta < best_length)
+                {
+                    best_move = move;
+                }
+            };
+
+            // the first location stays in place, so the positions of all others are stable
+            for (const auto first : util::irange<std::size_t>(1, number_of_nodes))
+            {
+                deadline_check.Step();
+                const NodeID before = route[first - 1];
+
+                // 2-opt: reverse [first, last]
+                for (const auto last : util::irange(first + 1, number_of_nodes))
+                {
+                    const NodeID after = route[(last + 1) % number_of_nodes];
+                    const std::int64_t delta =
+                        Weight(before, route[last]) + Weight(route[first], after) -
+                        Weight(before, route[first]) - Weight(route[last], after) +
+                        ReversedLength(prefixes, first, last) - Length(prefixes, first, last);
+                    consider(Move{delta, first, last, 0, false, true}, before, route[last],
+                             route[first], after, SPECIAL_NODEID, SPECIAL_NODEID);
+                }
+
+                // Or-opt: move [first, last] of up to three locations between two others
+                for (const auto last :
+                     util::irange(first, std::min(first + MAX_OR_OPT_LENGTH, number_of_nodes)))
+                {
+                    if (last - first + 3 > number_of_nodes)
+                    {
+                        break;
+                    }
+                    const NodeID after = route[(last + 1) % number_of_nodes];
+                    const std::int64_t removal =
+                        Weight(before, after) - Weight(before, route[first]) -
+                        Weight(route[last], after);
+                    const std::int64_t reversal =
+                        ReversedLength(prefixes, first, last) - Length(prefixes, first, last);
+                    // insert between route[position] and its successor
+                    for (auto position = (last + 1) % number_of_nodes; position != first - 1;
+                         position = (position + 1) % number_of_nodes)
+                    {
+                        const NodeID from = route[position];
+                        const NodeID to = route[(position + 1) % number_of_nodes];
+                        const std::int64_t delta =
+                            removal - Weight(from, to) + Weight(from, route[first]) +
+                            Weight(route[last], to);
+                        consider(Move{delta, first, last, position, false, false}, before, after,
+                                 from, route[first], route[last], to);
+                        const std::int64_t reversed_delta = removal - Weight(from, to) +
+                                                            Weight(from, route[last]) +
+                                                            Weight(route[first], to) + reversal;
+                        consider(Move{reversed_delta, first, last, position, true, false}, before,
+                                 after, from, route[last], route[first], to);
+                    }
+                }
+            }
+
+            if (best_move.delta == std::numeric_limits<std::int64_t>::max())
+            {
+                // every move is tabu
+                break;
+            }
+
+            for (const auto &arc : Apply(best_move, route))
+            {
+                tabu_until[arc.first * dist_table.GetNumberOfNodes() + arc.second] =
+                    iteration + tabu_tenure;
+            }
+            length += best_move.delta;
+            BOOST_ASSERT(length == GetLength(route));
+
+            if (length < best_length)
+            {
+                best_length = length;
+                best_route = route;
+                last_improvement = iteration;
+            }
+        }
+        return best_route;
+    }
+
+    std::int64_t GetLength(const std::vector<NodeID> &route) const
+    {
+        std::int64_t length = 0;
+        for (const auto i : util::irange<std::size_t>(0, route.size()))
+        {
+            length += Weight(route[i], route[(i + 1) % route.size()]);
+        }
+        return length;
+    }
+
+  private:
+    static const constexpr std::size_t MAX_OR_OPT_LENGTH = 3;
+
+    struct Move
+    {
+        std::int64_t delta;
+        std::size_t first;
+        std::size_t last;
+        // Or-opt only: the segment goes behind this position
+        std::size_t position;
+        bool reversed;
+        bool two_opt;
+    };
+
+    // forward[i]: length of route[0] -> ... -> route[i],
+    // backward[i]: length of route[i] -> ... -> route[0]
+    struct Prefixes
+    {
+        std::vector<std::int64_t> forward;
+        std::vector<std::int64_t> backward;
+    };
+
+    std::int64_t Weight(const NodeID from, const NodeID to) const
+    {
+        BOOST_ASSERT(INVALID_EDGE_WEIGHT != dist_table(from, to));
+        return dist_table(from, to);
+    }
+
+    void ComputePrefixes(const std::vector<NodeID> &route, Prefixes &prefixes) const
+    {
+        prefixes.forward.resize(route.size());
+        prefixes.backward.resize(route.size());
+        prefixes.forward[0] = 0;
+        prefixes.backward[0] = 0;
+        for (const auto i : util::irange<std::size_t>(1, route.size()))
+        {
+            prefixes.forward[i] = prefixes.forward[i - 1] + Weight(route[i - 1], route[i]);
+            prefixes.backward[i] = prefixes.backward[i - 1] + Weight(route[i], route[i - 1]);
+        }
+    }
+
+    static std::int64_t
+    Length(const Prefixes &prefixes, const std::size_t first, const std::size_t last)
+    {
+        return prefixes.forward[last] - prefixes.forward[first];
+    }
+
+    static std::int64_t
+    ReversedLength(const Prefixes &prefixes, const std::size_t first, const std::size_t last)
+    {
+        return prefixes.backward[last] - prefixes.backward[first];
+    }
+
+    // applies the move and returns the arcs it removed
+    static std::vector<std::pair<NodeID, NodeID>> Apply(const Move &move,
+                                                        std::vector<NodeID> &route)
+    {
+        const auto number_of_nodes = route.size();
+        const NodeID before = route[move.first - 1];
+        const NodeID after = route[(move.last + 1) % number_of_nodes];
+        std::vector<std::pair<NodeID, NodeID>> removed = {{before, route[move.first]},
+                                                          {route[move.last], after}};
+        if (move.two_opt)
+        {
+            std::reverse(route.begin() + move.first, route.begin() + move.last + 1);
+            return removed;
+        }
+
+        removed.emplace_back(route[move.position], route[(move.position + 1) % number_of_nodes]);
+        std::vector<NodeID> segment(route.begin() + move.first, route.begin() + move.last + 1);
+        if (move.reversed)
+        {
+            std::reverse(segment.begin(), segment.end());
+        }
+        std::vector<NodeID> new_route;
+        new_route.reserve(number_of_nodes);
+        for (const auto i : util::irange<std::size_t>(0, number_of_nodes))
+        {
+            if (i >= move.first && i <= move.last)
+            {
+                continue;
+            }
+            new_route.push_back(route[i]);
+            if (i == move.position)
+            {
+                new_route.insert(new_route.end(), segment.begin(), segment.end());
+            }
+        }
+        route = std::move(new_route);
+        return removed;
+    }
+
+    const util::DistTableWrapper<EdgeWeight> &dist_table;
+    const Clock::time_point stop_time;
+};
+
+// Swaps two random parts of the trip (double bridge), which a few local moves can not undo
+inline void PerturbTrip(std::vector<NodeID> &route, std::mt19937 &generator)
+{
+    if (route.size() < 8)
+    {
+        std::shuffle(std::next(route.begin()), route.end(), generator);
+        return;
+    }
+    std::vector<std::size_t> cuts(3);
+    std::uniform_int_distribution<std::size_t> cut_distribution(1, route.size() - 1);
+    do
+    {
+        std::generate(cuts.begin(), cuts.end(), [&]
+                      {
+                          return cut_distribution(generator);
+                      });
+        std::sort(cuts.begin(), cuts.end());
+    } while (cuts[0] == cuts[1] || cuts[1] == cuts[2]);
+    std::rotate(route.begin() + cuts[0], route.begin() + cuts[1], route.begin() + cuts[2]);
 }
 
-void TabuSearchTrip(const PhantomNodeArray &phantom_node_vector,
-                    const std::vector<EdgeWeight> &dist_table,
-                    InternalRouteResult &min_route,
-                    std::vector<int> &min_loc_permutation)
+// Improves the given round trip with tabu searches that run in parallel for at most the time
+// budget. One search starts at the given trip, the others at perturbations of it.
+inline std::vector<NodeID> TabuSearchTrip(std::vector<NodeID> route,
+                                          const util::DistTableWrapper<EdgeWeight> &dist_table,
+                                          const std::chrono::milliseconds time_budget)
 {
+    if (route.size() < 4 || time_budget.count() <= 0)
+    {
+        return route;
+    }
+
+    const TabuSearch search(dist_table, std::chrono::steady_clock::now() + time_budget);
+    const auto number_of_starts =
+        static_cast<std::size_t>(std::max(1, tbb::task_scheduler_init::default_num_threads()));
+    std::vector<std::vector<NodeID>> routes(number_of_starts, route);
+
+    const auto deadline_state = ScopedQueryDeadline::GetCurrent();
+    const QueryDeadline *deadline = deadline_state ? deadline_state->deadline : nullptr;
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, number_of_starts),
+                      [&](const tbb::blocked_range<std::size_t> &range)
+                      {
+                          ScopedQueryDeadline scoped_deadline(deadline);
+                          for (auto i = range.begin(); i != range.end(); ++i)
+                          {
+                              if (i > 0)
+                              {
+                                  // seeded by the start, so a trip only depends on the time
+                                  std::mt19937 generator(static_cast<unsigned>(i));
+                                  PerturbTrip(routes[i], generator);
+                              }
+                              routes[i] = search.Run(std::move(routes[i]));
+                          }
+                      });
+
+    // ties go to the earlier start
+    std::vector<std::int64_t> lengths(number_of_starts);
+    std::transform(routes.begin(), routes.end(), lengths.begin(),
+                   [&search](const std::vector<NodeID> &route)
+                   {
+                       return search.GetLength(route);
+                   });
+    const auto best =
+        std::distance(lengths.begin(), std::min_element(lengths.begin(), lengths.end()));
+    return std::move(routes[best]);
 }
 }
 }
 }
 
-#endif // TRIP_BRUTE_FORCE_HPP
+#endif // TRIP_TABU_SEARCH_HPP
@@ -48,6 +48,9 @@ namespace engine
 class Engine;
 struct EngineConfig;
 struct RouteParameters;
+struct CachedResponse;
+struct ResponseCacheTicket;
+struct EngineStatistics;
 }
 
 using engine::EngineConfig;
@@ -63,6 +66,19 @@ class OSRM
     OSRM(EngineConfig &lib_config);
     ~OSRM(); // needed because we need to define it with the implementation of OSRM_impl
     int RunQuery(const RouteParameters &route_parameters, json::Object &json_result);
+
+    // Like the above, but answers with the reply of an identical earlier request if it is still
+    // cached. No query is run then and cached_response is set. On a miss the ticket can be used
+    // to store the reply once it is rendered.
+    int RunQuery(const RouteParameters &route_parameters,
+                 json::Object &json_result,
+                 engine::ResponseCacheTicket &ticket,
+                 std::shared_ptr<const engine::CachedResponse> &cached_response);
+    void StoreResponse(const engine::ResponseCacheTicket &ticket,
+                       engine::CachedResponse response);
+
+    // Current load and cumulative search effort, e.g. for monitoring
+    engine::EngineStatistics GetStatistics() const;
 };
 
 }
@@ -0,0 +1,90 @@
+#ifndef ACCESS_LOG_HPP
+#define ACCESS_LOG_HPP
+
+#include <boost/thread/tss.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace http
+{
+struct request;
+}
+
+/// Request log that never blocks the threads answering queries.
+/// Every thread writes its records into its own fixed size ring buffer, a background thread
+/// drains the buffers and does the formatting and the actual output. Records are dropped,
+/// and counted, if a thread produces them faster than they can be written.
+class AccessLog
+{
+  public:
+    static const constexpr std::size_t RECORDS_PER_THREAD = 1024;
+    // longer lines, e.g. of large tables, are kept on the heap instead
+    static const constexpr std::size_t MAX_LINE_LENGTH = 500;
+
+    AccessLog();
+    AccessLog(const AccessLog &) = delete;
+    AccessLog &operator=(const AccessLog &) = delete;
+    // writes all pending records before returning
+    ~AccessLog();
+
+    void Log(const http::request &current_request, const std::string &decoded_uri);
+
+    std::uint64_t GetDroppedRecords() const;
+
+  private:
+    struct Record
+    {
+        std::time_t time;
+        std::uint32_t length;
+        std::array<char, MAX_LINE_LENGTH> line;
+        // only used if length exceeds MAX_LINE_LENGTH, keeps its memory for the next long line
+        std::string long_line;
+    };
+
+    // single producer, single consumer
+    struct RingBuffer
+    {
+        // written by the producing thread only
+        std::atomic<std::uint64_t> head;
+        std::atomic<std::uint64_t> dropped;
+        std::array<Record, RECORDS_PER_THREAD> records;
+        // written by the draining thread only
+        std::atomic<std::uint64_t> tail;
+    };
+
+    RingBuffer &GetThreadBuffer();
+    void Drain();
+    // returns the number of records written
+    std::size_t DrainOnce();
+    const char *FormatTime(const std::time_t time);
+
+    mutable std::mutex registry_mutex;
+    // owned here so records of finished threads are still written
+    std::vector<std::unique_ptr<RingBuffer>> registry;
+    boost::thread_specific_ptr<RingBuffer> thread_buffer;
+
+    // only used by the draining thread
+    std::time_t cached_time;
+    std::array<char, 32> cached_timestamp;
+    std::uint64_t reported_dropped;
+
+    std::atomic<bool> stopped;
+    std::thread drain_thread;
+};
+}
+}
+
+#endif // ACCESS_LOG_HPP
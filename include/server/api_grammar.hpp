@@ -47,7 +47,8 @@ template <typename Iterator, class HandlerT> struct APIGrammar : qi::grammar<Ite
         query = ('?') >> +(zoom | output | jsonp | checksum | uturns | location_with_options |
                            destination_with_options | source_with_options | cmp | language |
                            instruction | geometry | alt_route | old_API | num_results |
-                           matching_beta | gps_precision | classify | locs | x | y | z);
+                           matching_beta | gps_precision | classify | session | locs | cutoff |
+                           x | y | z);
         // all combinations of timestamp, uturn, hint and bearing without duplicates
         t_u = (u >> -timestamp) | (timestamp >> -u);
         t_h = (hint >> -timestamp) | (timestamp >> -hint);
@@ -62,7 +63,8 @@ template <typename Iterator, class HandlerT> struct APIGrammar : qi::grammar<Ite
         destination_with_options = destination >> -location_options;
         zoom = (-qi::lit('&')) >> qi::lit('z') >> '=' >>
                qi::short_[boost::bind(&HandlerT::SetZoomLevel, handler, ::_1)];
-        output = (-qi::lit('&')) >> qi::lit("output=json");
+        output = (-qi::lit('&')) >> qi::lit("output") >> '=' >>
+                 string[boost::bind(&HandlerT::SetOutputFormat, handler, ::_1)];
         jsonp = (-qi::lit('&')) >> qi::lit("jsonp") >> '=' >>
                 stringwithPercent[boost::bind(&HandlerT::SetJSONpParameter, handler, ::_1)];
         checksum = (-qi::lit('&')) >> qi::lit("checksum") >> '=' >>
@@ -107,8 +109,12 @@ template <typename Iterator, class HandlerT> struct APIGrammar : qi::grammar<Ite
                         qi::float_[boost::bind(&HandlerT::SetGPSPrecision, handler, ::_1)];
         classify = (-qi::lit('&')) >> qi::lit("classify") >> '=' >>
                    qi::bool_[boost::bind(&HandlerT::SetClassify, handler, ::_1)];
+        session = (-qi::lit('&')) >> qi::lit("session") >> '=' >>
+                  stringwithDot[boost::bind(&HandlerT::SetSession, handler, ::_1)];
         locs = (-qi::lit('&')) >> qi::lit("locs") >> '=' >>
                stringforPolyline[boost::bind(&HandlerT::SetCoordinatesFromGeometry, handler, ::_1)];
+        cutoff = (-qi::lit('&')) >> qi::lit("cutoff") >> '=' >>
+                 qi::uint_[boost::bind(&HandlerT::AddCutoff, handler, ::_1)];
 
         z = (-qi::lit('&')) >> qi::lit("tz") >> '=' >>
             qi::int_[boost::bind<void>(&HandlerT::SetZ, handler, ::_1)];
@@ -129,7 +135,7 @@ template <typename Iterator, class HandlerT> struct APIGrammar : qi::grammar<Ite
     qi::rule<Iterator, std::string()> service, zoom, output, string, jsonp, checksum, location,
         destination, source, hint, timestamp, bearing, stringwithDot, stringwithPercent, language,
         geometry, cmp, alt_route, u, uturns, old_API, num_results, matching_beta, gps_precision,
-        classify, locs, instruction, stringforPolyline, x, y, z;
+        classify, session, locs, cutoff, instruction, stringforPolyline, x, y, z;
 
     HandlerT *handler;
 };
@@ -5,6 +5,7 @@
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
 #include "server/request_parser.hpp"
+#include "server/stream_compressor.hpp"
 
 #include <boost/array.hpp>
 #include <boost/asio.hpp>
@@ -32,12 +33,20 @@ namespace server
 {
 
 class RequestHandler;
+class QueryQueue;
 
 /// Represents a single connection from a client.
+/// The connection is kept open for further (possibly pipelined) requests as long as the client
+/// asks for it, the idle timeout does not expire and the per-connection request limit is not hit.
 class Connection : public std::enable_shared_from_this<Connection>
 {
   public:
-    explicit Connection(boost::asio::io_service &io_service, RequestHandler &handler);
+    explicit Connection(boost::asio::io_service &io_service,
+                        RequestHandler &handler,
+                        QueryQueue &query_queue,
+                        const unsigned keepalive_timeout,
+                        const unsigned keepalive_max_requests,
+                        const std::size_t compression_threshold);
     Connection(const Connection &) = delete;
     Connection &operator=(const Connection &) = delete;
 
@@ -47,23 +56,55 @@ class Connection : public std::enable_shared_from_this<Connection>
     void start();
 
   private:
+    /// Read more data from the socket, bounded by the idle timeout.
+    void read_more();
+
     void handle_read(const boost::system::error_code &e, std::size_t bytes_transferred);
 
+    /// Parse buffered data and answer the first complete request in it.
+    void handle_data(char *begin, char *end);
+
+    /// Answer the current request, runs on a query worker. Replies with an internal server
+    /// error if the query throws.
+    void run_query(const http::compression_type compression_type);
+
+    /// Add connection headers and compress the reply, then schedule writing it.
+    void send_reply(http::compression_type compression_type);
+
+    /// Compress the next part of the reply into compressed_output, framed as an HTTP chunk.
+    void compress_next_chunk();
+
+    void write_reply();
+
     /// Handle completion of a write operation.
     void handle_write(const boost::system::error_code &e);
 
-    std::vector<char> compress_buffers(const std::vector<char> &uncompressed_data,
-                                       const http::compression_type compression_type);
+    /// Close connections that stayed idle for longer than the keep-alive timeout.
+    void handle_timeout(const boost::system::error_code &e);
 
     boost::asio::io_service::strand strand;
     boost::asio::ip::tcp::socket TCP_socket;
+    boost::asio::deadline_timer idle_timer;
     RequestHandler &request_handler;
+    QueryQueue &query_queue;
     RequestParser request_parser;
+    const unsigned keepalive_timeout;
+    const unsigned keepalive_max_requests;
+    // smaller replies are not worth compressing
+    const std::size_t compression_threshold;
+    unsigned processed_requests;
+    bool keep_alive;
     boost::array<char, 8192> incoming_data_buffer;
+    // unparsed bytes of pipelined requests that arrived together with the current one
+    std::size_t pending_data_begin;
+    std::size_t pending_data_end;
     http::request current_request;
     http::reply current_reply;
+    StreamCompressor compressor;
+    // compressed replies are written one chunk at a time, the buffer is reused for all of them
     std::vector<char> compressed_output;
-    // Header compression_header;
+    std::size_t compressed_content_end;
+    bool sending_chunks;
     std::vector<boost::asio::const_buffer> output_buffer;
 };
 }
@@ -3,6 +3,7 @@
 
 #include <boost/asio.hpp>
 
+#include <chrono>
 #include <string>
 
 namespace osrm
@@ -18,6 +19,14 @@ struct request
     std::string referrer;
     std::string agent;
     boost::asio::ip::address endpoint;
+    // true if the client asked for (or, on HTTP/1.1, did not opt out of) a persistent connection
+    bool keep_alive = false;
+    // HTTP/1.1 clients understand chunked transfer encoding
+    bool accepts_chunked = false;
+    // time budget the client gave us via 'X-Request-Timeout' (in ms), zero if none
+    std::chrono::milliseconds timeout{0};
+    // when the request was completely read, the time budget starts here
+    std::chrono::steady_clock::time_point received;
 };
 }
 }
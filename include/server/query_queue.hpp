@@ -0,0 +1,101 @@
+#ifndef QUERY_QUEUE_HPP
+#define QUERY_QUEUE_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/// Bounded queue of routing queries that is drained by a dedicated pool of worker threads.
+/// Keeping the (potentially long running) queries off the asio threads means accepts and
+/// reads are never blocked by a few heavy requests. Queries are shed at admission time if
+/// the queue is full or if the expected wait time exceeds the configured budget.
+class QueryQueue
+{
+  public:
+    using Task = std::function<void()>;
+
+    enum class Admission
+    {
+        accepted,
+        queue_full,
+        wait_budget_exceeded
+    };
+
+    struct ServiceStatistics
+    {
+        std::size_t queue_depth = 0;
+        std::uint64_t accepted = 0;
+        std::uint64_t rejected = 0;
+        std::uint64_t processed = 0;
+        // time spent waiting in the queue before a worker picked the query up
+        double total_wait_ms = 0.;
+        double max_wait_ms = 0.;
+    };
+
+    /// max_queue_wait of zero disables the wait budget check
+    QueryQueue(const unsigned num_workers,
+               const std::size_t max_queue_size,
+               const std::chrono::milliseconds max_queue_wait);
+    QueryQueue(const QueryQueue &) = delete;
+    QueryQueue &operator=(const QueryQueue &) = delete;
+    ~QueryQueue();
+
+    /// Enqueue a task for the given service. The task is only run if it is accepted.
+    Admission Submit(const std::string &service, Task task);
+
+    /// Wake up all workers and wait for them to finish their current task.
+    /// Tasks still in the queue are dropped.
+    void Stop();
+
+    std::map<std::string, ServiceStatistics> GetStatistics() const;
+    std::size_t GetQueueDepth() const;
+    unsigned GetNumberOfWorkers() const { return static_cast<unsigned>(workers.size()); }
+
+    /// Expected time a newly submitted task has to wait for a worker
+    std::chrono::milliseconds EstimateQueueWait() const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedTask
+    {
+        Task task;
+        ServiceStatistics *statistics;
+        Clock::time_point enqueued;
+    };
+
+    void Work();
+    ServiceStatistics &GetServiceStatistics(const std::string &service);
+    double EstimateQueueWaitMs() const;
+
+    const std::size_t max_queue_size;
+    const std::chrono::milliseconds max_queue_wait;
+
+    mutable std::mutex queue_mutex;
+    std::condition_variable queue_not_empty;
+    std::deque<QueuedTask> queue;
+    // exponential moving average of the time a worker spends on one task
+    double average_service_time_ms;
+    bool stopped;
+
+    // std::map never invalidates references, queued tasks point into it
+    std::map<std::string, ServiceStatistics> service_statistics;
+
+    std::vector<std::thread> workers;
+};
+}
+}
+
+#endif // QUERY_QUEUE_HPP
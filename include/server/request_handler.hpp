@@ -1,7 +1,14 @@
 #ifndef REQUEST_HANDLER_HPP
 #define REQUEST_HANDLER_HPP
 
+#include "server/access_log.hpp"
+#include "server/request_metrics.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -9,10 +16,12 @@ class OSRM;
 namespace engine
 {
 struct RouteParameters;
+class QueryDeadline;
 }
 namespace server
 {
 template <typename Iterator, class HandlerT> struct APIGrammar;
+class QueryQueue;
 
 namespace http
 {
@@ -26,15 +35,36 @@ class RequestHandler
   public:
     using APIGrammarParser = APIGrammar<std::string::iterator, engine::RouteParameters>;
 
-    RequestHandler();
+    // max_query_time of zero means queries may run for as long as they need
+    RequestHandler(const std::chrono::milliseconds max_query_time,
+                   const std::size_t max_batch_size);
     RequestHandler(const RequestHandler &) = delete;
     RequestHandler &operator=(const RequestHandler &) = delete;
 
     void handle_request(const http::request &current_request, http::reply &current_reply);
+    // answered directly on the I/O threads, so it stays available while the queue is full
+    void handle_queue_status(const QueryQueue &query_queue, http::reply &current_reply);
+    // Prometheus text format, also answered on the I/O threads
+    void handle_metrics(const QueryQueue &query_queue, http::reply &current_reply);
     void RegisterRoutingMachine(OSRM *osrm);
 
+    // first path segment of the uri, e.g. 'viaroute' for '/viaroute?loc=...'
+    static std::string get_service_name(const std::string &uri);
+
   private:
+    void dispatch_request(const http::request &current_request, http::reply &current_reply);
+    // runs the sub-queries of a /batch request in parallel and replies with all their results
+    void handle_batch_request(const http::request &current_request, http::reply &current_reply);
+    void run_batch_query(const std::string &encoded_query,
+                         const std::shared_ptr<engine::QueryDeadline> &deadline,
+                         std::vector<char> &output);
+    std::chrono::milliseconds get_query_timeout(const http::request &current_request) const;
+
     OSRM *routing_machine;
+    const std::chrono::milliseconds max_query_time;
+    const std::size_t max_batch_size;
+    RequestMetrics request_metrics;
+    AccessLog access_log;
 };
 }
 }
@@ -0,0 +1,82 @@
+#ifndef REQUEST_METRICS_HPP
+#define REQUEST_METRICS_HPP
+
+#include <boost/thread/tss.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/// Request counts and latency histograms per service.
+/// Every thread records into its own counters, so recording takes no lock and never
+/// contends with other threads. The counters of all threads are only merged on a scrape.
+class RequestMetrics
+{
+  public:
+    static const constexpr std::size_t NUMBER_OF_LATENCY_BUCKETS = 13;
+    // upper bounds of the latency buckets in seconds, an implicit +Inf bucket follows
+    static const std::array<double, NUMBER_OF_LATENCY_BUCKETS> LATENCY_BUCKETS;
+    // service names come from the request uri, bound the number of distinct series
+    static const constexpr std::size_t MAX_TRACKED_SERVICES = 32;
+
+    struct ServiceMetrics
+    {
+        std::string service;
+        // by status class: 2xx, 4xx, 5xx
+        std::uint64_t replies_2xx = 0;
+        std::uint64_t replies_4xx = 0;
+        std::uint64_t replies_5xx = 0;
+        // cumulative counts as in a Prometheus histogram, the last one is +Inf
+        std::array<std::uint64_t, NUMBER_OF_LATENCY_BUCKETS + 1> latency_buckets{};
+        double latency_sum = 0.;
+    };
+
+    RequestMetrics();
+    RequestMetrics(const RequestMetrics &) = delete;
+    RequestMetrics &operator=(const RequestMetrics &) = delete;
+
+    void Record(const std::string &service,
+                const int status,
+                const std::chrono::steady_clock::duration latency);
+
+    /// Sums up the counters of all threads
+    std::vector<ServiceMetrics> Collect() const;
+
+  private:
+    using Counter = std::atomic<std::uint64_t>;
+
+    struct ThreadServiceCounters
+    {
+        std::array<Counter, 3> replies;
+        std::array<Counter, NUMBER_OF_LATENCY_BUCKETS + 1> latency_buckets;
+        Counter latency_sum_us;
+    };
+    using ThreadCounters = std::array<ThreadServiceCounters, MAX_TRACKED_SERVICES>;
+
+    std::size_t GetServiceIndex(const std::string &service);
+    ThreadCounters &GetThreadCounters();
+
+    // services are only ever added, an index stays valid forever
+    mutable std::mutex services_mutex;
+    std::array<std::string, MAX_TRACKED_SERVICES> service_names;
+    std::atomic<std::size_t> number_of_services;
+
+    // owned by the registry so they outlive their threads
+    mutable std::mutex registry_mutex;
+    std::vector<std::unique_ptr<ThreadCounters>> registry;
+    boost::thread_specific_ptr<ThreadCounters> thread_counters;
+};
+}
+}
+
+#endif // REQUEST_METRICS_HPP
@@ -28,9 +28,14 @@ class RequestParser
         indeterminate
     };
 
-    std::tuple<RequestStatus, http::compression_type>
+    // Consumes input until a request is complete. The returned pointer marks the first byte that
+    // was not consumed, i.e. the start of the next pipelined request in the same buffer.
+    std::tuple<RequestStatus, http::compression_type, char *>
     parse(http::request &current_request, char *begin, char *end);
 
+    // Prepares the parser for the next request on a persistent connection.
+    void reset();
+
   private:
     RequestStatus consume(http::request &current_request, const char input);
 
@@ -42,6 +47,8 @@ class RequestParser
 
     bool is_digit(const int character) const;
 
+    bool is_keep_alive() const;
+
     enum class internal_state : unsigned char
     {
         method_start,
@@ -75,6 +82,15 @@ class RequestParser
     http::compression_type selected_compression;
     bool is_post_header;
     int content_length;
+    unsigned http_version_major;
+    unsigned http_version_minor;
+
+    enum class connection_option : unsigned char
+    {
+        none,
+        keep_alive,
+        close
+    } requested_connection;
 };
 }
 }
@@ -2,6 +2,7 @@
 #define SERVER_HPP
 
 #include "server/connection.hpp"
+#include "server/query_queue.hpp"
 #include "server/request_handler.hpp"
 
 #include "util/integer_range.hpp"
@@ -12,6 +13,7 @@
 
 #include <zlib.h>
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -28,18 +30,53 @@ class Server
   public:
     // Note: returns a shared instead of a unique ptr as it is captured in a lambda somewhere else
     static std::shared_ptr<Server>
-    CreateServer(std::string &ip_address, int ip_port, unsigned requested_num_threads)
+    CreateServer(std::string &ip_address,
+                 int ip_port,
+                 unsigned requested_num_threads,
+                 unsigned requested_num_io_threads,
+                 unsigned max_queue_size,
+                 unsigned max_queue_wait_ms,
+                 unsigned max_query_time_ms,
+                 unsigned max_batch_size,
+                 unsigned keepalive_timeout,
+                 unsigned keepalive_max_requests,
+                 unsigned compression_threshold)
     {
         util::SimpleLogger().Write() << "http 1.1 compression handled by zlib version "
                                      << zlibVersion();
         const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
         const unsigned real_num_threads = std::min(hardware_threads, requested_num_threads);
-        return std::make_shared<Server>(ip_address, ip_port, real_num_threads);
+        const unsigned real_num_io_threads = std::min(hardware_threads, requested_num_io_threads);
+        return std::make_shared<Server>(ip_address, ip_port, real_num_io_threads, real_num_threads,
+                                        max_queue_size,
+                                        std::chrono::milliseconds(max_queue_wait_ms),
+                                        std::chrono::milliseconds(max_query_time_ms),
+                                        max_batch_size, keepalive_timeout, keepalive_max_requests,
+                                        compression_threshold);
     }
 
-    explicit Server(const std::string &address, const int port, const unsigned thread_pool_size)
-        : thread_pool_size(thread_pool_size), acceptor(io_service),
-          new_connection(std::make_shared<Connection>(io_service, request_handler))
+    explicit Server(const std::string &address,
+                    const int port,
+                    const unsigned thread_pool_size,
+                    const unsigned query_pool_size,
+                    const std::size_t max_queue_size,
+                    const std::chrono::milliseconds max_queue_wait,
+                    const std::chrono::milliseconds max_query_time,
+                    const std::size_t max_batch_size,
+                    const unsigned keepalive_timeout,
+                    const unsigned keepalive_max_requests,
+                    const std::size_t compression_threshold)
+        : thread_pool_size(thread_pool_size), keepalive_timeout(keepalive_timeout),
+          keepalive_max_requests(keepalive_max_requests),
+          compression_threshold(compression_threshold), acceptor(io_service),
+          new_connection(std::make_shared<Connection>(io_service,
+                                                      request_handler,
+                                                      query_queue,
+                                                      keepalive_timeout,
+                                                      keepalive_max_requests,
+                                                      compression_threshold)),
+          request_handler(max_query_time, max_batch_size),
+          query_queue(query_pool_size, max_queue_size, max_queue_wait)
     {
         const auto port_string = std::to_string(port);
 
@@ -71,7 +108,11 @@ class Server
         }
     }
 
-    void Stop() { io_service.stop(); }
+    void Stop()
+    {
+        io_service.stop();
+        query_queue.Stop();
+    }
 
     RequestHandler &GetRequestHandlerPtr() { return request_handler; }
 
@@ -81,7 +122,9 @@ class Server
         if (!e)
         {
             new_connection->start();
-            new_connection = std::make_shared<Connection>(io_service, request_handler);
+            new_connection = std::make_shared<Connection>(
+                io_service, request_handler, query_queue, keepalive_timeout,
+                keepalive_max_requests, compression_threshold);
             acceptor.async_accept(
                 new_connection->socket(),
                 boost::bind(&Server::HandleAccept, this, boost::asio::placeholders::error));
@@ -89,10 +132,15 @@ class Server
     }
 
     unsigned thread_pool_size;
+    unsigned keepalive_timeout;
+    unsigned keepalive_max_requests;
+    std::size_t compression_threshold;
     boost::asio::io_service io_service;
     boost::asio::ip::tcp::acceptor acceptor;
     std::shared_ptr<Connection> new_connection;
     RequestHandler request_handler;
+    // declared last so the workers are joined before anything they use is destroyed
+    QueryQueue query_queue;
 };
 }
 }
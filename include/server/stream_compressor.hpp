@@ -0,0 +1,52 @@
+#ifndef STREAM_COMPRESSOR_HPP
+#define STREAM_COMPRESSOR_HPP
+
+#include "server/http/compression_type.hpp"
+
+#include <zlib.h>
+
+#include <vector>
+
+namespace osrm
+{
+namespace server
+{
+
+/// Reusable zlib state for compressing replies piece by piece.
+/// Setting up a deflate stream allocates a few hundred KB, which costs more than compressing a
+/// typical reply. A connection keeps one compressor and only resets it between replies.
+class StreamCompressor
+{
+  public:
+    StreamCompressor();
+    StreamCompressor(const StreamCompressor &) = delete;
+    StreamCompressor &operator=(const StreamCompressor &) = delete;
+    ~StreamCompressor();
+
+    /// Starts a new gzip or raw deflate stream.
+    void Reset(const http::compression_type compression_type);
+
+    /// Compresses [begin, end) and appends whatever zlib emits to output.
+    /// Set finish for the last piece, it flushes the pending output and ends the stream.
+    void Compress(const char *begin, const char *end, const bool finish, std::vector<char> &output);
+
+    /// Compresses the beginning of [begin, end) into output, framed as an HTTP chunk. The input
+    /// is fed to zlib in pieces until the chunk carries at least MIN_CHUNK_SIZE bytes. Ends the
+    /// stream and appends the last chunk once all input is compressed. Returns the end of the
+    /// compressed input.
+    const char *CompressChunk(const char *begin, const char *end, std::vector<char> &output);
+
+    // size of the pieces the input of a chunk is handed to zlib in
+    static const constexpr std::size_t CHUNK_INPUT_SIZE = 16 * 1024;
+    // chunks are only written once they carry at least this much compressed data
+    static const constexpr std::size_t MIN_CHUNK_SIZE = 16 * 1024;
+
+  private:
+    z_stream stream;
+    // flavor the stream is set up for, no_compression until the first reset
+    http::compression_type stream_type;
+};
+}
+}
+
+#endif // STREAM_COMPRESSOR_HPP
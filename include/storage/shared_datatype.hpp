@@ -38,6 +38,13 @@ struct SharedDataLayout
         TIMESTAMP,
         FILE_INDEX_PATH,
         CORE_MARKER,
+        SWEEP_RANKS,
+        CORE_LANDMARK_COUNT,
+        CORE_LANDMARK_INDEX,
+        CORE_LANDMARK_DISTANCES,
+        SHORTCUT_KEYS,
+        SHORTCUT_OFFSETS,
+        SHORTCUT_EDGES,
         NUM_BLOCKS
     };
 
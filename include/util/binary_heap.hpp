@@ -4,10 +4,12 @@
 #include <boost/assert.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <map>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace osrm
@@ -84,6 +86,95 @@ template <typename NodeID, typename Key> class UnorderedMapStorage
     std::unordered_map<NodeID, Key> nodes;
 };
 
+// Dense storage that is cleared in constant time. Every entry is stamped with the generation it
+// was written in, clearing only starts a new generation and leaves all entries stale.
+template <typename NodeID, typename Key> class GenerationStampedStorage
+{
+  public:
+    explicit GenerationStampedStorage(size_t size) : entries(size, Entry{0, 0}), generation(1) {}
+
+    Key &operator[](const NodeID node)
+    {
+        Entry &entry = entries[node];
+        if (entry.generation != generation)
+        {
+            entry.generation = generation;
+            entry.key = 0;
+        }
+        return entry.key;
+    }
+
+    Key peek_index(const NodeID node) const
+    {
+        const Entry &entry = entries[node];
+        if (entry.generation != generation)
+        {
+            return std::numeric_limits<Key>::max();
+        }
+        return entry.key;
+    }
+
+    std::size_t Size() const { return entries.size(); }
+
+    void Clear()
+    {
+        ++generation;
+        // only after four billion clears, stamps of the first generation would look current
+        if (0 == generation)
+        {
+            std::fill(entries.begin(), entries.end(), Entry{0, 0});
+            generation = 1;
+        }
+    }
+
+  private:
+    struct Entry
+    {
+        std::uint32_t generation;
+        Key key;
+    };
+
+    std::vector<Entry> entries;
+    std::uint32_t generation;
+};
+
+// Either GenerationStampedStorage or UnorderedMapStorage, picked when the heap is created. Dense
+// storage is faster but needs memory for every node, which is too much for large datasets.
+template <typename NodeID, typename Key> class SelectableStorage
+{
+  public:
+    SelectableStorage(size_t size, const bool use_dense)
+        : use_dense(use_dense), dense(use_dense ? size : 0), hashed(size)
+    {
+    }
+
+    Key &operator[](const NodeID node) { return use_dense ? dense[node] : hashed[node]; }
+
+    Key peek_index(const NodeID node) const
+    {
+        return use_dense ? dense.peek_index(node) : hashed.peek_index(node);
+    }
+
+    void Clear()
+    {
+        if (use_dense)
+        {
+            dense.Clear();
+        }
+        else
+        {
+            hashed.Clear();
+        }
+    }
+
+    bool IsDense() const { return use_dense; }
+
+  private:
+    bool use_dense;
+    GenerationStampedStorage<NodeID, Key> dense;
+    UnorderedMapStorage<NodeID, Key> hashed;
+};
+
 template <typename NodeID,
           typename Key,
           typename Weight,
@@ -101,6 +192,14 @@ class BinaryHeap
 
     explicit BinaryHeap(size_t maxID) : node_index(maxID) { Clear(); }
 
+    // passes further arguments on to the index storage
+    template <typename... StorageArgs>
+    BinaryHeap(size_t maxID, StorageArgs &&... storage_args)
+        : node_index(maxID, std::forward<StorageArgs>(storage_args)...)
+    {
+        Clear();
+    }
+
     void Clear()
     {
         heap.resize(1);
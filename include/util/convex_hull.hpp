@@ -0,0 +1,69 @@
+#ifndef CONVEX_HULL_HPP
+#define CONVEX_HULL_HPP
+
+#include "util/coordinate.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Convex hull of a set of coordinates in counter-clockwise order (lon as x, lat as y),
+// starting at the south-west most coordinate. The first coordinate is not repeated at the end.
+// Uses Andrew's monotone chain, collinear coordinates on the hull are dropped.
+inline std::vector<FixedPointCoordinate> ConvexHull(std::vector<FixedPointCoordinate> coordinates)
+{
+    std::sort(coordinates.begin(), coordinates.end(),
+              [](const FixedPointCoordinate &lhs, const FixedPointCoordinate &rhs)
+              {
+                  return lhs.lon < rhs.lon || (lhs.lon == rhs.lon && lhs.lat < rhs.lat);
+              });
+    coordinates.erase(std::unique(coordinates.begin(), coordinates.end()), coordinates.end());
+    if (coordinates.size() < 3)
+    {
+        return coordinates;
+    }
+
+    // > 0 if o -> a -> b turns left, fixed point coordinates need 64 bit for the products
+    const auto cross = [](const FixedPointCoordinate &o, const FixedPointCoordinate &a,
+                          const FixedPointCoordinate &b)
+    {
+        return (static_cast<std::int64_t>(a.lon) - o.lon) *
+                   (static_cast<std::int64_t>(b.lat) - o.lat) -
+               (static_cast<std::int64_t>(a.lat) - o.lat) *
+                   (static_cast<std::int64_t>(b.lon) - o.lon);
+    };
+
+    std::vector<FixedPointCoordinate> hull(2 * coordinates.size());
+    std::size_t size = 0;
+    // lower hull from west to east
+    for (const auto &coordinate : coordinates)
+    {
+        while (size >= 2 && cross(hull[size - 2], hull[size - 1], coordinate) <= 0)
+        {
+            --size;
+        }
+        hull[size++] = coordinate;
+    }
+    // upper hull from east to west, the east most coordinate is shared with the lower hull
+    const std::size_t lower_size = size + 1;
+    for (auto iter = coordinates.rbegin() + 1; iter != coordinates.rend(); ++iter)
+    {
+        while (size >= lower_size && cross(hull[size - 2], hull[size - 1], *iter) <= 0)
+        {
+            --size;
+        }
+        hull[size++] = *iter;
+    }
+    // the last coordinate is the west most one again
+    hull.resize(size - 1);
+    return hull;
+}
+}
+}
+
+#endif // CONVEX_HULL_HPP
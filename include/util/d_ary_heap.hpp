@@ -0,0 +1,251 @@
+#ifndef D_ARY_HEAP_HPP
+#define D_ARY_HEAP_HPP
+
+#include "util/binary_heap.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Drop-in replacement for BinaryHeap with Arity children per node. The tree is flatter, so
+// fewer levels are touched per operation and the children of a node share cache lines.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>,
+          unsigned Arity = 4>
+class DAryHeap
+{
+    static_assert(Arity >= 2, "a heap node needs at least two children");
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    DAryHeap(const DAryHeap &) = delete;
+    DAryHeap &operator=(const DAryHeap &) = delete;
+
+    explicit DAryHeap(size_t maxID) : node_index(maxID) { Clear(); }
+
+    // passes further arguments on to the index storage
+    template <typename... StorageArgs>
+    DAryHeap(size_t maxID, StorageArgs &&... storage_args)
+        : node_index(maxID, std::forward<StorageArgs>(storage_args)...)
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        heap.clear();
+        inserted_nodes.clear();
+        node_index.Clear();
+    }
+
+    std::size_t Size() const { return heap.size(); }
+
+    bool Empty() const { return heap.empty(); }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        const Key index = static_cast<Key>(inserted_nodes.size());
+        const Key key = static_cast<Key>(heap.size());
+        heap.push_back(HeapElement{index, weight});
+        inserted_nodes.emplace_back(node, key, weight, data);
+        node_index[node] = index;
+        Upheap(key);
+        CheckHeap();
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].key == REMOVED;
+    }
+
+    bool WasInserted(const NodeID node) const
+    {
+        const auto index = node_index.peek_index(node);
+        if (index >= static_cast<decltype(index)>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return inserted_nodes[heap.front().index].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!heap.empty());
+        return heap.front().weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!heap.empty());
+        const Key removed_index = heap.front().index;
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            Downheap(0);
+        }
+        inserted_nodes[removed_index].key = REMOVED;
+        CheckHeap();
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (const auto &element : heap)
+        {
+            inserted_nodes[element.index].key = REMOVED;
+        }
+        heap.clear();
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        BOOST_ASSERT(std::numeric_limits<NodeID>::max() != node);
+        const Key index = node_index.peek_index(node);
+        const Key key = inserted_nodes[index].key;
+        BOOST_ASSERT(key != REMOVED);
+
+        inserted_nodes[index].weight = weight;
+        heap[key].weight = weight;
+        Upheap(key);
+        CheckHeap();
+    }
+
+  private:
+    // position of nodes that were already removed from the heap
+    static const constexpr Key REMOVED = std::numeric_limits<Key>::max();
+
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Key k, Weight w, Data d) : node(n), key(k), weight(w), data(std::move(d))
+        {
+        }
+
+        NodeID node;
+        Key key;
+        Weight weight;
+        Data data;
+    };
+    struct HeapElement
+    {
+        Key index;
+        Weight weight;
+    };
+
+    std::vector<HeapNode> inserted_nodes;
+    // the root is at position 0, the children of key are at Arity * key + 1 ... Arity * key + Arity
+    std::vector<HeapElement> heap;
+    IndexStorage node_index;
+
+    void Downheap(Key key)
+    {
+        const HeapElement dropping = heap[key];
+        const std::size_t heap_size = heap.size();
+        while (true)
+        {
+            const std::size_t first_child = static_cast<std::size_t>(key) * Arity + 1;
+            if (first_child >= heap_size)
+            {
+                break;
+            }
+            const std::size_t end_child = std::min<std::size_t>(first_child + Arity, heap_size);
+            std::size_t min_child = first_child;
+            for (std::size_t child = first_child + 1; child < end_child; ++child)
+            {
+                if (heap[child].weight < heap[min_child].weight)
+                {
+                    min_child = child;
+                }
+            }
+            if (dropping.weight <= heap[min_child].weight)
+            {
+                break;
+            }
+            heap[key] = heap[min_child];
+            inserted_nodes[heap[key].index].key = key;
+            key = static_cast<Key>(min_child);
+        }
+        heap[key] = dropping;
+        inserted_nodes[dropping.index].key = key;
+    }
+
+    void Upheap(Key key)
+    {
+        const HeapElement rising = heap[key];
+        while (key > 0)
+        {
+            const Key parent = (key - 1) / Arity;
+            if (heap[parent].weight <= rising.weight)
+            {
+                break;
+            }
+            heap[key] = heap[parent];
+            inserted_nodes[heap[key].index].key = key;
+            key = parent;
+        }
+        heap[key] = rising;
+        inserted_nodes[rising.index].key = key;
+    }
+
+    void CheckHeap()
+    {
+#ifndef NDEBUG
+        for (std::size_t i = 1; i < heap.size(); ++i)
+        {
+            BOOST_ASSERT(heap[i].weight >= heap[(i - 1) / Arity].weight);
+        }
+#endif
+    }
+};
+
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage,
+          unsigned Arity>
+const constexpr Key DAryHeap<NodeID, Key, Weight, Data, IndexStorage, Arity>::REMOVED;
+}
+}
+
+#endif // D_ARY_HEAP_HPP
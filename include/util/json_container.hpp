@@ -33,10 +33,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <variant/variant.hpp>
 
-#include <vector>
+#include <algorithm>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
-#include <unordered_map>
+#include <vector>
 
 namespace osrm
 {
@@ -95,9 +97,124 @@ using Value = mapbox::util::variant<String,
                                     False,
                                     Null>;
 
+// Members of an object, kept in insertion order. Objects only have a handful of members, a
+// linear search over contiguous storage is faster than hashing and allocates far less.
+// Offers the interface of the std::unordered_map it replaces, but like a vector adding a member
+// invalidates references and iterators to all other members, and erasing one those to the
+// members after it.
+class ObjectMembers
+{
+  public:
+    using key_type = std::string;
+    using mapped_type = Value;
+    using value_type = std::pair<std::string, Value>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    Value &operator[](const std::string &key)
+    {
+        const auto iter = find(key);
+        if (iter != members.end())
+        {
+            return iter->second;
+        }
+        members.emplace_back(key, Value());
+        return members.back().second;
+    }
+
+    Value &at(const std::string &key)
+    {
+        const auto iter = find(key);
+        if (iter == members.end())
+        {
+            throw std::out_of_range("no member " + key);
+        }
+        return iter->second;
+    }
+
+    const Value &at(const std::string &key) const
+    {
+        const auto iter = find(key);
+        if (iter == members.end())
+        {
+            throw std::out_of_range("no member " + key);
+        }
+        return iter->second;
+    }
+
+    // Adds the member unless the key exists, returns its position and whether it was added
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(const std::string &key, Args &&... args)
+    {
+        const auto iter = find(key);
+        if (iter != members.end())
+        {
+            return std::make_pair(iter, false);
+        }
+        members.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+        return std::make_pair(members.end() - 1, true);
+    }
+
+    std::pair<iterator, bool> insert(value_type member)
+    {
+        const auto iter = find(member.first);
+        if (iter != members.end())
+        {
+            return std::make_pair(iter, false);
+        }
+        members.push_back(std::move(member));
+        return std::make_pair(members.end() - 1, true);
+    }
+
+    iterator find(const std::string &key)
+    {
+        return std::find_if(members.begin(), members.end(), [&key](const value_type &member)
+                            {
+                                return member.first == key;
+                            });
+    }
+
+    const_iterator find(const std::string &key) const
+    {
+        return std::find_if(members.begin(), members.end(), [&key](const value_type &member)
+                            {
+                                return member.first == key;
+                            });
+    }
+
+    std::size_t count(const std::string &key) const { return find(key) == end() ? 0 : 1; }
+
+    std::size_t erase(const std::string &key)
+    {
+        const auto iter = find(key);
+        if (iter == members.end())
+        {
+            return 0;
+        }
+        members.erase(iter);
+        return 1;
+    }
+
+    iterator erase(const_iterator position) { return members.erase(position); }
+
+    iterator begin() { return members.begin(); }
+    iterator end() { return members.end(); }
+    const_iterator begin() const { return members.begin(); }
+    const_iterator end() const { return members.end(); }
+
+    std::size_t size() const { return members.size(); }
+    bool empty() const { return members.empty(); }
+    void clear() { members.clear(); }
+    void reserve(const std::size_t capacity) { members.reserve(capacity); }
+
+  private:
+    std::vector<value_type> members;
+};
+
 struct Object
 {
-    std::unordered_map<std::string, Value> values;
+    ObjectMembers values;
 };
 
 struct Array
@@ -9,6 +9,10 @@
 
 #include "osrm/json_container.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <ostream>
 #include <vector>
 #include <iterator>
@@ -84,30 +88,116 @@ struct Renderer
     std::ostream &out;
 };
 
-struct ArrayRenderer
+namespace detail
 {
-    explicit ArrayRenderer(std::vector<char> &_out) : out(_out) {}
+// large enough for every number the fast path formats
+const constexpr std::size_t NUMBER_BUFFER_SIZE = 32;
+// larger numbers and non-finite values take the slow path
+const constexpr double MAX_FAST_NUMBER = 1e15;
+// below this the six decimals fit into an integer without loss
+const constexpr double MAX_SCALED_NUMBER = 1e9;
 
-    void operator()(const Buffer &buffer) const
+// writes the decimal digits of value, returns the end of the output
+inline char *WriteDigits(std::uint64_t value, char *out)
+{
+    char digits[20];
+    int length = 0;
+    do
     {
-        out.push_back('\"');
-        const auto string_to_insert = escape_JSON(buffer.value);
-        out.insert(std::end(out), std::begin(string_to_insert), std::end(string_to_insert));
-        out.push_back('\"');
+        digits[length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (length > 0)
+    {
+        *out++ = digits[--length];
     }
+    return out;
+}
 
-    void operator()(const String &string) const
+// Same output as cast::to_string_with_precision<double, 6>, fixed notation with trailing zeros
+// and a trailing '.' removed, but without a string stream and allocations.
+// Returns the number of characters written or 0 if the value needs the slow path.
+inline std::size_t FormatNumber(const double value, char *buffer)
+{
+    const double magnitude = std::abs(value);
+    // also false for NaN
+    if (!(magnitude < MAX_FAST_NUMBER))
     {
-        out.push_back('\"');
-        const auto string_to_insert = escape_JSON(string.value);
-        out.insert(std::end(out), std::begin(string_to_insert), std::end(string_to_insert));
-        out.push_back('\"');
+        return 0;
+    }
+
+    char *out = buffer;
+    if (std::signbit(value))
+    {
+        *out++ = '-';
+    }
+
+    if (std::floor(magnitude) == magnitude)
+    {
+        return WriteDigits(static_cast<std::uint64_t>(magnitude), out) - buffer;
+    }
+
+    const double scaled = magnitude * 1e6;
+    // away from a tie the rounding error of the product can not change the result
+    if (magnitude < MAX_SCALED_NUMBER && std::abs(scaled - std::floor(scaled) - 0.5) > 0.1)
+    {
+        const auto fixed = static_cast<std::uint64_t>(std::floor(scaled + 0.5));
+        out = WriteDigits(fixed / 1000000, out);
+        auto fraction = fixed % 1000000;
+        if (fraction != 0)
+        {
+            char digits[6];
+            for (int i = 5; i >= 0; --i)
+            {
+                digits[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            int length = 6;
+            while (digits[length - 1] == '0')
+            {
+                --length;
+            }
+            *out++ = '.';
+            out = std::copy(digits, digits + length, out);
+        }
+        return out - buffer;
+    }
+
+    auto length =
+        static_cast<std::size_t>(std::snprintf(buffer, NUMBER_BUFFER_SIZE, "%.6f", value));
+    while (buffer[length - 1] == '0')
+    {
+        --length;
+    }
+    if (buffer[length - 1] == '.')
+    {
+        --length;
     }
+    return length;
+}
+}
+
+struct ArrayRenderer
+{
+    explicit ArrayRenderer(std::vector<char> &_out) : out(_out) {}
+
+    void operator()(const Buffer &buffer) const { write_escaped(buffer.value); }
+
+    void operator()(const String &string) const { write_escaped(string.value); }
 
     void operator()(const Number &number) const
     {
-        const std::string number_string = cast::to_string_with_precision(number.value);
-        out.insert(out.end(), number_string.begin(), number_string.end());
+        char buffer[detail::NUMBER_BUFFER_SIZE];
+        const auto length = detail::FormatNumber(number.value, buffer);
+        if (length > 0)
+        {
+            out.insert(out.end(), buffer, buffer + length);
+        }
+        else
+        {
+            const std::string number_string = cast::to_string_with_precision(number.value);
+            out.insert(out.end(), number_string.begin(), number_string.end());
+        }
     }
 
     void operator()(const Object &object) const
@@ -120,7 +210,7 @@ struct ArrayRenderer
             out.push_back('\"');
             out.push_back(':');
 
-            mapbox::util::apply_visitor(ArrayRenderer(out), it->second);
+            mapbox::util::apply_visitor(*this, it->second);
             if (++it != end)
             {
                 out.push_back(',');
@@ -134,7 +224,7 @@ struct ArrayRenderer
         out.push_back('[');
         for (auto it = array.values.cbegin(), end = array.values.cend(); it != end;)
         {
-            mapbox::util::apply_visitor(ArrayRenderer(out), *it);
+            mapbox::util::apply_visitor(*this, *it);
             if (++it != end)
             {
                 out.push_back(',');
@@ -143,38 +233,76 @@ struct ArrayRenderer
         out.push_back(']');
     }
 
-    void operator()(const True &) const
-    {
-        const std::string temp("true");
-        out.insert(out.end(), temp.begin(), temp.end());
-    }
+    void operator()(const True &) const { write("true"); }
 
-    void operator()(const False &) const
+    void operator()(const False &) const { write("false"); }
+
+    void operator()(const Null &) const { write("null"); }
+
+  private:
+    template <std::size_t N> void write(const char (&literal)[N]) const
     {
-        const std::string temp("false");
-        out.insert(out.end(), temp.begin(), temp.end());
+        out.insert(out.end(), literal, literal + N - 1);
     }
 
-    void operator()(const Null &) const
+    // escapes like escape_JSON, but straight into the output
+    void write_escaped(const std::string &string) const
     {
-        const std::string temp("null");
-        out.insert(out.end(), temp.begin(), temp.end());
+        out.push_back('\"');
+        auto unescaped_begin = string.begin();
+        for (auto it = string.begin(); it != string.end(); ++it)
+        {
+            const char *replacement = nullptr;
+            switch (*it)
+            {
+            case '\\':
+                replacement = "\\\\";
+                break;
+            case '"':
+                replacement = "\\\"";
+                break;
+            case '/':
+                replacement = "\\/";
+                break;
+            case '\b':
+                replacement = "\\b";
+                break;
+            case '\f':
+                replacement = "\\f";
+                break;
+            case '\n':
+                replacement = "\\n";
+                break;
+            case '\r':
+                replacement = "\\r";
+                break;
+            case '\t':
+                replacement = "\\t";
+                break;
+            default:
+                continue;
+            }
+            out.insert(out.end(), unescaped_begin, it);
+            out.insert(out.end(), replacement, replacement + 2);
+            unescaped_begin = it + 1;
+        }
+        out.insert(out.end(), unescaped_begin, string.end());
+        out.push_back('\"');
     }
 
-  private:
     std::vector<char> &out;
 };
 
 inline void render(std::ostream &out, const Object &object)
 {
-    Value value = object;
-    mapbox::util::apply_visitor(Renderer(out), value);
+    const Renderer renderer(out);
+    renderer(object);
 }
 
 inline void render(std::vector<char> &out, const Object &object)
 {
-    Value value = object;
-    mapbox::util::apply_visitor(ArrayRenderer(out), value);
+    const ArrayRenderer renderer(out);
+    renderer(object);
 }
 
 } // namespace json
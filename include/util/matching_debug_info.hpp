@@ -7,6 +7,10 @@
 
 #include "osrm/coordinate.hpp"
 
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 namespace osrm
 {
 namespace util
@@ -80,9 +84,7 @@ struct MatchingDebugInfo
             .values.push_back(transistion);
     }
 
-    void set_viterbi(const std::vector<std::vector<double>> &viterbi,
-                     const std::vector<std::vector<bool>> &pruned,
-                     const std::vector<std::vector<bool>> &suspicious)
+    void set_viterbi(const engine::map_matching::HiddenMarkovModel &model)
     {
         // json logger not enabled
         if (!logger)
@@ -90,16 +92,17 @@ struct MatchingDebugInfo
             return;
         }
 
-        for (auto t = 0u; t < viterbi.size(); t++)
+        for (auto t = 0u; t < model.size(); t++)
         {
-            for (auto s_prime = 0u; s_prime < viterbi[t].size(); ++s_prime)
+            for (auto s_prime = 0u; s_prime < model.row_size(t); ++s_prime)
             {
+                const auto entry = model.row(t) + s_prime;
                 json::get(*object, "states", t, s_prime, "viterbi") =
-                    json::clamp_float(viterbi[t][s_prime]);
+                    json::clamp_float(model.viterbi[entry]);
                 json::get(*object, "states", t, s_prime, "pruned") =
-                    static_cast<unsigned>(pruned[t][s_prime]);
+                    static_cast<unsigned>(model.pruned[entry]);
                 json::get(*object, "states", t, s_prime, "suspicious") =
-                    static_cast<unsigned>(suspicious[t][s_prime]);
+                    static_cast<unsigned>(model.suspicious[entry]);
             }
         }
     }
@@ -115,7 +118,7 @@ struct MatchingDebugInfo
         json::get(*object, "states", t, s, "chosen") = true;
     }
 
-    void add_breakage(const std::vector<bool> &breakage)
+    void add_breakage(const std::vector<std::uint8_t> &breakage)
     {
         // json logger not enabled
         if (!logger)
@@ -123,7 +126,12 @@ struct MatchingDebugInfo
             return;
         }
 
-        json::get(*object, "breakage") = json::make_array(breakage);
+        json::Array array;
+        for (const auto broken : breakage)
+        {
+            array.values.emplace_back(static_cast<bool>(broken));
+        }
+        json::get(*object, "breakage") = std::move(array);
     }
 
     const json::Logger *logger;
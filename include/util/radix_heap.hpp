@@ -0,0 +1,276 @@
+#ifndef RADIX_HEAP_HPP
+#define RADIX_HEAP_HPP
+
+#include "util/binary_heap.hpp"
+
+#include <boost/assert.hpp>
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Monotone radix heap for integral weights, a drop-in replacement for BinaryHeap in Dijkstra
+// style searches. Weights of inserted or decreased nodes must not be smaller than the last
+// minimum that was taken out, which holds as long as all edge weights are non-negative.
+//
+// Elements are kept in buckets by the highest bit in which their weight differs from the last
+// minimum. Only the first non-empty bucket is ever redistributed, every element moves to a lower
+// bucket each time, so an element is touched at most once per bit of the weight.
+template <typename NodeID,
+          typename Key,
+          typename Weight,
+          typename Data,
+          typename IndexStorage = ArrayStorage<NodeID, NodeID>>
+class RadixHeap
+{
+    static_assert(std::is_integral<Weight>::value, "radix heaps need integral weights");
+
+  public:
+    using WeightType = Weight;
+    using DataType = Data;
+
+    RadixHeap(const RadixHeap &) = delete;
+    RadixHeap &operator=(const RadixHeap &) = delete;
+
+    explicit RadixHeap(size_t maxID) : node_index(maxID) { Clear(); }
+
+    // passes further arguments on to the index storage
+    template <typename... StorageArgs>
+    RadixHeap(size_t maxID, StorageArgs &&... storage_args)
+        : node_index(maxID, std::forward<StorageArgs>(storage_args)...)
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        for (auto &bucket : buckets)
+        {
+            bucket.clear();
+        }
+        inserted_nodes.clear();
+        node_index.Clear();
+        number_of_elements = 0;
+        last_min = 0;
+    }
+
+    std::size_t Size() const { return number_of_elements; }
+
+    bool Empty() const { return 0 == number_of_elements; }
+
+    void Insert(NodeID node, Weight weight, const Data &data)
+    {
+        const Key index = static_cast<Key>(inserted_nodes.size());
+        inserted_nodes.emplace_back(node, weight, data);
+        node_index[node] = index;
+        PutIntoBucket(index);
+        ++number_of_elements;
+    }
+
+    Data &GetData(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Data const &GetData(NodeID node) const
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].data;
+    }
+
+    Weight &GetKey(NodeID node)
+    {
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].weight;
+    }
+
+    bool WasRemoved(const NodeID node) const
+    {
+        BOOST_ASSERT(WasInserted(node));
+        const Key index = node_index.peek_index(node);
+        return inserted_nodes[index].bucket == REMOVED;
+    }
+
+    bool WasInserted(const NodeID node) const
+    {
+        const auto index = node_index.peek_index(node);
+        if (index >= static_cast<decltype(index)>(inserted_nodes.size()))
+        {
+            return false;
+        }
+        return inserted_nodes[index].node == node;
+    }
+
+    NodeID Min() const
+    {
+        BOOST_ASSERT(!Empty());
+        FillFirstBucket();
+        return inserted_nodes[buckets[0].back()].node;
+    }
+
+    Weight MinKey() const
+    {
+        BOOST_ASSERT(!Empty());
+        FillFirstBucket();
+        return inserted_nodes[buckets[0].back()].weight;
+    }
+
+    NodeID DeleteMin()
+    {
+        BOOST_ASSERT(!Empty());
+        FillFirstBucket();
+        const Key removed_index = buckets[0].back();
+        buckets[0].pop_back();
+        inserted_nodes[removed_index].bucket = REMOVED;
+        --number_of_elements;
+        return inserted_nodes[removed_index].node;
+    }
+
+    void DeleteAll()
+    {
+        for (auto &bucket : buckets)
+        {
+            for (const auto index : bucket)
+            {
+                inserted_nodes[index].bucket = REMOVED;
+            }
+            bucket.clear();
+        }
+        number_of_elements = 0;
+    }
+
+    void DecreaseKey(NodeID node, Weight weight)
+    {
+        const Key index = node_index.peek_index(node);
+        BOOST_ASSERT(inserted_nodes[index].bucket != REMOVED);
+        BOOST_ASSERT(weight <= inserted_nodes[index].weight);
+
+        RemoveFromBucket(index);
+        inserted_nodes[index].weight = weight;
+        PutIntoBucket(index);
+    }
+
+  private:
+    using RadixType = typename std::make_unsigned<Weight>::type;
+    static const constexpr unsigned NUMBER_OF_BUCKETS = std::numeric_limits<RadixType>::digits + 1;
+    // bucket of nodes that were already removed from the heap
+    static const constexpr std::uint8_t REMOVED = std::numeric_limits<std::uint8_t>::max();
+
+    class HeapNode
+    {
+      public:
+        HeapNode(NodeID n, Weight w, Data d)
+            : node(n), weight(w), data(std::move(d)), position(0), bucket(REMOVED)
+        {
+        }
+
+        NodeID node;
+        Weight weight;
+        Data data;
+        // place in its bucket
+        Key position;
+        std::uint8_t bucket;
+    };
+
+    // maps weights to unsigned values of the same order, negative weights come first
+    static RadixType ToRadix(const Weight weight)
+    {
+        return static_cast<RadixType>(weight) ^
+               (std::is_signed<Weight>::value ? RadixType(1) << (NUMBER_OF_BUCKETS - 2)
+                                              : RadixType(0));
+    }
+
+    // number of significant bits, 0 for 0
+    static unsigned BitWidth(RadixType value)
+    {
+        unsigned width = 0;
+        for (unsigned shift = std::numeric_limits<RadixType>::digits / 2; shift > 0; shift /= 2)
+        {
+            if (value >> shift)
+            {
+                value >>= shift;
+                width += shift;
+            }
+        }
+        return width + static_cast<unsigned>(value);
+    }
+
+    void PutIntoBucket(const Key index) const
+    {
+        auto &heap_node = inserted_nodes[index];
+        const auto radix = ToRadix(heap_node.weight);
+        BOOST_ASSERT_MSG(radix >= last_min, "radix heap weights must not decrease");
+        const auto bucket = BitWidth(radix ^ last_min);
+        heap_node.bucket = static_cast<std::uint8_t>(bucket);
+        heap_node.position = static_cast<Key>(buckets[bucket].size());
+        buckets[bucket].push_back(index);
+    }
+
+    void RemoveFromBucket(const Key index)
+    {
+        const auto &heap_node = inserted_nodes[index];
+        auto &bucket = buckets[heap_node.bucket];
+        const Key moved_index = bucket.back();
+        bucket[heap_node.position] = moved_index;
+        inserted_nodes[moved_index].position = heap_node.position;
+        bucket.pop_back();
+    }
+
+    // Makes sure the first bucket holds the minimum. Only changes the internal layout, so it is
+    // fine to do from the const accessors.
+    void FillFirstBucket() const
+    {
+        if (!buckets[0].empty())
+        {
+            return;
+        }
+
+        unsigned first_filled = 1;
+        while (buckets[first_filled].empty())
+        {
+            ++first_filled;
+            BOOST_ASSERT(first_filled < NUMBER_OF_BUCKETS);
+        }
+
+        auto &bucket = buckets[first_filled];
+        RadixType new_min = std::numeric_limits<RadixType>::max();
+        for (const auto index : bucket)
+        {
+            new_min = std::min(new_min, ToRadix(inserted_nodes[index].weight));
+        }
+
+        // everything in the bucket ends up in a lower one
+        last_min = new_min;
+        redistribute_buffer.swap(bucket);
+        for (const auto index : redistribute_buffer)
+        {
+            PutIntoBucket(index);
+        }
+        redistribute_buffer.clear();
+    }
+
+    mutable std::vector<HeapNode> inserted_nodes;
+    mutable std::array<std::vector<Key>, NUMBER_OF_BUCKETS> buckets;
+    mutable std::vector<Key> redistribute_buffer;
+    mutable RadixType last_min;
+    std::size_t number_of_elements;
+    IndexStorage node_index;
+};
+
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+const constexpr unsigned RadixHeap<NodeID, Key, Weight, Data, IndexStorage>::NUMBER_OF_BUCKETS;
+template <typename NodeID, typename Key, typename Weight, typename Data, typename IndexStorage>
+const constexpr std::uint8_t RadixHeap<NodeID, Key, Weight, Data, IndexStorage>::REMOVED;
+}
+}
+
+#endif // RADIX_HEAP_HPP
@@ -41,6 +41,12 @@ populate_base_path(std::unordered_map<std::string, boost::filesystem::path> &ser
         BOOST_ASSERT(server_paths.find("nodesdata") != server_paths.end());
         server_paths["coredata"] = base_string + ".core";
         BOOST_ASSERT(server_paths.find("coredata") != server_paths.end());
+        server_paths["leveldata"] = base_string + ".level";
+        BOOST_ASSERT(server_paths.find("leveldata") != server_paths.end());
+        server_paths["landmarksdata"] = base_string + ".landmarks";
+        BOOST_ASSERT(server_paths.find("landmarksdata") != server_paths.end());
+        server_paths["shortcutsdata"] = base_string + ".shortcuts";
+        BOOST_ASSERT(server_paths.find("shortcutsdata") != server_paths.end());
         server_paths["edgesdata"] = base_string + ".edges";
         BOOST_ASSERT(server_paths.find("edgesdata") != server_paths.end());
         server_paths["geometries"] = base_string + ".geometry";
@@ -123,12 +129,26 @@ GenerateServerProgramOptions(const int argc,
                              std::string &ip_address,
                              int &ip_port,
                              int &requested_num_threads,
+                             int &requested_num_io_threads,
+                             int &max_queue_size,
+                             int &max_queue_wait,
+                             int &max_query_time,
+                             int &max_batch_size,
                              bool &use_shared_memory,
                              bool &trial,
                              int &max_locations_trip,
                              int &max_locations_viaroute,
                              int &max_locations_distance_table,
-                             int &max_locations_map_matching)
+                             int &max_locations_map_matching,
+                             int &response_cache_size,
+                             int &keepalive_timeout,
+                             int &keepalive_max_requests,
+                             int &compression_threshold,
+                             int &max_dense_heap_nodes,
+                             int &min_phast_table_targets,
+                             int &trip_search_time,
+                             int &matching_session_ttl,
+                             int &min_parallel_matching_locations)
 {
     using boost::program_options::value;
     using boost::filesystem::path;
@@ -160,7 +180,19 @@ GenerateServerProgramOptions(const int argc,
         ("port,p", value<int>(&ip_port)->default_value(5000),
          "TCP/IP port") //
         ("threads,t", value<int>(&requested_num_threads)->default_value(8),
-         "Number of threads to use") //
+         "Number of threads used to answer queries") //
+        ("io-threads", value<int>(&requested_num_io_threads)->default_value(2),
+         "Number of threads handling network I/O") //
+        ("max-queue-size", value<int>(&max_queue_size)->default_value(256),
+         "Max. queries waiting for a thread, further queries are rejected with 503") //
+        ("max-queue-wait", value<int>(&max_queue_wait)->default_value(0),
+         "Reject queries expected to wait longer than this (in ms) for a thread, 0 for no "
+         "limit") //
+        ("max-query-time", value<int>(&max_query_time)->default_value(0),
+         "Abort queries running longer than this (in ms), 0 for no limit. Clients can ask for "
+         "less with the 'X-Request-Timeout' header") //
+        ("max-batch-size", value<int>(&max_batch_size)->default_value(1000),
+         "Max. queries in one batch request") //
         ("shared-memory,s",
          value<bool>(&use_shared_memory)->implicit_value(true)->default_value(false),
          "Load data from shared memory") //
@@ -171,7 +203,32 @@ GenerateServerProgramOptions(const int argc,
         ("max-table-size", value<int>(&max_locations_distance_table)->default_value(100),
          "Max. locations supported in distance table query") //
         ("max-matching-size", value<int>(&max_locations_map_matching)->default_value(100),
-         "Max. locations supported in map matching query");
+         "Max. locations supported in map matching query") //
+        ("cache-size", value<int>(&response_cache_size)->default_value(0),
+         "Size of the response cache in MB, 0 disables caching") //
+        ("keepalive-timeout", value<int>(&keepalive_timeout)->default_value(5),
+         "Seconds an idle persistent connection is kept open, 0 disables keep-alive") //
+        ("keepalive-requests", value<int>(&keepalive_max_requests)->default_value(512),
+         "Max. requests served over one persistent connection, 0 for no limit") //
+        ("compression-threshold", value<int>(&compression_threshold)->default_value(1024),
+         "Replies smaller than this (in bytes) are sent uncompressed") //
+        ("max-dense-heap-nodes", value<int>(&max_dense_heap_nodes)->default_value(0),
+         "Search heaps of datasets with at most this many nodes use arrays instead of hash maps. "
+         "An array costs 8 bytes per node, every query thread and TBB worker that searches keeps "
+         "up to six of them, e.g. 192MB per thread at 4M nodes. 0 always uses hash maps") //
+        ("phast-table-targets", value<int>(&min_phast_table_targets)->default_value(1000),
+         "Tables with at least this many destinations sweep the hierarchy (PHAST) instead of "
+         "searching buckets, 0 never sweeps") //
+        ("trip-search-time", value<int>(&trip_search_time)->default_value(100),
+         "Time (in ms) a trip request spends improving the trips of components too large to "
+         "try all orders, 0 disables it") //
+        ("matching-session-ttl", value<int>(&matching_session_ttl)->default_value(300),
+         "Seconds a map matching session is kept after its last request, 0 disables sessions") //
+        ("parallel-matching-size",
+         value<int>(&min_parallel_matching_locations)->default_value(500),
+         "Traces with at least this many coordinates are split at gaps and the parts matched in "
+         "parallel, 0 never splits. Traces without timestamps are split at large distances "
+         "between points, their matchings may differ from those of the whole trace");
 
     // hidden options, will be allowed on command line, but will not be shown to the user
     boost::program_options::options_description hidden_options("Hidden options");
@@ -216,6 +273,26 @@ GenerateServerProgramOptions(const int argc,
     {
         throw exception("Number of threads must be a positive number");
     }
+    if (1 > requested_num_io_threads)
+    {
+        throw exception("Number of I/O threads must be a positive number");
+    }
+    if (1 > max_queue_size)
+    {
+        throw exception("Max. queue size must be a positive number");
+    }
+    if (0 > max_queue_wait)
+    {
+        throw exception("Max. queue wait must not be negative");
+    }
+    if (0 > max_query_time)
+    {
+        throw exception("Max. query time must not be negative");
+    }
+    if (1 > max_batch_size)
+    {
+        throw exception("Max. batch size must be a positive number");
+    }
     if (2 > max_locations_distance_table)
     {
         throw exception("Max location for distance table must be at least two");
@@ -224,6 +301,38 @@ GenerateServerProgramOptions(const int argc,
     {
         throw exception("Max location for map matching must be at least two");
     }
+    if (0 > response_cache_size)
+    {
+        throw exception("Response cache size must not be negative");
+    }
+    if (0 > keepalive_timeout)
+    {
+        throw exception("Keep-alive timeout must not be negative");
+    }
+    if (0 > keepalive_max_requests)
+    {
+        throw exception("Max. requests per keep-alive connection must not be negative");
+    }
+    if (0 > compression_threshold)
+    {
+        throw exception("Compression threshold must not be negative");
+    }
+    if (0 > max_dense_heap_nodes)
+    {
+        throw exception("Max. nodes for dense heaps must not be negative");
+    }
+    if (0 > min_phast_table_targets)
+    {
+        throw exception("Min. destinations for PHAST tables must not be negative");
+    }
+    if (0 > matching_session_ttl)
+    {
+        throw exception("Matching session TTL must not be negative");
+    }
+    if (0 > min_parallel_matching_locations)
+    {
+        throw exception("Min. coordinates for parallel map matching must not be negative");
+    }
 
     if (!use_shared_memory && option_variables.count("base"))
     {
@@ -0,0 +1,71 @@
+#ifndef SWEEP_RANKS_HPP
+#define SWEEP_RANKS_HPP
+
+#include "util/typedefs.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace osrm
+{
+namespace util
+{
+
+// Position of every node in a top-down sweep over a contraction hierarchy. Nodes are sorted by
+// descending contraction level, so all edges of a node lead to nodes of smaller rank and a
+// downward sweep in rank order sees every node after all nodes above it.
+// Returns an empty vector if the levels do not describe the hierarchy of the graph, e.g. if it
+// has an uncontracted core or the levels are left over from an earlier contraction.
+template <typename GraphT>
+std::vector<NodeID> ComputeSweepRanks(const std::vector<float> &node_levels, const GraphT &graph)
+{
+    std::vector<NodeID> ranks;
+    if (node_levels.empty() || node_levels.size() != graph.GetNumberOfNodes())
+    {
+        return ranks;
+    }
+
+    std::vector<NodeID> sweep_order(node_levels.size());
+    std::iota(sweep_order.begin(), sweep_order.end(), 0);
+    std::stable_sort(sweep_order.begin(), sweep_order.end(), [&](const NodeID lhs, const NodeID rhs)
+                     {
+                         return node_levels[lhs] > node_levels[rhs];
+                     });
+
+    ranks.resize(sweep_order.size());
+    for (NodeID rank = 0; rank < sweep_order.size(); ++rank)
+    {
+        ranks[sweep_order[rank]] = rank;
+    }
+
+    for (NodeID node = 0; node < graph.GetNumberOfNodes(); ++node)
+    {
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            // loops are the only edges that stay on the same level
+            const NodeID target = graph.GetTarget(edge);
+            if (target != node && ranks[target] >= ranks[node])
+            {
+                ranks.clear();
+                return ranks;
+            }
+        }
+    }
+    return ranks;
+}
+
+// Nodes in the order of their sweep ranks, the inverse of ComputeSweepRanks
+template <typename RanksT> std::vector<NodeID> ComputeSweepOrder(const RanksT &ranks)
+{
+    std::vector<NodeID> sweep_order(ranks.size());
+    for (NodeID node = 0; node < ranks.size(); ++node)
+    {
+        sweep_order[ranks[node]] = node;
+    }
+    return sweep_order;
+}
+}
+}
+
+#endif // SWEEP_RANKS_HPP
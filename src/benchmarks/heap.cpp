@@ -0,0 +1,258 @@
+#include "contractor/query_edge.hpp"
+#include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/graph_loader.hpp"
+#include "util/radix_heap.hpp"
+#include "util/static_graph.hpp"
+#include "util/timing_util.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/filesystem/path.hpp>
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace osrm
+{
+namespace benchmarks
+{
+
+// Choosen by a fair W20 dice roll (this value is completely arbitrary)
+constexpr unsigned RANDOM_SEED = 13;
+
+using QueryGraph = util::StaticGraph<contractor::QueryEdge::EdgeData>;
+
+struct HeapData
+{
+    NodeID parent;
+    /* explicit */ HeapData(NodeID p) : parent(p) {}
+};
+
+template <typename IndexStorage>
+using BenchHeap = util::BinaryHeap<NodeID, NodeID, int, HeapData, IndexStorage>;
+using BenchStorage = util::GenerationStampedStorage<NodeID, int>;
+
+struct HeapOperation
+{
+    enum Type : std::uint8_t
+    {
+        clear,
+        insert,
+        decrease_key,
+        delete_min
+    } type;
+    NodeID node;
+    int weight;
+};
+
+// Binary heap that records all modifications, the trace is replayed on the other heaps so that
+// all of them do exactly the same work
+class RecordingHeap final : public BenchHeap<BenchStorage>
+{
+    using BaseHeap = BenchHeap<BenchStorage>;
+
+  public:
+    RecordingHeap(const std::size_t max_id, std::vector<HeapOperation> &trace)
+        : BaseHeap(max_id), trace(trace)
+    {
+    }
+
+    void Clear()
+    {
+        trace.push_back(HeapOperation{HeapOperation::clear, SPECIAL_NODEID, 0});
+        BaseHeap::Clear();
+    }
+
+    void Insert(NodeID node, int weight, const HeapData &data)
+    {
+        trace.push_back(HeapOperation{HeapOperation::insert, node, weight});
+        BaseHeap::Insert(node, weight, data);
+    }
+
+    void DecreaseKey(NodeID node, int weight)
+    {
+        trace.push_back(HeapOperation{HeapOperation::decrease_key, node, weight});
+        BaseHeap::DecreaseKey(node, weight);
+    }
+
+    NodeID DeleteMin()
+    {
+        trace.push_back(HeapOperation{HeapOperation::delete_min, SPECIAL_NODEID, 0});
+        return BaseHeap::DeleteMin();
+    }
+
+  private:
+    std::vector<HeapOperation> &trace;
+};
+
+std::unique_ptr<QueryGraph> loadGraph(const boost::filesystem::path &hsgr_path)
+{
+    util::ShM<QueryGraph::NodeArrayEntry, false>::vector node_list;
+    util::ShM<QueryGraph::EdgeArrayEntry, false>::vector edge_list;
+    unsigned check_sum = 0;
+    util::readHSGRFromStream(hsgr_path, node_list, edge_list, &check_sum);
+    return std::unique_ptr<QueryGraph>(new QueryGraph(node_list, edge_list));
+}
+
+// Forward search in the upward graph of the hierarchy, as done by every query for each
+// source. Settles all nodes reachable from the source, returns their number.
+template <typename HeapT> std::size_t search(const QueryGraph &graph, HeapT &heap, NodeID source)
+{
+    heap.Clear();
+    heap.Insert(source, 0, source);
+
+    std::size_t settled = 0;
+    while (!heap.Empty())
+    {
+        const NodeID node = heap.DeleteMin();
+        const int weight = heap.GetKey(node);
+        ++settled;
+
+        for (const auto edge : graph.GetAdjacentEdgeRange(node))
+        {
+            const auto &data = graph.GetEdgeData(edge);
+            if (!data.forward)
+            {
+                continue;
+            }
+            const NodeID to = graph.GetTarget(edge);
+            const int to_weight = weight + data.distance;
+            if (!heap.WasInserted(to))
+            {
+                heap.Insert(to, to_weight, node);
+            }
+            else if (to_weight < heap.GetKey(to))
+            {
+                heap.GetData(to).parent = node;
+                heap.DecreaseKey(to, to_weight);
+            }
+        }
+    }
+    return settled;
+}
+
+template <typename HeapT>
+void benchmarkHeap(const QueryGraph &graph,
+                   const std::vector<NodeID> &sources,
+                   const std::string &name,
+                   HeapT &heap)
+{
+    std::cout << "Running " << name << " with " << sources.size() << " searches: " << std::flush;
+
+    std::size_t settled = 0;
+    TIMER_START(search);
+    for (const auto source : sources)
+    {
+        settled += search(graph, heap, source);
+    }
+    TIMER_STOP(search);
+
+    std::cout << "Took " << TIMER_SEC(search) << " seconds "
+              << "(" << TIMER_MSEC(search) << "ms"
+              << ")  ->  " << TIMER_MSEC(search) / sources.size() << " ms/search "
+              << "(" << settled / sources.size() << " nodes settled per search)" << std::endl;
+}
+
+// Ties may be broken differently than in the recorded search, but that never changes which nodes
+// are still in the heap when a key is decreased, the trace stays valid for every heap.
+template <typename HeapT>
+void benchmarkTrace(const std::vector<HeapOperation> &trace,
+                    const std::size_t number_of_nodes,
+                    const std::string &name)
+{
+    HeapT heap(number_of_nodes);
+    std::cout << "Replaying " << trace.size() << " operations on " << name << ": " << std::flush;
+
+    std::uint64_t checksum = 0;
+    TIMER_START(replay);
+    for (const auto &operation : trace)
+    {
+        switch (operation.type)
+        {
+        case HeapOperation::clear:
+            heap.Clear();
+            break;
+        case HeapOperation::insert:
+            heap.Insert(operation.node, operation.weight, operation.node);
+            break;
+        case HeapOperation::decrease_key:
+            heap.DecreaseKey(operation.node, operation.weight);
+            break;
+        case HeapOperation::delete_min:
+            checksum += heap.DeleteMin();
+            break;
+        }
+    }
+    TIMER_STOP(replay);
+
+    std::cout << "Took " << TIMER_SEC(replay) << " seconds "
+              << "(" << TIMER_MSEC(replay) << "ms"
+              << ")  ->  " << TIMER_NSEC(replay) / trace.size() << " ns/operation "
+              << "(checksum " << checksum << ")" << std::endl;
+}
+
+void benchmark(const QueryGraph &graph, unsigned num_queries)
+{
+    const auto number_of_nodes = graph.GetNumberOfNodes();
+
+    std::mt19937 mt_rand(RANDOM_SEED);
+    std::uniform_int_distribution<NodeID> node_udist(0, number_of_nodes - 1);
+    std::vector<NodeID> sources;
+    for (unsigned i = 0; i < num_queries; i++)
+    {
+        sources.push_back(node_udist(mt_rand));
+    }
+
+    // heaps are reused for all searches, like the thread local heaps of the query engine
+    {
+        BenchHeap<util::UnorderedMapStorage<NodeID, int>> heap(number_of_nodes);
+        benchmarkHeap(graph, sources, "hash map storage", heap);
+    }
+    {
+        BenchHeap<util::ArrayStorage<NodeID, int>> heap(number_of_nodes);
+        benchmarkHeap(graph, sources, "array storage", heap);
+    }
+    {
+        BenchHeap<util::GenerationStampedStorage<NodeID, int>> heap(number_of_nodes);
+        benchmarkHeap(graph, sources, "generation stamped storage", heap);
+    }
+
+    std::vector<HeapOperation> trace;
+    {
+        RecordingHeap heap(number_of_nodes, trace);
+        for (const auto source : sources)
+        {
+            search(graph, heap, source);
+        }
+    }
+    benchmarkTrace<BenchHeap<BenchStorage>>(trace, number_of_nodes, "binary heap");
+    benchmarkTrace<util::DAryHeap<NodeID, NodeID, int, HeapData, BenchStorage, 4>>(
+        trace, number_of_nodes, "4-ary heap");
+    benchmarkTrace<util::DAryHeap<NodeID, NodeID, int, HeapData, BenchStorage, 8>>(
+        trace, number_of_nodes, "8-ary heap");
+    benchmarkTrace<util::RadixHeap<NodeID, NodeID, int, HeapData, BenchStorage>>(
+        trace, number_of_nodes, "radix heap");
+}
+}
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "./heap-bench file.hsgr [number of searches]"
+                  << "\n";
+        return 1;
+    }
+
+    const auto graph = osrm::benchmarks::loadGraph(argv[1]);
+    const unsigned num_queries = argc > 2 ? std::stoul(argv[2]) : 10000;
+
+    osrm::benchmarks::benchmark(*graph, num_queries);
+
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include "contractor/contractor.hpp"
+#include "contractor/core_landmarks.hpp"
 #include "contractor/graph_contractor.hpp"
+#include "contractor/shortcut_unpacking.hpp"
 
 #include "extractor/edge_based_edge.hpp"
 
@@ -23,6 +25,7 @@
 
 #include <tbb/parallel_sort.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <bitset>
@@ -107,6 +110,8 @@ int Contractor::Run()
     util::SimpleLogger().Write() << "Contraction took " << TIMER_SEC(contraction) << " sec";
 
     std::size_t number_of_used_edges = WriteContractedGraph(max_edge_id, contracted_edge_list);
+    WriteCoreLandmarks(is_core_node, contracted_edge_list);
+    WriteShortcutUnpacking(max_edge_id, contracted_edge_list);
     WriteCoreNodeMarker(std::move(is_core_node));
     if (!config.use_cached_priority)
     {
@@ -289,6 +294,71 @@ void Contractor::WriteCoreNodeMarker(std::vector<bool> &&in_is_core_node) const
                                     sizeof(char) * unpacked_bool_flags.size());
 }
 
+void Contractor::WriteCoreLandmarks(
+    const std::vector<bool> &is_core_node,
+    const util::DeallocatingVector<QueryEdge> &contracted_edge_list) const
+{
+    // the file is always written so no stale landmarks of an earlier core are loaded
+    std::vector<EdgeWeight> landmark_distances;
+    unsigned number_of_landmarks = 0;
+    unsigned number_of_core_nodes = 0;
+    if (config.core_factor < 1.0 && config.number_of_core_landmarks > 0)
+    {
+        TIMER_START(landmarks);
+        CoreLandmarks core_landmarks(is_core_node, contracted_edge_list);
+        number_of_core_nodes = core_landmarks.GetNumberOfCoreNodes();
+        number_of_landmarks = std::min(config.number_of_core_landmarks, number_of_core_nodes);
+        landmark_distances = core_landmarks.ComputeDistances(number_of_landmarks);
+        TIMER_STOP(landmarks);
+        util::SimpleLogger().Write() << "Computed " << number_of_landmarks << " landmarks for "
+                                     << number_of_core_nodes << " core nodes in "
+                                     << TIMER_SEC(landmarks) << " sec";
+    }
+
+    boost::filesystem::ofstream landmarks_output_stream(config.landmarks_output_path,
+                                                        std::ios::binary);
+    landmarks_output_stream.write((char *)&number_of_landmarks, sizeof(unsigned));
+    landmarks_output_stream.write((char *)&number_of_core_nodes, sizeof(unsigned));
+    landmarks_output_stream.write((char *)landmark_distances.data(),
+                                  sizeof(EdgeWeight) * landmark_distances.size());
+}
+
+void Contractor::WriteShortcutUnpacking(
+    const unsigned max_node_id,
+    const util::DeallocatingVector<QueryEdge> &contracted_edge_list) const
+{
+    // the file is always written so no stale unpackings of an earlier hierarchy are loaded
+    ShortcutUnpackingTable table;
+    unsigned edges_crc32 = 0;
+    if (config.min_unpacked_shortcut_size > 0)
+    {
+        TIMER_START(unpacking);
+        // edge ids are the positions in the sorted edge list, as in the .hsgr file
+        const util::StaticGraph<EdgeData> graph(max_node_id + 1, contracted_edge_list);
+        table = ShortcutUnpackingTable(graph, config.min_unpacked_shortcut_size);
+        RangebasedCRC32 crc32_calculator;
+        edges_crc32 = crc32_calculator(contracted_edge_list);
+        TIMER_STOP(unpacking);
+        util::SimpleLogger().Write() << "Unpacked " << table.keys.size() << " shortcuts into "
+                                     << table.edges.size() << " edges in "
+                                     << TIMER_SEC(unpacking) << " sec";
+    }
+
+    boost::filesystem::ofstream shortcuts_output_stream(config.shortcuts_output_path,
+                                                        std::ios::binary);
+    const unsigned number_of_shortcuts = table.keys.size();
+    const unsigned number_of_unpacked_edges = table.edges.size();
+    shortcuts_output_stream.write((char *)&edges_crc32, sizeof(unsigned));
+    shortcuts_output_stream.write((char *)&number_of_shortcuts, sizeof(unsigned));
+    shortcuts_output_stream.write((char *)&number_of_unpacked_edges, sizeof(unsigned));
+    shortcuts_output_stream.write((char *)table.keys.data(),
+                                  sizeof(unsigned) * table.keys.size());
+    shortcuts_output_stream.write((char *)table.offsets.data(),
+                                  sizeof(unsigned) * table.offsets.size());
+    shortcuts_output_stream.write((char *)table.edges.data(),
+                                  sizeof(UnpackedShortcutEdge) * table.edges.size());
+}
+
 std::size_t
 Contractor::WriteContractedGraph(unsigned max_node_id,
                                  const util::DeallocatingVector<QueryEdge> &contracted_edge_list)
@@ -1,9 +1,15 @@
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/engine_statistics.hpp"
+#include "engine/protobuf_response.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/response_cache.hpp"
 #include "engine/route_parameters.hpp"
+#include "engine/search_engine_data.hpp"
 
 #include "engine/plugins/distance_table.hpp"
 #include "engine/plugins/hello_world.hpp"
+#include "engine/plugins/isochrone.hpp"
 #include "engine/plugins/nearest.hpp"
 #include "engine/plugins/timestamp.hpp"
 #include "engine/plugins/trip.hpp"
@@ -26,6 +32,7 @@
 #include <boost/thread/lock_types.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <utility>
 #include <vector>
@@ -35,7 +42,15 @@ namespace osrm
 namespace engine
 {
 
-Engine::Engine(EngineConfig &config)
+namespace
+{
+// independently locked parts of the response cache
+const constexpr std::size_t RESPONSE_CACHE_SHARDS = 16;
+// bounds the memory of map matching sessions, each holds the candidates of a single point
+const constexpr std::size_t MAX_MATCHING_SESSIONS = 100000;
+}
+
+Engine::Engine(EngineConfig &config) : running_queries(0)
 {
     if (config.use_shared_memory)
     {
@@ -50,20 +65,31 @@ Engine::Engine(EngineConfig &config)
             config.server_paths);
     }
 
+    SearchEngineData::SetMaxDenseHeapNodes(config.max_dense_heap_nodes);
+
+    if (config.response_cache_size > 0)
+    {
+        response_cache =
+            util::make_unique<ResponseCache>(config.response_cache_size, RESPONSE_CACHE_SHARDS);
+    }
+
     using DataFacade = datafacade::BaseDataFacade<contractor::QueryEdge::EdgeData>;
 
     // The following plugins handle all requests.
     RegisterPlugin(new plugins::DistanceTablePlugin<DataFacade>(
-        query_data_facade, config.max_locations_distance_table));
+        query_data_facade, config.max_locations_distance_table, config.min_phast_table_targets));
     RegisterPlugin(new plugins::HelloWorldPlugin());
+    RegisterPlugin(new plugins::IsochronePlugin<DataFacade>(query_data_facade));
     RegisterPlugin(new plugins::NearestPlugin<DataFacade>(query_data_facade));
-    RegisterPlugin(new plugins::MapMatchingPlugin<DataFacade>(query_data_facade,
-                                                              config.max_locations_map_matching));
+    RegisterPlugin(new plugins::MapMatchingPlugin<DataFacade>(
+        query_data_facade, config.max_locations_map_matching,
+        std::chrono::seconds(config.matching_session_ttl), MAX_MATCHING_SESSIONS,
+        config.min_parallel_matching_locations));
     RegisterPlugin(new plugins::TimestampPlugin<DataFacade>(query_data_facade));
     RegisterPlugin(
         new plugins::ViaRoutePlugin<DataFacade>(query_data_facade, config.max_locations_viaroute));
-    RegisterPlugin(
-        new plugins::RoundTripPlugin<DataFacade>(query_data_facade, config.max_locations_trip));
+    RegisterPlugin(new plugins::RoundTripPlugin<DataFacade>(
+        query_data_facade, config.max_locations_trip, config.trip_search_time));
     RegisterPlugin(new plugins::TilePlugin<DataFacade>(query_data_facade));
 }
 
@@ -75,6 +101,22 @@ void Engine::RegisterPlugin(plugins::BasePlugin *raw_plugin_ptr)
 }
 
 int Engine::RunQuery(const RouteParameters &route_parameters, util::json::Object &json_result)
+{
+    return RunQuery(route_parameters, json_result, nullptr, nullptr);
+}
+
+int Engine::RunQuery(const RouteParameters &route_parameters,
+                     util::json::Object &json_result,
+                     ResponseCacheTicket &ticket,
+                     std::shared_ptr<const CachedResponse> &cached_response)
+{
+    return RunQuery(route_parameters, json_result, &ticket, &cached_response);
+}
+
+int Engine::RunQuery(const RouteParameters &route_parameters,
+                     util::json::Object &json_result,
+                     ResponseCacheTicket *ticket,
+                     std::shared_ptr<const CachedResponse> *cached_response)
 {
     const auto &plugin_iterator = plugin_map.find(route_parameters.service);
 
@@ -83,29 +125,121 @@ int Engine::RunQuery(const RouteParameters &route_parameters, util::json::Object
         json_result.values["status_message"] = "Service not found";
         return 400;
     }
+    if (!plugin_iterator->second->SupportsOutputFormat(route_parameters.output_format))
+    {
+        json_result.values["status_message"] =
+            "Output format " + route_parameters.output_format + " not supported by service";
+        return 400;
+    }
 
     osrm::engine::plugins::BasePlugin::Status return_code;
+    std::shared_ptr<const CachedResponse> cached;
+    // the cache is looked up while the query is counted, so a reload has already cleared the
+    // replies of the old dataset
+    const auto handle_request = [&]
+    {
+        if (ticket != nullptr)
+        {
+            cached = LookupResponse(route_parameters, *ticket);
+        }
+        if (!cached)
+        {
+            return_code = plugin_iterator->second->HandleRequest(route_parameters, json_result);
+        }
+    };
     increase_concurrent_query_count();
-    if (barrier)
+    try
     {
-        // Get a shared data lock so that other threads won't update
-        // things while the query is running
-        boost::shared_lock<boost::shared_mutex> data_lock{
-            (static_cast<datafacade::SharedDataFacade<contractor::QueryEdge::EdgeData> *>(
-                 query_data_facade))->data_mutex};
-        return_code = plugin_iterator->second->HandleRequest(route_parameters, json_result);
+        // all searches of this query run on the calling thread
+        ScopedQueryDeadline query_deadline(route_parameters.deadline.get());
+        if (barrier)
+        {
+            // Get a shared data lock so that other threads won't update
+            // things while the query is running
+            boost::shared_lock<boost::shared_mutex> data_lock{
+                (static_cast<datafacade::SharedDataFacade<contractor::QueryEdge::EdgeData> *>(
+                     query_data_facade))->data_mutex};
+            handle_request();
+        }
+        else
+        {
+            handle_request();
+        }
     }
-    else
+    catch (const QueryDeadlineExceeded &e)
     {
-        return_code = plugin_iterator->second->HandleRequest(route_parameters, json_result);
+        decrease_concurrent_query_count();
+        // partial results are of no use
+        json_result.values.clear();
+        json_result.values["status_message"] = e.what();
+        return 503;
+    }
+    catch (...)
+    {
+        decrease_concurrent_query_count();
+        throw;
     }
     decrease_concurrent_query_count();
-    return static_cast<int>(return_code);
+
+    if (cached)
+    {
+        *cached_response = std::move(cached);
+        return (*cached_response)->status;
+    }
+
+    // every successful binary reply carries its status, errors are always reported as JSON
+    const auto status = static_cast<int>(return_code);
+    if (route_parameters.output_format == "pbf" && status / 100 == 2)
+    {
+        auto &buffer = json_result.values["pbf"];
+        if (!buffer.is<util::json::Buffer>())
+        {
+            buffer = util::json::Buffer();
+        }
+        const auto status_message = json_result.values.find("status_message");
+        pbf::AddStatus(buffer.get<util::json::Buffer>().value, status,
+                       status_message != json_result.values.end() &&
+                               status_message->second.is<util::json::String>()
+                           ? status_message->second.get<util::json::String>().value
+                           : std::string());
+    }
+    return status;
+}
+
+std::shared_ptr<const CachedResponse>
+Engine::LookupResponse(const RouteParameters &route_parameters, ResponseCacheTicket &ticket)
+{
+    // replies of map matching sessions depend on the previous requests of the session
+    if (!response_cache || !route_parameters.session.empty())
+    {
+        return {};
+    }
+
+    ticket.generation = response_cache->GetGeneration();
+    ticket.key = MakeResponseCacheKey(route_parameters, query_data_facade->GetCheckSum());
+    return response_cache->Get(ticket.key);
+}
+
+void Engine::StoreResponse(const ResponseCacheTicket &ticket, CachedResponse response)
+{
+    if (!response_cache || ticket.key.empty())
+    {
+        return;
+    }
+    response_cache->Put(ticket, std::make_shared<const CachedResponse>(std::move(response)));
+}
+
+EngineStatistics Engine::GetStatistics() const
+{
+    const auto search_effort = SearchEngineData::GetTotalSearchEffort();
+    return EngineStatistics{running_queries.load(), search_effort.heap_pops,
+                            search_effort.edge_relaxations};
 }
 
 // decrease number of concurrent queries
 void Engine::decrease_concurrent_query_count()
 {
+    --running_queries;
     if (!barrier)
     {
         return;
@@ -128,6 +262,7 @@ void Engine::decrease_concurrent_query_count()
 // increase number of concurrent queries
 void Engine::increase_concurrent_query_count()
 {
+    ++running_queries;
     if (!barrier)
     {
         return;
@@ -147,8 +282,13 @@ void Engine::increase_concurrent_query_count()
     // increment query count
     ++(barrier->number_of_queries);
 
-    (static_cast<datafacade::SharedDataFacade<contractor::QueryEdge::EdgeData> *>(
-         query_data_facade))->CheckAndReloadFacade();
+    const bool reloaded =
+        (static_cast<datafacade::SharedDataFacade<contractor::QueryEdge::EdgeData> *>(
+             query_data_facade))->CheckAndReloadFacade();
+    if (reloaded && response_cache)
+    {
+        response_cache->Clear();
+    }
 }
 }
 }
@@ -0,0 +1,86 @@
+#include "engine/isochrone_areas.hpp"
+#include "util/convex_hull.hpp"
+#include "util/integer_range.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+IsochroneAreas::IsochroneAreas(std::vector<EdgeWeight> weight_cutoffs_,
+                               const util::FixedPointCoordinate source)
+    : weight_cutoffs(std::move(weight_cutoffs_)), reached_coordinates(weight_cutoffs.size()),
+      number_of_reached_segments(0)
+{
+    BOOST_ASSERT(!weight_cutoffs.empty());
+    BOOST_ASSERT(std::is_sorted(weight_cutoffs.begin(), weight_cutoffs.end()));
+    reached_coordinates.front().push_back(source);
+}
+
+void IsochroneAreas::AddSegment(const EdgeWeight distance,
+                                const EdgeWeight offset,
+                                const EdgeWeight weight,
+                                const util::FixedPointCoordinate from,
+                                const util::FixedPointCoordinate to)
+{
+    if (distance == INVALID_EDGE_WEIGHT)
+    {
+        return;
+    }
+    const EdgeWeight from_weight = distance + offset;
+    const EdgeWeight to_weight = from_weight + weight;
+    // parts of the source segment behind the source are not reached
+    if (to_weight < 0 || from_weight > weight_cutoffs.back())
+    {
+        return;
+    }
+    ++number_of_reached_segments;
+    AddReachedCoordinate(from_weight, from);
+    AddReachedCoordinate(to_weight, to);
+    // the segment leaves the area of every cutoff between its end points
+    for (const auto i : util::irange<std::size_t>(0, weight_cutoffs.size()))
+    {
+        if (from_weight <= weight_cutoffs[i] && weight_cutoffs[i] < to_weight)
+        {
+            const double ratio = static_cast<double>(weight_cutoffs[i] - from_weight) / weight;
+            reached_coordinates[i].emplace_back(
+                static_cast<int>(from.lat + ratio * (to.lat - from.lat)),
+                static_cast<int>(from.lon + ratio * (to.lon - from.lon)));
+        }
+    }
+}
+
+std::vector<std::vector<util::FixedPointCoordinate>> IsochroneAreas::GetAreas() const
+{
+    std::vector<std::vector<util::FixedPointCoordinate>> areas;
+    std::vector<util::FixedPointCoordinate> hull;
+    for (const auto &coordinates : reached_coordinates)
+    {
+        // the hull of the smaller cutoffs already contains everything reached within them
+        hull.insert(hull.end(), coordinates.begin(), coordinates.end());
+        hull = util::ConvexHull(std::move(hull));
+        areas.push_back(hull);
+    }
+    return areas;
+}
+
+void IsochroneAreas::AddReachedCoordinate(const EdgeWeight weight,
+                                          const util::FixedPointCoordinate coordinate)
+{
+    if (weight < 0)
+    {
+        return;
+    }
+    const auto cutoff = std::lower_bound(weight_cutoffs.begin(), weight_cutoffs.end(), weight);
+    if (cutoff != weight_cutoffs.end())
+    {
+        reached_coordinates[cutoff - weight_cutoffs.begin()].push_back(coordinate);
+    }
+}
+}
+}
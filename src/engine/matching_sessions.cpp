@@ -0,0 +1,97 @@
+#include "engine/matching_sessions.hpp"
+
+#include <boost/assert.hpp>
+
+#include <utility>
+
+namespace osrm
+{
+namespace engine
+{
+
+MatchingSessions::MatchingSessions(const std::chrono::seconds time_to_live,
+                                   const std::size_t max_sessions)
+    : time_to_live(time_to_live), max_sessions(max_sessions)
+{
+    BOOST_ASSERT(max_sessions > 0);
+}
+
+bool MatchingSessions::Take(const std::string &session,
+                            MatchingFrontier &frontier,
+                            const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Evict(now);
+
+    const auto iter = index.find(session);
+    if (iter == index.end())
+    {
+        return false;
+    }
+    frontier = std::move(iter->second->frontier);
+    sessions.erase(iter->second);
+    index.erase(iter);
+    return true;
+}
+
+void MatchingSessions::Put(const std::string &session,
+                           MatchingFrontier frontier,
+                           const Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto iter = index.find(session);
+    if (iter != index.end())
+    {
+        // a concurrent request of the same session, the later one wins
+        sessions.erase(iter->second);
+        index.erase(iter);
+    }
+
+    sessions.push_front(Session{session, std::move(frontier), now});
+    index.emplace(session, sessions.begin());
+    Evict(now);
+}
+
+std::size_t MatchingSessions::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return sessions.size();
+}
+
+ScopedFrontierReturn::ScopedFrontierReturn(MatchingSessions &sessions,
+                                           std::string session,
+                                           MatchingFrontier frontier)
+    : sessions(sessions), session(std::move(session)), frontier(std::move(frontier)),
+      dismissed(false)
+{
+}
+
+ScopedFrontierReturn::~ScopedFrontierReturn()
+{
+    if (dismissed)
+    {
+        return;
+    }
+    try
+    {
+        sessions.Put(session, std::move(frontier), MatchingSessions::Clock::now());
+    }
+    catch (...)
+    {
+        // may run while an exception unwinds, the session is lost then
+    }
+}
+
+void MatchingSessions::Evict(const Clock::time_point now)
+{
+    // the list is ordered by last use, so expired sessions are at its end
+    while (!sessions.empty() &&
+           (sessions.size() > max_sessions || now - sessions.back().last_used > time_to_live))
+    {
+        index.erase(sessions.back().id);
+        sessions.pop_back();
+    }
+}
+}
+}
@@ -0,0 +1,27 @@
+#include "engine/query_deadline.hpp"
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+// the state is owned by the scope object, the thread local storage only points to it
+void no_cleanup(ScopedQueryDeadline::State *) {}
+}
+
+boost::thread_specific_ptr<ScopedQueryDeadline::State>
+    ScopedQueryDeadline::current_state(&no_cleanup);
+
+ScopedQueryDeadline::ScopedQueryDeadline(const QueryDeadline *deadline)
+    : state{deadline, 0}, previous_state(current_state.get())
+{
+    current_state.reset(&state);
+}
+
+ScopedQueryDeadline::~ScopedQueryDeadline() { current_state.reset(previous_state); }
+
+void QueryDeadlineExceeded::anchor() const {}
+}
+}
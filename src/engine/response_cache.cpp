@@ -0,0 +1,218 @@
+#include "engine/response_cache.hpp"
+#include "engine/route_parameters.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+namespace osrm
+{
+namespace engine
+{
+
+namespace
+{
+// rough bookkeeping cost of an entry on top of key and content
+const constexpr std::size_t ENTRY_OVERHEAD = 128;
+
+class KeyWriter
+{
+  public:
+    explicit KeyWriter(std::string &key) : key(key) {}
+
+    template <typename T> void Write(const T value)
+    {
+        static_assert(std::is_arithmetic<T>::value, "only plain values can be written");
+        key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void Write(const std::string &value)
+    {
+        // length prefix keeps consecutive strings from being ambiguous
+        Write(static_cast<std::uint32_t>(value.size()));
+        key.append(value);
+    }
+
+    template <typename T> void Write(const std::vector<T> &values)
+    {
+        Write(static_cast<std::uint32_t>(values.size()));
+        for (const auto &value : values)
+        {
+            Write(value);
+        }
+    }
+
+    // std::vector<bool> elements are proxies, not plain values
+    void Write(const std::vector<bool> &values)
+    {
+        Write(static_cast<std::uint32_t>(values.size()));
+        for (const bool value : values)
+        {
+            Write(value);
+        }
+    }
+
+  private:
+    std::string &key;
+};
+}
+
+std::string MakeResponseCacheKey(const RouteParameters &route_parameters,
+                                 const unsigned data_checksum)
+{
+    std::string key;
+    key.reserve(64 + 8 * route_parameters.coordinates.size());
+    KeyWriter writer(key);
+
+    writer.Write(data_checksum);
+    writer.Write(route_parameters.service);
+    writer.Write(route_parameters.output_format);
+    writer.Write(route_parameters.jsonp_parameter);
+    writer.Write(route_parameters.language);
+    writer.Write(route_parameters.zoom_level);
+    writer.Write(route_parameters.print_instructions);
+    writer.Write(route_parameters.alternate_route);
+    writer.Write(route_parameters.geometry);
+    writer.Write(route_parameters.compression);
+    writer.Write(route_parameters.deprecatedAPI);
+    writer.Write(route_parameters.uturn_default);
+    writer.Write(route_parameters.classify);
+    writer.Write(route_parameters.matching_beta);
+    writer.Write(route_parameters.gps_precision);
+    writer.Write(route_parameters.check_sum);
+    writer.Write(route_parameters.num_results);
+    writer.Write(route_parameters.x);
+    writer.Write(route_parameters.y);
+    writer.Write(route_parameters.z);
+
+    writer.Write(static_cast<std::uint32_t>(route_parameters.coordinates.size()));
+    for (const auto &coordinate : route_parameters.coordinates)
+    {
+        writer.Write(coordinate.lat);
+        writer.Write(coordinate.lon);
+    }
+    writer.Write(static_cast<std::uint32_t>(route_parameters.bearings.size()));
+    for (const auto &bearing : route_parameters.bearings)
+    {
+        writer.Write(bearing.first);
+        writer.Write(bearing.second ? *bearing.second : -1);
+    }
+    writer.Write(route_parameters.hints);
+    writer.Write(route_parameters.timestamps);
+    writer.Write(route_parameters.uturns);
+    writer.Write(route_parameters.is_source);
+    writer.Write(route_parameters.is_destination);
+    writer.Write(route_parameters.cutoffs);
+
+    return key;
+}
+
+ResponseCache::ResponseCache(const std::size_t max_size_in_bytes,
+                             const std::size_t number_of_shards)
+    : max_shard_size_in_bytes(max_size_in_bytes / std::max<std::size_t>(1, number_of_shards)),
+      generation(0)
+{
+    BOOST_ASSERT(number_of_shards > 0);
+    shards.reserve(number_of_shards);
+    for (std::size_t i = 0; i < number_of_shards; ++i)
+    {
+        shards.emplace_back(new Shard());
+    }
+}
+
+std::shared_ptr<const CachedResponse> ResponseCache::Get(const std::string &key)
+{
+    auto &shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    const auto iter = shard.index.find(key);
+    if (iter == shard.index.end())
+    {
+        return {};
+    }
+    // move to the front of the LRU list
+    shard.entries.splice(shard.entries.begin(), shard.entries, iter->second);
+    return iter->second->second;
+}
+
+void ResponseCache::Put(const ResponseCacheTicket &ticket,
+                        std::shared_ptr<const CachedResponse> response)
+{
+    BOOST_ASSERT(response);
+    const auto entry_size = GetEntrySize(ticket.key, *response);
+    if (entry_size > max_shard_size_in_bytes)
+    {
+        return;
+    }
+
+    auto &shard = GetShard(ticket.key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // Clear() bumps the generation before it empties the shards, so checking it while holding
+    // the shard lock guarantees that no result computed on replaced data survives a Clear()
+    if (ticket.generation != generation.load())
+    {
+        return;
+    }
+
+    const auto iter = shard.index.find(ticket.key);
+    if (iter != shard.index.end())
+    {
+        // a concurrent query computed the same response
+        shard.size_in_bytes -= GetEntrySize(iter->first, *iter->second->second);
+        shard.entries.erase(iter->second);
+        shard.index.erase(iter);
+    }
+
+    shard.entries.emplace_front(ticket.key, std::move(response));
+    shard.index.emplace(ticket.key, shard.entries.begin());
+    shard.size_in_bytes += entry_size;
+
+    while (shard.size_in_bytes > max_shard_size_in_bytes)
+    {
+        BOOST_ASSERT(!shard.entries.empty());
+        const auto &least_recently_used = shard.entries.back();
+        shard.size_in_bytes -= GetEntrySize(least_recently_used.first, *least_recently_used.second);
+        shard.index.erase(least_recently_used.first);
+        shard.entries.pop_back();
+    }
+}
+
+void ResponseCache::Clear()
+{
+    ++generation;
+    for (auto &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+        shard->size_in_bytes = 0;
+    }
+}
+
+std::uint64_t ResponseCache::GetGeneration() const { return generation.load(); }
+
+std::size_t ResponseCache::GetSizeInBytes() const
+{
+    std::size_t size_in_bytes = 0;
+    for (const auto &shard : shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        size_in_bytes += shard->size_in_bytes;
+    }
+    return size_in_bytes;
+}
+
+ResponseCache::Shard &ResponseCache::GetShard(const std::string &key)
+{
+    return *shards[std::hash<std::string>()(key) % shards.size()];
+}
+
+std::size_t ResponseCache::GetEntrySize(const std::string &key, const CachedResponse &response)
+{
+    // the key is stored twice, in the list and in the index
+    return 2 * key.size() + response.content.size() + ENTRY_OVERHEAD;
+}
+}
+}
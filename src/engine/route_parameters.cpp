@@ -2,6 +2,7 @@
 #include "util/coordinate.hpp"
 
 #include "engine/polyline_compressor.hpp"
+#include "engine/query_deadline.hpp"
 
 #include <string>
 #include <utility>
@@ -14,7 +15,7 @@ namespace engine
 RouteParameters::RouteParameters()
     : zoom_level(18), print_instructions(false), alternate_route(true), geometry(true),
       compression(true), deprecatedAPI(false), uturn_default(false), classify(false),
-      matching_beta(5), gps_precision(5), check_sum(-1), num_results(1)
+      matching_beta(5), gps_precision(5), check_sum(-1), num_results(1), z(0), x(0), y(0)
 {
 }
 
@@ -58,6 +59,11 @@ void RouteParameters::SetDeprecatedAPIFlag(const std::string & /*unused*/) { dep
 
 void RouteParameters::SetChecksum(const unsigned sum) { check_sum = sum; }
 
+void RouteParameters::SetDeadline(const std::chrono::steady_clock::time_point deadline_)
+{
+    deadline = std::make_shared<QueryDeadline>(deadline_);
+}
+
 void RouteParameters::SetInstructionFlag(const bool flag) { print_instructions = flag; }
 
 void RouteParameters::SetService(const std::string &service_string) { service = service_string; }
@@ -144,6 +150,10 @@ void RouteParameters::SetCoordinatesFromGeometry(const std::string &geometry_str
     coordinates = polylineDecode(geometry_string);
 }
 
+void RouteParameters::AddCutoff(const unsigned cutoff) { cutoffs.push_back(cutoff); }
+
+void RouteParameters::SetSession(const std::string &session_) { session = session_; }
+
 void RouteParameters::SetX(const int &x_) { x = x_; }
 void RouteParameters::SetZ(const int &z_) { z = z_; }
 void RouteParameters::SetY(const int &y_) { y = y_; }
@@ -1,73 +1,131 @@
 #include "engine/search_engine_data.hpp"
 
+#include "engine/map_matching/hidden_markov_model.hpp"
 #include "util/binary_heap.hpp"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace osrm
 {
 namespace engine
 {
 
-void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_1;
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_1;
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_2;
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_2;
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::forward_heap_3;
+SearchEngineData::SearchEngineHeapPtr SearchEngineData::reverse_heap_3;
+
+namespace
 {
-    if (forward_heap_1.get())
-    {
-        forward_heap_1->Clear();
-    }
-    else
-    {
-        forward_heap_1.reset(new QueryHeap(number_of_nodes));
-    }
+// the counters are owned by the registry below, the thread local storage only points to them
+void no_cleanup(SearchEffortCounters *) {}
+
+boost::thread_specific_ptr<SearchEffortCounters> thread_search_effort(&no_cleanup);
+
+// counters of all threads that ever searched, kept so their totals survive the threads
+std::mutex search_effort_mutex;
+std::vector<std::unique_ptr<SearchEffortCounters>> search_effort_registry;
+
+std::atomic<std::size_t> max_dense_heap_nodes(0);
+
+boost::thread_specific_ptr<map_matching::HiddenMarkovModel> thread_hidden_markov_model;
 
-    if (reverse_heap_1.get())
+boost::thread_specific_ptr<SearchEngineData::NodeSlotStorage> thread_node_slots;
+
+// Heaps live as long as their thread and are shared by all of its queries. They are only
+// replaced when the dataset changed size, a dense heap could not index all nodes otherwise.
+void InitializeOrClear(SearchEngineData::SearchEngineHeapPtr &heap, const unsigned number_of_nodes)
+{
+    if (heap.get() && heap->GetMaxID() == number_of_nodes)
     {
-        reverse_heap_1->Clear();
+        heap->Clear();
     }
     else
     {
-        reverse_heap_1.reset(new QueryHeap(number_of_nodes));
+        heap.reset(new SearchEngineData::QueryHeap(
+            number_of_nodes, number_of_nodes <= max_dense_heap_nodes.load()));
     }
 }
+}
 
-void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+CountingQueryHeap::CountingQueryHeap(const std::size_t max_id, const bool use_dense_storage)
+    : BaseHeap(max_id, use_dense_storage), counters(SearchEngineData::GetThreadSearchEffort()),
+      max_id(max_id)
 {
-    if (forward_heap_2.get())
-    {
-        forward_heap_2->Clear();
-    }
-    else
-    {
-        forward_heap_2.reset(new QueryHeap(number_of_nodes));
-    }
+}
 
-    if (reverse_heap_2.get())
-    {
-        reverse_heap_2->Clear();
-    }
-    else
+void SearchEngineData::SetMaxDenseHeapNodes(const std::size_t max_nodes)
+{
+    max_dense_heap_nodes = max_nodes;
+}
+
+SearchEffortCounters &SearchEngineData::GetThreadSearchEffort()
+{
+    if (!thread_search_effort.get())
     {
-        reverse_heap_2.reset(new QueryHeap(number_of_nodes));
+        std::lock_guard<std::mutex> lock(search_effort_mutex);
+        search_effort_registry.emplace_back(new SearchEffortCounters());
+        thread_search_effort.reset(search_effort_registry.back().get());
     }
+    return *thread_search_effort;
 }
 
-void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+SearchEffort SearchEngineData::GetTotalSearchEffort()
 {
-    if (forward_heap_3.get())
+    SearchEffort total{0, 0};
+    std::lock_guard<std::mutex> lock(search_effort_mutex);
+    for (const auto &counters : search_effort_registry)
     {
-        forward_heap_3->Clear();
+        total.heap_pops += counters->heap_pops.load(std::memory_order_relaxed);
+        total.edge_relaxations += counters->edge_relaxations.load(std::memory_order_relaxed);
     }
-    else
+    return total;
+}
+
+map_matching::HiddenMarkovModel &SearchEngineData::GetThreadHiddenMarkovModel()
+{
+    if (!thread_hidden_markov_model.get())
     {
-        forward_heap_3.reset(new QueryHeap(number_of_nodes));
+        thread_hidden_markov_model.reset(new map_matching::HiddenMarkovModel());
     }
+    return *thread_hidden_markov_model;
+}
 
-    if (reverse_heap_3.get())
+SearchEngineData::NodeSlotStorage &
+SearchEngineData::InitializeOrClearThreadNodeSlots(const unsigned number_of_nodes)
+{
+    if (thread_node_slots.get() && thread_node_slots->Size() == number_of_nodes)
     {
-        reverse_heap_3->Clear();
+        thread_node_slots->Clear();
     }
     else
     {
-        reverse_heap_3.reset(new QueryHeap(number_of_nodes));
+        thread_node_slots.reset(new NodeSlotStorage(number_of_nodes));
     }
+    return *thread_node_slots;
+}
+
+void SearchEngineData::InitializeOrClearFirstThreadLocalStorage(const unsigned number_of_nodes)
+{
+    InitializeOrClear(forward_heap_1, number_of_nodes);
+    InitializeOrClear(reverse_heap_1, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearSecondThreadLocalStorage(const unsigned number_of_nodes)
+{
+    InitializeOrClear(forward_heap_2, number_of_nodes);
+    InitializeOrClear(reverse_heap_2, number_of_nodes);
+}
+
+void SearchEngineData::InitializeOrClearThirdThreadLocalStorage(const unsigned number_of_nodes)
+{
+    InitializeOrClear(forward_heap_3, number_of_nodes);
+    InitializeOrClear(reverse_heap_3, number_of_nodes);
 }
 }
 }
@@ -1,7 +1,9 @@
 #include "osrm/osrm.hpp"
 #include "engine/engine.hpp"
 #include "engine/engine_config.hpp"
+#include "engine/engine_statistics.hpp"
 #include "engine/plugins/plugin_base.hpp"
+#include "engine/response_cache.hpp"
 #include "storage/shared_barriers.hpp"
 #include "util/make_unique.hpp"
 
@@ -19,4 +21,19 @@ int OSRM::RunQuery(const RouteParameters &route_parameters, util::json::Object &
     return engine_->RunQuery(route_parameters, json_result);
 }
 
+int OSRM::RunQuery(const RouteParameters &route_parameters,
+                   util::json::Object &json_result,
+                   engine::ResponseCacheTicket &ticket,
+                   std::shared_ptr<const engine::CachedResponse> &cached_response)
+{
+    return engine_->RunQuery(route_parameters, json_result, ticket, cached_response);
+}
+
+void OSRM::StoreResponse(const engine::ResponseCacheTicket &ticket,
+                         engine::CachedResponse response)
+{
+    engine_->StoreResponse(ticket, std::move(response));
+}
+
+engine::EngineStatistics OSRM::GetStatistics() const { return engine_->GetStatistics(); }
 }
@@ -0,0 +1,203 @@
+#include "server/access_log.hpp"
+#include "server/http/request.hpp"
+
+#include "util/simple_logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// the buffers are owned by the registry, the thread local storage only points to them
+template <typename T> void no_cleanup(T *) {}
+
+// how long the drain thread sleeps when there was nothing to write
+const constexpr auto IDLE_DRAIN_INTERVAL = std::chrono::milliseconds(20);
+
+// empty fields are written as '-'
+std::pair<const char *, std::size_t> Field(const std::string &text)
+{
+    return text.empty() ? std::make_pair("-", std::size_t{1})
+                        : std::make_pair(text.data(), text.size());
+}
+}
+
+const constexpr std::size_t AccessLog::RECORDS_PER_THREAD;
+const constexpr std::size_t AccessLog::MAX_LINE_LENGTH;
+
+AccessLog::AccessLog()
+    : thread_buffer(&no_cleanup<RingBuffer>), cached_time(0), reported_dropped(0), stopped(false)
+{
+    cached_timestamp[0] = '\0';
+    drain_thread = std::thread(&AccessLog::Drain, this);
+}
+
+AccessLog::~AccessLog()
+{
+    stopped = true;
+    drain_thread.join();
+}
+
+void AccessLog::Log(const http::request &current_request, const std::string &decoded_uri)
+{
+    if (util::LogPolicy::GetInstance().IsMute())
+    {
+        return;
+    }
+
+    auto &buffer = GetThreadBuffer();
+    const auto head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) == RECORDS_PER_THREAD)
+    {
+        // never wait for the drain thread, losing a log line is better than a slow reply
+        buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1,
+                             std::memory_order_relaxed);
+        return;
+    }
+
+    const auto endpoint = current_request.endpoint.to_string();
+    const std::array<std::pair<const char *, std::size_t>, 7> parts = {
+        {std::make_pair(endpoint.data(), endpoint.size()), std::make_pair(" ", std::size_t{1}),
+         Field(current_request.referrer), std::make_pair(" ", std::size_t{1}),
+         Field(current_request.agent), std::make_pair(" ", std::size_t{1}),
+         std::make_pair(decoded_uri.data(), decoded_uri.size())}};
+    std::size_t length = 0;
+    for (const auto &part : parts)
+    {
+        length += part.second;
+    }
+
+    auto &record = buffer.records[head % RECORDS_PER_THREAD];
+    record.time = std::time(nullptr);
+    record.length = static_cast<std::uint32_t>(length);
+    if (length <= MAX_LINE_LENGTH)
+    {
+        auto out = record.line.data();
+        for (const auto &part : parts)
+        {
+            out = std::copy(part.first, part.first + part.second, out);
+        }
+    }
+    else
+    {
+        record.long_line.clear();
+        for (const auto &part : parts)
+        {
+            record.long_line.append(part.first, part.second);
+        }
+    }
+
+    // publishes the record to the drain thread
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::uint64_t AccessLog::GetDroppedRecords() const
+{
+    std::uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &buffer : registry)
+    {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+AccessLog::RingBuffer &AccessLog::GetThreadBuffer()
+{
+    if (!thread_buffer.get())
+    {
+        std::unique_ptr<RingBuffer> buffer(new RingBuffer());
+        buffer->head = 0;
+        buffer->dropped = 0;
+        buffer->tail = 0;
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::move(buffer));
+        thread_buffer.reset(registry.back().get());
+    }
+    return *thread_buffer;
+}
+
+void AccessLog::Drain()
+{
+    while (!stopped)
+    {
+        if (DrainOnce() == 0)
+        {
+            std::this_thread::sleep_for(IDLE_DRAIN_INTERVAL);
+        }
+    }
+    // records logged before the shutdown
+    DrainOnce();
+}
+
+std::size_t AccessLog::DrainOnce()
+{
+    // buffers are only ever added, the ones we know about stay valid
+    std::vector<RingBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffers.reserve(registry.size());
+        for (const auto &buffer : registry)
+        {
+            buffers.push_back(buffer.get());
+        }
+    }
+
+    std::size_t written = 0;
+    std::uint64_t dropped = 0;
+    for (auto buffer : buffers)
+    {
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        auto tail = buffer->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail)
+        {
+            const auto &record = buffer->records[tail % RECORDS_PER_THREAD];
+            if (record.length > MAX_LINE_LENGTH)
+            {
+                util::SimpleLogger().Write() << FormatTime(record.time) << " "
+                                             << record.long_line;
+            }
+            else
+            {
+                util::SimpleLogger().Write() << FormatTime(record.time) << " "
+                                             << std::string(record.line.data(), record.length);
+            }
+            ++written;
+        }
+        // hands the slots back to the producer
+        buffer->tail.store(tail, std::memory_order_release);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    if (dropped > reported_dropped)
+    {
+        util::SimpleLogger().Write(logWARNING) << "access log dropped "
+                                               << dropped - reported_dropped
+                                               << " requests, the log can not keep up";
+        reported_dropped = dropped;
+    }
+    return written;
+}
+
+const char *AccessLog::FormatTime(const std::time_t time)
+{
+    // requests arrive much more often than once a second
+    if (time != cached_time)
+    {
+        // only the drain thread formats times, localtime's static buffer is not shared
+        const auto time_stamp = std::localtime(&time);
+        std::strftime(cached_timestamp.data(), cached_timestamp.size(), "%d-%m-%Y %H:%M:%S",
+                      time_stamp);
+        cached_time = time;
+    }
+    return cached_timestamp.data();
+}
+}
+}
@@ -1,11 +1,11 @@
 #include "server/connection.hpp"
+#include "server/query_queue.hpp"
 #include "server/request_handler.hpp"
 #include "server/request_parser.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/bind.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include <string>
 #include <vector>
@@ -15,16 +15,43 @@ namespace osrm
 namespace server
 {
 
-Connection::Connection(boost::asio::io_service &io_service, RequestHandler &handler)
-    : strand(io_service), TCP_socket(io_service), request_handler(handler)
+namespace
+{
+// answered on the I/O threads without going through the query queue
+const constexpr char QUEUE_STATUS_URI[] = "/queue";
+const constexpr char METRICS_URI[] = "/metrics";
+}
+
+Connection::Connection(boost::asio::io_service &io_service,
+                       RequestHandler &handler,
+                       QueryQueue &query_queue,
+                       const unsigned keepalive_timeout,
+                       const unsigned keepalive_max_requests,
+                       const std::size_t compression_threshold)
+    : strand(io_service), TCP_socket(io_service), idle_timer(io_service),
+      request_handler(handler), query_queue(query_queue), keepalive_timeout(keepalive_timeout),
+      keepalive_max_requests(keepalive_max_requests), compression_threshold(compression_threshold),
+      processed_requests(0), keep_alive(false), pending_data_begin(0), pending_data_end(0),
+      compressed_content_end(0), sending_chunks(false)
 {
 }
 
 boost::asio::ip::tcp::socket &Connection::socket() { return TCP_socket; }
 
 /// Start the first asynchronous operation for the connection.
-void Connection::start()
+void Connection::start() { read_more(); }
+
+void Connection::read_more()
 {
+    if (keepalive_timeout > 0)
+    {
+        // re-arming the timer cancels a pending wait
+        idle_timer.expires_from_now(boost::posix_time::seconds(keepalive_timeout));
+        idle_timer.async_wait(
+            strand.wrap(boost::bind(&Connection::handle_timeout, this->shared_from_this(),
+                                    boost::asio::placeholders::error)));
+    }
+
     TCP_socket.async_read_some(
         boost::asio::buffer(incoming_data_buffer),
         strand.wrap(boost::bind(&Connection::handle_read, this->shared_from_this(),
@@ -36,58 +63,168 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
 {
     if (error)
     {
+        // the client is gone, the pending idle wait would keep the connection and its socket
+        // alive until the timeout
+        boost::system::error_code ignore_error;
+        idle_timer.cancel(ignore_error);
+        TCP_socket.close(ignore_error);
         return;
     }
 
+    // data arrived in time, disarm the idle timer
+    idle_timer.expires_at(boost::posix_time::pos_infin);
+
+    handle_data(incoming_data_buffer.data(), incoming_data_buffer.data() + bytes_transferred);
+}
+
+void Connection::send_reply(http::compression_type compression_type)
+{
+    if (keep_alive)
+    {
+        current_reply.headers.emplace_back("Connection", "keep-alive");
+        std::string keep_alive_parameters = "timeout=" + std::to_string(keepalive_timeout);
+        if (keepalive_max_requests > 0)
+        {
+            keep_alive_parameters +=
+                ", max=" + std::to_string(keepalive_max_requests - processed_requests);
+        }
+        current_reply.headers.emplace_back("Keep-Alive", keep_alive_parameters);
+    }
+    else
+    {
+        current_reply.headers.emplace_back("Connection", "close");
+    }
+
+    if (current_reply.content.size() < compression_threshold)
+    {
+        compression_type = http::no_compression;
+    }
+
+    // compress the result w/ gzip/deflate if requested
+    switch (compression_type)
+    {
+    case http::deflate_rfc1951:
+        // use deflate for compression
+        current_reply.headers.insert(current_reply.headers.begin(),
+                                     {"Content-Encoding", "deflate"});
+        break;
+    case http::gzip_rfc1952:
+        // use gzip for compression
+        current_reply.headers.insert(current_reply.headers.begin(),
+                                     {"Content-Encoding", "gzip"});
+        break;
+    case http::no_compression:
+        // don't use any compression
+        current_reply.set_uncompressed_size();
+        output_buffer = current_reply.to_buffers();
+        break;
+    }
+
+    if (compression_type != http::no_compression)
+    {
+        compressor.Reset(compression_type);
+        compressed_content_end = 0;
+        if (current_request.accepts_chunked)
+        {
+            // only the first chunk is compressed up front, the rest follows as it is written
+            current_reply.set_chunked();
+            sending_chunks = true;
+            compress_next_chunk();
+        }
+        else
+        {
+            // HTTP/1.0 clients need to know the size of the body in advance
+            compressed_output.clear();
+            compressor.Compress(current_reply.content.data(),
+                                current_reply.content.data() + current_reply.content.size(),
+                                true, compressed_output);
+            current_reply.set_size(compressed_output.size());
+        }
+        output_buffer = current_reply.headers_to_buffers();
+        output_buffer.push_back(boost::asio::buffer(compressed_output));
+    }
+
+    // may be called from a query worker, so start the write from within the strand
+    strand.post(boost::bind(&Connection::write_reply, this->shared_from_this()));
+}
+
+void Connection::write_reply()
+{
+    // write result to stream
+    boost::asio::async_write(
+        TCP_socket, output_buffer,
+        strand.wrap(boost::bind(&Connection::handle_write, this->shared_from_this(),
+                                boost::asio::placeholders::error)));
+}
+
+void Connection::compress_next_chunk()
+{
+    const auto &content = current_reply.content;
+    const auto content_end = content.data() + content.size();
+    const auto chunk_end = compressor.CompressChunk(content.data() + compressed_content_end,
+                                                    content_end, compressed_output);
+    compressed_content_end = chunk_end - content.data();
+    sending_chunks = chunk_end != content_end;
+}
+
+void Connection::handle_data(char *begin, char *end)
+{
     // no error detected, let's parse the request
     http::compression_type compression_type(http::no_compression);
     RequestParser::RequestStatus result;
-    std::tie(result, compression_type) =
-        request_parser.parse(current_request, incoming_data_buffer.data(),
-                             incoming_data_buffer.data() + bytes_transferred);
+    char *parsed_end;
+    std::tie(result, compression_type, parsed_end) =
+        request_parser.parse(current_request, begin, end);
+
+    // remember what belongs to the next pipelined request
+    pending_data_begin = parsed_end - incoming_data_buffer.data();
+    pending_data_end = end - incoming_data_buffer.data();
 
     // the request has been parsed
     if (result == RequestParser::RequestStatus::valid)
     {
+        ++processed_requests;
+        // a request cap of 0 means the connection may serve any number of requests
+        keep_alive = keepalive_timeout > 0 && current_request.keep_alive &&
+                     (keepalive_max_requests == 0 || processed_requests < keepalive_max_requests);
+
         current_request.endpoint = TCP_socket.remote_endpoint().address();
-        request_handler.handle_request(current_request, current_reply);
+        current_request.received = std::chrono::steady_clock::now();
 
-        // compress the result w/ gzip/deflate if requested
-        switch (compression_type)
+        if (current_request.uri == QUEUE_STATUS_URI)
         {
-        case http::deflate_rfc1951:
-            // use deflate for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "deflate"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::gzip_rfc1952:
-            // use gzip for compression
-            current_reply.headers.insert(current_reply.headers.begin(),
-                                         {"Content-Encoding", "gzip"});
-            compressed_output = compress_buffers(current_reply.content, compression_type);
-            current_reply.set_size(static_cast<unsigned>(compressed_output.size()));
-            output_buffer = current_reply.headers_to_buffers();
-            output_buffer.push_back(boost::asio::buffer(compressed_output));
-            break;
-        case http::no_compression:
-            // don't use any compression
-            current_reply.set_uncompressed_size();
-            output_buffer = current_reply.to_buffers();
-            break;
+            request_handler.handle_queue_status(query_queue, current_reply);
+            send_reply(compression_type);
+            return;
+        }
+        if (current_request.uri == METRICS_URI)
+        {
+            request_handler.handle_metrics(query_queue, current_reply);
+            send_reply(compression_type);
+            return;
+        }
+
+        // the query itself runs on the worker pool, the reply is written back on our strand
+        auto self = this->shared_from_this();
+        const auto service = RequestHandler::get_service_name(current_request.uri);
+        const auto admission = query_queue.Submit(service, [self, compression_type]
+                                                  {
+                                                      self->run_query(compression_type);
+                                                  });
+        if (admission != QueryQueue::Admission::accepted)
+        {
+            // overloaded, shed the request and drop the connection
+            keep_alive = false;
+            current_reply = http::reply::stock_reply(http::reply::service_unavailable);
+            current_reply.headers.emplace_back("Retry-After", "1");
+            send_reply(http::no_compression);
         }
-        // write result to stream
-        boost::asio::async_write(
-            TCP_socket, output_buffer,
-            strand.wrap(boost::bind(&Connection::handle_write, this->shared_from_this(),
-                                    boost::asio::placeholders::error)));
     }
     else if (result == RequestParser::RequestStatus::invalid)
     { // request is not parseable
+        keep_alive = false;
         current_reply = http::reply::stock_reply(http::reply::bad_request);
+        current_reply.headers.emplace_back("Connection", "close");
 
         boost::asio::async_write(
             TCP_socket, current_reply.to_buffers(),
@@ -97,47 +234,82 @@ void Connection::handle_read(const boost::system::error_code &error, std::size_t
     else
     {
         // we don't have a result yet, so continue reading
-        TCP_socket.async_read_some(
-            boost::asio::buffer(incoming_data_buffer),
-            strand.wrap(boost::bind(&Connection::handle_read, this->shared_from_this(),
-                                    boost::asio::placeholders::error,
-                                    boost::asio::placeholders::bytes_transferred)));
+        read_more();
+    }
+}
+
+void Connection::run_query(const http::compression_type compression_type)
+{
+    try
+    {
+        request_handler.handle_request(current_request, current_reply);
+        send_reply(compression_type);
+    }
+    catch (...)
+    {
+        // the client still gets an answer, the query queue logs what went wrong
+        current_reply = http::reply::stock_reply(http::reply::internal_server_error);
+        send_reply(http::no_compression);
+        throw;
     }
 }
 
 /// Handle completion of a write operation.
 void Connection::handle_write(const boost::system::error_code &error)
 {
-    if (!error)
+    if (error)
+    {
+        return;
+    }
+
+    if (sending_chunks)
+    {
+        // the previous chunk is out, compress and write the next one
+        compress_next_chunk();
+        output_buffer.clear();
+        output_buffer.push_back(boost::asio::buffer(compressed_output));
+        write_reply();
+        return;
+    }
+
+    if (!keep_alive)
     {
         // Initiate graceful connection closure.
         boost::system::error_code ignore_error;
         TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        return;
     }
-}
 
-std::vector<char> Connection::compress_buffers(const std::vector<char> &uncompressed_data,
-                                               const http::compression_type compression_type)
-{
-    boost::iostreams::gzip_params compression_parameters;
+    // get ready for the next request on this connection
+    request_parser.reset();
+    current_request = http::request();
+    current_reply = http::reply();
+    compressed_output.clear();
+    output_buffer.clear();
 
-    // there's a trade-off between speed and size. speed wins
-    compression_parameters.level = boost::iostreams::zlib::best_speed;
-    // check which compression flavor is used
-    if (http::deflate_rfc1951 == compression_type)
+    if (pending_data_begin < pending_data_end)
     {
-        compression_parameters.noheader = true;
+        // a pipelined request is already (partially) buffered
+        handle_data(incoming_data_buffer.data() + pending_data_begin,
+                    incoming_data_buffer.data() + pending_data_end);
     }
+    else
+    {
+        read_more();
+    }
+}
 
-    std::vector<char> compressed_data;
-    // plug data into boost's compression stream
-    boost::iostreams::filtering_ostream gzip_stream;
-    gzip_stream.push(boost::iostreams::gzip_compressor(compression_parameters));
-    gzip_stream.push(boost::iostreams::back_inserter(compressed_data));
-    gzip_stream.write(&uncompressed_data[0], uncompressed_data.size());
-    boost::iostreams::close(gzip_stream);
-
-    return compressed_data;
+void Connection::handle_timeout(const boost::system::error_code &error)
+{
+    // the timer is re-armed or disarmed whenever data arrives, so only close the connection if
+    // it really expired
+    if (error != boost::asio::error::operation_aborted &&
+        idle_timer.expires_at() <= boost::asio::deadline_timer::traits_type::now())
+    {
+        boost::system::error_code ignore_error;
+        TCP_socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ignore_error);
+        TCP_socket.close(ignore_error);
+    }
 }
 }
 }
@@ -1,5 +1,6 @@
 #include "server/http/reply.hpp"
 
+#include <algorithm>
 #include <string>
 
 namespace osrm
@@ -13,11 +14,14 @@ const char ok_html[] = "";
 const char bad_request_html[] = "{\"status\": 400,\"status_message\":\"Bad Request\"}";
 const char internal_server_error_html[] =
     "{\"status\": 500,\"status_message\":\"Internal Server Error\"}";
+const char service_unavailable_html[] =
+    "{\"status\": 503,\"status_message\":\"Service Unavailable\"}";
 const char seperators[] = {':', ' '};
 const char crlf[] = {'\r', '\n'};
-const std::string http_ok_string = "HTTP/1.0 200 OK\r\n";
-const std::string http_bad_request_string = "HTTP/1.0 400 Bad Request\r\n";
-const std::string http_internal_server_error_string = "HTTP/1.0 500 Internal Server Error\r\n";
+const std::string http_ok_string = "HTTP/1.1 200 OK\r\n";
+const std::string http_bad_request_string = "HTTP/1.1 400 Bad Request\r\n";
+const std::string http_internal_server_error_string = "HTTP/1.1 500 Internal Server Error\r\n";
+const std::string http_service_unavailable_string = "HTTP/1.1 503 Service Unavailable\r\n";
 
 void reply::set_size(const std::size_t size)
 {
@@ -32,6 +36,16 @@ void reply::set_size(const std::size_t size)
 
 void reply::set_uncompressed_size() { set_size(content.size()); }
 
+void reply::set_chunked()
+{
+    headers.erase(std::remove_if(headers.begin(), headers.end(), [](const header &h)
+                                 {
+                                     return "Content-Length" == h.name;
+                                 }),
+                  headers.end());
+    headers.emplace_back("Transfer-Encoding", "chunked");
+}
+
 std::vector<boost::asio::const_buffer> reply::to_buffers()
 {
     std::vector<boost::asio::const_buffer> buffers;
@@ -87,6 +101,10 @@ std::string reply::status_to_string(const reply::status_type status)
     {
         return bad_request_html;
     }
+    if (reply::service_unavailable == status)
+    {
+        return service_unavailable_html;
+    }
     return internal_server_error_html;
 }
 
@@ -100,14 +118,15 @@ boost::asio::const_buffer reply::status_to_buffer(const reply::status_type statu
     {
         return boost::asio::buffer(http_internal_server_error_string);
     }
+    if (reply::service_unavailable == status)
+    {
+        return boost::asio::buffer(http_service_unavailable_string);
+    }
     return boost::asio::buffer(http_bad_request_string);
 }
 
-reply::reply() : status(ok)
-{
-    // We do not currently support keep alive. Always set 'Connection: close'.
-    headers.emplace_back("Connection", "close");
-}
+// The 'Connection' header is added by the connection once it knows whether it stays open.
+reply::reply() : status(ok) {}
 }
 }
 }
@@ -0,0 +1,183 @@
+#include "server/query_queue.hpp"
+
+#include "util/simple_logger.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// service names come from the request uri, bound the number of distinct counters
+const constexpr std::size_t MAX_TRACKED_SERVICES = 32;
+// weight of the most recent sample in the moving average of the service time
+const constexpr double SERVICE_TIME_SMOOTHING = 0.1;
+}
+
+QueryQueue::QueryQueue(const unsigned num_workers,
+                       const std::size_t max_queue_size,
+                       const std::chrono::milliseconds max_queue_wait)
+    : max_queue_size(max_queue_size), max_queue_wait(max_queue_wait),
+      average_service_time_ms(0.), stopped(false)
+{
+    BOOST_ASSERT(num_workers > 0);
+    workers.reserve(num_workers);
+    for (unsigned i = 0; i < num_workers; ++i)
+    {
+        workers.emplace_back(&QueryQueue::Work, this);
+    }
+}
+
+QueryQueue::~QueryQueue() { Stop(); }
+
+QueryQueue::Admission QueryQueue::Submit(const std::string &service, Task task)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    auto &statistics = GetServiceStatistics(service);
+
+    if (stopped || queue.size() >= max_queue_size)
+    {
+        ++statistics.rejected;
+        return Admission::queue_full;
+    }
+    if (max_queue_wait.count() > 0 && EstimateQueueWaitMs() > max_queue_wait.count())
+    {
+        ++statistics.rejected;
+        return Admission::wait_budget_exceeded;
+    }
+
+    ++statistics.accepted;
+    ++statistics.queue_depth;
+    queue.push_back({std::move(task), &statistics, Clock::now()});
+    lock.unlock();
+
+    queue_not_empty.notify_one();
+    return Admission::accepted;
+}
+
+void QueryQueue::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopped)
+        {
+            return;
+        }
+        stopped = true;
+        for (const auto &queued_task : queue)
+        {
+            --queued_task.statistics->queue_depth;
+        }
+        queue.clear();
+    }
+    queue_not_empty.notify_all();
+
+    for (auto &worker : workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+std::map<std::string, QueryQueue::ServiceStatistics> QueryQueue::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return service_statistics;
+}
+
+std::size_t QueryQueue::GetQueueDepth() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return queue.size();
+}
+
+std::chrono::milliseconds QueryQueue::EstimateQueueWait() const
+{
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(
+        EstimateQueueWaitMs()));
+}
+
+void QueryQueue::Work()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    while (true)
+    {
+        queue_not_empty.wait(lock, [this]
+                             {
+                                 return stopped || !queue.empty();
+                             });
+        if (stopped)
+        {
+            return;
+        }
+
+        QueuedTask queued_task = std::move(queue.front());
+        queue.pop_front();
+
+        const auto dequeued = Clock::now();
+        const double wait_ms =
+            std::chrono::duration<double, std::milli>(dequeued - queued_task.enqueued).count();
+        auto &statistics = *queued_task.statistics;
+        --statistics.queue_depth;
+        statistics.total_wait_ms += wait_ms;
+        statistics.max_wait_ms = std::max(statistics.max_wait_ms, wait_ms);
+        lock.unlock();
+
+        try
+        {
+            queued_task.task();
+        }
+        catch (const std::exception &e)
+        {
+            util::SimpleLogger().Write(logWARNING) << "[query queue] task failed: " << e.what();
+        }
+        catch (...)
+        {
+            // nothing may escape, it would terminate the server
+            util::SimpleLogger().Write(logWARNING) << "[query queue] task failed";
+        }
+
+        const double service_time_ms =
+            std::chrono::duration<double, std::milli>(Clock::now() - dequeued).count();
+
+        lock.lock();
+        ++statistics.processed;
+        average_service_time_ms += SERVICE_TIME_SMOOTHING *
+                                   (service_time_ms - average_service_time_ms);
+    }
+}
+
+// needs to be called with the queue mutex held
+QueryQueue::ServiceStatistics &QueryQueue::GetServiceStatistics(const std::string &service)
+{
+    auto iter = service_statistics.find(service);
+    if (iter != service_statistics.end())
+    {
+        return iter->second;
+    }
+    if (service_statistics.size() >= MAX_TRACKED_SERVICES)
+    {
+        return service_statistics["other"];
+    }
+    return service_statistics[service];
+}
+
+// needs to be called with the queue mutex held
+double QueryQueue::EstimateQueueWaitMs() const
+{
+    // the tasks in front of a new one are spread over all workers
+    return average_service_time_ms * static_cast<double>(queue.size()) /
+           static_cast<double>(workers.size());
+}
+}
+}
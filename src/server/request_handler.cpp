@@ -3,12 +3,17 @@
 #include "server/api_grammar.hpp"
 #include "server/http/reply.hpp"
 #include "server/http/request.hpp"
+#include "server/query_queue.hpp"
 
+#include "util/integer_range.hpp"
 #include "util/json_renderer.hpp"
 #include "util/simple_logger.hpp"
 #include "util/string_util.hpp"
 #include "util/typedefs.hpp"
 
+#include "engine/engine_statistics.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/response_cache.hpp"
 #include "engine/route_parameters.hpp"
 #include "util/json_container.hpp"
 #include "osrm/osrm.hpp"
@@ -17,21 +22,152 @@
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 
-#include <ctime>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
 namespace server
 {
 
-RequestHandler::RequestHandler() : routing_machine(nullptr) {}
+namespace
+{
+const constexpr std::size_t MAX_SERVICE_NAME_LENGTH = 32;
+
+// service names come straight from the uri, keep them from breaking the metrics format
+std::string EscapeLabelValue(const std::string &value)
+{
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (const char character : value)
+    {
+        if (character == '\\' || character == '"')
+        {
+            escaped.push_back('\\');
+            escaped.push_back(character);
+        }
+        else if (character == '\n')
+        {
+            escaped.append("\\n");
+        }
+        else
+        {
+            escaped.push_back(character);
+        }
+    }
+    return escaped;
+}
+
+// tiles and output=pbf replies are protobuf encoded
+bool IsBinaryOutput(const engine::RouteParameters &route_parameters)
+{
+    return route_parameters.service == "tile" || route_parameters.output_format == "pbf";
+}
+
+std::string GetContentType(const engine::RouteParameters &route_parameters)
+{
+    if (IsBinaryOutput(route_parameters))
+    {
+        return "application/x-protobuf";
+    }
+    if (route_parameters.jsonp_parameter.empty())
+    {
+        return "application/json; charset=UTF-8";
+    }
+    return "text/javascript; charset=UTF-8";
+}
+
+const constexpr char BATCH_SERVICE[] = "/batch";
+
+bool IsBatchRequest(const std::string &uri)
+{
+    const auto length = sizeof(BATCH_SERVICE) - 1;
+    return uri.compare(0, length, BATCH_SERVICE) == 0 &&
+           (uri.size() == length || uri[length] == '?');
+}
+
+// Splits the still percent-encoded 'q=' values off a batch request, so that the separators
+// inside the sub-queries survive
+std::vector<std::string> GetBatchQueries(const std::string &uri)
+{
+    std::vector<std::string> queries;
+    const auto query_begin = uri.find('?');
+    if (query_begin == std::string::npos)
+    {
+        return queries;
+    }
+
+    auto parameter_begin = uri.begin() + query_begin + 1;
+    while (parameter_begin < uri.end())
+    {
+        const auto parameter_end = std::find(parameter_begin, uri.end(), '&');
+        if (std::distance(parameter_begin, parameter_end) >= 2 && *parameter_begin == 'q' &&
+            *(parameter_begin + 1) == '=')
+        {
+            queries.emplace_back(parameter_begin + 2, parameter_end);
+        }
+        parameter_begin = parameter_end == uri.end() ? parameter_end : parameter_end + 1;
+    }
+    return queries;
+}
+
+void RenderError(const int status, const std::string &message, std::vector<char> &output)
+{
+    util::json::Object json_result;
+    json_result.values["status"] = status;
+    json_result.values["status_message"] = message;
+    util::json::render(output, json_result);
+}
+}
+
+RequestHandler::RequestHandler(const std::chrono::milliseconds max_query_time,
+                               const std::size_t max_batch_size)
+    : routing_machine(nullptr), max_query_time(max_query_time), max_batch_size(max_batch_size)
+{
+}
+
+std::chrono::milliseconds
+RequestHandler::get_query_timeout(const http::request &current_request) const
+{
+    // the client may ask for a tighter time budget than the configured one
+    auto timeout = max_query_time;
+    if (current_request.timeout.count() > 0 &&
+        (timeout.count() == 0 || current_request.timeout < timeout))
+    {
+        timeout = current_request.timeout;
+    }
+    return timeout;
+}
+
+std::string RequestHandler::get_service_name(const std::string &uri)
+{
+    const auto begin = uri.empty() || uri.front() != '/' ? uri.begin() : uri.begin() + 1;
+    const auto end = std::find_if(begin, uri.end(), [](const char character)
+                                  {
+                                      return character == '?' || character == '/';
+                                  });
+    return std::string(begin, begin + std::min<std::size_t>(std::distance(begin, end),
+                                                             MAX_SERVICE_NAME_LENGTH));
+}
 
 void RequestHandler::handle_request(const http::request &current_request,
                                     http::reply &current_reply)
+{
+    dispatch_request(current_request, current_reply);
+    // measured from the arrival of the request, so the time spent queued is included
+    request_metrics.Record(get_service_name(current_request.uri), current_reply.status,
+                           std::chrono::steady_clock::now() - current_request.received);
+}
+
+void RequestHandler::dispatch_request(const http::request &current_request,
+                                      http::reply &current_reply)
 {
     util::json::Object json_result;
 
@@ -41,34 +177,18 @@ void RequestHandler::handle_request(const http::request &current_request,
         std::string request_string;
         util::URIDecode(current_request.uri, request_string);
 
-        // deactivated as GCC apparently does not implement that, not even in 4.9
-        // std::time_t t = std::time(nullptr);
-        // util::SimpleLogger().Write() << std::put_time(std::localtime(&t), "%m-%d-%Y %H:%M:%S") <<
-        //     " " << current_request.endpoint.to_string() << " " <<
-        //     current_request.referrer << ( 0 == current_request.referrer.length() ? "- " :" ") <<
-        //     current_request.agent << ( 0 == current_request.agent.length() ? "- " :" ") <<
-        //     request;
-
-        time_t ltime;
-        struct tm *time_stamp;
-
-        ltime = time(nullptr);
-        time_stamp = localtime(&ltime);
-
-        // log timestamp
-        util::SimpleLogger().Write()
-            << (time_stamp->tm_mday < 10 ? "0" : "") << time_stamp->tm_mday << "-"
-            << (time_stamp->tm_mon + 1 < 10 ? "0" : "") << (time_stamp->tm_mon + 1) << "-"
-            << 1900 + time_stamp->tm_year << " " << (time_stamp->tm_hour < 10 ? "0" : "")
-            << time_stamp->tm_hour << ":" << (time_stamp->tm_min < 10 ? "0" : "")
-            << time_stamp->tm_min << ":" << (time_stamp->tm_sec < 10 ? "0" : "")
-            << time_stamp->tm_sec << " " << current_request.endpoint.to_string() << " "
-            << current_request.referrer << (0 == current_request.referrer.length() ? "- " : " ")
-            << current_request.agent << (0 == current_request.agent.length() ? "- " : " ")
-            << request_string;
+        access_log.Log(current_request, request_string);
+
+        if (IsBatchRequest(current_request.uri))
+        {
+            handle_batch_request(current_request, current_reply);
+            return;
+        }
 
         engine::RouteParameters route_parameters;
         APIGrammarParser api_parser(&route_parameters);
+        engine::ResponseCacheTicket cache_ticket;
+        std::shared_ptr<const engine::CachedResponse> cached_response;
 
         auto api_iterator = request_string.begin();
         const bool result =
@@ -80,6 +200,10 @@ void RequestHandler::handle_request(const http::request &current_request,
             // parsing done, lets call the right plugin to handle the request
             BOOST_ASSERT_MSG(routing_machine != nullptr, "pointer not init'ed");
 
+            if (IsBinaryOutput(route_parameters))
+            { // binary replies can not be wrapped into a callback
+                route_parameters.jsonp_parameter.clear();
+            }
             if (!route_parameters.jsonp_parameter.empty())
             { // prepend response with jsonp parameter
                 const std::string json_p = (route_parameters.jsonp_parameter + "(");
@@ -87,15 +211,34 @@ void RequestHandler::handle_request(const http::request &current_request,
                                              json_p.end());
             }
 
-            const int return_code = routing_machine->RunQuery(route_parameters, json_result);
+            const auto timeout = get_query_timeout(current_request);
+            if (timeout.count() > 0)
+            {
+                route_parameters.SetDeadline(current_request.received + timeout);
+            }
+
+            const int return_code = routing_machine->RunQuery(route_parameters, json_result,
+                                                              cache_ticket, cached_response);
             json_result.values["status"] = return_code;
+            if (cached_response)
+            {
+                // identical request on the same data, the rendered reply can be sent right away
+                current_reply.content = cached_response->content;
+            }
             // 4xx bad request return code
-            if (return_code / 100 == 4)
+            else if (return_code / 100 == 4)
             {
                 current_reply.status = http::reply::bad_request;
                 current_reply.content.clear();
                 route_parameters.output_format.clear();
             }
+            // 5xx the query was aborted, e.g. because its deadline expired
+            else if (return_code / 100 == 5)
+            {
+                current_reply.status = http::reply::service_unavailable;
+                current_reply.content.clear();
+                route_parameters.output_format.clear();
+            }
             else
             {
                 // 2xx valid request
@@ -107,6 +250,7 @@ void RequestHandler::handle_request(const http::request &current_request,
             const auto position = std::distance(request_string.begin(), api_iterator);
 
             current_reply.status = http::reply::bad_request;
+            route_parameters.output_format.clear();
             json_result.values["status"] = http::reply::bad_request;
             json_result.values["status_message"] =
                 "Query string malformed close to position " + std::to_string(position);
@@ -117,34 +261,54 @@ void RequestHandler::handle_request(const http::request &current_request,
         current_reply.headers.emplace_back("Access-Control-Allow-Headers",
                                            "X-Requested-With, Content-Type");
 
-        if (route_parameters.service == "tile")
+        if (cached_response)
+        {
+            current_reply.headers.emplace_back("Content-Type",
+                                               GetContentType(route_parameters));
+            if (!IsBinaryOutput(route_parameters))
+            {
+                current_reply.headers.emplace_back("Content-Disposition",
+                                                   route_parameters.jsonp_parameter.empty()
+                                                       ? "inline; filename=\"response.json\""
+                                                       : "inline; filename=\"response.js\"");
+            }
+        }
+        else if (IsBinaryOutput(route_parameters) && current_reply.status == http::reply::ok)
         {
             std::copy(json_result.values["pbf"].get<osrm::util::json::Buffer>().value.cbegin(),
                       json_result.values["pbf"].get<osrm::util::json::Buffer>().value.cend(),
                       std::back_inserter(current_reply.content));
 
-            current_reply.headers.emplace_back("Content-Type", "application/x-protobuf");
+            current_reply.headers.emplace_back("Content-Type", GetContentType(route_parameters));
         }
         else if (route_parameters.jsonp_parameter.empty())
         { // json file
             util::json::render(current_reply.content, json_result);
-            current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+            current_reply.headers.emplace_back("Content-Type", GetContentType(route_parameters));
             current_reply.headers.emplace_back("Content-Disposition",
                                                "inline; filename=\"response.json\"");
         }
         else
         { // jsonp
             util::json::render(current_reply.content, json_result);
-            current_reply.headers.emplace_back("Content-Type", "text/javascript; charset=UTF-8");
+            current_reply.headers.emplace_back("Content-Type", GetContentType(route_parameters));
             current_reply.headers.emplace_back("Content-Disposition",
                                                "inline; filename=\"response.js\"");
         }
         current_reply.headers.emplace_back("Content-Length",
                                            std::to_string(current_reply.content.size()));
-        if (!route_parameters.jsonp_parameter.empty())
+        if (!cached_response && !route_parameters.jsonp_parameter.empty())
         { // append brace to jsonp response
             current_reply.content.push_back(')');
         }
+
+        // only successful replies are worth keeping, errors are cheap to recompute
+        if (!cached_response && !cache_ticket.key.empty() &&
+            current_reply.status == http::reply::ok)
+        {
+            routing_machine->StoreResponse(
+                cache_ticket, engine::CachedResponse{http::reply::ok, current_reply.content});
+        }
     }
     catch (const std::exception &e)
     {
@@ -154,6 +318,254 @@ void RequestHandler::handle_request(const http::request &current_request,
     }
 }
 
+void RequestHandler::handle_batch_request(const http::request &current_request,
+                                          http::reply &current_reply)
+{
+    const auto queries = GetBatchQueries(current_request.uri);
+
+    current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
+    current_reply.headers.emplace_back("Access-Control-Allow-Methods", "GET, POST");
+    current_reply.headers.emplace_back("Access-Control-Allow-Headers",
+                                       "X-Requested-With, Content-Type");
+    current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+
+    if (queries.empty() || queries.size() > max_batch_size)
+    {
+        current_reply.status = http::reply::bad_request;
+        RenderError(http::reply::bad_request,
+                    queries.empty() ? "No queries in batch"
+                                    : "Too many queries in batch, at most " +
+                                          std::to_string(max_batch_size) + " are supported",
+                    current_reply.content);
+        current_reply.headers.emplace_back("Content-Length",
+                                           std::to_string(current_reply.content.size()));
+        return;
+    }
+
+    // all sub-queries share one time budget and are abandoned together
+    std::shared_ptr<engine::QueryDeadline> deadline;
+    const auto timeout = get_query_timeout(current_request);
+    if (timeout.count() > 0)
+    {
+        deadline = std::make_shared<engine::QueryDeadline>(current_request.received + timeout);
+    }
+
+    // every sub-query renders into its own buffer, they are only joined at the end
+    std::vector<std::vector<char>> results(queries.size());
+    tbb::parallel_for(tbb::blocked_range<std::size_t>(0, queries.size()),
+                      [&](const tbb::blocked_range<std::size_t> &range)
+                      {
+                          for (auto i = range.begin(); i != range.end(); ++i)
+                          {
+                              run_batch_query(queries[i], deadline, results[i]);
+                          }
+                      });
+
+    std::size_t content_size = 64;
+    for (const auto &result : results)
+    {
+        content_size += result.size() + 1;
+    }
+    current_reply.content.reserve(content_size);
+
+    const std::string header = "{\"status\":200,\"results\":[";
+    current_reply.content.insert(current_reply.content.end(), header.begin(), header.end());
+    for (const auto i : util::irange<std::size_t>(0, results.size()))
+    {
+        if (i > 0)
+        {
+            current_reply.content.push_back(',');
+        }
+        current_reply.content.insert(current_reply.content.end(), results[i].begin(),
+                                     results[i].end());
+    }
+    current_reply.content.push_back(']');
+    current_reply.content.push_back('}');
+
+    current_reply.headers.emplace_back("Content-Disposition",
+                                       "inline; filename=\"response.json\"");
+    current_reply.headers.emplace_back("Content-Length",
+                                       std::to_string(current_reply.content.size()));
+}
+
+void RequestHandler::run_batch_query(const std::string &encoded_query,
+                                     const std::shared_ptr<engine::QueryDeadline> &deadline,
+                                     std::vector<char> &output)
+{
+    try
+    {
+        std::string query;
+        util::URIDecode(encoded_query, query);
+        if (query.empty() || query.front() != '/')
+        {
+            query.insert(query.begin(), '/');
+        }
+
+        engine::RouteParameters route_parameters;
+        APIGrammarParser api_parser(&route_parameters);
+        auto api_iterator = query.begin();
+        const bool result = boost::spirit::qi::parse(api_iterator, query.end(), api_parser);
+        if (!result || api_iterator != query.end())
+        {
+            const auto position = std::distance(query.begin(), api_iterator);
+            RenderError(http::reply::bad_request,
+                        "Query string malformed close to position " + std::to_string(position),
+                        output);
+            return;
+        }
+        if (route_parameters.service != "viaroute" && route_parameters.service != "nearest")
+        {
+            RenderError(http::reply::bad_request,
+                        "Service " + route_parameters.service + " is not supported in batches",
+                        output);
+            return;
+        }
+        // the results are embedded into the batch reply and can not be wrapped individually
+        route_parameters.jsonp_parameter.clear();
+        route_parameters.output_format.clear();
+        route_parameters.deadline = deadline;
+
+        engine::ResponseCacheTicket cache_ticket;
+        std::shared_ptr<const engine::CachedResponse> cached_response;
+        util::json::Object json_result;
+        const int return_code = routing_machine->RunQuery(route_parameters, json_result,
+                                                          cache_ticket, cached_response);
+        if (cached_response)
+        {
+            output = cached_response->content;
+            return;
+        }
+        json_result.values["status"] = return_code;
+        util::json::render(output, json_result);
+
+        if (!cache_ticket.key.empty() && return_code / 100 == 2)
+        {
+            routing_machine->StoreResponse(cache_ticket,
+                                           engine::CachedResponse{http::reply::ok, output});
+        }
+    }
+    catch (const std::exception &e)
+    {
+        // one failing sub-query must not take the whole batch down
+        output.clear();
+        RenderError(http::reply::internal_server_error, "Internal server error", output);
+        util::SimpleLogger().Write(logWARNING) << "[server error] code: " << e.what()
+                                               << ", batch query: " << encoded_query;
+    }
+}
+
+void RequestHandler::handle_queue_status(const QueryQueue &query_queue,
+                                         http::reply &current_reply)
+{
+    util::json::Object json_result;
+    json_result.values["status"] = http::reply::ok;
+    json_result.values["workers"] = query_queue.GetNumberOfWorkers();
+    json_result.values["queue_depth"] = query_queue.GetQueueDepth();
+    json_result.values["estimated_wait_ms"] = query_queue.EstimateQueueWait().count();
+
+    util::json::Object json_services;
+    for (const auto &service_statistics : query_queue.GetStatistics())
+    {
+        const auto &statistics = service_statistics.second;
+        util::json::Object json_service;
+        json_service.values["queue_depth"] = statistics.queue_depth;
+        json_service.values["accepted"] = statistics.accepted;
+        json_service.values["rejected"] = statistics.rejected;
+        json_service.values["processed"] = statistics.processed;
+        const auto dequeued = statistics.accepted - statistics.queue_depth;
+        json_service.values["average_wait_ms"] =
+            dequeued > 0 ? statistics.total_wait_ms / dequeued : 0.;
+        json_service.values["max_wait_ms"] = statistics.max_wait_ms;
+        json_services.values[service_statistics.first] = std::move(json_service);
+    }
+    json_result.values["services"] = std::move(json_services);
+
+    util::json::render(current_reply.content, json_result);
+    current_reply.headers.emplace_back("Access-Control-Allow-Origin", "*");
+    current_reply.headers.emplace_back("Content-Type", "application/json; charset=UTF-8");
+    current_reply.headers.emplace_back("Content-Length",
+                                       std::to_string(current_reply.content.size()));
+}
+
 void RequestHandler::RegisterRoutingMachine(OSRM *osrm) { routing_machine = osrm; }
+
+void RequestHandler::handle_metrics(const QueryQueue &query_queue, http::reply &current_reply)
+{
+    std::ostringstream metrics;
+    metrics.precision(12);
+
+    metrics << "# HELP osrm_requests_total Answered requests by service and status class.\n"
+            << "# TYPE osrm_requests_total counter\n";
+    auto service_metrics = request_metrics.Collect();
+    for (auto &service : service_metrics)
+    {
+        service.service = EscapeLabelValue(service.service);
+        metrics << "osrm_requests_total{service=\"" << service.service << "\",code=\"2xx\"} "
+                << service.replies_2xx << "\n";
+        metrics << "osrm_requests_total{service=\"" << service.service << "\",code=\"4xx\"} "
+                << service.replies_4xx << "\n";
+        metrics << "osrm_requests_total{service=\"" << service.service << "\",code=\"5xx\"} "
+                << service.replies_5xx << "\n";
+    }
+
+    metrics << "# HELP osrm_request_duration_seconds Time from receiving a request until its "
+               "reply was ready, including the time spent queued.\n"
+            << "# TYPE osrm_request_duration_seconds histogram\n";
+    for (const auto &service : service_metrics)
+    {
+        for (std::size_t bucket = 0; bucket < RequestMetrics::NUMBER_OF_LATENCY_BUCKETS; ++bucket)
+        {
+            metrics << "osrm_request_duration_seconds_bucket{service=\"" << service.service
+                    << "\",le=\"" << RequestMetrics::LATENCY_BUCKETS[bucket] << "\"} "
+                    << service.latency_buckets[bucket] << "\n";
+        }
+        metrics << "osrm_request_duration_seconds_bucket{service=\"" << service.service
+                << "\",le=\"+Inf\"} " << service.latency_buckets.back() << "\n";
+        metrics << "osrm_request_duration_seconds_sum{service=\"" << service.service << "\"} "
+                << service.latency_sum << "\n";
+        metrics << "osrm_request_duration_seconds_count{service=\"" << service.service << "\"} "
+                << service.latency_buckets.back() << "\n";
+    }
+
+    metrics << "# HELP osrm_rejected_requests_total Requests shed by the query queue.\n"
+            << "# TYPE osrm_rejected_requests_total counter\n";
+    for (const auto &service_statistics : query_queue.GetStatistics())
+    {
+        metrics << "osrm_rejected_requests_total{service=\""
+                << EscapeLabelValue(service_statistics.first)
+                << "\"} " << service_statistics.second.rejected << "\n";
+    }
+
+    metrics << "# HELP osrm_access_log_dropped_total Access log lines lost because the log "
+               "could not keep up.\n"
+            << "# TYPE osrm_access_log_dropped_total counter\n"
+            << "osrm_access_log_dropped_total " << access_log.GetDroppedRecords() << "\n";
+    metrics << "# HELP osrm_queue_depth Queries waiting for a worker.\n"
+            << "# TYPE osrm_queue_depth gauge\n"
+            << "osrm_queue_depth " << query_queue.GetQueueDepth() << "\n";
+    metrics << "# HELP osrm_query_workers Threads answering queries.\n"
+            << "# TYPE osrm_query_workers gauge\n"
+            << "osrm_query_workers " << query_queue.GetNumberOfWorkers() << "\n";
+
+    if (routing_machine != nullptr)
+    {
+        const auto engine_statistics = routing_machine->GetStatistics();
+        metrics << "# HELP osrm_concurrent_queries Queries currently running in the engine.\n"
+                << "# TYPE osrm_concurrent_queries gauge\n"
+                << "osrm_concurrent_queries " << engine_statistics.running_queries << "\n";
+        metrics << "# HELP osrm_heap_pops_total Nodes settled by all searches.\n"
+                << "# TYPE osrm_heap_pops_total counter\n"
+                << "osrm_heap_pops_total " << engine_statistics.heap_pops << "\n";
+        metrics << "# HELP osrm_edge_relaxations_total Edges relaxed by all searches.\n"
+                << "# TYPE osrm_edge_relaxations_total counter\n"
+                << "osrm_edge_relaxations_total " << engine_statistics.edge_relaxations << "\n";
+    }
+
+    const auto content = metrics.str();
+    current_reply.content.assign(content.begin(), content.end());
+    current_reply.headers.emplace_back("Content-Type", "text/plain; version=0.0.4");
+    current_reply.headers.emplace_back("Content-Length",
+                                       std::to_string(current_reply.content.size()));
+}
 }
 }
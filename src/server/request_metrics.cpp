@@ -0,0 +1,142 @@
+#include "server/request_metrics.hpp"
+
+#include <algorithm>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// the counters are owned by the registry, the thread local storage only points to them
+template <typename T> void no_cleanup(T *) {}
+
+// no other thread writes, so there is no need for an atomic read-modify-write
+void Add(std::atomic<std::uint64_t> &counter, const std::uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+const constexpr char OTHER_SERVICE[] = "other";
+}
+
+const std::array<double, RequestMetrics::NUMBER_OF_LATENCY_BUCKETS>
+    RequestMetrics::LATENCY_BUCKETS = {
+    {0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1., 2.5, 5., 10.}};
+const constexpr std::size_t RequestMetrics::NUMBER_OF_LATENCY_BUCKETS;
+const constexpr std::size_t RequestMetrics::MAX_TRACKED_SERVICES;
+
+RequestMetrics::RequestMetrics()
+    : number_of_services(0), thread_counters(&no_cleanup<ThreadCounters>)
+{
+    // all services beyond the tracked ones end up here
+    service_names[0] = OTHER_SERVICE;
+    number_of_services = 1;
+}
+
+void RequestMetrics::Record(const std::string &service,
+                            const int status,
+                            const std::chrono::steady_clock::duration latency)
+{
+    auto &counters = GetThreadCounters()[GetServiceIndex(service)];
+
+    const auto status_class = status / 100;
+    Add(counters.replies[status_class == 2 ? 0 : (status_class == 4 ? 1 : 2)], 1);
+
+    const auto latency_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    const double latency_s = latency_us / 1000000.;
+    const auto bucket = std::lower_bound(LATENCY_BUCKETS.begin(), LATENCY_BUCKETS.end(),
+                                         latency_s) -
+                        LATENCY_BUCKETS.begin();
+    Add(counters.latency_buckets[bucket], 1);
+    Add(counters.latency_sum_us, static_cast<std::uint64_t>(latency_us));
+}
+
+std::vector<RequestMetrics::ServiceMetrics> RequestMetrics::Collect() const
+{
+    std::vector<ServiceMetrics> metrics(number_of_services.load());
+    {
+        std::lock_guard<std::mutex> lock(services_mutex);
+        for (std::size_t i = 0; i < metrics.size(); ++i)
+        {
+            metrics[i].service = service_names[i];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (const auto &thread_counters : registry)
+    {
+        for (std::size_t i = 0; i < metrics.size(); ++i)
+        {
+            const auto &counters = (*thread_counters)[i];
+            metrics[i].replies_2xx += counters.replies[0].load(std::memory_order_relaxed);
+            metrics[i].replies_4xx += counters.replies[1].load(std::memory_order_relaxed);
+            metrics[i].replies_5xx += counters.replies[2].load(std::memory_order_relaxed);
+            for (std::size_t bucket = 0; bucket < counters.latency_buckets.size(); ++bucket)
+            {
+                metrics[i].latency_buckets[bucket] +=
+                    counters.latency_buckets[bucket].load(std::memory_order_relaxed);
+            }
+            metrics[i].latency_sum +=
+                counters.latency_sum_us.load(std::memory_order_relaxed) / 1000000.;
+        }
+    }
+
+    // turn the per bucket counts into cumulative ones
+    for (auto &service_metrics : metrics)
+    {
+        for (std::size_t bucket = 1; bucket < service_metrics.latency_buckets.size(); ++bucket)
+        {
+            service_metrics.latency_buckets[bucket] += service_metrics.latency_buckets[bucket - 1];
+        }
+    }
+    return metrics;
+}
+
+std::size_t RequestMetrics::GetServiceIndex(const std::string &service)
+{
+    // names are published before the count, so the known ones can be read without the lock
+    const auto known_services = number_of_services.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < known_services; ++i)
+    {
+        if (service_names[i] == service)
+        {
+            return i;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(services_mutex);
+    const auto current_services = number_of_services.load(std::memory_order_relaxed);
+    for (std::size_t i = known_services; i < current_services; ++i)
+    {
+        if (service_names[i] == service)
+        {
+            return i;
+        }
+    }
+    if (current_services == MAX_TRACKED_SERVICES)
+    {
+        return 0;
+    }
+    service_names[current_services] = service;
+    number_of_services.store(current_services + 1, std::memory_order_release);
+    return current_services;
+}
+
+RequestMetrics::ThreadCounters &RequestMetrics::GetThreadCounters()
+{
+    if (!thread_counters.get())
+    {
+        // value initialization zeroes all counters
+        std::unique_ptr<ThreadCounters> counters(new ThreadCounters());
+
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::move(counters));
+        thread_counters.reset(registry.back().get());
+    }
+    return *thread_counters;
+}
+}
+}
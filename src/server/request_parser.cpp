@@ -6,6 +6,7 @@
 
 #include <boost/algorithm/string/predicate.hpp>
 
+#include <algorithm>
 #include <string>
 
 namespace osrm
@@ -15,11 +16,24 @@ namespace server
 
 RequestParser::RequestParser()
     : state(internal_state::method_start), current_header({"", ""}),
-      selected_compression(http::no_compression), is_post_header(false), content_length(0)
+      selected_compression(http::no_compression), is_post_header(false), content_length(0),
+      http_version_major(0), http_version_minor(0), requested_connection(connection_option::none)
 {
 }
 
-std::tuple<RequestParser::RequestStatus, http::compression_type>
+void RequestParser::reset()
+{
+    state = internal_state::method_start;
+    current_header.clear();
+    selected_compression = http::no_compression;
+    is_post_header = false;
+    content_length = 0;
+    http_version_major = 0;
+    http_version_minor = 0;
+    requested_connection = connection_option::none;
+}
+
+std::tuple<RequestParser::RequestStatus, http::compression_type, char *>
 RequestParser::parse(http::request &current_request, char *begin, char *end)
 {
     while (begin != end)
@@ -27,16 +41,31 @@ RequestParser::parse(http::request &current_request, char *begin, char *end)
         RequestStatus result = consume(current_request, *begin++);
         if (result != RequestStatus::indeterminate)
         {
-            return std::make_tuple(result, selected_compression);
+            if (result == RequestStatus::valid)
+            {
+                current_request.keep_alive = is_keep_alive();
+                current_request.accepts_chunked =
+                    http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
+            }
+            return std::make_tuple(result, selected_compression, begin);
         }
     }
-    RequestStatus result = RequestStatus::indeterminate;
+    return std::make_tuple(RequestStatus::indeterminate, selected_compression, end);
+}
 
-    if (state == internal_state::post_request && content_length <= 0)
+bool RequestParser::is_keep_alive() const
+{
+    // HTTP/1.1 connections are persistent unless the client opts out, HTTP/1.0 ones are not
+    // unless the client opts in.
+    if (requested_connection == connection_option::close)
     {
-        result = RequestStatus::valid;
+        return false;
+    }
+    if (requested_connection == connection_option::keep_alive)
+    {
+        return true;
     }
-    return std::make_tuple(result, selected_compression);
+    return http_version_major > 1 || (http_version_major == 1 && http_version_minor >= 1);
 }
 
 RequestParser::RequestStatus RequestParser::consume(http::request &current_request, const char input)
@@ -80,7 +109,8 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::post_request:
         current_request.uri.push_back(input);
         --content_length;
-        return RequestStatus::indeterminate;
+        // stop exactly at the end of the body, anything after it belongs to the next request
+        return content_length <= 0 ? RequestStatus::valid : RequestStatus::indeterminate;
     case internal_state::method:
         if (input == ' ')
         {
@@ -150,6 +180,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::http_version_major_start:
         if (is_digit(input))
         {
+            http_version_major = input - '0';
             state = internal_state::http_version_major;
             return RequestStatus::indeterminate;
         }
@@ -162,12 +193,14 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_major = http_version_major * 10 + (input - '0');
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
     case internal_state::http_version_minor_start:
         if (is_digit(input))
         {
+            http_version_minor = input - '0';
             state = internal_state::http_version_minor;
             return RequestStatus::indeterminate;
         }
@@ -180,6 +213,7 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         }
         if (is_digit(input))
         {
+            http_version_minor = http_version_minor * 10 + (input - '0');
             return RequestStatus::indeterminate;
         }
         return RequestStatus::invalid;
@@ -213,6 +247,17 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
         {
             current_request.agent = current_header.value;
         }
+        if (boost::iequals(current_header.name, "Connection"))
+        {
+            if (boost::icontains(current_header.value, "close"))
+            {
+                requested_connection = connection_option::close;
+            }
+            else if (boost::icontains(current_header.value, "keep-alive"))
+            {
+                requested_connection = connection_option::keep_alive;
+            }
+        }
         if (boost::iequals(current_header.name, "Content-Length"))
         {
             try
@@ -224,6 +269,18 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
                 // Ignore the header if the parameter isn't an int
             }
         }
+        if (boost::iequals(current_header.name, "X-Request-Timeout"))
+        {
+            try
+            {
+                current_request.timeout = std::chrono::milliseconds(
+                    std::max(0, std::stoi(current_header.value)));
+            }
+            catch (const std::exception &e)
+            {
+                // Ignore the header if the parameter isn't an int
+            }
+        }
         if (boost::iequals(current_header.name, "Content-Type"))
         {
             if (!boost::icontains(current_header.value, "application/x-www-form-urlencoded"))
@@ -302,12 +359,9 @@ RequestParser::RequestStatus RequestParser::consume(http::request &current_reque
     case internal_state::expecting_newline_3:
         if (input == '\n')
         {
-            if (is_post_header)
+            if (is_post_header && content_length > 0)
             {
-                if (content_length > 0)
-                {
-                    current_request.uri.push_back('?');
-                }
+                current_request.uri.push_back('?');
                 state = internal_state::post_request;
                 return RequestStatus::indeterminate;
             }
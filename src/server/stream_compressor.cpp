@@ -0,0 +1,130 @@
+#include "server/stream_compressor.hpp"
+
+#include "util/exception.hpp"
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace osrm
+{
+namespace server
+{
+
+namespace
+{
+// the output grows in steps of this size while zlib fills it
+const constexpr std::size_t OUTPUT_STEP = 16 * 1024;
+// window of 2^15 bytes, adding 16 asks for a gzip header, a negative value for no header at all
+const constexpr int GZIP_WINDOW_BITS = 15 + 16;
+const constexpr int RAW_DEFLATE_WINDOW_BITS = -15;
+const constexpr int MEMORY_LEVEL = 8;
+// the chunk size is written as a fixed width hex number so the room for it can be reserved
+const constexpr std::size_t CHUNK_SIZE_DIGITS = 8;
+const constexpr char CHUNK_SIZE_FORMAT[] = "%08zx\r\n";
+const constexpr std::size_t CHUNK_HEADER_SIZE = CHUNK_SIZE_DIGITS + 2;
+const constexpr char CRLF[] = "\r\n";
+const constexpr char LAST_CHUNK[] = "0\r\n\r\n";
+}
+
+const constexpr std::size_t StreamCompressor::CHUNK_INPUT_SIZE;
+const constexpr std::size_t StreamCompressor::MIN_CHUNK_SIZE;
+
+StreamCompressor::StreamCompressor() : stream_type(http::no_compression)
+{
+    std::memset(&stream, 0, sizeof(stream));
+}
+
+StreamCompressor::~StreamCompressor()
+{
+    if (stream_type != http::no_compression)
+    {
+        deflateEnd(&stream);
+    }
+}
+
+void StreamCompressor::Reset(const http::compression_type compression_type)
+{
+    BOOST_ASSERT(compression_type != http::no_compression);
+    if (compression_type == stream_type)
+    {
+        // keeps the allocated state
+        deflateReset(&stream);
+        return;
+    }
+
+    if (stream_type != http::no_compression)
+    {
+        deflateEnd(&stream);
+        stream_type = http::no_compression;
+    }
+    std::memset(&stream, 0, sizeof(stream));
+    // there's a trade-off between speed and size. speed wins
+    if (Z_OK != deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED,
+                             compression_type == http::gzip_rfc1952 ? GZIP_WINDOW_BITS
+                                                                    : RAW_DEFLATE_WINDOW_BITS,
+                             MEMORY_LEVEL, Z_DEFAULT_STRATEGY))
+    {
+        throw util::exception("could not initialize zlib compression");
+    }
+    stream_type = compression_type;
+}
+
+void StreamCompressor::Compress(const char *begin,
+                                const char *end,
+                                const bool finish,
+                                std::vector<char> &output)
+{
+    BOOST_ASSERT(stream_type != http::no_compression);
+    // zlib does not modify the input, its interface just predates const
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(begin));
+    stream.avail_in = static_cast<uInt>(end - begin);
+
+    do
+    {
+        const auto offset = output.size();
+        output.resize(offset + OUTPUT_STEP);
+        stream.next_out = reinterpret_cast<Bytef *>(output.data() + offset);
+        stream.avail_out = static_cast<uInt>(OUTPUT_STEP);
+
+        const auto result = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        BOOST_ASSERT(result != Z_STREAM_ERROR);
+        static_cast<void>(result);
+
+        output.resize(offset + OUTPUT_STEP - stream.avail_out);
+        // a full output buffer means zlib has more to emit
+    } while (stream.avail_out == 0);
+    BOOST_ASSERT(stream.avail_in == 0);
+}
+const char *
+StreamCompressor::CompressChunk(const char *begin, const char *end, std::vector<char> &output)
+{
+    // the chunk size is filled in once it is known
+    output.resize(CHUNK_HEADER_SIZE);
+    // zlib holds back input until it has enough for a block, keep feeding it until there is
+    // something worth sending
+    bool finished;
+    do
+    {
+        const auto piece_end = begin + std::min<std::size_t>(end - begin, CHUNK_INPUT_SIZE);
+        finished = piece_end == end;
+        Compress(begin, piece_end, finished, output);
+        begin = piece_end;
+    } while (!finished && output.size() < CHUNK_HEADER_SIZE + MIN_CHUNK_SIZE);
+
+    // ending the stream always emits data, so a chunk is never empty
+    char chunk_header[CHUNK_HEADER_SIZE + 1];
+    std::snprintf(chunk_header, sizeof(chunk_header), CHUNK_SIZE_FORMAT,
+                  output.size() - CHUNK_HEADER_SIZE);
+    std::copy(chunk_header, chunk_header + CHUNK_HEADER_SIZE, output.begin());
+    output.insert(output.end(), CRLF, CRLF + sizeof(CRLF) - 1);
+    if (finished)
+    {
+        output.insert(output.end(), LAST_CHUNK, LAST_CHUNK + sizeof(LAST_CHUNK) - 1);
+    }
+    return begin;
+}
+}
+}
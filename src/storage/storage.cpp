@@ -1,10 +1,12 @@
 #include "extractor/original_edge_data.hpp"
 #include "util/range_table.hpp"
 #include "contractor/query_edge.hpp"
+#include "contractor/shortcut_unpacking.hpp"
 #include "extractor/query_node.hpp"
 #include "util/shared_memory_vector_wrapper.hpp"
 #include "util/static_graph.hpp"
 #include "util/static_rtree.hpp"
+#include "util/sweep_ranks.hpp"
 #include "engine/datafacade/datafacade_base.hpp"
 #include "extractor/travel_mode.hpp"
 #include "extractor/turn_instructions.hpp"
@@ -28,9 +30,11 @@
 
 #include <cstdint>
 
+#include <algorithm>
 #include <fstream>
 #include <new>
 #include <string>
+#include <vector>
 
 namespace osrm
 {
@@ -172,6 +176,18 @@ int Storage::Run()
     BOOST_ASSERT(paths.end() != paths_iterator);
     BOOST_ASSERT(!paths_iterator->second.empty());
     const boost::filesystem::path &core_marker_path = paths_iterator->second;
+    // optional, without node levels tables are always computed with bucket searches
+    paths_iterator = paths.find("levels");
+    const boost::filesystem::path level_path =
+        paths.end() != paths_iterator ? paths_iterator->second : boost::filesystem::path();
+    // optional, without landmarks the core is searched without goal direction
+    paths_iterator = paths.find("landmarks");
+    const boost::filesystem::path landmarks_path =
+        paths.end() != paths_iterator ? paths_iterator->second : boost::filesystem::path();
+    // optional, without it all shortcuts are unpacked by searching the graph
+    paths_iterator = paths.find("shortcuts");
+    const boost::filesystem::path shortcuts_path =
+        paths.end() != paths_iterator ? paths_iterator->second : boost::filesystem::path();
 
     // determine segment to use
     bool segment2_in_use = SharedMemory::RegionExists(LAYOUT_2);
@@ -307,6 +323,83 @@ int Storage::Run()
     core_marker_file.read((char *)&number_of_core_markers, sizeof(uint32_t));
     shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::CORE_MARKER,
                                               number_of_core_markers);
+    std::vector<char> unpacked_core_markers(number_of_core_markers);
+    core_marker_file.read((char *)unpacked_core_markers.data(),
+                          sizeof(char) * number_of_core_markers);
+    const auto number_of_core_nodes = static_cast<uint32_t>(
+        std::count(unpacked_core_markers.begin(), unpacked_core_markers.end(), 1));
+
+    // load core landmark sizes, they are only used if they fit the core
+    boost::filesystem::ifstream landmarks_file;
+    uint32_t number_of_landmarks = 0;
+    if (!landmarks_path.empty() && boost::filesystem::is_regular_file(landmarks_path))
+    {
+        landmarks_file.open(landmarks_path, std::ios::binary);
+        uint32_t number_of_landmark_core_nodes = 0;
+        landmarks_file.read((char *)&number_of_landmarks, sizeof(uint32_t));
+        landmarks_file.read((char *)&number_of_landmark_core_nodes, sizeof(uint32_t));
+        if (number_of_landmark_core_nodes != number_of_core_nodes)
+        {
+            if (number_of_landmarks > 0)
+            {
+                util::SimpleLogger().Write(logWARNING) << landmarks_path
+                                                       << " does not match the core";
+            }
+            number_of_landmarks = 0;
+        }
+    }
+    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::CORE_LANDMARK_COUNT, 1);
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::CORE_LANDMARK_INDEX,
+                                            number_of_landmarks > 0 ? number_of_core_markers : 0);
+    shared_layout_ptr->SetBlockSize<EdgeWeight>(SharedDataLayout::CORE_LANDMARK_DISTANCES,
+                                                2 * static_cast<uint64_t>(number_of_landmarks) *
+                                                    number_of_core_nodes);
+
+    // load sizes of the unpacked shortcuts, they are only used if they fit the search graph
+    boost::filesystem::ifstream shortcuts_file;
+    uint32_t number_of_shortcuts = 0;
+    uint32_t number_of_unpacked_edges = 0;
+    if (!shortcuts_path.empty() && boost::filesystem::is_regular_file(shortcuts_path))
+    {
+        shortcuts_file.open(shortcuts_path, std::ios::binary);
+        unsigned shortcuts_checksum = 0;
+        shortcuts_file.read((char *)&shortcuts_checksum, sizeof(unsigned));
+        shortcuts_file.read((char *)&number_of_shortcuts, sizeof(uint32_t));
+        shortcuts_file.read((char *)&number_of_unpacked_edges, sizeof(uint32_t));
+        if (number_of_shortcuts > 0 && shortcuts_checksum != checksum)
+        {
+            util::SimpleLogger().Write(logWARNING) << shortcuts_path
+                                                   << " does not match the search graph";
+            number_of_shortcuts = 0;
+            number_of_unpacked_edges = 0;
+        }
+    }
+    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::SHORTCUT_KEYS, number_of_shortcuts);
+    shared_layout_ptr->SetBlockSize<unsigned>(SharedDataLayout::SHORTCUT_OFFSETS,
+                                              number_of_shortcuts > 0 ? number_of_shortcuts + 1
+                                                                      : 0);
+    shared_layout_ptr->SetBlockSize<contractor::UnpackedShortcutEdge>(
+        SharedDataLayout::SHORTCUT_EDGES, number_of_unpacked_edges);
+
+    // load node levels, they are only used if they fit the search graph
+    std::vector<float> node_levels;
+    if (!level_path.empty() && boost::filesystem::is_regular_file(level_path))
+    {
+        boost::filesystem::ifstream level_file(level_path, std::ios::binary);
+        uint32_t number_of_levels = 0;
+        level_file.read((char *)&number_of_levels, sizeof(uint32_t));
+        if (number_of_levels + 1 == number_of_graph_nodes)
+        {
+            node_levels.resize(number_of_levels);
+            level_file.read((char *)node_levels.data(), sizeof(float) * number_of_levels);
+        }
+        else
+        {
+            util::SimpleLogger().Write(logWARNING) << level_path
+                                                   << " does not match the search graph";
+        }
+    }
+    shared_layout_ptr->SetBlockSize<NodeID>(SharedDataLayout::SWEEP_RANKS, node_levels.size());
 
     // load coordinate size
     boost::filesystem::ifstream nodes_input_stream(nodes_data_path, std::ios::binary);
@@ -488,10 +581,6 @@ int Storage::Run()
     tree_node_file.close();
 
     // load core markers
-    std::vector<char> unpacked_core_markers(number_of_core_markers);
-    core_marker_file.read((char *)unpacked_core_markers.data(),
-                          sizeof(char) * number_of_core_markers);
-
     unsigned *core_marker_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
         shared_memory_ptr, SharedDataLayout::CORE_MARKER);
 
@@ -517,6 +606,45 @@ int Storage::Run()
         }
     }
 
+    // load core landmarks, core nodes are numbered by increasing node id
+    unsigned *landmark_count_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+        shared_memory_ptr, SharedDataLayout::CORE_LANDMARK_COUNT);
+    landmark_count_ptr[0] = number_of_landmarks;
+    if (number_of_landmarks > 0)
+    {
+        NodeID *landmark_index_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+            shared_memory_ptr, SharedDataLayout::CORE_LANDMARK_INDEX);
+        NodeID core_index = 0;
+        for (auto i = 0u; i < number_of_core_markers; ++i)
+        {
+            landmark_index_ptr[i] = unpacked_core_markers[i] == 1 ? core_index++ : SPECIAL_NODEID;
+        }
+
+        EdgeWeight *landmark_distances_ptr = shared_layout_ptr->GetBlockPtr<EdgeWeight, true>(
+            shared_memory_ptr, SharedDataLayout::CORE_LANDMARK_DISTANCES);
+        landmarks_file.read(
+            (char *)landmark_distances_ptr,
+            shared_layout_ptr->GetBlockSize(SharedDataLayout::CORE_LANDMARK_DISTANCES));
+    }
+
+    // load the unpacked shortcuts
+    if (number_of_shortcuts > 0)
+    {
+        unsigned *shortcut_keys_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::SHORTCUT_KEYS);
+        shortcuts_file.read((char *)shortcut_keys_ptr,
+                            shared_layout_ptr->GetBlockSize(SharedDataLayout::SHORTCUT_KEYS));
+        unsigned *shortcut_offsets_ptr = shared_layout_ptr->GetBlockPtr<unsigned, true>(
+            shared_memory_ptr, SharedDataLayout::SHORTCUT_OFFSETS);
+        shortcuts_file.read((char *)shortcut_offsets_ptr,
+                            shared_layout_ptr->GetBlockSize(SharedDataLayout::SHORTCUT_OFFSETS));
+        contractor::UnpackedShortcutEdge *shortcut_edges_ptr =
+            shared_layout_ptr->GetBlockPtr<contractor::UnpackedShortcutEdge, true>(
+                shared_memory_ptr, SharedDataLayout::SHORTCUT_EDGES);
+        shortcuts_file.read((char *)shortcut_edges_ptr,
+                            shared_layout_ptr->GetBlockSize(SharedDataLayout::SHORTCUT_EDGES));
+    }
+
     // load the nodes of the search graph
     QueryGraph::NodeArrayEntry *graph_node_list_ptr =
         shared_layout_ptr->GetBlockPtr<QueryGraph::NodeArrayEntry, true>(
@@ -538,6 +666,36 @@ int Storage::Run()
     }
     hsgr_input_stream.close();
 
+    // rank the nodes for downward sweeps over the hierarchy
+    NodeID *sweep_ranks_ptr = shared_layout_ptr->GetBlockPtr<NodeID, true>(
+        shared_memory_ptr, SharedDataLayout::SWEEP_RANKS);
+    if (!node_levels.empty())
+    {
+        // the search graph as the shared memory data facades see it
+        using SharedQueryGraph = util::StaticGraph<contractor::QueryEdge::EdgeData, true>;
+        util::ShM<SharedQueryGraph::NodeArrayEntry, true>::vector graph_node_list(
+            shared_layout_ptr->GetBlockPtr<SharedQueryGraph::NodeArrayEntry>(
+                shared_memory_ptr, SharedDataLayout::GRAPH_NODE_LIST),
+            shared_layout_ptr->num_entries[SharedDataLayout::GRAPH_NODE_LIST]);
+        util::ShM<SharedQueryGraph::EdgeArrayEntry, true>::vector graph_edge_list(
+            shared_layout_ptr->GetBlockPtr<SharedQueryGraph::EdgeArrayEntry>(
+                shared_memory_ptr, SharedDataLayout::GRAPH_EDGE_LIST),
+            shared_layout_ptr->num_entries[SharedDataLayout::GRAPH_EDGE_LIST]);
+        const SharedQueryGraph graph(graph_node_list, graph_edge_list);
+        const auto sweep_ranks = util::ComputeSweepRanks(node_levels, graph);
+        if (sweep_ranks.empty())
+        {
+            // marks the ranks as unusable, the size of the block is already fixed
+            util::SimpleLogger().Write(logWARNING)
+                << level_path << " does not match the hierarchy, PHAST queries are disabled";
+            std::fill(sweep_ranks_ptr, sweep_ranks_ptr + node_levels.size(), SPECIAL_NODEID);
+        }
+        else
+        {
+            std::copy(sweep_ranks.begin(), sweep_ranks.end(), sweep_ranks_ptr);
+        }
+    }
+
     // acquire lock
     SharedMemory *data_type_memory =
         makeSharedMemory(CURRENT_REGIONS, sizeof(SharedDataTimestamp), true, false);
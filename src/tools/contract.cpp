@@ -39,6 +39,14 @@ return_code parseArguments(int argc, char *argv[], contractor::ContractorConfig
         "core,k",
         boost::program_options::value<double>(&contractor_config.core_factor)->default_value(1.0),
         "Percentage of the graph (in vertices) to contract [0..1]")(
+        "core-landmarks",
+        boost::program_options::value<unsigned>(&contractor_config.number_of_core_landmarks)
+            ->default_value(16),
+        "Number of landmarks that guide queries through the uncontracted core")(
+        "unpack-shortcuts",
+        boost::program_options::value<unsigned>(&contractor_config.min_unpacked_shortcut_size)
+            ->default_value(0),
+        "Store the unpacking of shortcuts of at least this many edges, 0 disables it")(
         "segment-speed-file",
         boost::program_options::value<std::string>(&contractor_config.segment_speed_lookup_path),
         "Lookup file containing nodeA,nodeB,speed data to adjust edge weights")(
@@ -46,14 +46,21 @@ int main(int argc, const char *argv[]) try
 
     bool trial_run = false;
     std::string ip_address;
-    int ip_port, requested_thread_num;
+    int ip_port, requested_thread_num, requested_io_thread_num, max_queue_size, max_queue_wait;
+    int max_query_time, max_batch_size, response_cache_size, keepalive_timeout;
+    int keepalive_max_requests, compression_threshold, max_dense_heap_nodes;
+    int min_phast_table_targets, min_parallel_matching_locations;
 
     EngineConfig config;
     const unsigned init_result = util::GenerateServerProgramOptions(
         argc, argv, config.server_paths, ip_address, ip_port, requested_thread_num,
-        config.use_shared_memory, trial_run, config.max_locations_trip,
+        requested_io_thread_num, max_queue_size, max_queue_wait, max_query_time,
+        max_batch_size, config.use_shared_memory, trial_run, config.max_locations_trip,
         config.max_locations_viaroute, config.max_locations_distance_table,
-        config.max_locations_map_matching);
+        config.max_locations_map_matching, response_cache_size, keepalive_timeout,
+        keepalive_max_requests, compression_threshold, max_dense_heap_nodes,
+        min_phast_table_targets, config.trip_search_time, config.matching_session_ttl,
+        min_parallel_matching_locations);
     if (init_result == util::INIT_OK_DO_NOT_START_ENGINE)
     {
         return EXIT_SUCCESS;
@@ -62,6 +69,11 @@ int main(int argc, const char *argv[]) try
     {
         return EXIT_FAILURE;
     }
+    config.response_cache_size = static_cast<std::size_t>(response_cache_size) * 1024 * 1024;
+    config.max_dense_heap_nodes = static_cast<std::size_t>(max_dense_heap_nodes);
+    config.min_phast_table_targets = static_cast<std::size_t>(min_phast_table_targets);
+    config.min_parallel_matching_locations =
+        static_cast<std::size_t>(min_parallel_matching_locations);
 
 #ifdef __linux__
     struct MemoryLocker final
@@ -90,8 +102,26 @@ int main(int argc, const char *argv[]) try
     }
 
     util::SimpleLogger().Write(logDEBUG) << "Threads:\t" << requested_thread_num;
+    util::SimpleLogger().Write(logDEBUG) << "I/O threads:\t" << requested_io_thread_num;
+    util::SimpleLogger().Write(logDEBUG) << "Queue:\t" << max_queue_size << " queries, "
+                                         << max_queue_wait << "ms max. wait";
+    util::SimpleLogger().Write(logDEBUG) << "Max. query time:\t" << max_query_time << "ms";
+    util::SimpleLogger().Write(logDEBUG) << "Max. batch size:\t" << max_batch_size;
     util::SimpleLogger().Write(logDEBUG) << "IP address:\t" << ip_address;
     util::SimpleLogger().Write(logDEBUG) << "IP port:\t" << ip_port;
+    util::SimpleLogger().Write(logDEBUG) << "Keep-alive:\t" << keepalive_timeout << "s, "
+                                         << keepalive_max_requests << " requests";
+    util::SimpleLogger().Write(logDEBUG) << "Compression threshold:\t" << compression_threshold
+                                         << " bytes";
+    util::SimpleLogger().Write(logDEBUG) << "Max. dense heap nodes:\t" << max_dense_heap_nodes;
+    util::SimpleLogger().Write(logDEBUG) << "Min. PHAST table destinations:\t"
+                                         << min_phast_table_targets;
+    util::SimpleLogger().Write(logDEBUG) << "Trip search time:\t" << config.trip_search_time
+                                         << "ms";
+    util::SimpleLogger().Write(logDEBUG) << "Matching session TTL:\t"
+                                         << config.matching_session_ttl << "s";
+    util::SimpleLogger().Write(logDEBUG) << "Min. parallel matching coordinates:\t"
+                                         << min_parallel_matching_locations;
 
 #ifndef _WIN32
     int sig = 0;
@@ -102,7 +132,11 @@ int main(int argc, const char *argv[]) try
 #endif
 
     OSRM osrm_lib(config);
-    auto routing_server = server::Server::CreateServer(ip_address, ip_port, requested_thread_num);
+    auto routing_server =
+        server::Server::CreateServer(ip_address, ip_port, requested_thread_num,
+                                     requested_io_thread_num, max_queue_size, max_queue_wait,
+                                     max_query_time, max_batch_size, keepalive_timeout,
+                                     keepalive_max_requests, compression_threshold);
 
     routing_server->GetRequestHandlerPtr().RegisterRoutingMachine(&osrm_lib);
 
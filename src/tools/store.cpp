@@ -35,6 +35,12 @@ bool generateDataStoreOptions(const int argc, const char *argv[], storage::DataP
         ".fileIndex file")("core",
                            boost::program_options::value<boost::filesystem::path>(&paths["core"]),
                            ".core file")(
+        "levels", boost::program_options::value<boost::filesystem::path>(&paths["levels"]),
+        ".level file")(
+        "landmarks", boost::program_options::value<boost::filesystem::path>(&paths["landmarks"]),
+        ".landmarks file")(
+        "shortcuts", boost::program_options::value<boost::filesystem::path>(&paths["shortcuts"]),
+        ".shortcuts file")(
         "namesdata", boost::program_options::value<boost::filesystem::path>(&paths["namesdata"]),
         ".names file")("timestamp",
                        boost::program_options::value<boost::filesystem::path>(&paths["timestamp"]),
@@ -133,6 +139,24 @@ bool generateDataStoreOptions(const int argc, const char *argv[], storage::DataP
         path_iterator->second = base_string + ".core";
     }
 
+    path_iterator = paths.find("levels");
+    if (path_iterator != paths.end())
+    {
+        path_iterator->second = base_string + ".level";
+    }
+
+    path_iterator = paths.find("landmarks");
+    if (path_iterator != paths.end())
+    {
+        path_iterator->second = base_string + ".landmarks";
+    }
+
+    path_iterator = paths.find("shortcuts");
+    if (path_iterator != paths.end())
+    {
+        path_iterator->second = base_string + ".shortcuts";
+    }
+
     path_iterator = paths.find("namesdata");
     if (path_iterator != paths.end())
     {
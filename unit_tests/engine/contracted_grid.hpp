@@ -0,0 +1,301 @@
+#ifndef UNIT_TESTS_CONTRACTED_GRID_HPP
+#define UNIT_TESTS_CONTRACTED_GRID_HPP
+
+#include "contractor/query_edge.hpp"
+#include "contractor/shortcut_unpacking.hpp"
+#include "engine/phantom_node.hpp"
+#include "extractor/travel_mode.hpp"
+#include "extractor/turn_instructions.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include "osrm/coordinate.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osrm
+{
+namespace unit_tests
+{
+
+// Square grid of streets with random weights, some of them one-way or missing, contracted in a
+// random order. Like in osrm-contract every edge is stored at the node contracted first, a
+// two-way street becomes a loop at the node contracted last. Implements the part of the data
+// facade the routing algorithms use, node i lies at (i / width, i % width) millidegrees.
+class ContractedGrid
+{
+  public:
+    using EdgeData = contractor::QueryEdge::EdgeData;
+    using Graph = util::StaticGraph<EdgeData>;
+    using UnpackedShortcutRange = std::pair<const contractor::UnpackedShortcutEdge *,
+                                            const contractor::UnpackedShortcutEdge *>;
+
+    ContractedGrid(const unsigned width, const unsigned seed)
+        : width(width), number_of_nodes(width * width), out_edges(number_of_nodes)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<EdgeWeight> weight_distribution(20, 2000);
+        const auto add_street = [&](const NodeID from, const NodeID to)
+        {
+            // one in six directions is missing
+            if (generator() % 6 != 0)
+            {
+                out_edges[from].emplace_back(to, weight_distribution(generator));
+            }
+            if (generator() % 6 != 0)
+            {
+                out_edges[to].emplace_back(from, weight_distribution(generator));
+            }
+        };
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            if (node % width + 1 < width)
+            {
+                add_street(node, node + 1);
+            }
+            if (node + width < number_of_nodes)
+            {
+                add_street(node, node + width);
+            }
+        }
+
+        std::vector<NodeID> order(number_of_nodes);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), generator);
+        Contract(order);
+    }
+
+    unsigned GetNumberOfNodes() const { return number_of_nodes; }
+    unsigned GetNumberOfEdges() const { return graph->GetNumberOfEdges(); }
+    util::range<EdgeID> GetAdjacentEdgeRange(const NodeID node) const
+    {
+        return graph->GetAdjacentEdgeRange(node);
+    }
+    const EdgeData &GetEdgeData(const EdgeID edge) const { return graph->GetEdgeData(edge); }
+    NodeID GetTarget(const EdgeID edge) const { return graph->GetTarget(edge); }
+    util::FixedPointCoordinate GetCoordinateOfNode(const unsigned id) const
+    {
+        return util::FixedPointCoordinate((id / width) * 1000, (id % width) * 1000);
+    }
+
+    // the contraction order is the order of the levels
+    bool HasSweepRanks() const { return true; }
+    NodeID GetSweepRank(const NodeID node) const { return sweep_ranks[node]; }
+    NodeID GetNodeAtSweepRank(const NodeID rank) const { return sweep_order[rank]; }
+
+    UnpackedShortcutRange GetUnpackedShortcut(const EdgeID, const bool) const
+    {
+        return UnpackedShortcutRange(nullptr, nullptr);
+    }
+    bool EdgeIsCompressed(const unsigned) const { return false; }
+    unsigned GetGeometryIndexForEdgeID(const unsigned id) const { return id; }
+    void GetUncompressedGeometry(const unsigned, std::vector<unsigned> &) const {}
+    extractor::TurnInstruction GetTurnInstructionForEdgeID(const unsigned) const
+    {
+        return extractor::TurnInstruction::NoTurn;
+    }
+    extractor::TravelMode GetTravelModeForEdgeID(const unsigned) const
+    {
+        return TRAVEL_MODE_DEFAULT;
+    }
+    unsigned GetNameIndexFromEdgeID(const unsigned id) const { return id; }
+
+    // Distances from the node on the uncontracted grid, INVALID_EDGE_WEIGHT if unreachable
+    std::vector<EdgeWeight> GetDistances(const NodeID source) const
+    {
+        using QueueEntry = std::pair<EdgeWeight, NodeID>;
+        std::vector<EdgeWeight> distances(number_of_nodes, INVALID_EDGE_WEIGHT);
+        std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+        distances[source] = 0;
+        queue.emplace(0, source);
+        while (!queue.empty())
+        {
+            const auto entry = queue.top();
+            queue.pop();
+            if (entry.first > distances[entry.second])
+            {
+                continue;
+            }
+            for (const auto &edge : out_edges[entry.second])
+            {
+                const EdgeWeight distance = entry.first + edge.second;
+                if (distance < distances[edge.first])
+                {
+                    distances[edge.first] = distance;
+                    queue.emplace(distance, edge.first);
+                }
+            }
+        }
+        return distances;
+    }
+
+    // Phantom node on a random segment, with a reverse node in two of three cases
+    engine::PhantomNode GetRandomPhantomNode(std::mt19937 &generator) const
+    {
+        engine::PhantomNode phantom;
+        phantom.forward_node_id = generator() % number_of_nodes;
+        phantom.reverse_node_id =
+            generator() % 3 != 0 ? generator() % number_of_nodes : SPECIAL_NODEID;
+        phantom.forward_weight = generator() % 200;
+        phantom.reverse_weight = generator() % 200;
+        phantom.forward_offset = generator() % 50;
+        phantom.reverse_offset = generator() % 50;
+        phantom.location = GetCoordinateOfNode(phantom.forward_node_id);
+        return phantom;
+    }
+
+    // Walk along the streets of the uncontracted grid, only turns back at dead ends. Stops early
+    // at nodes without outgoing streets.
+    std::vector<NodeID> GetRandomWalk(std::mt19937 &generator, const std::size_t length) const
+    {
+        std::vector<NodeID> walk = {static_cast<NodeID>(generator() % number_of_nodes)};
+        while (walk.size() < length && !out_edges[walk.back()].empty())
+        {
+            const auto &edges = out_edges[walk.back()];
+            auto next = edges[generator() % edges.size()].first;
+            if (walk.size() > 1 && next == walk[walk.size() - 2] && edges.size() > 1)
+            {
+                continue;
+            }
+            walk.push_back(next);
+        }
+        return walk;
+    }
+
+    // Nodes with a loop, source and target on them in the wrong order need a detour
+    std::vector<NodeID> GetLoopNodes() const
+    {
+        std::vector<NodeID> loop_nodes;
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            for (const auto edge : graph->GetAdjacentEdgeRange(node))
+            {
+                if (graph->GetTarget(edge) == node)
+                {
+                    loop_nodes.push_back(node);
+                    break;
+                }
+            }
+        }
+        return loop_nodes;
+    }
+
+  private:
+    // Contracts the nodes in the given order, keeps the shortest of parallel edges
+    void Contract(const std::vector<NodeID> &order)
+    {
+        // target -> (weight, middle node or SPECIAL_NODEID)
+        using Adjacency = std::map<NodeID, std::pair<EdgeWeight, NodeID>>;
+        std::vector<Adjacency> remaining_out(number_of_nodes);
+        std::vector<Adjacency> remaining_in(number_of_nodes);
+        std::vector<EdgeWeight> loop_weights(number_of_nodes, INVALID_EDGE_WEIGHT);
+        const auto add_edge = [&](const NodeID from, const NodeID to, const EdgeWeight weight,
+                                  const NodeID middle)
+        {
+            if (from == to)
+            {
+                loop_weights[from] = std::min(loop_weights[from], weight);
+                return;
+            }
+            const auto edge = remaining_out[from].find(to);
+            if (edge == remaining_out[from].end() || edge->second.first > weight)
+            {
+                remaining_out[from][to] = std::make_pair(weight, middle);
+                remaining_in[to][from] = std::make_pair(weight, middle);
+            }
+        };
+        for (NodeID node = 0; node < number_of_nodes; ++node)
+        {
+            for (const auto &edge : out_edges[node])
+            {
+                add_edge(node, edge.first, edge.second, SPECIAL_NODEID);
+            }
+        }
+
+        sweep_order.assign(order.rbegin(), order.rend());
+        sweep_ranks.resize(number_of_nodes);
+        for (NodeID rank = 0; rank < number_of_nodes; ++rank)
+        {
+            sweep_ranks[sweep_order[rank]] = rank;
+        }
+
+        std::vector<Graph::InputEdge> edges;
+        const auto store_edge = [&](const NodeID node, const NodeID other, const EdgeWeight weight,
+                                    const NodeID middle, const bool forward)
+        {
+            EdgeData data;
+            data.distance = weight;
+            data.shortcut = SPECIAL_NODEID != middle;
+            // the id of an original edge is the node it leads to, so unpacked paths visit the
+            // coordinates of their nodes
+            data.id = data.shortcut ? middle : (forward ? other : node);
+            data.forward = forward;
+            data.backward = !forward;
+            edges.emplace_back(node, other, data);
+        };
+        for (const auto node : order)
+        {
+
+            for (const auto &edge : remaining_out[node])
+            {
+                store_edge(node, edge.first, edge.second.first, edge.second.second, true);
+            }
+            for (const auto &edge : remaining_in[node])
+            {
+                store_edge(node, edge.first, edge.second.first, edge.second.second, false);
+            }
+            if (INVALID_EDGE_WEIGHT != loop_weights[node])
+            {
+                EdgeData data;
+                data.distance = loop_weights[node];
+                data.shortcut = false;
+                data.id = node;
+                data.forward = true;
+                data.backward = true;
+                edges.emplace_back(node, node, data);
+            }
+
+            for (const auto &in_edge : remaining_in[node])
+            {
+                for (const auto &out_edge : remaining_out[node])
+                {
+                    add_edge(in_edge.first, out_edge.first,
+                             in_edge.second.first + out_edge.second.first, node);
+                }
+            }
+            for (const auto &edge : remaining_out[node])
+            {
+                remaining_in[edge.first].erase(node);
+            }
+            for (const auto &edge : remaining_in[node])
+            {
+                remaining_out[edge.first].erase(node);
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        graph.reset(new Graph(number_of_nodes, edges));
+    }
+
+    const unsigned width;
+    const unsigned number_of_nodes;
+    // edges of the uncontracted grid, (target, weight)
+    std::vector<std::vector<std::pair<NodeID, EdgeWeight>>> out_edges;
+    std::unique_ptr<Graph> graph;
+    std::vector<NodeID> sweep_ranks;
+    std::vector<NodeID> sweep_order;
+};
+}
+}
+
+#endif // UNIT_TESTS_CONTRACTED_GRID_HPP
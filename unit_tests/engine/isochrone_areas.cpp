@@ -0,0 +1,125 @@
+#include "engine/isochrone_areas.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <osrm/coordinate.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(isochrone_areas)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+using Coordinates = std::vector<util::FixedPointCoordinate>;
+
+Coordinates Sorted(Coordinates coordinates)
+{
+    std::sort(coordinates.begin(), coordinates.end(),
+              [](const util::FixedPointCoordinate &lhs, const util::FixedPointCoordinate &rhs)
+              {
+                  return lhs.lat < rhs.lat || (lhs.lat == rhs.lat && lhs.lon < rhs.lon);
+              });
+    return coordinates;
+}
+
+// hulls are counter-clockwise, inside means left of or on every edge
+bool IsInside(const Coordinates &hull, const util::FixedPointCoordinate &coordinate)
+{
+    for (std::size_t i = 0; i < hull.size(); ++i)
+    {
+        const auto &a = hull[i];
+        const auto &b = hull[(i + 1) % hull.size()];
+        const auto cross = (static_cast<std::int64_t>(b.lon) - a.lon) *
+                               (static_cast<std::int64_t>(coordinate.lat) - a.lat) -
+                           (static_cast<std::int64_t>(b.lat) - a.lat) *
+                               (static_cast<std::int64_t>(coordinate.lon) - a.lon);
+        if (cross < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+}
+
+// On the source node the part of a segment behind the source is not reached
+BOOST_AUTO_TEST_CASE(source_segment_offset)
+{
+    const util::FixedPointCoordinate source(0, 0);
+    IsochroneAreas areas({100}, source);
+    // the source lies 50 into its node, 10 behind the end of the first segment
+    areas.AddSegment(-50, 0, 40, {0, -2000}, {0, -500});
+    BOOST_CHECK_EQUAL(areas.GetNumberOfReachedSegments(), 0);
+    // the segment the source lies on, only its end is reached
+    areas.AddSegment(-50, 40, 20, {0, -500}, {0, 500});
+    BOOST_CHECK_EQUAL(areas.GetNumberOfReachedSegments(), 1);
+
+    const auto hulls = areas.GetAreas();
+    BOOST_REQUIRE_EQUAL(hulls.size(), 1);
+    BOOST_CHECK(Sorted(hulls.front()) == Sorted({source, {0, 500}}));
+}
+
+// Segments leaving the area of a cutoff end in it at the point reached at the cutoff
+BOOST_AUTO_TEST_CASE(cutoff_interpolation)
+{
+    const util::FixedPointCoordinate source(0, 0);
+    IsochroneAreas areas({100, 200}, source);
+    // leaves the first area halfway, reaches the second one with its end
+    areas.AddSegment(0, 0, 200, source, {0, 2000});
+    // starts at the border of the first area, leaves the second one halfway
+    areas.AddSegment(80, 20, 200, {1000, 0}, {3000, 0});
+    // not reached or not within the largest cutoff
+    areas.AddSegment(INVALID_EDGE_WEIGHT, 0, 10, source, {-1000, 0});
+    areas.AddSegment(150, 60, 10, {-1000, 0}, {-2000, 0});
+    BOOST_CHECK_EQUAL(areas.GetNumberOfReachedSegments(), 2);
+
+    const auto hulls = areas.GetAreas();
+    BOOST_REQUIRE_EQUAL(hulls.size(), 2);
+    BOOST_CHECK(Sorted(hulls[0]) == Sorted({source, {0, 1000}, {1000, 0}}));
+    // the coordinates of the first area lie on the border of the second one
+    BOOST_CHECK(Sorted(hulls[1]) == Sorted({source, {0, 2000}, {2000, 0}}));
+}
+
+// Every area contains the areas of all smaller cutoffs
+BOOST_AUTO_TEST_CASE(nested_areas)
+{
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> coordinate_distribution(-10000, 10000);
+    std::uniform_int_distribution<EdgeWeight> distance_distribution(-100, 1000);
+    std::uniform_int_distribution<EdgeWeight> weight_distribution(1, 300);
+
+    for (unsigned round = 0; round < 20; ++round)
+    {
+        const std::vector<EdgeWeight> cutoffs = {150, 300, 450, 600};
+        IsochroneAreas areas(cutoffs, {0, 0});
+        for (unsigned segment = 0; segment < 50; ++segment)
+        {
+            const util::FixedPointCoordinate from(coordinate_distribution(generator),
+                                                  coordinate_distribution(generator));
+            const util::FixedPointCoordinate to(coordinate_distribution(generator),
+                                                coordinate_distribution(generator));
+            areas.AddSegment(distance_distribution(generator), 0, weight_distribution(generator),
+                             from, to);
+        }
+
+        const auto hulls = areas.GetAreas();
+        BOOST_REQUIRE_EQUAL(hulls.size(), cutoffs.size());
+        for (std::size_t i = 1; i < hulls.size(); ++i)
+        {
+            BOOST_CHECK_GE(hulls[i].size(), 3);
+            for (const auto &coordinate : hulls[i - 1])
+            {
+                BOOST_CHECK(IsInside(hulls[i], coordinate));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,96 @@
+#include "contractor/core_landmarks.hpp"
+#include "contractor/query_edge.hpp"
+#include "engine/routing_algorithms/landmark_potential.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <utility>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(landmark_potential)
+
+using namespace osrm;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+// every node is a core node
+struct LandmarkFacade
+{
+    unsigned number_of_landmarks;
+    std::vector<EdgeWeight> distances;
+
+    unsigned GetNumberOfCoreLandmarks() const { return number_of_landmarks; }
+
+    const EdgeWeight *GetCoreLandmarkDistances(const NodeID id) const
+    {
+        return &distances[2 * number_of_landmarks * id];
+    }
+};
+
+// one-way path 0 -> 1 -> 2 -> 3
+LandmarkFacade MakeOneWayPath()
+{
+    std::vector<contractor::QueryEdge> edges;
+    const auto add_edge = [&edges](const NodeID source, const NodeID target, const int weight)
+    {
+        contractor::QueryEdge::EdgeData data;
+        data.distance = weight;
+        data.forward = true;
+        edges.emplace_back(source, target, data);
+        // the core keeps an edge at both of its nodes
+        data.forward = false;
+        data.backward = true;
+        edges.emplace_back(target, source, data);
+    };
+    add_edge(0, 1, 10);
+    add_edge(1, 2, 20);
+    add_edge(2, 3, 30);
+
+    const contractor::CoreLandmarks landmarks(std::vector<bool>(4, true), edges);
+    BOOST_CHECK_EQUAL(landmarks.GetNumberOfCoreNodes(), 4);
+    return LandmarkFacade{2, landmarks.ComputeDistances(2)};
+}
+}
+
+BOOST_AUTO_TEST_CASE(landmark_distances)
+{
+    const auto facade = MakeOneWayPath();
+
+    // the node farthest from node 0 comes first, then the one no landmark has a round trip to
+    const std::vector<EdgeWeight> node_1 = {INVALID_EDGE_WEIGHT, 50, 10, INVALID_EDGE_WEIGHT};
+    const auto distances = facade.GetCoreLandmarkDistances(1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(distances, distances + 4, node_1.begin(), node_1.end());
+}
+
+BOOST_AUTO_TEST_CASE(bounds_on_a_path)
+{
+    const auto facade = MakeOneWayPath();
+    const std::vector<std::pair<NodeID, EdgeWeight>> sources = {{0, 5}};
+    const std::vector<std::pair<NodeID, EdgeWeight>> targets = {{3, 7}};
+    const CoreLandmarkPotential<LandmarkFacade> potential(&facade, sources, targets);
+
+    // exact on a path
+    BOOST_CHECK_EQUAL(potential.ToTargets(1), 50 + 7);
+    BOOST_CHECK_EQUAL(potential.ToTargets(3), 7);
+    BOOST_CHECK_EQUAL(potential.FromSources(2), 5 + 30);
+    BOOST_CHECK_EQUAL(potential.FromSources(0), 5);
+}
+
+BOOST_AUTO_TEST_CASE(unreachable_nodes)
+{
+    const auto facade = MakeOneWayPath();
+    const std::vector<std::pair<NodeID, EdgeWeight>> sources = {{1, 0}};
+    const std::vector<std::pair<NodeID, EdgeWeight>> targets = {{0, 0}};
+    const CoreLandmarkPotential<LandmarkFacade> potential(&facade, sources, targets);
+
+    // nothing behind node 0 reaches it again
+    BOOST_CHECK_EQUAL(potential.ToTargets(2), INVALID_EDGE_WEIGHT);
+    BOOST_CHECK_EQUAL(potential.ToTargets(0), 0);
+    // node 1 does not reach node 0 either, but no landmark lies behind node 0 to prove it
+    BOOST_CHECK(potential.FromSources(0) <= 0);
+    BOOST_CHECK_EQUAL(potential.FromSources(3), 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include "contracted_grid.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(many_to_many)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+using Grid = unit_tests::ContractedGrid;
+
+// phantom node at the start of the segment of the node, its distances are the ones of the node
+PhantomNode MakeNodePhantom(const NodeID node)
+{
+    PhantomNode phantom;
+    phantom.forward_node_id = node;
+    phantom.forward_weight = 0;
+    phantom.forward_offset = 0;
+    return phantom;
+}
+}
+
+// The buckets of the targets are collected by several threads in chunks of targets and then
+// sorted, the table has to match one sequential search per source on the uncontracted grid
+BOOST_AUTO_TEST_CASE(parallel_buckets_match_sequential_distances)
+{
+    Grid grid(20, 13);
+    std::mt19937 generator(7);
+    std::vector<NodeID> source_nodes(5);
+    std::vector<NodeID> target_nodes(300);
+    for (auto &node : source_nodes)
+    {
+        node = generator() % grid.GetNumberOfNodes();
+    }
+    for (auto &node : target_nodes)
+    {
+        node = generator() % grid.GetNumberOfNodes();
+    }
+    std::vector<PhantomNode> sources, targets;
+    for (const auto node : source_nodes)
+    {
+        sources.push_back(MakeNodePhantom(node));
+    }
+    for (const auto node : target_nodes)
+    {
+        targets.push_back(MakeNodePhantom(node));
+    }
+
+    SearchEngineData engine_working_data;
+    ManyToManyRouting<Grid> many_to_many(&grid, engine_working_data);
+    // more threads than cores, so even small machines split the targets
+    tbb::task_scheduler_init init(4);
+    const auto table = many_to_many(sources, targets);
+
+    BOOST_REQUIRE_EQUAL(table->size(), sources.size() * targets.size());
+    for (std::size_t source_id = 0; source_id < sources.size(); ++source_id)
+    {
+        const auto distances = grid.GetDistances(source_nodes[source_id]);
+        for (std::size_t target_id = 0; target_id < targets.size(); ++target_id)
+        {
+            BOOST_CHECK_EQUAL((*table)[source_id * targets.size() + target_id],
+                              distances[target_nodes[target_id]]);
+        }
+    }
+}
+
+// Sources are searched in bundles of eight once there are enough sources and targets. Every entry
+// has to match the table of the source on its own, which is searched without bundling.
+BOOST_AUTO_TEST_CASE(bundled_searches_match_single_sources)
+{
+    Grid grid(20, 17);
+    std::mt19937 generator(11);
+    std::vector<PhantomNode> sources(19), targets(100);
+    for (auto &phantom : sources)
+    {
+        phantom = grid.GetRandomPhantomNode(generator);
+    }
+    for (auto &phantom : targets)
+    {
+        phantom = grid.GetRandomPhantomNode(generator);
+    }
+    // sources behind targets on the same segment, only reached around a loop
+    const auto loop_nodes = grid.GetLoopNodes();
+    BOOST_REQUIRE(loop_nodes.size() >= 5);
+    for (const auto index : {0u, 3u, 9u, 10u, 18u})
+    {
+        const NodeID node = loop_nodes[index % 5];
+        sources[index] = MakeNodePhantom(node);
+        sources[index].forward_offset = 150;
+        targets[index * 5] = MakeNodePhantom(node);
+        targets[index * 5].forward_offset = 50;
+    }
+
+    SearchEngineData engine_working_data;
+    ManyToManyRouting<Grid> many_to_many(&grid, engine_working_data);
+    const auto table = many_to_many(sources, targets);
+
+    BOOST_REQUIRE_EQUAL(table->size(), sources.size() * targets.size());
+    for (std::size_t source_id = 0; source_id < sources.size(); ++source_id)
+    {
+        const auto row = many_to_many({sources[source_id]}, targets);
+        for (std::size_t target_id = 0; target_id < targets.size(); ++target_id)
+        {
+            BOOST_CHECK_EQUAL((*table)[source_id * targets.size() + target_id], (*row)[target_id]);
+        }
+    }
+    for (const auto index : {0u, 3u, 9u, 10u, 18u})
+    {
+        BOOST_CHECK_NE((*table)[index * targets.size() + index * 5], INVALID_EDGE_WEIGHT);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,396 @@
+#include "engine/matching_sessions.hpp"
+#include "engine/query_deadline.hpp"
+#include "engine/routing_algorithms/map_matching.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/json_logger.hpp"
+#include "util/typedefs.hpp"
+
+#include "contracted_grid.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(map_matching)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+using Grid = unit_tests::ContractedGrid;
+
+const constexpr double MATCHING_BETA = 5;
+const constexpr double GPS_PRECISION = 5;
+const constexpr unsigned SAMPLE_TIME = 60;
+
+struct Trace
+{
+    CandidateLists candidates;
+    std::vector<util::FixedPointCoordinate> coordinates;
+    std::vector<unsigned> timestamps;
+
+    // the points [begin, end)
+    Trace Slice(const std::size_t begin, const std::size_t end) const
+    {
+        return Trace{CandidateLists(candidates.begin() + begin, candidates.begin() + end),
+                     std::vector<util::FixedPointCoordinate>(coordinates.begin() + begin,
+                                                             coordinates.begin() + end),
+                     std::vector<unsigned>(timestamps.begin() + begin, timestamps.begin() + end)};
+    }
+};
+
+PhantomNodeWithDistance MakeCandidate(const Grid &grid, const NodeID node, const double distance)
+{
+    PhantomNodeWithDistance candidate;
+    candidate.phantom_node.forward_node_id = node;
+    candidate.phantom_node.forward_weight = 0;
+    candidate.phantom_node.forward_offset = 0;
+    candidate.phantom_node.location = grid.GetCoordinateOfNode(node);
+    candidate.distance = distance;
+    return candidate;
+}
+
+// A vehicle driving along the streets of the grid, sampled every minute. Besides the node it
+// drives through, every point has a candidate on a random node further away. The first point
+// after a gap is recorded 20 minutes after the one before.
+Trace MakeTrace(const Grid &grid,
+                std::mt19937 &generator,
+                const std::size_t length,
+                const std::vector<std::size_t> &gap_ends)
+{
+    std::vector<NodeID> walk;
+    while (walk.size() < length)
+    {
+        walk = grid.GetRandomWalk(generator, length);
+    }
+
+    Trace trace;
+    for (std::size_t index = 0; index < walk.size(); ++index)
+    {
+        const NodeID other_node = generator() % grid.GetNumberOfNodes();
+        trace.candidates.push_back(
+            {MakeCandidate(grid, walk[index], 2), MakeCandidate(grid, other_node, 30)});
+        trace.coordinates.push_back(grid.GetCoordinateOfNode(walk[index]));
+        const auto gaps = std::count_if(gap_ends.begin(), gap_ends.end(),
+                                        [index](const std::size_t gap_end)
+                                        {
+                                            return gap_end <= index;
+                                        });
+        trace.timestamps.push_back(SAMPLE_TIME * index + 1200 * gaps);
+    }
+    return trace;
+}
+
+// Adds the matchings of a request that continued the frontier to those of the previous requests,
+// the points of the request start at offset in the whole trace
+void AppendContinuedMatchings(SubMatchingList continued_matchings,
+                              const std::size_t offset,
+                              SubMatchingList &matchings)
+{
+    for (auto &sub_matching : continued_matchings)
+    {
+        const bool continues_matching = 0 == sub_matching.indices.front();
+        RemoveFrontier(sub_matching);
+        for (auto &index : sub_matching.indices)
+        {
+            index += offset;
+        }
+        if (continues_matching)
+        {
+            auto &last = matchings.back();
+            last.indices.insert(last.indices.end(), sub_matching.indices.begin(),
+                                sub_matching.indices.end());
+            last.nodes.insert(last.nodes.end(), sub_matching.nodes.begin(),
+                              sub_matching.nodes.end());
+            last.length += sub_matching.length;
+        }
+        else
+        {
+            matchings.push_back(sub_matching);
+        }
+    }
+}
+
+void CheckSameMatchings(const SubMatchingList &matchings, const SubMatchingList &expected)
+{
+    BOOST_REQUIRE_EQUAL(matchings.size(), expected.size());
+    for (std::size_t index = 0; index < matchings.size(); ++index)
+    {
+        BOOST_CHECK_EQUAL_COLLECTIONS(matchings[index].indices.begin(),
+                                      matchings[index].indices.end(),
+                                      expected[index].indices.begin(),
+                                      expected[index].indices.end());
+        BOOST_CHECK_CLOSE(matchings[index].length, expected[index].length, 1e-6);
+        BOOST_REQUIRE_EQUAL(matchings[index].nodes.size(), expected[index].nodes.size());
+        for (std::size_t node = 0; node < matchings[index].nodes.size(); ++node)
+        {
+            BOOST_CHECK_EQUAL(matchings[index].nodes[node].forward_node_id,
+                              expected[index].nodes[node].forward_node_id);
+        }
+    }
+}
+}
+
+// A trace sent in two requests of a session has to give the matchings of the trace sent at once.
+// The second request starts with the frontier of the first, its first matching continues the
+// last one of the first request. After the gap it starts a matching of its own.
+BOOST_AUTO_TEST_CASE(session_continues_trace)
+{
+    // debug builds log every matching, the log has to be set up
+    util::json::Logger::get()->initialize("matching");
+
+    for (unsigned seed = 1; seed <= 10; ++seed)
+    {
+        Grid grid(12, seed);
+        std::mt19937 generator(seed);
+        const std::size_t length = 30;
+        const std::size_t split = 5 + seed;
+        const auto trace = MakeTrace(grid, generator, length, {22});
+
+        SearchEngineData engine_working_data;
+        MapMatching<Grid> map_matching(&grid, engine_working_data);
+
+        SubMatchingList expected;
+        map_matching(trace.candidates, trace.coordinates, trace.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, expected);
+        BOOST_REQUIRE_EQUAL(expected.size(), 2);
+
+        MatchingFrontier frontier;
+        const auto first = trace.Slice(0, split);
+        SubMatchingList matchings;
+        map_matching(first.candidates, first.coordinates, first.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, matchings, &frontier);
+        BOOST_REQUIRE(!frontier.candidates.empty());
+
+        // what the plugin does with the next request of the session
+        auto second = trace.Slice(split, length);
+        PrependFrontier(frontier, second.candidates, second.coordinates, second.timestamps);
+        SubMatchingList second_matchings;
+        map_matching(second.candidates, second.coordinates, second.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, second_matchings, &frontier);
+        BOOST_REQUIRE_EQUAL(second_matchings.size(), 2);
+        BOOST_CHECK_EQUAL(second_matchings.front().indices.front(), 0);
+        BOOST_CHECK_NE(second_matchings.back().indices.front(), 0);
+
+        AppendContinuedMatchings(second_matchings, split, matchings);
+        CheckSameMatchings(matchings, expected);
+    }
+}
+
+// Long traces are split at their time gaps and the parts matched in parallel. The model splits
+// the trace at the gaps anyway, so the matchings have to be the ones of the whole trace.
+BOOST_AUTO_TEST_CASE(parts_match_like_whole_trace)
+{
+    util::json::Logger::get()->initialize("matching");
+    // more threads than cores, so even small machines match several parts at once
+    tbb::task_scheduler_init init(4);
+
+    for (unsigned seed = 1; seed <= 10; ++seed)
+    {
+        Grid grid(12, seed);
+        std::mt19937 generator(seed);
+        const auto trace = MakeTrace(grid, generator, 60, {12, 25 + seed, 47});
+
+        SearchEngineData engine_working_data;
+        MapMatching<Grid> map_matching(&grid, engine_working_data);
+
+        SubMatchingList expected;
+        map_matching(trace.candidates, trace.coordinates, trace.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, expected);
+        BOOST_REQUIRE_EQUAL(expected.size(), 4);
+
+        SubMatchingList matchings;
+        map_matching.MatchInParts(trace.candidates, trace.coordinates, trace.timestamps,
+                                  MATCHING_BETA, GPS_PRECISION, matchings);
+        CheckSameMatchings(matchings, expected);
+    }
+}
+
+// A request of a session that runs out of time fails after the matching cleared the frontier it
+// continues. The frontier taken from the session goes back, the retried request continues it.
+BOOST_AUTO_TEST_CASE(expired_deadline_keeps_session)
+{
+    util::json::Logger::get()->initialize("matching");
+
+    Grid grid(12, 4);
+    std::mt19937 generator(4);
+    const std::size_t length = 40;
+    const std::size_t split = 10;
+    const auto trace = MakeTrace(grid, generator, length, {});
+
+    SearchEngineData engine_working_data;
+    MapMatching<Grid> map_matching(&grid, engine_working_data);
+    SubMatchingList expected;
+    map_matching(trace.candidates, trace.coordinates, trace.timestamps, MATCHING_BETA,
+                 GPS_PRECISION, expected);
+
+    MatchingSessions sessions(std::chrono::seconds(60), 10);
+    const auto first = trace.Slice(0, split);
+    SubMatchingList matchings;
+    MatchingFrontier frontier;
+    map_matching(first.candidates, first.coordinates, first.timestamps, MATCHING_BETA,
+                 GPS_PRECISION, matchings, &frontier);
+    BOOST_REQUIRE(!frontier.candidates.empty());
+    sessions.Put("vehicle", std::move(frontier), MatchingSessions::Clock::now());
+
+    {
+        MatchingFrontier taken;
+        BOOST_REQUIRE(sessions.Take("vehicle", taken, MatchingSessions::Clock::now()));
+        ScopedFrontierReturn frontier_return(sessions, "vehicle", taken);
+
+        auto second = trace.Slice(split, length);
+        PrependFrontier(taken, second.candidates, second.coordinates, second.timestamps);
+        const QueryDeadline expired(QueryDeadline::Clock::now() - std::chrono::seconds(1));
+        ScopedQueryDeadline scoped_deadline(&expired);
+        SubMatchingList failed_matchings;
+        BOOST_CHECK_THROW(map_matching(second.candidates, second.coordinates, second.timestamps,
+                                       MATCHING_BETA, GPS_PRECISION, failed_matchings, &taken),
+                          QueryDeadlineExceeded);
+        BOOST_CHECK(taken.candidates.empty());
+        BOOST_CHECK_EQUAL(sessions.Size(), 0);
+    }
+
+    MatchingFrontier restored;
+    BOOST_REQUIRE(sessions.Take("vehicle", restored, MatchingSessions::Clock::now()));
+    auto second = trace.Slice(split, length);
+    PrependFrontier(restored, second.candidates, second.coordinates, second.timestamps);
+    SubMatchingList second_matchings;
+    map_matching(second.candidates, second.coordinates, second.timestamps, MATCHING_BETA,
+                 GPS_PRECISION, second_matchings, &restored);
+    BOOST_REQUIRE(!second_matchings.empty());
+    BOOST_CHECK_EQUAL(second_matchings.front().indices.front(), 0);
+    AppendContinuedMatchings(second_matchings, split, matchings);
+    CheckSameMatchings(matchings, expected);
+}
+
+// Leaving out transitions that can not beat the best predecessor must not change the matchings.
+// The model of the thread is reused for traces of different lengths, rows left over from a longer
+// trace must not leak into a shorter one.
+BOOST_AUTO_TEST_CASE(transition_pruning_keeps_matchings)
+{
+    util::json::Logger::get()->initialize("matching");
+
+    Grid grid(12, 6);
+    std::mt19937 generator(6);
+    SearchEngineData engine_working_data;
+    MapMatching<Grid> map_matching(&grid, engine_working_data);
+
+    for (const std::size_t length : {40, 8, 25, 3, 60, 12})
+    {
+        const std::vector<std::size_t> gap_ends =
+            length > 20 ? std::vector<std::size_t>{length / 2} : std::vector<std::size_t>{};
+        auto trace = MakeTrace(grid, generator, length, gap_ends);
+        // candidates about as far away as the point itself keep many transitions competitive
+        std::uniform_real_distribution<double> distance_distribution(0, 15);
+        for (auto &candidates : trace.candidates)
+        {
+            candidates.push_back(MakeCandidate(
+                grid, generator() % grid.GetNumberOfNodes(), distance_distribution(generator)));
+            for (auto &candidate : candidates)
+            {
+                candidate.distance = distance_distribution(generator);
+            }
+        }
+
+        SubMatchingList pruned;
+        map_matching.SetTransitionPruning(true);
+        map_matching(trace.candidates, trace.coordinates, trace.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, pruned);
+
+        SubMatchingList unpruned;
+        map_matching.SetTransitionPruning(false);
+        map_matching(trace.candidates, trace.coordinates, trace.timestamps, MATCHING_BETA,
+                     GPS_PRECISION, unpruned);
+
+        BOOST_CHECK(!pruned.empty());
+        CheckSameMatchings(pruned, unpruned);
+    }
+}
+
+// The paths of the many-to-many search between the candidates of two points have to be as long
+// as the shortest path of each pair searched on its own. A source behind its target on the same
+// segment needs the loop at the node.
+BOOST_AUTO_TEST_CASE(candidate_paths_match_network_distances)
+{
+    Grid grid(12, 3);
+    std::mt19937 generator(5);
+    SearchEngineData engine_working_data;
+    MapMatching<Grid> map_matching(&grid, engine_working_data);
+    engine_working_data.InitializeOrClearFirstThreadLocalStorage(grid.GetNumberOfNodes());
+    auto &forward_heap = *engine_working_data.forward_heap_1;
+    auto &reverse_heap = *engine_working_data.reverse_heap_1;
+
+    const auto loop_nodes = grid.GetLoopNodes();
+    BOOST_REQUIRE(!loop_nodes.empty());
+    unsigned number_of_paths = 0;
+    for (unsigned round = 0; round < 10; ++round)
+    {
+        CandidateList sources, targets;
+        for (unsigned candidate = 0; candidate < 6; ++candidate)
+        {
+            sources.push_back({grid.GetRandomPhantomNode(generator), 0});
+            targets.push_back({grid.GetRandomPhantomNode(generator), 0});
+        }
+        const auto loop_node = loop_nodes[generator() % loop_nodes.size()];
+        auto behind = MakeCandidate(grid, loop_node, 0);
+        behind.phantom_node.forward_weight = 30;
+        behind.phantom_node.forward_offset = 40;
+        auto ahead = MakeCandidate(grid, loop_node, 0);
+        ahead.phantom_node.forward_weight = 10;
+        ahead.phantom_node.forward_offset = 5;
+        sources.push_back(behind);
+        targets.push_back(ahead);
+        // pruned sources get no paths
+        std::vector<std::uint8_t> pruned(sources.size(), 0);
+        pruned[round % 6] = 1;
+
+        MapMatching<Grid>::SearchSpaceWithBuckets search_space_with_buckets;
+        MapMatching<Grid>::CandidatePaths paths;
+        map_matching.ComputeCandidatePaths(sources, pruned.data(), targets, forward_heap,
+                                           search_space_with_buckets, paths);
+
+        BOOST_REQUIRE_EQUAL(paths.ranges.size(), sources.size() * targets.size());
+        for (std::size_t s = 0; s < sources.size(); ++s)
+        {
+            for (std::size_t s_prime = 0; s_prime < targets.size(); ++s_prime)
+            {
+                const auto &path = paths.ranges[s * targets.size() + s_prime];
+                if (pruned[s])
+                {
+                    BOOST_CHECK_EQUAL(path.first, path.second);
+                    continue;
+                }
+                forward_heap.Clear();
+                reverse_heap.Clear();
+                const auto expected =
+                    map_matching.get_network_distance(forward_heap, reverse_heap,
+                                                      sources[s].phantom_node,
+                                                      targets[s_prime].phantom_node);
+                if (expected == std::numeric_limits<double>::max())
+                {
+                    BOOST_CHECK_EQUAL(path.first, path.second);
+                    continue;
+                }
+                BOOST_REQUIRE_LT(path.first, path.second);
+                const auto distance = map_matching.GetPathDistance(
+                    paths.nodes.begin() + path.first, paths.nodes.begin() + path.second,
+                    sources[s].phantom_node, targets[s_prime].phantom_node);
+                BOOST_CHECK_CLOSE(distance, expected, 1e-6);
+                ++number_of_paths;
+            }
+        }
+    }
+    // most pairs are connected, so the comparison is not vacuous
+    BOOST_CHECK_GT(number_of_paths, 200);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/matching_sessions.hpp"
+
+#include <chrono>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(matching_sessions)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+MatchingFrontier MakeFrontier(const unsigned timestamp)
+{
+    MatchingFrontier frontier;
+    frontier.candidates.resize(2);
+    frontier.viterbi = {0., -1.};
+    frontier.has_timestamp = true;
+    frontier.timestamp = timestamp;
+    return frontier;
+}
+}
+
+BOOST_AUTO_TEST_CASE(take_and_put)
+{
+    MatchingSessions sessions(std::chrono::seconds(60), 10);
+    const auto now = MatchingSessions::Clock::now();
+    MatchingFrontier frontier;
+    BOOST_CHECK(!sessions.Take("a", frontier, now));
+
+    sessions.Put("a", MakeFrontier(5), now);
+    sessions.Put("b", MakeFrontier(7), now);
+    BOOST_CHECK_EQUAL(sessions.Size(), 2);
+
+    BOOST_REQUIRE(sessions.Take("a", frontier, now));
+    BOOST_CHECK_EQUAL(frontier.timestamp, 5);
+    BOOST_CHECK_EQUAL(frontier.candidates.size(), 2);
+    BOOST_CHECK_EQUAL(frontier.viterbi.size(), 2);
+
+    // handed out, a concurrent request of the session starts a new trace
+    BOOST_CHECK(!sessions.Take("a", frontier, now));
+    BOOST_CHECK_EQUAL(sessions.Size(), 1);
+
+    // the later frontier replaces the earlier one
+    sessions.Put("b", MakeFrontier(9), now);
+    BOOST_CHECK_EQUAL(sessions.Size(), 1);
+    BOOST_REQUIRE(sessions.Take("b", frontier, now));
+    BOOST_CHECK_EQUAL(frontier.timestamp, 9);
+}
+
+BOOST_AUTO_TEST_CASE(expires_after_time_to_live)
+{
+    MatchingSessions sessions(std::chrono::seconds(60), 10);
+    const auto start = MatchingSessions::Clock::now();
+    sessions.Put("a", MakeFrontier(1), start);
+    sessions.Put("b", MakeFrontier(2), start + std::chrono::seconds(30));
+
+    MatchingFrontier frontier;
+    const auto later = start + std::chrono::seconds(61);
+    BOOST_CHECK(!sessions.Take("a", frontier, later));
+    BOOST_CHECK_EQUAL(sessions.Size(), 1);
+    BOOST_CHECK(sessions.Take("b", frontier, later));
+
+    // continuing a session keeps it alive
+    sessions.Put("b", frontier, later);
+    BOOST_CHECK(sessions.Take("b", frontier, later + std::chrono::seconds(60)));
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    MatchingSessions sessions(std::chrono::seconds(60), 2);
+    const auto now = MatchingSessions::Clock::now();
+    sessions.Put("a", MakeFrontier(1), now);
+    sessions.Put("b", MakeFrontier(2), now);
+    sessions.Put("c", MakeFrontier(3), now);
+    BOOST_CHECK_EQUAL(sessions.Size(), 2);
+
+    MatchingFrontier frontier;
+    BOOST_CHECK(!sessions.Take("a", frontier, now));
+    BOOST_CHECK(sessions.Take("b", frontier, now));
+    BOOST_CHECK(sessions.Take("c", frontier, now));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+#include "engine/routing_algorithms/many_to_many.hpp"
+#include "engine/routing_algorithms/phast.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include "contracted_grid.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(phast)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+using Grid = unit_tests::ContractedGrid;
+
+// sweeps and bucket searches have to give the same table, entry by entry
+void CheckSameTable(Grid &grid,
+                    const std::vector<PhantomNode> &sources,
+                    const std::vector<PhantomNode> &targets)
+{
+    SearchEngineData engine_working_data;
+    PHASTRouting<Grid> phast(&grid, engine_working_data);
+    ManyToManyRouting<Grid> many_to_many(&grid, engine_working_data);
+    BOOST_REQUIRE(phast.IsAvailable());
+
+    const auto sweep_table = phast(sources, targets);
+    const auto bucket_table = many_to_many(sources, targets);
+    BOOST_REQUIRE_EQUAL(sweep_table->size(), bucket_table->size());
+    for (std::size_t entry = 0; entry < sweep_table->size(); ++entry)
+    {
+        BOOST_CHECK_EQUAL((*sweep_table)[entry], (*bucket_table)[entry]);
+    }
+}
+
+PhantomNode MakeNodePhantom(const NodeID node, const int offset)
+{
+    PhantomNode phantom;
+    phantom.forward_node_id = node;
+    phantom.forward_weight = 0;
+    phantom.forward_offset = offset;
+    return phantom;
+}
+}
+
+// Few targets only select a small part of the hierarchy for the sweeps
+BOOST_AUTO_TEST_CASE(restricted_sweeps_match_bucket_searches)
+{
+    for (unsigned seed = 1; seed <= 30; ++seed)
+    {
+        Grid grid(12, seed);
+        std::mt19937 generator(seed);
+        std::vector<PhantomNode> sources(10), targets(1 + seed % 8);
+        for (auto &phantom : sources)
+        {
+            phantom = grid.GetRandomPhantomNode(generator);
+        }
+        for (auto &phantom : targets)
+        {
+            phantom = grid.GetRandomPhantomNode(generator);
+        }
+        CheckSameTable(grid, sources, targets);
+    }
+}
+
+// Sources behind targets on the same segment are only connected around a loop, which the sweep
+// cannot see. These entries come from bucket searches.
+BOOST_AUTO_TEST_CASE(loop_entries_match_bucket_searches)
+{
+    Grid grid(12, 5);
+    const auto loop_nodes = grid.GetLoopNodes();
+    BOOST_REQUIRE(loop_nodes.size() >= 4);
+
+    std::vector<PhantomNode> sources, targets;
+    for (std::size_t index = 0; index < 4; ++index)
+    {
+        sources.push_back(MakeNodePhantom(loop_nodes[index], 150));
+        targets.push_back(MakeNodePhantom(loop_nodes[index], 50));
+    }
+    CheckSameTable(grid, sources, targets);
+
+    SearchEngineData engine_working_data;
+    PHASTRouting<Grid> phast(&grid, engine_working_data);
+    const auto table = phast(sources, targets);
+    for (std::size_t index = 0; index < 4; ++index)
+    {
+        BOOST_CHECK_NE((*table)[index * targets.size() + index], INVALID_EDGE_WEIGHT);
+    }
+}
+
+// The sweep over the whole hierarchy gives the distances of a plain search on the uncontracted
+// grid, shifted by the weight of the source up to its phantom node
+BOOST_AUTO_TEST_CASE(one_to_all_matches_dijkstra)
+{
+    for (unsigned seed = 1; seed <= 30; ++seed)
+    {
+        Grid grid(12, seed);
+        SearchEngineData engine_working_data;
+        PHASTRouting<Grid> phast(&grid, engine_working_data);
+
+        const NodeID source = seed % grid.GetNumberOfNodes();
+        std::vector<EdgeWeight> node_distances;
+        phast.OneToAll(MakeNodePhantom(source, 25), node_distances);
+
+        const auto distances = grid.GetDistances(source);
+        BOOST_REQUIRE_EQUAL(node_distances.size(), distances.size());
+        for (NodeID node = 0; node < distances.size(); ++node)
+        {
+            const auto expected =
+                INVALID_EDGE_WEIGHT == distances[node] ? INVALID_EDGE_WEIGHT : distances[node] - 25;
+            BOOST_CHECK_EQUAL(node_distances[node], expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
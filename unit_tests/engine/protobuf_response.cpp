@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/protobuf_response.hpp"
+
+#include <protozero/pbf_reader.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(protobuf_response)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+BOOST_AUTO_TEST_CASE(delta_coded_coordinates)
+{
+    const std::vector<util::FixedPointCoordinate> coordinates = {
+        {52500000, 13400000}, {52500100, 13399900}, {-33900000, 151200000}};
+
+    std::string buffer;
+    {
+        protozero::pbf_writer writer(buffer);
+        pbf::AddCoordinates(writer, pbf::table::source_coordinates, coordinates.begin(),
+                            coordinates.end(), [](const util::FixedPointCoordinate &coordinate)
+                            {
+                                return coordinate;
+                            });
+        // nothing is written for empty ranges
+        pbf::AddCoordinates(writer, pbf::table::destination_coordinates, coordinates.end(),
+                            coordinates.end(), [](const util::FixedPointCoordinate &coordinate)
+                            {
+                                return coordinate;
+                            });
+    }
+
+    protozero::pbf_reader reader(buffer);
+    BOOST_REQUIRE(reader.next());
+    BOOST_CHECK_EQUAL(reader.tag(), pbf::table::source_coordinates);
+    const auto values = reader.get_packed_sint32();
+    std::vector<std::int32_t> deltas(values.first, values.second);
+    BOOST_CHECK(!reader.next());
+
+    BOOST_REQUIRE_EQUAL(deltas.size(), 2 * coordinates.size());
+    std::int32_t lat = 0, lon = 0;
+    for (std::size_t i = 0; i < coordinates.size(); ++i)
+    {
+        lat += deltas[2 * i];
+        lon += deltas[2 * i + 1];
+        BOOST_CHECK_EQUAL(lat, coordinates[i].lat);
+        BOOST_CHECK_EQUAL(lon, coordinates[i].lon);
+    }
+    // small steps stay small
+    BOOST_CHECK_EQUAL(deltas[2], 100);
+    BOOST_CHECK_EQUAL(deltas[3], -100);
+}
+
+BOOST_AUTO_TEST_CASE(status_is_appended)
+{
+    std::string buffer;
+    {
+        protozero::pbf_writer writer(buffer);
+        protozero::pbf_writer table_writer(writer, pbf::response::table);
+        table_writer.add_uint32(pbf::table::sources, 3);
+    }
+    pbf::AddStatus(buffer, 200, "Found route between points");
+    pbf::AddStatus(buffer, 207, "");
+
+    protozero::pbf_reader reader(buffer);
+    std::vector<std::uint32_t> statuses;
+    std::string status_message;
+    bool found_table = false;
+    while (reader.next())
+    {
+        switch (reader.tag())
+        {
+        case pbf::response::status:
+            statuses.push_back(reader.get_uint32());
+            break;
+        case pbf::response::status_message:
+            status_message = reader.get_string();
+            break;
+        case pbf::response::table:
+        {
+            auto table_reader = reader.get_message();
+            BOOST_REQUIRE(table_reader.next(pbf::table::sources));
+            BOOST_CHECK_EQUAL(table_reader.get_uint32(), 3);
+            found_table = true;
+            break;
+        }
+        default:
+            reader.skip();
+        }
+    }
+
+    BOOST_CHECK(found_table);
+    BOOST_REQUIRE_EQUAL(statuses.size(), 2);
+    BOOST_CHECK_EQUAL(statuses[0], 200);
+    BOOST_CHECK_EQUAL(statuses[1], 207);
+    BOOST_CHECK_EQUAL(status_message, "Found route between points");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
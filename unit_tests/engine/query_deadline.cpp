@@ -0,0 +1,88 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/query_deadline.hpp"
+
+#include <chrono>
+
+BOOST_AUTO_TEST_SUITE(query_deadline)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+// runs the given number of search steps, returns false if the deadline check aborted them
+bool RunSteps(const unsigned number_of_steps)
+{
+    DeadlineCheck deadline_check;
+    try
+    {
+        for (unsigned i = 0; i < number_of_steps; ++i)
+        {
+            deadline_check.Step();
+        }
+    }
+    catch (const QueryDeadlineExceeded &)
+    {
+        return false;
+    }
+    return true;
+}
+}
+
+BOOST_AUTO_TEST_CASE(no_deadline)
+{
+    BOOST_CHECK(RunSteps(10 * DeadlineCheck::CHECK_INTERVAL));
+
+    ScopedQueryDeadline no_deadline(nullptr);
+    BOOST_CHECK(RunSteps(10 * DeadlineCheck::CHECK_INTERVAL));
+}
+
+BOOST_AUTO_TEST_CASE(expired_deadline)
+{
+    const QueryDeadline deadline(QueryDeadline::Clock::now() - std::chrono::seconds(1));
+    BOOST_CHECK(deadline.IsExpired());
+
+    ScopedQueryDeadline scoped_deadline(&deadline);
+    // the clock is only read every CHECK_INTERVAL steps
+    BOOST_CHECK(RunSteps(DeadlineCheck::CHECK_INTERVAL - 1));
+    BOOST_CHECK(!RunSteps(1));
+}
+
+BOOST_AUTO_TEST_CASE(steps_accumulate_over_searches)
+{
+    const QueryDeadline deadline(QueryDeadline::Clock::now() - std::chrono::seconds(1));
+    ScopedQueryDeadline scoped_deadline(&deadline);
+
+    unsigned completed_searches = 0;
+    while (RunSteps(10))
+    {
+        ++completed_searches;
+    }
+    BOOST_CHECK_EQUAL(completed_searches, DeadlineCheck::CHECK_INTERVAL / 10);
+}
+
+BOOST_AUTO_TEST_CASE(cancel)
+{
+    QueryDeadline deadline(QueryDeadline::Clock::now() + std::chrono::hours(1));
+    ScopedQueryDeadline scoped_deadline(&deadline);
+    BOOST_CHECK(!deadline.IsExpired());
+    BOOST_CHECK(RunSteps(2 * DeadlineCheck::CHECK_INTERVAL));
+
+    deadline.Cancel();
+    BOOST_CHECK(deadline.IsExpired());
+    BOOST_CHECK(!RunSteps(DeadlineCheck::CHECK_INTERVAL));
+}
+
+BOOST_AUTO_TEST_CASE(nested_scopes)
+{
+    const QueryDeadline expired(QueryDeadline::Clock::now() - std::chrono::seconds(1));
+    ScopedQueryDeadline outer(&expired);
+    {
+        ScopedQueryDeadline inner(nullptr);
+        BOOST_CHECK(RunSteps(10 * DeadlineCheck::CHECK_INTERVAL));
+    }
+    BOOST_CHECK(!RunSteps(DeadlineCheck::CHECK_INTERVAL));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/response_cache.hpp"
+#include "engine/route_parameters.hpp"
+
+#include <memory>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(response_cache)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+std::shared_ptr<const CachedResponse> MakeResponse(const std::size_t size)
+{
+    return std::make_shared<const CachedResponse>(
+        CachedResponse{200, std::vector<char>(size, 'x')});
+}
+}
+
+BOOST_AUTO_TEST_CASE(get_and_put)
+{
+    ResponseCache cache(1024 * 1024, 4);
+    BOOST_CHECK(!cache.Get("a"));
+
+    cache.Put({"a", cache.GetGeneration()}, MakeResponse(10));
+    const auto response = cache.Get("a");
+    BOOST_REQUIRE(response);
+    BOOST_CHECK_EQUAL(response->status, 200);
+    BOOST_CHECK_EQUAL(response->content.size(), 10);
+    BOOST_CHECK(!cache.Get("b"));
+}
+
+BOOST_AUTO_TEST_CASE(evicts_least_recently_used)
+{
+    // a single shard makes the eviction order predictable
+    ResponseCache cache(1500, 1);
+    cache.Put({"a", cache.GetGeneration()}, MakeResponse(500));
+    cache.Put({"b", cache.GetGeneration()}, MakeResponse(500));
+    BOOST_CHECK(cache.Get("a"));
+
+    // needs room, 'b' was used least recently
+    cache.Put({"c", cache.GetGeneration()}, MakeResponse(500));
+    BOOST_CHECK(cache.Get("a"));
+    BOOST_CHECK(!cache.Get("b"));
+    BOOST_CHECK(cache.Get("c"));
+    BOOST_CHECK(cache.GetSizeInBytes() <= 1500);
+
+    // larger than the whole cache
+    cache.Put({"d", cache.GetGeneration()}, MakeResponse(4000));
+    BOOST_CHECK(!cache.Get("d"));
+}
+
+BOOST_AUTO_TEST_CASE(clear_rejects_old_tickets)
+{
+    ResponseCache cache(1024 * 1024, 4);
+    const ResponseCacheTicket ticket{"a", cache.GetGeneration()};
+    cache.Put({"b", cache.GetGeneration()}, MakeResponse(10));
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get("b"));
+    BOOST_CHECK_EQUAL(cache.GetSizeInBytes(), 0);
+
+    // computed on the replaced data
+    cache.Put(ticket, MakeResponse(10));
+    BOOST_CHECK(!cache.Get("a"));
+
+    cache.Put({"a", cache.GetGeneration()}, MakeResponse(10));
+    BOOST_CHECK(cache.Get("a"));
+}
+
+BOOST_AUTO_TEST_CASE(cache_key)
+{
+    RouteParameters parameters;
+    parameters.SetService("viaroute");
+    parameters.AddCoordinate(52.5, 13.4);
+    parameters.AddCoordinate(52.6, 13.5);
+
+    RouteParameters same_parameters;
+    same_parameters.SetService("viaroute");
+    same_parameters.AddCoordinate(52.5, 13.4);
+    same_parameters.AddCoordinate(52.6, 13.5);
+    same_parameters.SetDeadline(std::chrono::steady_clock::now());
+
+    BOOST_CHECK(MakeResponseCacheKey(parameters, 1) == MakeResponseCacheKey(same_parameters, 1));
+    // different dataset
+    BOOST_CHECK(MakeResponseCacheKey(parameters, 1) != MakeResponseCacheKey(same_parameters, 2));
+
+    same_parameters.SetInstructionFlag(true);
+    BOOST_CHECK(MakeResponseCacheKey(parameters, 1) != MakeResponseCacheKey(same_parameters, 1));
+
+    RouteParameters other_order;
+    other_order.SetService("viaroute");
+    other_order.AddCoordinate(52.6, 13.5);
+    other_order.AddCoordinate(52.5, 13.4);
+    BOOST_CHECK(MakeResponseCacheKey(parameters, 1) != MakeResponseCacheKey(other_order, 1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
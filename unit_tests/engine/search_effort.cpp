@@ -0,0 +1,53 @@
+#include <boost/test/unit_test.hpp>
+
+#include "engine/search_engine_data.hpp"
+
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(search_effort)
+
+using namespace osrm;
+using namespace osrm::engine;
+
+namespace
+{
+// inserts, improves and settles the given number of nodes
+void RunSearch(const unsigned number_of_nodes)
+{
+    SearchEngineData::QueryHeap heap(number_of_nodes, false);
+    for (unsigned node = 0; node < number_of_nodes; ++node)
+    {
+        heap.Insert(node, 2 * node + 2, node);
+        heap.DecreaseKey(node, 2 * node + 1);
+    }
+    while (!heap.Empty())
+    {
+        heap.DeleteMin();
+    }
+}
+}
+
+BOOST_AUTO_TEST_CASE(counts_heap_operations)
+{
+    const auto before = SearchEngineData::GetTotalSearchEffort();
+    RunSearch(10);
+    const auto after = SearchEngineData::GetTotalSearchEffort();
+
+    BOOST_CHECK_EQUAL(after.heap_pops - before.heap_pops, 10);
+    BOOST_CHECK_EQUAL(after.edge_relaxations - before.edge_relaxations, 20);
+}
+
+BOOST_AUTO_TEST_CASE(totals_survive_threads)
+{
+    const auto before = SearchEngineData::GetTotalSearchEffort();
+    std::thread first(RunSearch, 5);
+    std::thread second(RunSearch, 7);
+    first.join();
+    second.join();
+    const auto after = SearchEngineData::GetTotalSearchEffort();
+
+    BOOST_CHECK_EQUAL(after.heap_pops - before.heap_pops, 12);
+    BOOST_CHECK_EQUAL(after.edge_relaxations - before.edge_relaxations, 24);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+#include "contractor/query_edge.hpp"
+#include "contractor/shortcut_unpacking.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shortcut_unpacking)
+
+using namespace osrm;
+using namespace osrm::contractor;
+
+namespace
+{
+using Graph = util::StaticGraph<QueryEdge::EdgeData>;
+
+// path 0 -> 1 -> 2 -> 3 contracted in the order 1, 2, 0, 3
+Graph MakeContractedPath()
+{
+    std::vector<Graph::InputEdge> edges;
+    const auto add_edge = [&edges](const NodeID source, const NodeID target, const unsigned id,
+                                   const bool shortcut, const bool forward)
+    {
+        QueryEdge::EdgeData data;
+        data.id = id;
+        data.shortcut = shortcut;
+        data.distance = 10;
+        data.forward = forward;
+        data.backward = !forward;
+        edges.emplace_back(source, target, data);
+    };
+    add_edge(1, 0, 0, false, false);
+    add_edge(1, 2, 1, false, true);
+    add_edge(2, 0, 1, true, false);
+    add_edge(2, 3, 2, false, true);
+    add_edge(0, 3, 2, true, true);
+    std::sort(edges.begin(), edges.end());
+    return Graph(4, edges);
+}
+}
+
+BOOST_AUTO_TEST_CASE(disabled_without_threshold)
+{
+    const auto graph = MakeContractedPath();
+    const ShortcutUnpackingTable table(graph, 0);
+    BOOST_CHECK(table.keys.empty());
+    BOOST_CHECK_EQUAL(table.offsets.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(unpack_long_shortcuts)
+{
+    const auto graph = MakeContractedPath();
+    const ShortcutUnpackingTable table(graph, 3);
+
+    // only 0 -> 3 consists of three edges, 0 -> 2 of two
+    bool reversed;
+    const EdgeID shortcut = FindUnpackingEdge(graph, 0, 3, reversed);
+    BOOST_CHECK(!reversed);
+    BOOST_REQUIRE_EQUAL(table.keys.size(), 1);
+    BOOST_CHECK_EQUAL(table.keys[0], GetShortcutUnpackingKey(shortcut, false));
+    BOOST_REQUIRE_EQUAL(table.offsets.size(), 2);
+    BOOST_REQUIRE_EQUAL(table.offsets[1], 3);
+
+    const std::vector<NodeID> sources = {0, 1, 2};
+    const std::vector<unsigned> ids = {0, 1, 2};
+    for (const auto i : {0u, 1u, 2u})
+    {
+        BOOST_CHECK_EQUAL(table.edges[i].source, sources[i]);
+        const auto &data = graph.GetEdgeData(table.edges[i].edge);
+        BOOST_CHECK(!data.shortcut);
+        BOOST_CHECK_EQUAL(data.id, ids[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(unpack_backward_shortcuts)
+{
+    const auto graph = MakeContractedPath();
+    const ShortcutUnpackingTable table(graph, 2);
+
+    // 0 -> 2 is stored at node 2 and traversed against its direction
+    bool reversed;
+    const EdgeID shortcut = FindUnpackingEdge(graph, 0, 2, reversed);
+    BOOST_CHECK(reversed);
+    BOOST_REQUIRE_EQUAL(table.keys.size(), 2);
+    BOOST_CHECK(std::is_sorted(table.keys.begin(), table.keys.end()));
+    BOOST_CHECK(std::find(table.keys.begin(), table.keys.end(),
+                          GetShortcutUnpackingKey(shortcut, true)) != table.keys.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
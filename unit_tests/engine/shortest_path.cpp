@@ -0,0 +1,137 @@
+#include "engine/routing_algorithms/shortest_path.hpp"
+#include "engine/internal_route_result.hpp"
+#include "engine/search_engine_data.hpp"
+#include "util/typedefs.hpp"
+
+#include "contracted_grid.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <tbb/task_scheduler_init.h>
+
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(shortest_path)
+
+using namespace osrm;
+using namespace osrm::engine;
+using namespace osrm::engine::routing_algorithms;
+
+namespace
+{
+using Grid = unit_tests::ContractedGrid;
+using Routing = ShortestPathRouting<Grid>;
+
+std::vector<NodeID> GetPackedLeg(const Routing::PackedLegs &legs, const std::size_t leg)
+{
+    const auto leg_end =
+        leg + 1 < legs.packed_leg_begin.size() ? legs.packed_leg_begin[leg + 1]
+                                               : legs.packed_path.size();
+    return std::vector<NodeID>(legs.packed_path.begin() + legs.packed_leg_begin[leg],
+                               legs.packed_path.begin() + leg_end);
+}
+
+void CheckSamePaths(const std::vector<PathData> &lhs, const std::vector<PathData> &rhs)
+{
+    BOOST_REQUIRE_EQUAL(lhs.size(), rhs.size());
+    for (std::size_t i = 0; i < lhs.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(lhs[i].node, rhs[i].node);
+        BOOST_CHECK_EQUAL(lhs[i].name_id, rhs[i].name_id);
+        BOOST_CHECK_EQUAL(lhs[i].segment_duration, rhs[i].segment_duration);
+    }
+}
+}
+
+// Runs of legs between u-turn vias are searched and unpacked in parallel. Packed legs, distance
+// and unpacked paths have to match one sequential search over all legs.
+BOOST_AUTO_TEST_CASE(parallel_runs_match_sequential_legs)
+{
+    Grid grid(12, 5);
+    std::mt19937 generator(11);
+    SearchEngineData engine_working_data;
+    Routing shortest_path(&grid, engine_working_data);
+    // more threads than cores, so even small machines search the runs concurrently
+    tbb::task_scheduler_init init(4);
+
+    unsigned number_of_valid_routes = 0;
+    for (unsigned round = 0; round < 40; ++round)
+    {
+        const std::size_t number_of_legs = 2 + generator() % 7;
+        std::vector<PhantomNode> vias(number_of_legs + 1);
+        for (auto &via : vias)
+        {
+            via = grid.GetRandomPhantomNode(generator);
+        }
+        std::vector<PhantomNodes> legs;
+        for (std::size_t leg = 0; leg < number_of_legs; ++leg)
+        {
+            legs.push_back(PhantomNodes{vias[leg], vias[leg + 1]});
+        }
+        std::vector<bool> uturn_indicators(number_of_legs + 1);
+        for (std::size_t via = 0; via < uturn_indicators.size(); ++via)
+        {
+            uturn_indicators[via] = generator() % 2 == 0;
+        }
+
+        engine_working_data.InitializeOrClearFirstThreadLocalStorage(grid.GetNumberOfNodes());
+        Routing::PackedLegs sequential;
+        shortest_path.SearchLegs(legs, uturn_indicators, 0, number_of_legs,
+                                 *engine_working_data.forward_heap_1,
+                                 *engine_working_data.reverse_heap_1, sequential);
+
+        InternalRouteResult parallel;
+        shortest_path(legs, uturn_indicators, parallel);
+        if (sequential.distance == INVALID_EDGE_WEIGHT)
+        {
+            BOOST_CHECK(!parallel.is_valid());
+            continue;
+        }
+        ++number_of_valid_routes;
+
+        // every run on its own finds the packed legs of the sequential search
+        int total_distance = 0;
+        std::size_t run_begin = 0;
+        for (std::size_t leg = 1; leg <= number_of_legs; ++leg)
+        {
+            if (leg < number_of_legs && !uturn_indicators[leg])
+            {
+                continue;
+            }
+            Routing::PackedLegs run;
+            shortest_path.SearchLegs(legs, uturn_indicators, run_begin, leg,
+                                     *engine_working_data.forward_heap_1,
+                                     *engine_working_data.reverse_heap_1, run);
+            BOOST_REQUIRE_NE(run.distance, INVALID_EDGE_WEIGHT);
+            total_distance += run.distance;
+            for (auto run_leg = run_begin; run_leg < leg; ++run_leg)
+            {
+                BOOST_CHECK(GetPackedLeg(run, run_leg - run_begin) ==
+                            GetPackedLeg(sequential, run_leg));
+            }
+            run_begin = leg;
+        }
+        BOOST_CHECK_EQUAL(total_distance, sequential.distance);
+
+        InternalRouteResult expected;
+        auto packed_leg_begin = sequential.packed_leg_begin;
+        packed_leg_begin.push_back(sequential.packed_path.size());
+        shortest_path.UnpackLegs(legs, sequential.packed_path, packed_leg_begin,
+                                 sequential.distance, expected);
+
+        BOOST_CHECK_EQUAL(parallel.shortest_path_length, sequential.distance);
+        BOOST_REQUIRE_EQUAL(parallel.unpacked_path_segments.size(), number_of_legs);
+        for (std::size_t leg = 0; leg < number_of_legs; ++leg)
+        {
+            CheckSamePaths(parallel.unpacked_path_segments[leg],
+                           expected.unpacked_path_segments[leg]);
+        }
+        BOOST_CHECK(parallel.source_traversed_in_reverse == expected.source_traversed_in_reverse);
+        BOOST_CHECK(parallel.target_traversed_in_reverse == expected.target_traversed_in_reverse);
+    }
+    // most routes are found, so the comparison is not vacuous
+    BOOST_CHECK_GT(number_of_valid_routes, 20);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,125 @@
+#include "engine/trip/trip_branch_and_bound.hpp"
+#include "engine/trip/trip_held_karp.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_held_karp)
+
+using namespace osrm;
+using namespace osrm::engine::trip;
+
+namespace
+{
+util::DistTableWrapper<EdgeWeight> MakeRandomTable(const std::size_t number_of_locations,
+                                                   const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<EdgeWeight> weight_distribution(1, 100);
+    std::vector<EdgeWeight> table(number_of_locations * number_of_locations, 0);
+    for (const auto from : util::irange<std::size_t>(0, number_of_locations))
+    {
+        for (const auto to : util::irange<std::size_t>(0, number_of_locations))
+        {
+            if (from != to)
+            {
+                table[from * number_of_locations + to] = weight_distribution(generator);
+            }
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(table, number_of_locations);
+}
+
+std::int64_t GetLength(const util::DistTableWrapper<EdgeWeight> &table,
+                       const std::vector<NodeID> &trip)
+{
+    std::int64_t length = 0;
+    for (const auto i : util::irange<std::size_t>(0, trip.size()))
+    {
+        length += table(trip[i], trip[(i + 1) % trip.size()]);
+    }
+    return length;
+}
+
+std::int64_t GetShortestLength(const util::DistTableWrapper<EdgeWeight> &table,
+                               std::vector<NodeID> trip)
+{
+    auto shortest = std::numeric_limits<std::int64_t>::max();
+    do
+    {
+        shortest = std::min(shortest, GetLength(table, trip));
+    } while (std::next_permutation(trip.begin() + 1, trip.end()));
+    return shortest;
+}
+
+bool IsTrip(const std::vector<NodeID> &trip, const std::vector<NodeID> &locations)
+{
+    auto sorted = trip;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted == locations && trip.front() == locations.front();
+}
+}
+
+BOOST_AUTO_TEST_CASE(held_karp_is_optimal)
+{
+    for (const auto seed : util::irange(0u, 10u))
+    {
+        const std::size_t number_of_locations = 3 + seed % 6;
+        const auto table = MakeRandomTable(number_of_locations, seed);
+        std::vector<NodeID> locations(number_of_locations);
+        std::iota(locations.begin(), locations.end(), 0);
+
+        const auto trip =
+            HeldKarpTrip(locations.cbegin(), locations.cend(), number_of_locations, table);
+        BOOST_CHECK(IsTrip(trip, locations));
+        BOOST_CHECK_EQUAL(GetLength(table, trip), GetShortestLength(table, locations));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(held_karp_on_a_subset)
+{
+    const auto table = MakeRandomTable(10, 42);
+    const std::vector<NodeID> locations = {1, 4, 5, 8, 9};
+    const auto trip = HeldKarpTrip(locations.cbegin(), locations.cend(), 10, table);
+    BOOST_CHECK(IsTrip(trip, locations));
+    BOOST_CHECK_EQUAL(GetLength(table, trip), GetShortestLength(table, locations));
+}
+
+BOOST_AUTO_TEST_CASE(branch_and_bound_matches_held_karp)
+{
+    for (const auto seed : util::irange(0u, 5u))
+    {
+        const std::size_t number_of_locations = 8 + seed;
+        const auto table = MakeRandomTable(number_of_locations, seed);
+        std::vector<NodeID> locations(number_of_locations);
+        std::iota(locations.begin(), locations.end(), 0);
+
+        const auto optimal =
+            HeldKarpTrip(locations.cbegin(), locations.cend(), number_of_locations, table);
+        const auto trip = BranchAndBoundTrip(locations, table, std::chrono::seconds(60));
+        BOOST_CHECK(IsTrip(trip, locations));
+        BOOST_CHECK_EQUAL(GetLength(table, trip), GetLength(table, optimal));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(branch_and_bound_keeps_optimal_trip)
+{
+    const auto table = MakeRandomTable(9, 7);
+    std::vector<NodeID> locations(9);
+    std::iota(locations.begin(), locations.end(), 0);
+    const auto optimal = HeldKarpTrip(locations.cbegin(), locations.cend(), 9, table);
+
+    const auto trip = BranchAndBoundTrip(optimal, table, std::chrono::seconds(60));
+    BOOST_CHECK_EQUAL_COLLECTIONS(trip.begin(), trip.end(), optimal.begin(), optimal.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
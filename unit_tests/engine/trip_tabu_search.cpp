@@ -0,0 +1,61 @@
+#include "engine/trip/trip_tabu_search.hpp"
+#include "util/dist_table_wrapper.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(trip_tabu_search)
+
+using namespace osrm;
+using namespace osrm::engine::trip;
+
+namespace
+{
+// locations on a line, going left is twice as expensive as going right
+util::DistTableWrapper<EdgeWeight> MakeLineTable(const int number_of_locations)
+{
+    std::vector<EdgeWeight> table;
+    for (const auto from : util::irange(0, number_of_locations))
+    {
+        for (const auto to : util::irange(0, number_of_locations))
+        {
+            table.push_back(to >= from ? 10 * (to - from) : 20 * (from - to));
+        }
+    }
+    return util::DistTableWrapper<EdgeWeight>(table, number_of_locations);
+}
+}
+
+BOOST_AUTO_TEST_CASE(finds_optimal_trip)
+{
+    const auto table = MakeLineTable(12);
+    const std::vector<NodeID> zigzag = {5, 0, 11, 1, 10, 2, 9, 3, 8, 4, 7, 6};
+    const auto trip = TabuSearchTrip(zigzag, table, std::chrono::milliseconds(1000));
+
+    // the first location stays first, every location is visited once
+    BOOST_REQUIRE_EQUAL(trip.size(), zigzag.size());
+    BOOST_CHECK_EQUAL(trip.front(), 5);
+    auto sorted = trip;
+    std::sort(sorted.begin(), sorted.end());
+    BOOST_CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+    // any trip goes once to the right end and once back
+    const TabuSearch search(table, std::chrono::steady_clock::now());
+    BOOST_CHECK_EQUAL(search.GetLength(trip), 10 * 11 + 20 * 11);
+    BOOST_CHECK(search.GetLength(zigzag) > search.GetLength(trip));
+}
+
+BOOST_AUTO_TEST_CASE(no_time_no_change)
+{
+    const auto table = MakeLineTable(6);
+    const std::vector<NodeID> trip = {0, 3, 1, 4, 2, 5};
+    const auto result = TabuSearchTrip(trip, table, std::chrono::milliseconds(0));
+    BOOST_CHECK_EQUAL_COLLECTIONS(result.begin(), result.end(), trip.begin(), trip.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,154 @@
+#include "server/connection.hpp"
+#include "server/query_queue.hpp"
+#include "server/request_handler.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(connection)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+// long enough that waiting for it would show up in the test duration
+const constexpr unsigned KEEPALIVE_TIMEOUT = 30;
+// replies of the queue status are not compressed
+const constexpr std::size_t COMPRESSION_THRESHOLD = 1 << 20;
+const constexpr char QUEUE_STATUS_REQUEST[] = "GET /queue HTTP/1.1\r\n\r\n";
+
+std::size_t CountOccurrences(const std::string &text, const std::string &pattern)
+{
+    std::size_t count = 0;
+    for (auto position = text.find(pattern); position != std::string::npos;
+         position = text.find(pattern, position + pattern.size()))
+    {
+        ++count;
+    }
+    return count;
+}
+
+// Serves a single connection on the loopback interface. The queue status is answered on the
+// I/O thread, so no routing machine is needed.
+class SingleConnectionServer
+{
+  public:
+    explicit SingleConnectionServer(const unsigned keepalive_max_requests)
+        : acceptor(io_service,
+                   boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)),
+          request_handler(std::chrono::milliseconds(0), 1),
+          query_queue(1, 1, std::chrono::milliseconds(0)), start(std::chrono::steady_clock::now())
+    {
+        auto new_connection =
+            std::make_shared<Connection>(io_service, request_handler, query_queue,
+                                         KEEPALIVE_TIMEOUT, keepalive_max_requests,
+                                         COMPRESSION_THRESHOLD);
+        connection = new_connection;
+        acceptor.async_accept(new_connection->socket(),
+                              [new_connection](const boost::system::error_code &error)
+                              {
+                                  BOOST_REQUIRE(!error);
+                                  new_connection->start();
+                              });
+        io_thread = std::thread([this]
+                                {
+                                    io_service.run();
+                                });
+    }
+
+    ~SingleConnectionServer()
+    {
+        io_service.stop();
+        if (io_thread.joinable())
+        {
+            io_thread.join();
+        }
+    }
+
+    boost::asio::ip::tcp::endpoint GetEndpoint() const { return acceptor.local_endpoint(); }
+
+    // Waits until the server has no more work, which is once the connection is gone. Returns
+    // how long the server ran.
+    std::chrono::seconds WaitForShutdown()
+    {
+        io_thread.join();
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() -
+                                                                start);
+    }
+
+    bool IsConnectionAlive() const { return !connection.expired(); }
+
+  private:
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor acceptor;
+    RequestHandler request_handler;
+    QueryQueue query_queue;
+    std::weak_ptr<Connection> connection;
+    const std::chrono::steady_clock::time_point start;
+    std::thread io_thread;
+};
+
+// reads until the server closes the connection
+std::string ReadAll(boost::asio::ip::tcp::socket &socket)
+{
+    boost::asio::streambuf response;
+    boost::system::error_code error;
+    boost::asio::read(socket, response, error);
+    BOOST_CHECK(boost::asio::error::eof == error);
+    return std::string(std::istreambuf_iterator<char>(&response), {});
+}
+}
+
+// Pipelined requests are answered in order until the request cap is hit, the last reply
+// announces the close
+BOOST_AUTO_TEST_CASE(request_cap_closes_connection)
+{
+    SingleConnectionServer server(2);
+
+    boost::asio::io_service client_service;
+    boost::asio::ip::tcp::socket client(client_service);
+    client.connect(server.GetEndpoint());
+    const std::string requests =
+        std::string(QUEUE_STATUS_REQUEST) + QUEUE_STATUS_REQUEST + QUEUE_STATUS_REQUEST;
+    boost::asio::write(client, boost::asio::buffer(requests));
+
+    const auto response = ReadAll(client);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "HTTP/1.1 200 OK"), 2);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "Connection: keep-alive"), 1);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "Keep-Alive: timeout=30, max=1"), 1);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "Connection: close"), 1);
+    BOOST_CHECK_LT(response.find("Connection: keep-alive"), response.find("Connection: close"));
+
+    BOOST_CHECK_LT(server.WaitForShutdown().count(), KEEPALIVE_TIMEOUT / 3);
+    BOOST_CHECK(!server.IsConnectionAlive());
+}
+
+// A client that hangs up on a kept alive connection frees it right away, not only once the idle
+// timeout expired
+BOOST_AUTO_TEST_CASE(client_close_frees_connection)
+{
+    SingleConnectionServer server(0);
+
+    boost::asio::io_service client_service;
+    boost::asio::ip::tcp::socket client(client_service);
+    client.connect(server.GetEndpoint());
+    boost::asio::write(client, boost::asio::buffer(std::string(QUEUE_STATUS_REQUEST)));
+    client.shutdown(boost::asio::ip::tcp::socket::shutdown_send);
+
+    const auto response = ReadAll(client);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "HTTP/1.1 200 OK"), 1);
+    BOOST_CHECK_EQUAL(CountOccurrences(response, "Connection: keep-alive"), 1);
+
+    BOOST_CHECK_LT(server.WaitForShutdown().count(), KEEPALIVE_TIMEOUT / 3);
+    BOOST_CHECK(!server.IsConnectionAlive());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
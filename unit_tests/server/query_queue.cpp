@@ -0,0 +1,170 @@
+#include "server/query_queue.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+BOOST_AUTO_TEST_SUITE(query_queue)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+const constexpr char SERVICE[] = "viaroute";
+
+// Keeps the only worker busy until it is opened, so submitted tasks stay in the queue
+class BlockingTask
+{
+  public:
+    BlockingTask() : released(release.get_future().share()) {}
+
+    void Submit(QueryQueue &query_queue)
+    {
+        auto waiting = std::make_shared<std::promise<void>>();
+        auto started = waiting->get_future();
+        auto released_copy = released;
+        BOOST_REQUIRE(QueryQueue::Admission::accepted ==
+                      query_queue.Submit(SERVICE, [waiting, released_copy]
+                                         {
+                                             waiting->set_value();
+                                             released_copy.wait();
+                                         }));
+        started.wait();
+    }
+
+    void Open() { release.set_value(); }
+
+  private:
+    std::promise<void> release;
+    std::shared_future<void> released;
+};
+
+// waits until the worker has taken up the task submitted after all others
+void WaitForWorker(QueryQueue &query_queue)
+{
+    std::promise<void> done;
+    auto finished = done.get_future();
+    const auto signal = [&done]
+    {
+        done.set_value();
+    };
+    BOOST_REQUIRE(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, signal));
+    finished.wait();
+}
+}
+
+BOOST_AUTO_TEST_CASE(full_queue_rejects_tasks)
+{
+    QueryQueue query_queue(1, 2, std::chrono::milliseconds(0));
+    BlockingTask blocking_task;
+    blocking_task.Submit(query_queue);
+
+    std::atomic<unsigned> processed(0);
+    const auto count = [&processed]
+    {
+        ++processed;
+    };
+    BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, count));
+    BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, count));
+    BOOST_CHECK(QueryQueue::Admission::queue_full == query_queue.Submit(SERVICE, count));
+    BOOST_CHECK_EQUAL(query_queue.GetQueueDepth(), 2);
+
+    blocking_task.Open();
+    while (query_queue.GetQueueDepth() > 0)
+    {
+        std::this_thread::yield();
+    }
+    WaitForWorker(query_queue);
+    BOOST_CHECK_EQUAL(processed, 2);
+
+    const auto statistics = query_queue.GetStatistics().at(SERVICE);
+    BOOST_CHECK_EQUAL(statistics.accepted, 4);
+    BOOST_CHECK_EQUAL(statistics.rejected, 1);
+    BOOST_CHECK_EQUAL(statistics.queue_depth, 0);
+}
+
+// The wait is estimated from the time tasks took so far and the number of tasks in front
+BOOST_AUTO_TEST_CASE(long_wait_rejects_tasks)
+{
+    QueryQueue query_queue(1, 10, std::chrono::milliseconds(20));
+    const auto slow_task = []
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    };
+    const auto fast_task = []
+    {
+    };
+    // moves the average service time well above the wait budget
+    BOOST_REQUIRE(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, slow_task));
+    WaitForWorker(query_queue);
+
+    BlockingTask blocking_task;
+    blocking_task.Submit(query_queue);
+    BOOST_CHECK_EQUAL(query_queue.EstimateQueueWait().count(), 0);
+    // nothing waits in front of the first task, but the second would wait for it
+    BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, fast_task));
+    BOOST_CHECK_GT(query_queue.EstimateQueueWait().count(), 20);
+    BOOST_CHECK(QueryQueue::Admission::wait_budget_exceeded ==
+                query_queue.Submit(SERVICE, fast_task));
+    BOOST_CHECK_EQUAL(query_queue.GetStatistics().at(SERVICE).rejected, 1);
+    blocking_task.Open();
+}
+
+// Stopping waits for the running task but drops the queued ones
+BOOST_AUTO_TEST_CASE(stop_drops_queued_tasks)
+{
+    QueryQueue query_queue(1, 10, std::chrono::milliseconds(0));
+    BlockingTask blocking_task;
+    blocking_task.Submit(query_queue);
+
+    std::atomic<unsigned> processed(0);
+    const auto count = [&processed]
+    {
+        ++processed;
+    };
+    for (unsigned task = 0; task < 3; ++task)
+    {
+        BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, count));
+    }
+
+    std::thread stopping_thread([&query_queue]
+                                {
+                                    query_queue.Stop();
+                                });
+    while (query_queue.GetQueueDepth() > 0)
+    {
+        std::this_thread::yield();
+    }
+    blocking_task.Open();
+    stopping_thread.join();
+
+    BOOST_CHECK_EQUAL(processed, 0);
+    BOOST_CHECK_EQUAL(query_queue.GetStatistics().at(SERVICE).queue_depth, 0);
+    BOOST_CHECK(QueryQueue::Admission::queue_full == query_queue.Submit(SERVICE, count));
+}
+
+// Whatever a task throws, the worker goes on with the next one
+BOOST_AUTO_TEST_CASE(throwing_tasks_keep_workers_alive)
+{
+    QueryQueue query_queue(1, 10, std::chrono::milliseconds(0));
+    const auto throw_exception = []
+    {
+        throw std::runtime_error("failed");
+    };
+    const auto throw_other = []
+    {
+        throw 1;
+    };
+    BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, throw_exception));
+    BOOST_CHECK(QueryQueue::Admission::accepted == query_queue.Submit(SERVICE, throw_other));
+    WaitForWorker(query_queue);
+    BOOST_CHECK_GE(query_queue.GetStatistics().at(SERVICE).processed, 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,128 @@
+#include "server/http/request.hpp"
+#include "server/request_parser.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <tuple>
+
+BOOST_AUTO_TEST_SUITE(request_parser)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+struct ParseResult
+{
+    RequestParser::RequestStatus status;
+    http::compression_type compression;
+    // bytes of the input that were consumed
+    std::size_t consumed;
+};
+
+ParseResult Parse(RequestParser &parser, http::request &request, std::string &input)
+{
+    ParseResult result;
+    char *parsed_end;
+    std::tie(result.status, result.compression, parsed_end) =
+        parser.parse(request, &input[0], &input[0] + input.size());
+    result.consumed = parsed_end - &input[0];
+    return result;
+}
+
+bool IsKeepAlive(std::string input)
+{
+    RequestParser parser;
+    http::request request;
+    const auto result = Parse(parser, request, input);
+    BOOST_REQUIRE(RequestParser::RequestStatus::valid == result.status);
+    return request.keep_alive;
+}
+}
+
+BOOST_AUTO_TEST_CASE(keep_alive_depends_on_version_and_header)
+{
+    BOOST_CHECK(IsKeepAlive("GET /nearest HTTP/1.1\r\n\r\n"));
+    BOOST_CHECK(!IsKeepAlive("GET /nearest HTTP/1.1\r\nConnection: close\r\n\r\n"));
+    BOOST_CHECK(!IsKeepAlive("GET /nearest HTTP/1.0\r\n\r\n"));
+    BOOST_CHECK(IsKeepAlive("GET /nearest HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"));
+}
+
+BOOST_AUTO_TEST_CASE(chunked_replies_need_http_1_1)
+{
+    RequestParser parser;
+    http::request request;
+    std::string input = "GET /nearest HTTP/1.0\r\n\r\n";
+    Parse(parser, request, input);
+    BOOST_CHECK(!request.accepts_chunked);
+
+    parser.reset();
+    request = http::request();
+    input = "GET /nearest HTTP/1.1\r\n\r\n";
+    Parse(parser, request, input);
+    BOOST_CHECK(request.accepts_chunked);
+}
+
+// Requests sent back to back arrive in one buffer, the parser has to stop after the first one
+// and pick up the next one where it stopped
+BOOST_AUTO_TEST_CASE(pipelined_requests)
+{
+    const std::string first = "GET /nearest?loc=1,2 HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n";
+    const std::string second = "POST /table HTTP/1.1\r\nContent-Length: 7\r\n\r\nloc=3,4";
+    const std::string third = "GET /viaroute?loc=5,6 HTTP/1.1\r\n";
+    std::string input = first + second + third;
+
+    RequestParser parser;
+    http::request request;
+    auto result = Parse(parser, request, input);
+    BOOST_CHECK(RequestParser::RequestStatus::valid == result.status);
+    BOOST_CHECK_EQUAL(result.compression, http::gzip_rfc1952);
+    BOOST_CHECK_EQUAL(result.consumed, first.size());
+    BOOST_CHECK_EQUAL(request.uri, "/nearest?loc=1,2");
+
+    // the body ends at its content length, not at the end of the buffer
+    parser.reset();
+    request = http::request();
+    std::string rest = input.substr(result.consumed);
+    result = Parse(parser, request, rest);
+    BOOST_CHECK(RequestParser::RequestStatus::valid == result.status);
+    BOOST_CHECK_EQUAL(result.compression, http::no_compression);
+    BOOST_CHECK_EQUAL(result.consumed, second.size());
+    BOOST_CHECK_EQUAL(request.uri, "/table?loc=3,4");
+
+    // the last request is incomplete, everything is consumed while waiting for more
+    parser.reset();
+    request = http::request();
+    rest = rest.substr(result.consumed);
+    result = Parse(parser, request, rest);
+    BOOST_CHECK(RequestParser::RequestStatus::indeterminate == result.status);
+    BOOST_CHECK_EQUAL(result.consumed, third.size());
+    std::string end = "\r\n";
+    result = Parse(parser, request, end);
+    BOOST_CHECK(RequestParser::RequestStatus::valid == result.status);
+    BOOST_CHECK_EQUAL(request.uri, "/viaroute?loc=5,6");
+}
+
+// a reset parser must not carry over headers of the previous request on the connection
+BOOST_AUTO_TEST_CASE(reset_forgets_previous_request)
+{
+    RequestParser parser;
+    http::request request;
+    std::string input = "GET /nearest HTTP/1.1\r\nConnection: close\r\nAccept-Encoding: "
+                        "deflate\r\nX-Request-Timeout: 200\r\n\r\n";
+    auto result = Parse(parser, request, input);
+    BOOST_CHECK(!request.keep_alive);
+    BOOST_CHECK_EQUAL(result.compression, http::deflate_rfc1951);
+    BOOST_CHECK_EQUAL(request.timeout.count(), 200);
+
+    parser.reset();
+    request = http::request();
+    input = "GET /nearest HTTP/1.1\r\n\r\n";
+    result = Parse(parser, request, input);
+    BOOST_CHECK(request.keep_alive);
+    BOOST_CHECK_EQUAL(result.compression, http::no_compression);
+    BOOST_CHECK_EQUAL(request.timeout.count(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
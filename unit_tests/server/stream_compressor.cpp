@@ -0,0 +1,152 @@
+#include "server/stream_compressor.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(stream_compressor)
+
+using namespace osrm;
+using namespace osrm::server;
+
+namespace
+{
+const constexpr std::size_t STEP = 16 * 1024;
+
+// Half text, half random bytes, so compressed bodies of any size can be made
+std::vector<char> MakeBody(const std::size_t size, const unsigned seed)
+{
+    std::mt19937 generator(seed);
+    const std::string text = "{\"status\":200,\"route_geometry\":\"_p~iF~ps|U_ulLnnqC\"}";
+    std::vector<char> body(size);
+    for (std::size_t index = 0; index < size; ++index)
+    {
+        body[index] = index % 2 == 0 ? text[index % text.size()] : static_cast<char>(generator());
+    }
+    return body;
+}
+
+std::vector<char> Inflate(const std::vector<char> &compressed,
+                          const http::compression_type compression_type)
+{
+    z_stream stream = {};
+    BOOST_REQUIRE_EQUAL(Z_OK,
+                        inflateInit2(&stream, compression_type == http::gzip_rfc1952 ? 15 + 16
+                                                                                    : -15));
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+
+    std::vector<char> inflated;
+    int result;
+    do
+    {
+        const auto offset = inflated.size();
+        inflated.resize(offset + STEP);
+        stream.next_out = reinterpret_cast<Bytef *>(inflated.data() + offset);
+        stream.avail_out = static_cast<uInt>(STEP);
+        result = inflate(&stream, Z_NO_FLUSH);
+        inflated.resize(offset + STEP - stream.avail_out);
+    } while (result == Z_OK);
+    BOOST_CHECK_EQUAL(result, Z_STREAM_END);
+    // nothing may follow the end of the stream
+    BOOST_CHECK_EQUAL(stream.avail_in, 0);
+    inflateEnd(&stream);
+    return inflated;
+}
+
+// Removes the chunk framing, checks that only the last chunk is small and that the terminating
+// chunk follows it
+std::vector<char> Dechunk(const std::vector<char> &chunks)
+{
+    std::vector<char> body;
+    std::size_t position = 0;
+    bool last_chunk = false;
+    while (true)
+    {
+        const std::string rest(chunks.begin() + position, chunks.end());
+        const auto header_end = rest.find("\r\n");
+        BOOST_REQUIRE(header_end != std::string::npos);
+        const auto chunk_size = std::strtoul(rest.substr(0, header_end).c_str(), nullptr, 16);
+        position += header_end + 2;
+        if (chunk_size == 0)
+        {
+            BOOST_CHECK_EQUAL(std::string(chunks.begin() + position, chunks.end()), "\r\n");
+            return body;
+        }
+        BOOST_CHECK(!last_chunk);
+        last_chunk = chunk_size < StreamCompressor::MIN_CHUNK_SIZE;
+        BOOST_REQUIRE_LE(position + chunk_size + 2, chunks.size());
+        body.insert(body.end(), chunks.begin() + position, chunks.begin() + position + chunk_size);
+        position += chunk_size;
+        BOOST_CHECK_EQUAL(std::string(chunks.begin() + position, chunks.begin() + position + 2),
+                          "\r\n");
+        position += 2;
+    }
+}
+
+// what the connection sends for a body, one chunk per write
+std::vector<char> CompressChunked(StreamCompressor &compressor, const std::vector<char> &body)
+{
+    std::vector<char> chunks, chunk;
+    const auto body_end = body.data() + body.size();
+    auto chunk_begin = body.data();
+    do
+    {
+        chunk_begin = compressor.CompressChunk(chunk_begin, body_end, chunk);
+        chunks.insert(chunks.end(), chunk.begin(), chunk.end());
+    } while (chunk_begin != body_end);
+    return chunks;
+}
+}
+
+// Bodies below, at and above the size of the pieces zlib is fed, and ones that need several
+// chunks. The compressor is reused and switches between gzip and deflate.
+BOOST_AUTO_TEST_CASE(chunks_inflate_to_body)
+{
+    StreamCompressor compressor;
+    const std::vector<std::size_t> sizes = {0, 1000, STEP - 1, STEP, STEP + 1, 3 * STEP, 20 * STEP};
+    unsigned seed = 0;
+    for (const auto size : sizes)
+    {
+        for (const auto compression_type : {http::gzip_rfc1952, http::deflate_rfc1951})
+        {
+            const auto body = MakeBody(size, ++seed);
+            compressor.Reset(compression_type);
+            const auto chunks = CompressChunked(compressor, body);
+            BOOST_CHECK(Inflate(Dechunk(chunks), compression_type) == body);
+        }
+    }
+}
+
+// HTTP/1.0 replies are compressed in pieces without chunks
+BOOST_AUTO_TEST_CASE(pieces_inflate_to_body)
+{
+    StreamCompressor compressor;
+    const std::vector<std::size_t> sizes = {1000, STEP, 5 * STEP + 7};
+    unsigned seed = 0;
+    for (const auto compression_type :
+         {http::deflate_rfc1951, http::deflate_rfc1951, http::gzip_rfc1952, http::gzip_rfc1952})
+    {
+        for (const auto size : sizes)
+        {
+            const auto body = MakeBody(size, ++seed);
+            compressor.Reset(compression_type);
+            std::vector<char> compressed;
+            for (std::size_t begin = 0; begin < size; begin += 3000)
+            {
+                const auto end = std::min(size, begin + 3000);
+                compressor.Compress(body.data() + begin, body.data() + end, end == size,
+                                    compressed);
+            }
+            BOOST_CHECK(Inflate(compressed, compression_type) == body);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,4 +1,6 @@
 #include "util/binary_heap.hpp"
+#include "util/d_ary_heap.hpp"
+#include "util/radix_heap.hpp"
 #include "util/typedefs.hpp"
 
 #include <boost/test/unit_test.hpp>
@@ -25,7 +27,8 @@ typedef int TestKey;
 typedef int TestWeight;
 typedef boost::mpl::list<ArrayStorage<TestNodeID, TestKey>,
                          MapStorage<TestNodeID, TestKey>,
-                         UnorderedMapStorage<TestNodeID, TestKey>> storage_types;
+                         UnorderedMapStorage<TestNodeID, TestKey>,
+                         GenerationStampedStorage<TestNodeID, TestKey>> storage_types;
 
 template <unsigned NUM_ELEM> struct RandomDataFixture
 {
@@ -156,4 +159,121 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(decrease_key_test, T, storage_types, RandomData
     }
 }
 
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(clear_test, T, storage_types, RandomDataFixture<NUM_NODES>)
+{
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, T> heap(NUM_NODES);
+
+    for (unsigned round = 0; round < 3; ++round)
+    {
+        // every round only uses a part of the nodes
+        for (unsigned idx : order)
+        {
+            if (idx % 3 == round)
+            {
+                heap.Insert(ids[idx], weights[idx] + round, data[idx]);
+            }
+        }
+
+        for (auto id : ids)
+        {
+            BOOST_CHECK_EQUAL(heap.WasInserted(id), id % 3 == round);
+            if (id % 3 == round)
+            {
+                BOOST_CHECK_EQUAL(heap.GetKey(id), weights[id] + round);
+            }
+        }
+
+        heap.Clear();
+        BOOST_CHECK(heap.Empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(selectable_storage_test)
+{
+    for (const bool use_dense : {true, false})
+    {
+        BinaryHeap<TestNodeID, TestKey, TestWeight, TestData,
+                   SelectableStorage<TestNodeID, TestKey>> heap(NUM_NODES, use_dense);
+        heap.Insert(7, 10, TestData{1});
+        heap.Insert(3, 5, TestData{2});
+        BOOST_CHECK(heap.WasInserted(7));
+        BOOST_CHECK(!heap.WasInserted(4));
+        BOOST_CHECK_EQUAL(heap.DeleteMin(), 3);
+        heap.Clear();
+        BOOST_CHECK(!heap.WasInserted(7));
+    }
+}
+
+typedef GenerationStampedStorage<TestNodeID, TestKey> TestStorage;
+typedef boost::mpl::list<DAryHeap<TestNodeID, TestKey, TestWeight, TestData, TestStorage, 2>,
+                         DAryHeap<TestNodeID, TestKey, TestWeight, TestData, TestStorage, 4>,
+                         DAryHeap<TestNodeID, TestKey, TestWeight, TestData, TestStorage, 8>,
+                         RadixHeap<TestNodeID, TestKey, TestWeight, TestData, TestStorage>>
+    heap_types;
+
+// runs a Dijkstra-like sequence of operations on the heap and on a binary heap side by side
+BOOST_AUTO_TEST_CASE_TEMPLATE(same_order_as_binary_heap_test, HeapT, heap_types)
+{
+    constexpr unsigned NUM_SEARCH_NODES = 1000;
+    BinaryHeap<TestNodeID, TestKey, TestWeight, TestData, TestStorage> reference(NUM_SEARCH_NODES);
+    HeapT heap(NUM_SEARCH_NODES);
+
+    std::mt19937 g(7);
+    std::uniform_int_distribution<TestNodeID> node_dist(0, NUM_SEARCH_NODES - 1);
+    std::uniform_int_distribution<TestWeight> weight_dist(0, 50);
+
+    for (unsigned round = 0; round < 3; ++round)
+    {
+        reference.Clear();
+        heap.Clear();
+        // negative start weights as for phantom node offsets
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            const auto node = node_dist(g);
+            if (!reference.WasInserted(node))
+            {
+                const TestWeight weight = -weight_dist(g);
+                reference.Insert(node, weight, TestData{node});
+                heap.Insert(node, weight, TestData{node});
+            }
+        }
+
+        while (!reference.Empty())
+        {
+            BOOST_REQUIRE(!heap.Empty());
+            BOOST_CHECK_EQUAL(heap.Size(), reference.Size());
+            BOOST_REQUIRE_EQUAL(heap.MinKey(), reference.MinKey());
+            const auto min_weight = reference.MinKey();
+            // ties may be broken differently, so take the node out of the reference heap too
+            const auto node = heap.DeleteMin();
+            BOOST_CHECK(heap.WasRemoved(node));
+            BOOST_REQUIRE(reference.WasInserted(node) && !reference.WasRemoved(node));
+            BOOST_REQUIRE_EQUAL(reference.GetKey(node), min_weight);
+            reference.DecreaseKey(node, std::numeric_limits<TestWeight>::min() / 2);
+            reference.DeleteMin();
+
+            for (unsigned edge = 0; edge < 4; ++edge)
+            {
+                const auto to = node_dist(g);
+                const auto to_weight = min_weight + weight_dist(g);
+                if (!reference.WasInserted(to))
+                {
+                    BOOST_CHECK(!heap.WasInserted(to));
+                    reference.Insert(to, to_weight, TestData{to});
+                    heap.Insert(to, to_weight, TestData{to});
+                }
+                else if (!reference.WasRemoved(to) && to_weight < reference.GetKey(to))
+                {
+                    BOOST_CHECK(!heap.WasRemoved(to));
+                    reference.DecreaseKey(to, to_weight);
+                    heap.DecreaseKey(to, to_weight);
+                    heap.GetData(to).value = node;
+                    BOOST_CHECK_EQUAL(heap.GetKey(to), to_weight);
+                }
+            }
+        }
+        BOOST_CHECK(heap.Empty());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
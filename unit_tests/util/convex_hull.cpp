@@ -0,0 +1,51 @@
+#include "util/convex_hull.hpp"
+#include "util/coordinate.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(convex_hull)
+
+using namespace osrm;
+using namespace osrm::util;
+
+BOOST_AUTO_TEST_CASE(hull_of_square)
+{
+    // corners of a square, its center, an edge midpoint and a duplicate corner
+    const std::vector<FixedPointCoordinate> coordinates = {
+        {10, 10}, {0, 0}, {5, 5}, {0, 10}, {10, 0}, {0, 5}, {10, 10}};
+
+    const auto hull = ConvexHull(coordinates);
+
+    // counter-clockwise, starting at the south-west corner
+    BOOST_REQUIRE_EQUAL(hull.size(), 4);
+    BOOST_CHECK_EQUAL(hull[0], FixedPointCoordinate(0, 0));
+    BOOST_CHECK_EQUAL(hull[1], FixedPointCoordinate(0, 10));
+    BOOST_CHECK_EQUAL(hull[2], FixedPointCoordinate(10, 10));
+    BOOST_CHECK_EQUAL(hull[3], FixedPointCoordinate(10, 0));
+}
+
+BOOST_AUTO_TEST_CASE(degenerate_hulls)
+{
+    BOOST_CHECK(ConvexHull({}).empty());
+    BOOST_CHECK_EQUAL(ConvexHull({{1, 2}, {1, 2}}).size(), 1);
+
+    // collinear coordinates only keep the end points
+    const auto hull = ConvexHull({{0, 0}, {2, 2}, {1, 1}});
+    BOOST_REQUIRE_EQUAL(hull.size(), 2);
+    BOOST_CHECK_EQUAL(hull[0], FixedPointCoordinate(0, 0));
+    BOOST_CHECK_EQUAL(hull[1], FixedPointCoordinate(2, 2));
+}
+
+BOOST_AUTO_TEST_CASE(hull_of_world_wide_coordinates)
+{
+    // products of fixed point coordinates exceed 32 bit
+    const std::vector<FixedPointCoordinate> coordinates = {
+        {-80000000, -170000000}, {80000000, -170000000}, {80000000, 170000000},
+        {-80000000, 170000000},  {0, 0}};
+
+    BOOST_CHECK_EQUAL(ConvexHull(coordinates).size(), 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
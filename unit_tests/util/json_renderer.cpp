@@ -0,0 +1,113 @@
+#include "util/json_renderer.hpp"
+#include "util/cast.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(json_renderer)
+
+using namespace osrm;
+using namespace osrm::util;
+
+namespace
+{
+std::string RenderNumber(const double value)
+{
+    std::vector<char> output;
+    json::ArrayRenderer renderer(output);
+    renderer(json::Number(value));
+    return std::string(output.begin(), output.end());
+}
+}
+
+BOOST_AUTO_TEST_CASE(number_formatting)
+{
+    const std::vector<double> values = {0.,
+                                        -0.,
+                                        1.,
+                                        -1.,
+                                        0.5,
+                                        13.388860,
+                                        -33.8688197,
+                                        52.5170365,
+                                        0.0000001,
+                                        -0.0000001,
+                                        0.0000005,
+                                        0.0000015,
+                                        123456.1234565,
+                                        999999999.9999999,
+                                        1e9 + 0.25,
+                                        1e15,
+                                        -1e20,
+                                        std::numeric_limits<double>::max(),
+                                        std::numeric_limits<double>::infinity()};
+    for (const auto value : values)
+    {
+        BOOST_CHECK_EQUAL(RenderNumber(value), cast::to_string_with_precision(value));
+    }
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> coordinates(-180., 180.);
+    std::uniform_real_distribution<double> durations(0., 1e7);
+    for (int i = 0; i < 100000; ++i)
+    {
+        const auto coordinate = coordinates(generator);
+        BOOST_CHECK_EQUAL(RenderNumber(coordinate), cast::to_string_with_precision(coordinate));
+        // values with few decimals hit ties most often
+        const auto rounded = std::round(durations(generator) * 100) / 100;
+        BOOST_CHECK_EQUAL(RenderNumber(rounded), cast::to_string_with_precision(rounded));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(object_rendering)
+{
+    json::Object object;
+    object.values["status"] = 200;
+    object.values["name"] = json::String("Aleja \"Solidarnosci\"/\b\\");
+    json::Array array;
+    array.values.push_back(json::True());
+    array.values.push_back(json::Null());
+    array.values.push_back(0.25);
+    object.values["array"] = array;
+    object.values["empty"] = json::Object();
+    // assigning an existing key keeps its position
+    object.values["status"] = 0;
+
+    std::vector<char> output;
+    json::render(output, object);
+    BOOST_CHECK_EQUAL(std::string(output.begin(), output.end()),
+                      "{\"status\":0,\"name\":\"Aleja \\\"Solidarnosci\\\"\\/\\b\\\\\","
+                      "\"array\":[true,null,0.25],\"empty\":{}}");
+    BOOST_CHECK_EQUAL(object.values.size(), 4);
+    BOOST_CHECK(object.values.find("missing") == object.values.end());
+}
+
+// the members offer the interface of the map they replaced
+BOOST_AUTO_TEST_CASE(object_members_like_map)
+{
+    json::Object object;
+    BOOST_CHECK(object.values.emplace("status", 200).second);
+    BOOST_CHECK(!object.values.emplace("status", 400).second);
+    BOOST_CHECK(object.values.insert({"name", json::String("Unter den Linden")}).second);
+    const auto inserted = object.values.insert({"name", json::String("Friedrichstrasse")});
+    BOOST_CHECK(!inserted.second);
+    BOOST_CHECK(inserted.first == object.values.find("name"));
+
+    BOOST_CHECK_EQUAL(object.values.at("status").get<json::Number>().value, 200);
+    BOOST_CHECK_EQUAL(object.values.at("name").get<json::String>().value, "Unter den Linden");
+    const auto &const_object = object;
+    BOOST_CHECK_THROW(const_object.values.at("missing"), std::out_of_range);
+    BOOST_CHECK_EQUAL(object.values.count("missing"), 0);
+
+    object.values.erase(object.values.find("status"));
+    BOOST_CHECK_EQUAL(object.values.size(), 1);
+    BOOST_CHECK_EQUAL(object.values.begin()->first, "name");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,74 @@
+#include "util/sweep_ranks.hpp"
+#include "util/static_graph.hpp"
+#include "util/typedefs.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_AUTO_TEST_SUITE(sweep_ranks)
+
+using namespace osrm;
+using namespace osrm::util;
+
+struct TestData
+{
+    EdgeID id;
+};
+
+typedef StaticGraph<TestData> TestStaticGraph;
+typedef TestStaticGraph::InputEdge TestInputEdge;
+
+BOOST_AUTO_TEST_CASE(ranks_follow_levels)
+{
+    /*
+     *  level 2        (1)
+     *                 ^ ^
+     *  level 1       /  (2)
+     *               /   ^
+     *  level 0    (0)  (3)
+     *
+     *  every edge is stored at its lower end, (0) has a loop
+     */
+    std::vector<TestInputEdge> input_edges = {
+        TestInputEdge{0, 0, TestData{0}}, TestInputEdge{0, 1, TestData{1}},
+        TestInputEdge{2, 1, TestData{2}}, TestInputEdge{3, 2, TestData{3}}};
+    TestStaticGraph graph(4, input_edges);
+    const std::vector<float> node_levels = {0, 2, 1, 0};
+
+    const auto ranks = ComputeSweepRanks(node_levels, graph);
+
+    BOOST_REQUIRE_EQUAL(ranks.size(), 4);
+    BOOST_CHECK_EQUAL(ranks[1], 0);
+    BOOST_CHECK_EQUAL(ranks[2], 1);
+    // nodes of the same level keep their order
+    BOOST_CHECK_EQUAL(ranks[0], 2);
+    BOOST_CHECK_EQUAL(ranks[3], 3);
+}
+
+BOOST_AUTO_TEST_CASE(order_inverts_ranks)
+{
+    const std::vector<NodeID> ranks = {2, 0, 1, 3};
+    const auto sweep_order = ComputeSweepOrder(ranks);
+
+    const std::vector<NodeID> expected_order = {1, 2, 0, 3};
+    BOOST_CHECK_EQUAL_COLLECTIONS(sweep_order.begin(), sweep_order.end(), expected_order.begin(),
+                                  expected_order.end());
+}
+
+BOOST_AUTO_TEST_CASE(levels_not_matching_the_hierarchy)
+{
+    std::vector<TestInputEdge> input_edges = {TestInputEdge{0, 1, TestData{0}},
+                                              TestInputEdge{1, 0, TestData{1}}};
+    TestStaticGraph graph(2, input_edges);
+
+    // an uncontracted core leaves edges between nodes of the same level
+    BOOST_CHECK(ComputeSweepRanks(std::vector<float>{0, 0}, graph).empty());
+    // edges pointing down the hierarchy
+    BOOST_CHECK(ComputeSweepRanks(std::vector<float>{1, 0}, graph).empty());
+    // levels of a different graph
+    BOOST_CHECK(ComputeSweepRanks(std::vector<float>{0, 1, 2}, graph).empty());
+    BOOST_CHECK(ComputeSweepRanks(std::vector<float>{}, graph).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()